@@ -14,21 +14,71 @@
 
 #include "hid.hpp"
 
+#include <algorithm>
+#include <atomic>
+
+#include "argtable3/argtable3.h"
 #include "class/hid/hid.h"
 #include "class/hid/hid_device.h"
 #include "device/usbd.h"
 #include "esp_console.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/event_groups.h"
 #include "freertos/idf_additions.h"
+#include "nvs.h"
 #include "portmacro.h"
 #include "projdefs.h"
 #include "tinyusb.h"
+#if CONFIG_NSG_HID_CDC_CONTROL
+#include "class/cdc/cdc_device.h"
+#include "tusb_cdc_acm.h"
+#endif
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+#include "pro_controller.hpp"
+#endif
+
+// HID task core affinity
+#if CONFIG_NSG_HID_TASK_CORE_ID < 0
+#define HID_TASK_CORE tskNO_AFFINITY
+#else
+#define HID_TASK_CORE CONFIG_NSG_HID_TASK_CORE_ID
+#endif
 
 namespace HID {
 
 static const char* TAG = "app hid";
 
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+// Pro Controller HID descriptor
+// Input: 0x30 full mode report, 0x21 subcommand reply, 0x81 USB command reply
+// Output: 0x01 rumble & subcommand, 0x10 rumble, 0x80 USB command, 0x82 pre-handshake
+const uint8_t hid_report_descriptor[] = {
+    0x05, 0x01, 0x15, 0x00, 0x09, 0x04, 0xA1, 0x01,  // Gamepad, application collection
+    // === [0x30: buttons 1-10] ===
+    0x85, 0x30, 0x05, 0x01, 0x05, 0x09, 0x19, 0x01, 0x29, 0x0A, 0x15, 0x00, 0x25, 0x01, 0x75,
+    0x01, 0x95, 0x0A, 0x55, 0x00, 0x65, 0x00, 0x81, 0x02,
+    // === [0x30: buttons 11-14, padding] ===
+    0x05, 0x09, 0x19, 0x0B, 0x29, 0x0E, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x04, 0x81,
+    0x02, 0x75, 0x01, 0x95, 0x02, 0x81, 0x03,
+    // === [0x30: X/Y/Z/Rz axes, 16 bits] ===
+    0x0B, 0x01, 0x00, 0x01, 0x00, 0xA1, 0x00, 0x0B, 0x30, 0x00, 0x01, 0x00, 0x0B, 0x31, 0x00,
+    0x01, 0x00, 0x0B, 0x32, 0x00, 0x01, 0x00, 0x0B, 0x35, 0x00, 0x01, 0x00, 0x15, 0x00, 0x27,
+    0xFF, 0xFF, 0x00, 0x00, 0x75, 0x10, 0x95, 0x04, 0x81, 0x02, 0xC0,
+    // === [0x30: hat switch, buttons 15-18, vendor data] ===
+    0x0B, 0x39, 0x00, 0x01, 0x00, 0x15, 0x00, 0x25, 0x07, 0x35, 0x00, 0x46, 0x3B, 0x01, 0x65,
+    0x14, 0x75, 0x04, 0x95, 0x01, 0x81, 0x02, 0x05, 0x09, 0x19, 0x0F, 0x29, 0x12, 0x15, 0x00,
+    0x25, 0x01, 0x75, 0x01, 0x95, 0x04, 0x81, 0x02, 0x75, 0x08, 0x95, 0x34, 0x81, 0x03,
+    // === [Vendor reports: 0x21, 0x81 input, 0x01, 0x10, 0x80, 0x82 output, 63 bytes] ===
+    0x06, 0x00, 0xFF, 0x85, 0x21, 0x09, 0x01, 0x75, 0x08, 0x95, 0x3F, 0x81, 0x03,  //
+    0x85, 0x81, 0x09, 0x02, 0x75, 0x08, 0x95, 0x3F, 0x81, 0x03,                    //
+    0x85, 0x01, 0x09, 0x03, 0x75, 0x08, 0x95, 0x3F, 0x91, 0x83,                    //
+    0x85, 0x10, 0x09, 0x04, 0x75, 0x08, 0x95, 0x3F, 0x91, 0x83,                    //
+    0x85, 0x80, 0x09, 0x05, 0x75, 0x08, 0x95, 0x3F, 0x91, 0x83,                    //
+    0x85, 0x82, 0x09, 0x06, 0x75, 0x08, 0x95, 0x3F, 0x91, 0x83,                    //
+    0xC0};
+#else
 // Gamepad HID descriptor for Nintendo Switch
 // 14 buttons, 1 8-way dpad, 2 analog sticks (4 axes)
 const uint8_t hid_report_descriptor[] = {
@@ -101,19 +151,32 @@ const uint8_t hid_report_descriptor[] = {
 
     // === [End of descriptor] ===
     HID_COLLECTION_END};
+#endif
 
 // USB Device descriptor
 const tusb_desc_device_t device_descriptor = {
     .bLength = sizeof(device_descriptor),       // Size of this descriptor in bytes
     .bDescriptorType = TUSB_DESC_DEVICE,        // Device descriptor type (0x01)
     .bcdUSB = 0x0200,                           // USB specification version (2.00)
+#if CONFIG_NSG_HID_CDC_CONTROL
+    .bDeviceClass = TUSB_CLASS_MISC,            // Composite device with IAD (CDC)
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,    // Common class
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,       // Interface association descriptor
+#else
     .bDeviceClass = TUSB_CLASS_UNSPECIFIED,     // Base class
     .bDeviceSubClass = 0x00,                    // Subclass (unused)
     .bDeviceProtocol = 0x00,                    // Protocol (unused)
+#endif
     .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,  // Max packet size for EP0
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+    .idVendor = 0x057e,                         // Vendor ID (Nintendo)
+    .idProduct = 0x2009,                        // Product ID (Pro Controller)
+    .bcdDevice = 0x0200,                        // Device release number
+#else
     .idVendor = 0x0f0d,                         // Vendor ID (HORI)
     .idProduct = 0x00c1,                        // Product ID (Nintendo Switch gamepad)
     .bcdDevice = 0x0572,                        // Device release number
+#endif
     .iManufacturer = 0x01,                      // Index of manufacturer string (1)
     .iProduct = 0x02,                           // Index of product string (2)
     .iSerialNumber = 0x00,                      // No serial number string
@@ -121,27 +184,101 @@ const tusb_desc_device_t device_descriptor = {
 };
 
 // USB String descriptor
-const char* hid_string_descriptor[5] = {
+const char* hid_string_descriptor[] = {
     // array of pointer to string descriptors
     (char[]){0x09, 0x04},                 // 0: is supported language is English (0x0409)
     CONFIG_NSG_HID_STRDESC_MANUFACTURER,  // 1: Manufacturer
     CONFIG_NSG_HID_STRDESC_PRODUCT,       // 2: Product
     CONFIG_NSG_HID_STRDESC_SERIAL,        // 3: Serials, should use chip ID
     CONFIG_NSG_HID_STRDESC_HID,           // 4: HID
+#if CONFIG_NSG_HID_CDC_CONTROL
+    CONFIG_NSG_HID_STRDESC_CDC,           // 5: CDC control channel
+#endif
 };
 
 // USB Configuration descriptor
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+// HID interface with IN & OUT endpoints (output reports carry subcommands)
+#define HID_DESC_LEN TUD_HID_INOUT_DESC_LEN
+#else
+#define HID_DESC_LEN TUD_HID_DESC_LEN
+#endif
+#if CONFIG_NSG_HID_CDC_CONTROL
+// 1 config, 1 HID + CDC-ACM (2 interfaces)
+#define HID_ITF_NUM_TOTAL 3
+#define HID_CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + HID_DESC_LEN + TUD_CDC_DESC_LEN)
+#else
 // 1 config, 1 HID
-static const uint8_t hid_configuration_descriptor[] = {
+#define HID_ITF_NUM_TOTAL 1
+#define HID_CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + HID_DESC_LEN)
+#endif
+#if CONFIG_NSG_HID_REMOTE_WAKEUP
+#define HID_CONFIG_ATTRIBUTE (0x80 | TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP)
+#else
+#define HID_CONFIG_ATTRIBUTE 0x80
+#endif
+// Not const: bInterval of HID IN endpoint is set from polling interval before enumeration
+static uint8_t hid_configuration_descriptor[] = {
     // Configuration number, interface count, string index, total length, attribute, power in mA
-    TUD_CONFIG_DESCRIPTOR(1, 1, 0, TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN, 0x80, 250),
+    TUD_CONFIG_DESCRIPTOR(1, HID_ITF_NUM_TOTAL, 0, HID_CONFIG_TOTAL_LEN, HID_CONFIG_ATTRIBUTE,
+                          250),
 
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+    // Interface number, string index, boot protocol, report descriptor len, EP Out & In address,
+    // size, polling interval
+    TUD_HID_INOUT_DESCRIPTOR(0, 4, false, sizeof(hid_report_descriptor), 0x01, 0x81,
+                             CFG_TUD_HID_EP_BUFSIZE, CONFIG_NSG_HID_POOLING_TICKRATE_MS),
+#else
     // Interface number, string index, boot protocol, report descriptor len, EP In address, size,
     // polling interval
     TUD_HID_DESCRIPTOR(0, 4, false, sizeof(hid_report_descriptor), 0x81, CFG_TUD_HID_EP_BUFSIZE,
-                       10),
+                       CONFIG_NSG_HID_POOLING_TICKRATE_MS),
+#endif
+
+#if CONFIG_NSG_HID_CDC_CONTROL
+    // Interface number, string index, EP notification address & size, EP data OUT & IN, size
+    TUD_CDC_DESCRIPTOR(1, 5, 0x82, 8, 0x03, 0x83, 64),
+#endif
 };
 
+// Offset of HID IN endpoint bInterval in configuration descriptor (last byte of HID descriptor)
+#define HID_EP_INTERVAL_OFFSET (TUD_CONFIG_DESC_LEN + HID_DESC_LEN - 1)
+// Offset of HID OUT endpoint bInterval (precedes IN endpoint descriptor)
+#define HID_EP_OUT_INTERVAL_OFFSET (HID_EP_INTERVAL_OFFSET - 7)
+
+// NVS storage of polling interval
+#define HID_NVS_NAMESPACE "hid"
+#define HID_NVS_KEY_INTERVAL "interval"
+
+// Polling interval, ms: endpoint bInterval & HID task tick period
+static std::atomic<uint8_t> poll_interval_ms = CONFIG_NSG_HID_POOLING_TICKRATE_MS;
+// New polling interval, which is applied by HID task (0 - none)
+static std::atomic<uint8_t> poll_interval_pending_ms = 0;
+
+// Load polling interval from NVS (Kconfig default, if not stored)
+static void poll_interval_load() {
+  nvs_handle_t nvs;
+  if (nvs_open(HID_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) return;
+  uint8_t interval;
+  if (nvs_get_u8(nvs, HID_NVS_KEY_INTERVAL, &interval) == ESP_OK && interval > 0) {
+    poll_interval_ms = interval;
+  }
+  nvs_close(nvs);
+}
+
+// Set endpoints bInterval in configuration descriptor
+static void set_descriptor_interval(uint8_t interval_ms) {
+  hid_configuration_descriptor[HID_EP_INTERVAL_OFFSET] = interval_ms;
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+  hid_configuration_descriptor[HID_EP_OUT_INTERVAL_OFFSET] = interval_ms;
+#endif
+}
+
+// Get polling interval, ms
+uint8_t get_poll_interval() {
+  return poll_interval_ms;
+}
+
 // TinyUSB HID callback
 // Invoked when received GET HID REPORT DESCRIPTOR request
 extern "C" uint8_t const* tud_hid_descriptor_report_cb(uint8_t instance) {
@@ -155,12 +292,12 @@ extern "C" uint8_t const* tud_hid_descriptor_report_cb(uint8_t instance) {
 extern "C" uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id,
                                           hid_report_type_t report_type, uint8_t* buffer,
                                           uint16_t reqlen) {
-  (void)instance;
-  (void)report_id;
-  (void)report_type;
-  (void)buffer;
-  (void)reqlen;
-
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+  // Last input report, without blocking report path
+  if (report_type == HID_REPORT_TYPE_INPUT) {
+    return ProController::get_input_report(buffer, reqlen);
+  }
+#endif
   return 0;
 }
 
@@ -169,7 +306,12 @@ extern "C" uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id,
 // received data on OUT endpoint ( Report ID = 0, Type = 0 )
 extern "C" void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id,
                                       hid_report_type_t report_type, uint8_t const* buffer,
-                                      uint16_t bufsize) {}
+                                      uint16_t bufsize) {
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+  // Handshake & subcommands, replies are queued for HID task
+  ProController::on_output_report(report_id, buffer, bufsize);
+#endif
+}
 
 // Gamepad report state
 static hid_device_report_t hid_report_state;
@@ -179,6 +321,18 @@ SemaphoreHandle_t hid_report_state_mtx;
 static bool is_gamepad_connected_state = false;
 SemaphoreHandle_t is_gamepad_connected_state_mtx;
 
+// Gamepad connection events (waiters of connection) & connections counter
+#define HID_EVENT_CONNECTED BIT0
+#define HID_EVENT_REPORT_COMPLETED BIT1
+static EventGroupHandle_t gamepad_events;
+static std::atomic<uint32_t> connection_num = 0;
+
+// Waiters of report completion, event is set only when somebody waits
+static std::atomic<uint32_t> completion_waiters = 0;
+
+// Remote wakeup is requested, signaled by HID task while USB is suspended
+static std::atomic<bool> remote_wakeup_requested = false;
+
 // Check is gamepad connected
 bool is_gamepad_connected() {
   bool state = false;
@@ -193,26 +347,379 @@ bool is_gamepad_connected() {
 inline void set_is_gamepad_connected(bool state) {
   if (xSemaphoreTake(is_gamepad_connected_state_mtx, portMAX_DELAY)) {
     is_gamepad_connected_state = state;
+    if (state) {
+      connection_num.fetch_add(1, std::memory_order_release);
+      xEventGroupSetBits(gamepad_events, HID_EVENT_CONNECTED);
+    } else {
+      xEventGroupClearBits(gamepad_events, HID_EVENT_CONNECTED);
+    }
     xSemaphoreGive(is_gamepad_connected_state_mtx);
   }
 }
 
+// Get gamepad connection number
+uint32_t get_connection_num() {
+  return connection_num.load(std::memory_order_acquire);
+}
+
+// Wait until gamepad is connected
+bool wait_gamepad_connected(uint32_t timeout_ms) {
+  TickType_t timeout = timeout_ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+  EventBits_t bits = xEventGroupWaitBits(gamepad_events, HID_EVENT_CONNECTED, pdFALSE, pdTRUE,
+                                         timeout);
+  return bits & HID_EVENT_CONNECTED;
+}
+
+// Wait until next report is delivered to host
+bool wait_report_completed(uint32_t timeout_ms) {
+  completion_waiters.fetch_add(1, std::memory_order_relaxed);
+  xEventGroupClearBits(gamepad_events, HID_EVENT_REPORT_COMPLETED);
+  EventBits_t bits = xEventGroupWaitBits(gamepad_events, HID_EVENT_REPORT_COMPLETED, pdTRUE,
+                                         pdTRUE, pdMS_TO_TICKS(timeout_ms) + 1);
+  completion_waiters.fetch_sub(1, std::memory_order_relaxed);
+  return bits & HID_EVENT_REPORT_COMPLETED;
+}
+
+// Request remote wakeup of suspended host
+bool request_remote_wakeup() {
+#if CONFIG_NSG_HID_REMOTE_WAKEUP
+  remote_wakeup_requested = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+// HID timings after power on
+static hid_timings_t hid_timings = {};
+static portMUX_TYPE hid_timings_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Record HID timing, if it is not recorded yet
+inline void mark_timing(int64_t& timing) {
+  int64_t now = esp_timer_get_time();
+  taskENTER_CRITICAL(&hid_timings_mux);
+  if (timing == 0) {
+    timing = now;
+  }
+  taskEXIT_CRITICAL(&hid_timings_mux);
+}
+
+// Get HID timings
+hid_timings_t get_timings() {
+  taskENTER_CRITICAL(&hid_timings_mux);
+  hid_timings_t timings = hid_timings;
+  taskEXIT_CRITICAL(&hid_timings_mux);
+  return timings;
+}
+
+// Tick jitter histogram buckets (upper bounds, us)
+const uint32_t jitter_buckets_us[HID_JITTER_BUCKETS_NUM - 1] = {50,   100,  250,  500,  1000,
+                                                                2000, 5000, 10000, 20000};
+
+// HID statistics counters
+// Updated with relaxed atomics, so readers never block HID task
+static struct {
+  std::atomic<uint32_t> ticks_sent;
+  std::atomic<uint32_t> ticks_skipped;
+  std::atomic<uint32_t> ticks_missed;
+  std::atomic<uint64_t> tick_jitter_sum_us;
+  std::atomic<uint32_t> tick_jitter_max_us;
+  std::atomic<uint32_t> tick_jitter_hist[HID_JITTER_BUCKETS_NUM];
+  std::atomic<uint32_t> report_waits;
+  std::atomic<uint64_t> report_wait_sum_us;
+  std::atomic<uint32_t> report_wait_max_us;
+  std::atomic<uint32_t> report_wait_timeouts;
+  std::atomic<uint32_t> reports_completed;
+  std::atomic<uint32_t> reports_dropped;
+  std::atomic<uint32_t> reports_retried;
+  std::atomic<uint32_t> stalls;
+  std::atomic<uint32_t> remote_wakeups;
+} hid_stats;
+
+// Update maximum value counter
+inline void stats_max(std::atomic<uint32_t>& counter, uint32_t value) {
+  uint32_t prev = counter.load(std::memory_order_relaxed);
+  while (value > prev &&
+         !counter.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+  }
+}
+
+// Get HID statistics
+hid_stats_t get_stats() {
+  hid_stats_t stats = {};
+  stats.ticks_sent = hid_stats.ticks_sent.load(std::memory_order_relaxed);
+  stats.ticks_skipped = hid_stats.ticks_skipped.load(std::memory_order_relaxed);
+  stats.ticks_missed = hid_stats.ticks_missed.load(std::memory_order_relaxed);
+  stats.tick_jitter_sum_us = hid_stats.tick_jitter_sum_us.load(std::memory_order_relaxed);
+  stats.tick_jitter_max_us = hid_stats.tick_jitter_max_us.load(std::memory_order_relaxed);
+  for (int b = 0; b < HID_JITTER_BUCKETS_NUM; b++) {
+    stats.tick_jitter_hist[b] = hid_stats.tick_jitter_hist[b].load(std::memory_order_relaxed);
+  }
+  stats.report_waits = hid_stats.report_waits.load(std::memory_order_relaxed);
+  stats.report_wait_sum_us = hid_stats.report_wait_sum_us.load(std::memory_order_relaxed);
+  stats.report_wait_max_us = hid_stats.report_wait_max_us.load(std::memory_order_relaxed);
+  stats.report_wait_timeouts = hid_stats.report_wait_timeouts.load(std::memory_order_relaxed);
+  stats.reports_completed = hid_stats.reports_completed.load(std::memory_order_relaxed);
+  stats.reports_dropped = hid_stats.reports_dropped.load(std::memory_order_relaxed);
+  stats.reports_retried = hid_stats.reports_retried.load(std::memory_order_relaxed);
+  stats.stalls = hid_stats.stalls.load(std::memory_order_relaxed);
+  stats.remote_wakeups = hid_stats.remote_wakeups.load(std::memory_order_relaxed);
+  return stats;
+}
+
+// Account tick period deviation
+inline void stats_tick(int64_t& last_tick_us, int64_t period_us) {
+  int64_t now = esp_timer_get_time();
+  if (last_tick_us != 0) {
+    int64_t deviation = now - last_tick_us - period_us;
+    uint32_t jitter = deviation < 0 ? -deviation : deviation;
+    hid_stats.tick_jitter_sum_us.fetch_add(jitter, std::memory_order_relaxed);
+    stats_max(hid_stats.tick_jitter_max_us, jitter);
+
+    int bucket = 0;
+    while (bucket < HID_JITTER_BUCKETS_NUM - 1 && jitter > jitter_buckets_us[bucket]) {
+      bucket++;
+    }
+    hid_stats.tick_jitter_hist[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+  last_tick_us = now;
+}
+
+// External report source, polled by HID task on every tick
+static std::atomic<report_source_t> report_source = NULL;
+
+// Set external report source
+void set_report_source(report_source_t source) {
+  report_source.store(source, std::memory_order_release);
+}
+
 // Report HID semaphore
-// unlocks, when HID report is sended
+// unlocks, when HID report transfer is completed
 SemaphoreHandle_t report_semaphore;
-inline void wait_hid_report() {
-  xSemaphoreTake(report_semaphore, pdMS_TO_TICKS(1000));
+
+// Report sequence numbers (wrapping)
+// state - last state set by set_hid_report(), submitted - state in IN endpoint transfer,
+// completed - state of last completed transfer
+static std::atomic<uint32_t> state_seq = 0;
+static std::atomic<uint32_t> submitted_seq = 0;
+static std::atomic<uint32_t> completed_seq = 0;
+
+// Wait until report with state seq is delivered to host
+// Returns false on timeout (endpoint is stalled or host doesn't poll it)
+static bool wait_hid_report(uint32_t seq) {
+  const int64_t deadline = esp_timer_get_time() + 1000000;
+  while ((int32_t)(completed_seq.load(std::memory_order_acquire) - seq) < 0) {
+    int64_t left = deadline - esp_timer_get_time();
+    if (left <= 0) return false;
+    // Wake up of other waiter is also possible, so sequence is checked again
+    xSemaphoreTake(report_semaphore, pdMS_TO_TICKS(left / 1000) + 1);
+  }
+  return true;
+}
+
+// TinyUSB HID callback
+// Invoked from TinyUSB task, when report is delivered to host (IN transfer is completed)
+extern "C" void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report,
+                                           uint16_t len) {
+  completed_seq.store(submitted_seq.load(std::memory_order_relaxed), std::memory_order_release);
+  hid_stats.reports_completed.fetch_add(1, std::memory_order_relaxed);
+  if (is_gamepad_connected_state) mark_timing(hid_timings.first_report_us);
+  xSemaphoreGive(report_semaphore);
+  if (completion_waiters.load(std::memory_order_relaxed)) {
+    xEventGroupSetBits(gamepad_events, HID_EVENT_REPORT_COMPLETED);
+  }
+}
+
+// Submit report to IN endpoint, if it is ready
+// Returns false, if endpoint is busy or report is rejected (report stays pending)
+static bool submit_report(const hid_device_report_t* report, uint32_t seq) {
+  if (!tud_hid_ready()) return false;
+  submitted_seq.store(seq, std::memory_order_relaxed);
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+  bool sent = ProController::send_input(report);
+#else
+  bool sent = tud_hid_report(0, report, sizeof(*report));
+#endif
+  if (!sent) {
+    hid_stats.reports_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+#if CONFIG_NSG_HID_AUTO_INIT_AFTER_MOUNT
+// Submit report, waiting for IN endpoint up to timeout (used by init sequence)
+static bool submit_report_wait(const hid_device_report_t* report, uint32_t timeout_ms) {
+  uint32_t seq = state_seq.load(std::memory_order_relaxed);
+  for (uint32_t waited = 0; !submit_report(report, seq); waited++) {
+    if (waited >= timeout_ms) return false;
+    vTaskDelay(1);
+  }
+  return true;
+}
+#endif
+
+// Re-enumerate device (disconnect & connect), gamepad is connected again by init sequence
+// Called from HID task
+static void reenumerate() {
+  set_is_gamepad_connected(false);
+  tud_disconnect();
+  vTaskDelay(pdMS_TO_TICKS(100));
+  tud_connect();
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+  ProController::reset();
+#endif
+}
+
+// Ticks with busy IN endpoint, after which endpoint is treated as stalled
+#define HID_STALL_POLLS CONFIG_NSG_HID_STALL_POLLS
+
+// Recover stalled IN endpoint
+static void recover_stall() {
+  hid_stats.stalls.fetch_add(1, std::memory_order_relaxed);
+#if CONFIG_NSG_HID_STALL_RECONNECT
+  ESP_LOGW(TAG, "HID IN endpoint is stalled for %d ticks, reconnecting USB", HID_STALL_POLLS);
+  reenumerate();
+#else
+  ESP_LOGW(TAG, "HID IN endpoint is stalled for %d ticks", HID_STALL_POLLS);
+#endif
+}
+
+// HID tick period
+#define HID_TICK_PERIOD_US ((int64_t)poll_interval_ms * 1000)
+
+// HID tick timer
+// Wakes HID task with report period, independently of FreeRTOS tick rate
+static esp_timer_handle_t tick_timer;
+static TaskHandle_t hid_task_handle = NULL;
+
+// HID tick timer callback
+static void IRAM_ATTR tick_timer_cb(void*) {
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+  BaseType_t need_yield = pdFALSE;
+  vTaskNotifyGiveFromISR(hid_task_handle, &need_yield);
+  if (need_yield) {
+    esp_timer_isr_dispatch_need_yield();
+  }
+#else
+  xTaskNotifyGive(hid_task_handle);
+#endif
+}
+
+// Timers for precise delays
+// Each timer serves one waiting task, if all are busy, delay falls back to FreeRTOS ticks
+#define HID_DELAY_TIMERS_NUM 4
+typedef struct {
+  esp_timer_handle_t timer;
+  SemaphoreHandle_t done;
+  StaticSemaphore_t done_buf;
+  std::atomic<bool> busy;
+} delay_timer_t;
+static delay_timer_t delay_timers[HID_DELAY_TIMERS_NUM];
+
+// Delay timer callback
+static void delay_timer_cb(void* arg) {
+  xSemaphoreGive(static_cast<delay_timer_t*>(arg)->done);
+}
+
+// Create delay timers
+static esp_err_t init_delay_timers() {
+  for (delay_timer_t& t : delay_timers) {
+    t.done = xSemaphoreCreateBinaryStatic(&t.done_buf);
+    const esp_timer_create_args_t timer_args = {
+        .callback = delay_timer_cb,
+        .arg = &t,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "hid_delay",
+        .skip_unhandled_events = false,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &t.timer));
+  }
+  return ESP_OK;
+}
+
+// Delay current task with microsecond resolution
+void delay_us(uint32_t us) {
+  if (us == 0) return;
+
+  for (delay_timer_t& t : delay_timers) {
+    bool expected = false;
+    if (t.timer && t.busy.compare_exchange_strong(expected, true)) {
+      esp_timer_start_once(t.timer, us);
+      xSemaphoreTake(t.done, portMAX_DELAY);
+      t.busy = false;
+      return;
+    }
+  }
+
+  // All timers are busy, round up to FreeRTOS ticks
+  vTaskDelay(((uint64_t)us * configTICK_RATE_HZ + 999999) / 1000000);
+}
+
+// Delay current task until absolute time
+void delay_until_us(int64_t deadline_us) {
+  // Long waits are split, so delay timer period fits in 32 bits
+  int64_t left;
+  while ((left = deadline_us - esp_timer_get_time()) > 0) {
+    delay_us(std::min<int64_t>(left, UINT32_MAX));
+  }
+}
+
+// Apply new polling interval: restart tick timer & re-enumerate device, so host reads new bInterval
+// Called from HID task
+static void apply_poll_interval(uint8_t interval_ms) {
+  ESP_LOGI(TAG, "Polling interval: %d -> %d ms, re-enumerating", get_poll_interval(),
+           interval_ms);
+  poll_interval_ms = interval_ms;
+  set_descriptor_interval(interval_ms);
+  esp_timer_stop(tick_timer);
+  ESP_ERROR_CHECK(esp_timer_start_periodic(tick_timer, HID_TICK_PERIOD_US));
+  reenumerate();
 }
 
 // Task for USB HID report
 void hid_handler_task(void*) {
-  const TickType_t freq = pdMS_TO_TICKS(CONFIG_NSG_HID_POOLING_TICKRATE_MS);
-  TickType_t last_wake_time = xTaskGetTickCount();
-  ESP_LOGI(TAG, "HID handler task runned, pooling tickrate: %d", CONFIG_NSG_HID_POOLING_TICKRATE_MS);
+  int64_t last_tick_us = 0;
+  int64_t tick_period_us = HID_TICK_PERIOD_US;
+  // Ticks with busy IN endpoint in a row
+  uint32_t busy_polls = 0;
+  ESP_LOGI(TAG, "HID handler task runned, pooling tickrate: %d", get_poll_interval());
 
   while (1) {
-    if (tud_mounted()) {
-      if (!is_gamepad_connected() && !tud_suspended()) {
+    // Wait for tick timer, several pending notifications mean missed ticks
+    uint32_t ticks = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+    if (ticks > 1) {
+      hid_stats.ticks_missed.fetch_add(ticks - 1, std::memory_order_relaxed);
+    }
+    // Polling interval is set by other task
+    uint8_t interval_ms = poll_interval_pending_ms.exchange(0);
+    if (interval_ms != 0 && interval_ms != poll_interval_ms) {
+      apply_poll_interval(interval_ms);
+      // Ticks pending during re-enumeration aren't missed
+      busy_polls = 0;
+      ulTaskNotifyTake(pdTRUE, 0);
+      continue;
+    }
+    // Polling interval is changed, previous tick isn't comparable
+    if (tick_period_us != HID_TICK_PERIOD_US) {
+      tick_period_us = HID_TICK_PERIOD_US;
+      last_tick_us = 0;
+    }
+    stats_tick(last_tick_us, tick_period_us);
+
+    if (tud_mounted() && !tud_suspended()) {
+      mark_timing(hid_timings.mounted_us);
+
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+      // Replies to host requests go first, input reports are sent after handshake
+      if (ProController::reply_pending() || !ProController::input_enabled()) {
+        ProController::send_reply();
+        hid_stats.ticks_skipped.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+#endif
+
+      if (!is_gamepad_connected()) {
         // For connection we need to trigger some buttons after USB initialization
         if (xSemaphoreTake(hid_report_state_mtx, portMAX_DELAY)) {
           // Clear report
@@ -226,47 +733,156 @@ void hid_handler_task(void*) {
 
           // Push one button for init
 #if CONFIG_NSG_HID_AUTO_INIT_AFTER_MOUNT
-          tud_hid_report(0, &hid_report_state, sizeof(hid_report_state));
-          vTaskDelay(pdMS_TO_TICKS(1000));
+          submit_report_wait(&hid_report_state, 100);
+          vTaskDelay(pdMS_TO_TICKS(CONFIG_NSG_HID_AUTO_INIT_DELAY_MS));
           hid_report_state.buttons = (uint16_t)1;
-          tud_hid_report(0, &hid_report_state, sizeof(hid_report_state));
+          submit_report_wait(&hid_report_state, 100);
           vTaskDelay(pdMS_TO_TICKS(100));
           hid_report_state.buttons = (uint16_t)0;
-          tud_hid_report(0, &hid_report_state, sizeof(hid_report_state));
+          submit_report_wait(&hid_report_state, 100);
           vTaskDelay(pdMS_TO_TICKS(100));
-          xSemaphoreGive(hid_report_state_mtx);
 #endif
+          xSemaphoreGive(hid_report_state_mtx);
         }
 
         ESP_LOGI(TAG, "Gamepad connected");
         set_is_gamepad_connected(true);
-
-      } else if (is_gamepad_connected_state && tud_suspended()) {
-        ESP_LOGI(TAG, "Gamepad unconnected");
-        set_is_gamepad_connected(false);
+        mark_timing(hid_timings.connected_us);
+        // Init sequence is not a regular tick, drop ticks pending during it
+        last_tick_us = 0;
+        busy_polls = 0;
+        ulTaskNotifyTake(pdTRUE, 0);
       }
 
+      // Take report from external source (e.g. streamed input), if it is active
+      hid_device_report_t sourced;
+      report_source_t source = report_source.load(std::memory_order_acquire);
+      bool is_sourced = source && source(esp_timer_get_time(), &sourced);
+
       // Report gamepad state
+      // While previous report is in flight, state stays pending and is sent on next tick
+      bool submitted = false;
       if (xSemaphoreTake(hid_report_state_mtx, portMAX_DELAY)) {
-        tud_hid_report(0, &hid_report_state, sizeof(hid_report_state));
+        if (is_sourced) {
+          hid_report_state = sourced;
+        }
+        submitted = submit_report(&hid_report_state, state_seq.load(std::memory_order_relaxed));
         xSemaphoreGive(hid_report_state_mtx);
       }
-      xSemaphoreGive(report_semaphore);
+
+      if (submitted) {
+        busy_polls = 0;
+        hid_stats.ticks_sent.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        hid_stats.reports_retried.fetch_add(1, std::memory_order_relaxed);
+        if (++busy_polls > HID_STALL_POLLS) {
+          busy_polls = 0;
+          recover_stall();
+        }
+      }
+    } else {
+      // Host repeats init sequence (or handshake) after resume & mount, so input sent meanwhile
+      // is lost: jobs pause until gamepad is connected again
+      if (is_gamepad_connected_state) {
+        ESP_LOGI(TAG, "Gamepad unconnected (%s)", tud_suspended() ? "suspended" : "unmounted");
+        set_is_gamepad_connected(false);
+      }
+#if CONFIG_NSG_HID_REMOTE_WAKEUP
+      // Remote wakeup is allowed only if host enabled it before suspend
+      if (tud_suspended() && remote_wakeup_requested.exchange(false)) {
+        if (tud_remote_wakeup()) {
+          ESP_LOGI(TAG, "Remote wakeup signaled");
+          hid_stats.remote_wakeups.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+#endif
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+      // Host repeats handshake after mount
+      if (!tud_mounted() && ProController::input_enabled()) ProController::reset();
+#endif
+      busy_polls = 0;
+      hid_stats.ticks_skipped.fetch_add(1, std::memory_order_relaxed);
     }
-    vTaskDelayUntil(&last_wake_time, freq);
   }
 }
 
+#if CONFIG_NSG_HID_CDC_CONTROL
+// CDC control channel receive callback
+static cdc_rx_cb_t cdc_rx_cb = NULL;
+
+// TinyUSB CDC callback
+// Invoked from TinyUSB task, when data is received
+static void cdc_rx_event(int itf, cdcacm_event_t* event) {
+  uint8_t buf[64];
+  size_t len = 0;
+  while (tinyusb_cdcacm_read(static_cast<tinyusb_cdcacm_itf_t>(itf), buf, sizeof(buf), &len) ==
+             ESP_OK &&
+         len > 0) {
+    if (cdc_rx_cb) cdc_rx_cb(buf, len);
+  }
+}
+
+// Set callback for data received over CDC control channel
+esp_err_t cdc_set_rx_callback(cdc_rx_cb_t cb) {
+  cdc_rx_cb = cb;
+  return ESP_OK;
+}
+
+// Write data to CDC control channel
+size_t cdc_write(const uint8_t* data, size_t len) {
+  size_t written = tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, data, len);
+  tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+  return written;
+}
+#else
+// Set callback for data received over CDC control channel
+esp_err_t cdc_set_rx_callback(cdc_rx_cb_t cb) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+// Write data to CDC control channel
+size_t cdc_write(const uint8_t* data, size_t len) {
+  return 0;
+}
+#endif
+
 // Setup USB descriptors & initialize USB stack
 esp_err_t init() {
   ESP_LOGI(TAG, "USB initialization");
 
+#if CONFIG_NSG_STATIC_ALLOCATION
+  static StaticSemaphore_t report_semaphore_buf;
+  static StaticSemaphore_t hid_report_state_mtx_buf;
+  static StaticSemaphore_t is_gamepad_connected_state_mtx_buf;
+  static StaticEventGroup_t gamepad_events_buf;
+  report_semaphore = xSemaphoreCreateBinaryStatic(&report_semaphore_buf);
+  hid_report_state_mtx = xSemaphoreCreateMutexStatic(&hid_report_state_mtx_buf);
+  is_gamepad_connected_state_mtx =
+      xSemaphoreCreateMutexStatic(&is_gamepad_connected_state_mtx_buf);
+  gamepad_events = xEventGroupCreateStatic(&gamepad_events_buf);
+#else
   // Create semaphore for HID task
   report_semaphore = xSemaphoreCreateBinary();
   // Create mutex for HID report
   hid_report_state_mtx = xSemaphoreCreateMutex();
   // Create mutex for gamepad state
   is_gamepad_connected_state_mtx = xSemaphoreCreateMutex();
+  // Create event group for gamepad connection waiters
+  gamepad_events = xEventGroupCreate();
+#endif
+
+  // Create timers for precise delays
+  ESP_ERROR_CHECK(init_delay_timers());
+
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+  // Pro Controller protocol (handshake & subcommands)
+  ESP_ERROR_CHECK(ProController::init());
+#endif
+
+  // Polling interval is used in configuration descriptor, so it's loaded before enumeration
+  poll_interval_load();
+  set_descriptor_interval(poll_interval_ms);
+  ESP_LOGI(TAG, "Polling interval: %d ms", get_poll_interval());
 
   // TinyUSB config
   const tinyusb_config_t tusb_cfg = {
@@ -277,6 +893,20 @@ esp_err_t init() {
       .configuration_descriptor = hid_configuration_descriptor,
   };
   ESP_ERROR_CHECK(tinyusb_driver_install(&tusb_cfg));
+
+#if CONFIG_NSG_HID_CDC_CONTROL
+  // CDC control channel
+  const tinyusb_config_cdcacm_t acm_cfg = {
+      .usb_dev = TINYUSB_USBDEV_0,
+      .cdc_port = TINYUSB_CDC_ACM_0,
+      .rx_unread_buf_sz = 64,
+      .callback_rx = &cdc_rx_event,
+      .callback_rx_wanted_char = NULL,
+      .callback_line_state_changed = NULL,
+      .callback_line_coding_changed = NULL,
+  };
+  ESP_ERROR_CHECK(tusb_cdc_acm_init(&acm_cfg));
+#endif
   ESP_LOGI(TAG, "USB initialization DONE");
 
   return ESP_OK;
@@ -285,20 +915,199 @@ esp_err_t init() {
 // Run task for HID handler
 esp_err_t init_hid_task() {
   ESP_LOGI(TAG, "Create HID handler task");
-  xTaskCreate(hid_handler_task, "app_hid_task", 2500, NULL, 6, NULL);
+#if CONFIG_NSG_STATIC_ALLOCATION
+  static StackType_t hid_task_stack[CONFIG_NSG_HID_TASK_STACK_SIZE];
+  static StaticTask_t hid_task_tcb;
+  hid_task_handle = xTaskCreateStaticPinnedToCore(
+      hid_handler_task, "app_hid_task", CONFIG_NSG_HID_TASK_STACK_SIZE, NULL,
+      CONFIG_NSG_HID_TASK_PRIORITY, hid_task_stack, &hid_task_tcb, HID_TASK_CORE);
+#else
+  xTaskCreatePinnedToCore(hid_handler_task, "app_hid_task", CONFIG_NSG_HID_TASK_STACK_SIZE, NULL,
+                          CONFIG_NSG_HID_TASK_PRIORITY, &hid_task_handle, HID_TASK_CORE);
+#endif
+
+  // Start HID tick timer
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+  const esp_timer_dispatch_t tick_dispatch = ESP_TIMER_ISR;
+#else
+  const esp_timer_dispatch_t tick_dispatch = ESP_TIMER_TASK;
+#endif
+  const esp_timer_create_args_t tick_timer_args = {
+      .callback = tick_timer_cb,
+      .arg = NULL,
+      .dispatch_method = tick_dispatch,
+      .name = "hid_tick",
+      .skip_unhandled_events = true,
+  };
+  ESP_ERROR_CHECK(esp_timer_create(&tick_timer_args, &tick_timer));
+  ESP_ERROR_CHECK(esp_timer_start_periodic(tick_timer, HID_TICK_PERIOD_US));
 
   return ESP_OK;
 }
 
+// Set polling interval: stores it in NVS & posts it to HID task, which re-enumerates device
+esp_err_t set_poll_interval(uint8_t interval_ms) {
+  if (interval_ms == 0) return ESP_ERR_INVALID_ARG;
+  uint8_t pending = poll_interval_pending_ms;
+  if (interval_ms == (pending != 0 ? pending : poll_interval_ms.load())) return ESP_OK;
+
+  nvs_handle_t nvs;
+  esp_err_t err = nvs_open(HID_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+  if (err != ESP_OK) return err;
+  err = nvs_set_u8(nvs, HID_NVS_KEY_INTERVAL, interval_ms);
+  if (err == ESP_OK) err = nvs_commit(nvs);
+  nvs_close(nvs);
+  if (err != ESP_OK) return err;
+
+  poll_interval_pending_ms = interval_ms;
+  return ESP_OK;
+}
+
 // CMD: Prints USB information
 static int cmd_usbinfo(int argc, char** argv) {
   printf("USB info:\r\n");
   printf("  Device HID name: %s\r\n", hid_string_descriptor[4]);
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+  printf("  Personality: Pro Controller (input reports %s)\r\n",
+         ProController::input_enabled() ? "enabled" : "waiting for handshake");
+#else
+  printf("  Personality: HORI gamepad\r\n");
+#endif
   printf("  Device mount state: %s\r\n", tud_mounted() ? "mounted" : "unmounted");
   printf("  Device connection state: %s\r\n", tud_connected() ? "connected" : "unconnected");
   printf("  Device suspension state: %s\r\n", tud_suspended() ? "suspended" : "not suspended");
   printf("  Gamepad connected: %s\r\n", is_gamepad_connected() ? "true" : "false");
-  printf("  Pooling tickrate: %d\r\n", CONFIG_NSG_HID_POOLING_TICKRATE_MS);
+  printf("  Pooling tickrate: %d\r\n", get_poll_interval());
+  hid_stats_t stats = get_stats();
+  printf("  Reports sent: %lu, skipped ticks: %lu, missed ticks: %lu\r\n",
+         (unsigned long)stats.ticks_sent, (unsigned long)stats.ticks_skipped,
+         (unsigned long)stats.ticks_missed);
+  printf("  Reports completed: %lu, dropped: %lu, retried: %lu, stalls: %lu\r\n",
+         (unsigned long)stats.reports_completed, (unsigned long)stats.reports_dropped,
+         (unsigned long)stats.reports_retried, (unsigned long)stats.stalls);
+  printf("  Tick jitter max: %lu us\r\n", (unsigned long)stats.tick_jitter_max_us);
+  printf("  Connections: %lu, remote wakeups: %lu\r\n", (unsigned long)get_connection_num(),
+         (unsigned long)stats.remote_wakeups);
+  return 0;
+}
+
+// CMD: Measure HID tick jitter
+static struct {
+  struct arg_int* time = arg_int0("t", "time", "<s>", "Measure duration, default = 10");
+  struct arg_int* max = arg_int0("m", "max", "<us>", "Fail, if p99 jitter exceeds it");
+  struct arg_end* end = arg_end(3);
+} cmd_hidjitter_args;
+static int cmd_hidjitter(int argc, char** argv) {
+  // Check argument parse error
+  int nerrors = arg_parse(argc, argv, (void**)&cmd_hidjitter_args);
+  if (nerrors != 0) {
+    arg_print_errors(stderr, cmd_hidjitter_args.end, argv[0]);
+    return 1;
+  }
+
+  int duration = 10;
+  if (cmd_hidjitter_args.time->count == 1) {
+    duration = cmd_hidjitter_args.time->ival[0];
+  }
+  if (duration < 1) {
+    printf("Duration should be at least 1 second\r\n");
+    return 1;
+  }
+  int max = -1;
+  if (cmd_hidjitter_args.max->count == 1) {
+    max = cmd_hidjitter_args.max->ival[0];
+  }
+
+  printf("Measuring HID tick jitter for %d s (tick %d ms, task core %d, priority %d)\r\n",
+         duration, get_poll_interval(), CONFIG_NSG_HID_TASK_CORE_ID,
+         CONFIG_NSG_HID_TASK_PRIORITY);
+  printf("Generate network load (e.g. tools/loadgen) meanwhile to check jitter under traffic\r\n");
+  printf("or run nsg_loadgen --max-jitter, it measures the same histogram over /api/metrics\r\n");
+  hid_stats_t before = get_stats();
+  vTaskDelay(pdMS_TO_TICKS(duration * 1000));
+  hid_stats_t after = get_stats();
+
+  uint32_t ticks = 0;
+  uint32_t hist[HID_JITTER_BUCKETS_NUM];
+  for (int b = 0; b < HID_JITTER_BUCKETS_NUM; b++) {
+    hist[b] = after.tick_jitter_hist[b] - before.tick_jitter_hist[b];
+    ticks += hist[b];
+  }
+  if (ticks == 0) {
+    printf("No ticks measured\r\n");
+    return 1;
+  }
+  uint64_t sum = after.tick_jitter_sum_us - before.tick_jitter_sum_us;
+  printf("Ticks: %lu, mean jitter: %llu us\r\n", (unsigned long)ticks,
+         (unsigned long long)(sum / ticks));
+
+  // Histogram with cumulative percentage
+  uint32_t cumulative = 0;
+  for (int b = 0; b < HID_JITTER_BUCKETS_NUM; b++) {
+    cumulative += hist[b];
+    if (b < HID_JITTER_BUCKETS_NUM - 1) {
+      printf("  <= %5lu us: %8lu (%6.2f%%)\r\n", (unsigned long)jitter_buckets_us[b],
+             (unsigned long)hist[b], cumulative * 100.0 / ticks);
+    } else {
+      printf("   > %5lu us: %8lu (%6.2f%%)\r\n",
+             (unsigned long)jitter_buckets_us[HID_JITTER_BUCKETS_NUM - 2], (unsigned long)hist[b],
+             cumulative * 100.0 / ticks);
+    }
+  }
+  if (max < 0) {
+    return 0;
+  }
+
+  // p99 is the upper bound of the bucket reaching 99% of ticks, unbounded for the last one
+  cumulative = 0;
+  int p99 = 0;
+  for (; p99 < HID_JITTER_BUCKETS_NUM - 1; p99++) {
+    cumulative += hist[p99];
+    if (cumulative * 100ull >= ticks * 99ull) {
+      break;
+    }
+  }
+  if (p99 == HID_JITTER_BUCKETS_NUM - 1) {
+    printf("FAIL: p99 jitter > %lu us, bound %d us\r\n",
+           (unsigned long)jitter_buckets_us[HID_JITTER_BUCKETS_NUM - 2], max);
+    return 1;
+  }
+  bool pass = jitter_buckets_us[p99] <= (uint32_t)max;
+  printf("%s: p99 jitter <= %lu us, bound %d us\r\n", pass ? "PASS" : "FAIL",
+         (unsigned long)jitter_buckets_us[p99], max);
+  return pass ? 0 : 1;
+}
+
+// CMD: Get or set USB polling interval
+static struct {
+  struct arg_int* interval = arg_int0(NULL, NULL, "<ms>", "Polling interval, 1-255 ms");
+  struct arg_end* end = arg_end(2);
+} cmd_usbinterval_args;
+static int cmd_usbinterval(int argc, char** argv) {
+  // Check argument parse error
+  int nerrors = arg_parse(argc, argv, (void**)&cmd_usbinterval_args);
+  if (nerrors != 0) {
+    arg_print_errors(stderr, cmd_usbinterval_args.end, argv[0]);
+    return 1;
+  }
+
+  if (cmd_usbinterval_args.interval->count == 1) {
+    int interval = cmd_usbinterval_args.interval->ival[0];
+    if (interval < 1 || interval > 255) {
+      printf("Polling interval should be 1-255 ms\r\n");
+      return 1;
+    }
+    esp_err_t err = set_poll_interval(interval);
+    if (err != ESP_OK) {
+      printf("Failed to set polling interval: %s\r\n", esp_err_to_name(err));
+      return 1;
+    }
+    if (interval != get_poll_interval()) {
+      printf("Polling interval: %d ms (HID task re-enumerates device)\r\n", interval);
+      return 0;
+    }
+  }
+  printf("Polling interval: %d ms\r\n", get_poll_interval());
   return 0;
 }
 
@@ -311,23 +1120,63 @@ esp_err_t cmds_register() {
       .help = "Get USB status information",
       .hint = NULL,
       .func = &cmd_usbinfo,
+      .argtable = NULL,
   };
   ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_usbinfo_cfg));
 
+  const esp_console_cmd_t cmd_hidjitter_cfg = {
+      .command = "hidjitter",
+      .help = "Measure HID tick jitter, optionally check p99 against bound",
+      .hint = NULL,
+      .func = &cmd_hidjitter,
+      .argtable = &cmd_hidjitter_args,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_hidjitter_cfg));
+
+  const esp_console_cmd_t cmd_usbinterval_cfg = {
+      .command = "usbinterval",
+      .help = "Get or set USB polling interval (stored, device is re-enumerated)",
+      .hint = NULL,
+      .func = &cmd_usbinterval,
+      .argtable = &cmd_usbinterval_args,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_usbinterval_cfg));
+
   return ESP_OK;
 }
 
 // Set HID device report
 esp_err_t set_hid_report(hid_device_report_t report) {
   if (is_gamepad_connected()) {
+    uint32_t seq = 0;
     if (xSemaphoreTake(hid_report_state_mtx, portMAX_DELAY)) {
       hid_report_state = report;
+      seq = state_seq.fetch_add(1, std::memory_order_relaxed) + 1;
       xSemaphoreGive(hid_report_state_mtx);
     }
-    wait_hid_report();
+    int64_t wait_start = esp_timer_get_time();
+    bool delivered = wait_hid_report(seq);
+    uint32_t wait_time = esp_timer_get_time() - wait_start;
+    hid_stats.report_waits.fetch_add(1, std::memory_order_relaxed);
+    hid_stats.report_wait_sum_us.fetch_add(wait_time, std::memory_order_relaxed);
+    stats_max(hid_stats.report_wait_max_us, wait_time);
+    if (!delivered) {
+      hid_stats.report_wait_timeouts.fetch_add(1, std::memory_order_relaxed);
+      return ESP_ERR_TIMEOUT;
+    }
     return ESP_OK;
   }
   return ESP_ERR_INVALID_STATE;
 }
 
+// Get HID device report
+hid_device_report_t get_hid_report() {
+  hid_device_report_t report = {};
+  if (xSemaphoreTake(hid_report_state_mtx, portMAX_DELAY)) {
+    report = hid_report_state;
+    xSemaphoreGive(hid_report_state_mtx);
+  }
+  return report;
+}
+
 }  // namespace HID
\ No newline at end of file
@@ -10,10 +10,13 @@
  *
  * Main features of the HID component:
  *   - Initialization of TinyUSB with custom USB/HID descriptors
- *   - Background FreeRTOS task for HID state polling and report updates
+ *   - Background FreeRTOS task for HID state polling and report updates,
+ *     paced by high-resolution esp_timer
  *   - Support for 14 buttons, an 8-way D-Pad (hat switch), and 2 analog sticks
  *     (X/Y/Z/Rz axes, 8-bit each)
  *   - Console command registration for USB/HID diagnostics
+ *   - Optional CDC-ACM control channel (composite device)
+ *   - Optional Pro Controller personality (handshake, subcommands, 12-bit sticks)
  *   - Safe, blocking API for sending HID reports
  *   - Runtime state tracking: gamepad connection and USB status
  *
@@ -24,6 +27,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 #include "esp_err.h"
 
 namespace HID {
@@ -37,6 +43,15 @@ esp_err_t init_hid_task();
 // Register console commands
 esp_err_t cmds_register();
 
+// Get USB polling interval, ms (HID IN endpoint bInterval & HID task tick period)
+uint8_t get_poll_interval();
+
+// Set USB polling interval, ms (1-255)
+// Stores interval in NVS (unchanged interval isn't written) & posts it to HID task, which
+// changes tick period & re-enumerates device on its next tick, so host reads new bInterval.
+// Should be called from task context
+esp_err_t set_poll_interval(uint8_t interval_ms);
+
 #define ATTRIBUTE_PACKED  __attribute__((packed, aligned(1)))
 
 // HID device report
@@ -56,12 +71,99 @@ typedef struct ATTRIBUTE_PACKED {
 } hid_device_report_t;
 
 // Set HID device report
-// Thread-safe. Blocks until report is sended
+// Thread-safe. Blocks until report is delivered to host (IN transfer is completed)
+// Returns ESP_ERR_TIMEOUT, if report isn't delivered in 1 s (state stays pending)
 esp_err_t set_hid_report(hid_device_report_t report);
 
+// Get HID device report, which is currently sent to host
+// Thread-safe
+hid_device_report_t get_hid_report();
 
 // Get gamepad state
 // Thread-safe
 bool is_gamepad_connected();
 
+// Get gamepad connection number (incremented on every connection, 0 - not connected yet)
+// Gamepad is disconnected on USB suspend or unmount and is connected again after init sequence
+// (or handshake), input sent to previous connection may be lost. Thread-safe
+uint32_t get_connection_num();
+
+// Wait until gamepad is connected, UINT32_MAX - wait forever
+// Returns false on timeout. Thread-safe, should be called from task context
+bool wait_gamepad_connected(uint32_t timeout_ms);
+
+// Wait until next report is delivered to host (IN transfer is completed)
+// Used to align flash writes (cache is disabled) with gaps between HID ticks
+// Returns false on timeout. Thread-safe, should be called from task context
+bool wait_report_completed(uint32_t timeout_ms);
+
+// Request remote wakeup of suspended host (signaled by HID task, if host enabled it)
+// Returns false, if remote wakeup is disabled (NSG_HID_REMOTE_WAKEUP). Thread-safe
+bool request_remote_wakeup();
+
+// External report source, called by HID task on every tick with current time (us)
+// Returns true & fills report, if report should be replaced. Should not block
+typedef bool (*report_source_t)(int64_t now_us, hid_device_report_t* report);
+
+// Set external report source (NULL - no source)
+// Thread-safe
+void set_report_source(report_source_t source);
+
+// Delay current task with microsecond resolution (not rounded to FreeRTOS ticks)
+// Used for timed button holds. Thread-safe, should be called from task context
+void delay_us(uint32_t us);
+
+// Delay current task until absolute time of monotonic clock (esp_timer_get_time(), us)
+// Returns immediately, if time is already passed
+void delay_until_us(int64_t deadline_us);
+
+// HID timings after power on (us since start, 0 - not reached yet)
+typedef struct {
+  int64_t mounted_us;       // USB mounted by host
+  int64_t connected_us;     // Gamepad connected (init sequence is done)
+  int64_t first_report_us;  // First report sended after gamepad connection
+} hid_timings_t;
+
+// Get HID timings
+// Thread-safe
+hid_timings_t get_timings();
+
+// Tick jitter histogram buckets (upper bounds, us), last bucket is unbounded
+#define HID_JITTER_BUCKETS_NUM 10
+extern const uint32_t jitter_buckets_us[HID_JITTER_BUCKETS_NUM - 1];
+
+// HID statistics (counters since start)
+typedef struct {
+  uint32_t ticks_sent;            // Ticks with report submitted to IN endpoint
+  uint32_t ticks_skipped;         // Ticks without report (USB unmounted or suspended)
+  uint32_t ticks_missed;          // Timer ticks missed by HID task (task was busy)
+  uint64_t tick_jitter_sum_us;    // Sum of tick period deviations
+  uint32_t tick_jitter_max_us;    // Maximum tick period deviation
+  uint32_t tick_jitter_hist[HID_JITTER_BUCKETS_NUM];  // Tick period deviations histogram
+  uint32_t report_waits;          // Calls of set_hid_report() waited for report
+  uint64_t report_wait_sum_us;    // Sum of set_hid_report() wait times
+  uint32_t report_wait_max_us;    // Maximum set_hid_report() wait time
+  uint32_t report_wait_timeouts;  // set_hid_report() calls timed out
+  uint32_t reports_completed;     // Reports delivered to host (IN transfer completed)
+  uint32_t reports_dropped;       // Reports rejected by TinyUSB (kept pending)
+  uint32_t reports_retried;       // Ticks with busy IN endpoint (report kept pending)
+  uint32_t stalls;                // IN endpoint stalls (busy longer than stall threshold)
+  uint32_t remote_wakeups;        // Remote wakeup signals sent to suspended host
+} hid_stats_t;
+
+// Get HID statistics
+// Thread-safe, lock-free
+hid_stats_t get_stats();
+
+// CDC control channel receive callback
+// Called from TinyUSB task, so it should not block
+typedef void (*cdc_rx_cb_t)(const uint8_t* data, size_t len);
+
+// Set callback for data received over CDC control channel
+// Returns ESP_ERR_NOT_SUPPORTED, if CDC control channel is disabled
+esp_err_t cdc_set_rx_callback(cdc_rx_cb_t cb);
+
+// Write data to CDC control channel, returns number of queued bytes
+size_t cdc_write(const uint8_t* data, size_t len);
+
 }  // namespace HID
\ No newline at end of file
@@ -0,0 +1,367 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file pro_controller.cpp
+ * @brief Pro Controller protocol of the HID component
+ *
+ * USB handshake, subcommands & full mode input reports of Pro Controller.
+ * Report formats follow the publicly documented Joy-Con/Pro Controller protocol
+ * (dekuNukem/Nintendo_Switch_Reverse_Engineering).
+ *
+ * Author: Mark Vodyanitskiy (@mvodya)
+ * Copyright (c) 2025
+ * Contact: mvodya@icloud.com
+ */
+
+#include "pro_controller.hpp"
+
+#if CONFIG_NSG_HID_PERSONALITY_PRO_CONTROLLER
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "class/hid/hid_device.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+namespace HID::ProController {
+
+static const char* TAG = "app hid pro";
+
+// Report IDs
+#define PRO_INPUT_FULL 0x30     // Standard full mode input report
+#define PRO_INPUT_REPLY 0x21    // Subcommand reply
+#define PRO_INPUT_USB 0x81      // USB command reply
+#define PRO_OUTPUT_SUBCMD 0x01  // Rumble & subcommand
+#define PRO_OUTPUT_RUMBLE 0x10  // Rumble only
+#define PRO_OUTPUT_USB 0x80     // USB command
+
+// Report data size (without report ID)
+#define PRO_DATA_SIZE (PRO_REPORT_SIZE - 1)
+
+// Offsets in input report data
+#define PRO_STD_SIZE 12        // Timer, battery, buttons, sticks, vibrator
+#define PRO_REPLY_ACK 12       // Subcommand reply: ACK byte
+#define PRO_REPLY_SUBCMD 13    // Subcommand reply: subcommand ID
+#define PRO_REPLY_DATA 14      // Subcommand reply: data
+#define PRO_REPLY_DATA_MAX 35  // Subcommand reply: maximum data size
+
+// Battery full & charging, Pro Controller powered from USB
+#define PRO_BATTERY_CONNECTION 0x91
+// Vibrator input report
+#define PRO_VIBRATOR 0x80
+
+// Sticks: 12-bit center & range of calibration (both directions)
+#define PRO_STICK_CENTER 0x800
+#define PRO_STICK_RANGE 0x600
+
+// Queued reply
+typedef struct {
+  uint8_t report_id;
+  uint8_t data[PRO_DATA_SIZE];
+} reply_t;
+
+// Reply queue (filled by TinyUSB task, sent by HID task)
+#define PRO_REPLY_QUEUE_LEN 4
+static StaticQueue_t reply_queue_buf;
+static uint8_t reply_queue_storage[PRO_REPLY_QUEUE_LEN * sizeof(reply_t)];
+static QueueHandle_t reply_queue = NULL;
+
+// Host enabled input reports
+static std::atomic<bool> input_on = false;
+
+// Device MAC address (controller identity for host)
+static uint8_t mac[6] = {};
+
+// Standard part of input reports (HID task only)
+static uint8_t std_fields[PRO_STD_SIZE] = {};
+
+// Last sent input report with ID (GET_REPORT request)
+static uint8_t last_input[PRO_REPORT_SIZE] = {};
+static portMUX_TYPE last_input_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Virtual SPI flash region (read by host with subcommand 0x10)
+typedef struct {
+  uint32_t addr;
+  uint8_t len;
+  const uint8_t* data;
+} spi_region_t;
+
+// Factory IMU calibration: acc origin, acc sensitivity, gyro origin, gyro sensitivity
+static const uint8_t spi_imu_calibration[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40,
+                                              0x00, 0x40, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00,
+                                              0x00, 0x00, 0x3B, 0x34, 0x3B, 0x34, 0x3B, 0x34};
+
+// 12-bit pair (x, y) packing, as in sticks calibration & input reports
+#define PRO_PACK12(x, y) \
+  (uint8_t)((x) & 0xFF), (uint8_t)(((x) >> 8) | (((y) & 0x0F) << 4)), (uint8_t)((y) >> 4)
+
+// Factory sticks calibration
+// Left: max above center, center, min below center. Right: center, min below, max above
+static const uint8_t spi_stick_calibration[] = {
+    PRO_PACK12(PRO_STICK_RANGE, PRO_STICK_RANGE),
+    PRO_PACK12(PRO_STICK_CENTER, PRO_STICK_CENTER),
+    PRO_PACK12(PRO_STICK_RANGE, PRO_STICK_RANGE),
+    PRO_PACK12(PRO_STICK_CENTER, PRO_STICK_CENTER),
+    PRO_PACK12(PRO_STICK_RANGE, PRO_STICK_RANGE),
+    PRO_PACK12(PRO_STICK_RANGE, PRO_STICK_RANGE),
+};
+
+// Colors: body, buttons, left grip, right grip
+static const uint8_t spi_colors[] = {0x32, 0x32, 0x32, 0xFF, 0xFF, 0xFF,
+                                     0x32, 0x32, 0x32, 0x32, 0x32, 0x32};
+
+// Sticks parameters (dead zone & range ratio), same for both sticks
+static const uint8_t spi_stick_params[] = {0x0F, 0x30, 0x61, 0x96, 0x30, 0xF3, 0xD4, 0x14, 0x54,
+                                           0x41, 0x15, 0x54, 0xC7, 0x79, 0x9C, 0x33, 0x36, 0x63};
+
+// IMU horizontal offsets
+static const uint8_t spi_imu_offsets[] = {0x50, 0xFD, 0x00, 0x00, 0xC6, 0x0F};
+
+// Virtual SPI flash, not listed bytes are 0xFF (e.g. no user calibration at 0x8010)
+static const spi_region_t spi_regions[] = {
+    {0x6020, sizeof(spi_imu_calibration), spi_imu_calibration},
+    {0x603D, sizeof(spi_stick_calibration), spi_stick_calibration},
+    {0x6050, sizeof(spi_colors), spi_colors},
+    {0x6080, sizeof(spi_imu_offsets), spi_imu_offsets},
+    {0x6086, sizeof(spi_stick_params), spi_stick_params},
+    {0x6098, sizeof(spi_stick_params), spi_stick_params},
+};
+
+// Read virtual SPI flash
+static void spi_read(uint32_t addr, uint8_t* out, uint8_t len) {
+  memset(out, 0xFF, len);
+  for (const spi_region_t& r : spi_regions) {
+    for (uint8_t i = 0; i < len; i++) {
+      if (addr + i >= r.addr && addr + i < r.addr + r.len) out[i] = r.data[addr + i - r.addr];
+    }
+  }
+}
+
+// 12-bit stick axis from 8-bit axis offset (-128..127 from center)
+static inline uint16_t stick_axis(int offset) {
+  return PRO_STICK_CENTER + offset * PRO_STICK_RANGE / 0x80;
+}
+
+// Pack stick (x, y) to 3 bytes
+static inline void pack_stick(uint8_t* out, uint16_t x, uint16_t y) {
+  out[0] = x & 0xFF;
+  out[1] = (x >> 8) | ((y & 0x0F) << 4);
+  out[2] = y >> 4;
+}
+
+// Fill standard part of input report from gamepad state
+static void fill_std_fields(const hid_device_report_t* report) {
+  const uint16_t b = report->buttons;
+  auto bit = [b](int n, uint8_t mask) -> uint8_t { return (b >> n) & 1 ? mask : 0; };
+  // Gamepad button bits, as in HORI report: Y, B, A, X, L, R, ZL, ZR, Minus, Plus, LStick,
+  // RStick, Home, Capture
+  uint8_t right = bit(0, 0x01) | bit(3, 0x02) | bit(1, 0x04) | bit(2, 0x08) | bit(5, 0x40) |
+                  bit(7, 0x80);
+  uint8_t shared = bit(8, 0x01) | bit(9, 0x02) | bit(11, 0x04) | bit(10, 0x08) | bit(12, 0x10) |
+                   bit(13, 0x20);
+  uint8_t left = bit(4, 0x40) | bit(6, 0x80);
+
+  // Hat switch (0 - up, clockwise) to dpad buttons
+  const uint8_t d = report->dPad;
+  if (d <= 7) {
+    if (d == 7 || d <= 1) left |= 0x02;  // Up
+    if (d >= 1 && d <= 3) left |= 0x04;  // Right
+    if (d >= 3 && d <= 5) left |= 0x01;  // Down
+    if (d >= 5 && d <= 7) left |= 0x08;  // Left
+  }
+
+  std_fields[0]++;  // Timer
+  std_fields[1] = PRO_BATTERY_CONNECTION;
+  std_fields[2] = right;
+  std_fields[3] = shared;
+  std_fields[4] = left;
+  // Pro Controller Y axis grows up, HORI Y axis grows down
+  pack_stick(&std_fields[5], stick_axis(report->leftXAxis - 0x80),
+             stick_axis(0x80 - report->leftYAxis));
+  pack_stick(&std_fields[8], stick_axis(report->rightXAxis - 0x80),
+             stick_axis(0x80 - report->rightYAxis));
+  std_fields[11] = PRO_VIBRATOR;
+}
+
+// Create reply queue & read device MAC address
+esp_err_t init() {
+  reply_queue = xQueueCreateStatic(PRO_REPLY_QUEUE_LEN, sizeof(reply_t), reply_queue_storage,
+                                   &reply_queue_buf);
+  esp_efuse_mac_get_default(mac);
+
+  // Neutral state until first input report
+  hid_device_report_t neutral = {.buttons = 0,
+                                 .dPad = 0xF,
+                                 .leftXAxis = 0x80,
+                                 .leftYAxis = 0x80,
+                                 .rightXAxis = 0x80,
+                                 .rightYAxis = 0x80,
+                                 .filler = 0};
+  fill_std_fields(&neutral);
+  ESP_LOGI(TAG, "Pro Controller personality");
+  return ESP_OK;
+}
+
+// Host enabled input reports
+bool input_enabled() {
+  return input_on;
+}
+
+// Reset protocol state
+void reset() {
+  input_on = false;
+  if (reply_queue) xQueueReset(reply_queue);
+}
+
+// Reply to host request is queued
+bool reply_pending() {
+  return reply_queue && uxQueueMessagesWaiting(reply_queue) > 0;
+}
+
+// Send queued reply, if IN endpoint is ready
+bool send_reply() {
+  if (!reply_pending() || !tud_hid_ready()) return false;
+  reply_t reply;
+  if (xQueueReceive(reply_queue, &reply, 0) != pdTRUE) return false;
+  // Subcommand reply carries current input state
+  if (reply.report_id == PRO_INPUT_REPLY) {
+    std_fields[0]++;
+    memcpy(reply.data, std_fields, PRO_STD_SIZE);
+  }
+  return tud_hid_report(reply.report_id, reply.data, PRO_DATA_SIZE);
+}
+
+// Send standard full mode input report
+bool send_input(const hid_device_report_t* report) {
+  fill_std_fields(report);
+  uint8_t data[PRO_DATA_SIZE] = {};
+  memcpy(data, std_fields, PRO_STD_SIZE);
+  // IMU samples (3 x 12 bytes) stay zero, no motion sensors
+
+  taskENTER_CRITICAL(&last_input_mux);
+  last_input[0] = PRO_INPUT_FULL;
+  memcpy(&last_input[1], data, PRO_DATA_SIZE);
+  taskEXIT_CRITICAL(&last_input_mux);
+
+  return tud_hid_report(PRO_INPUT_FULL, data, PRO_DATA_SIZE);
+}
+
+// Queue reply, drops it if queue is full (host repeats requests)
+static void queue_reply(const reply_t& reply) {
+  if (xQueueSend(reply_queue, &reply, 0) != pdTRUE) {
+    ESP_LOGW(TAG, "Reply queue is full, reply 0x%02x dropped", reply.report_id);
+  }
+}
+
+// USB command (0x80 output report)
+static void usb_command(uint8_t cmd) {
+  reply_t reply = {.report_id = PRO_INPUT_USB, .data = {cmd}};
+  switch (cmd) {
+    case 0x01:  // Status: controller type & MAC address (little endian)
+      reply.data[2] = 0x03;
+      for (int i = 0; i < 6; i++) reply.data[3 + i] = mac[5 - i];
+      queue_reply(reply);
+      break;
+    case 0x02:  // Handshake
+    case 0x03:  // Baudrate
+      queue_reply(reply);
+      break;
+    case 0x04:  // USB only: start input reports, no reply
+      ESP_LOGI(TAG, "Handshake is done, input reports enabled");
+      input_on = true;
+      break;
+    case 0x05:  // Bluetooth allowed again: no reply
+      break;
+    default:
+      ESP_LOGD(TAG, "Unknown USB command 0x%02x", cmd);
+      break;
+  }
+}
+
+// Subcommand (0x01 output report)
+static void subcommand(uint8_t id, const uint8_t* args, uint16_t len) {
+  reply_t reply = {.report_id = PRO_INPUT_REPLY, .data = {}};
+  uint8_t* data = &reply.data[PRO_REPLY_DATA];
+  reply.data[PRO_REPLY_ACK] = 0x80;
+  reply.data[PRO_REPLY_SUBCMD] = id;
+
+  switch (id) {
+    case 0x02: {  // Device info: firmware, type, MAC (big endian), colors from SPI
+      const uint8_t info[] = {0x03, 0x48, 0x03, 0x02};
+      memcpy(data, info, sizeof(info));
+      memcpy(data + 4, mac, sizeof(mac));
+      data[10] = 0x01;
+      data[11] = 0x01;
+      reply.data[PRO_REPLY_ACK] = 0x82;
+      break;
+    }
+    case 0x03:  // Input report mode
+      if (len >= 1 && args[0] == PRO_INPUT_FULL) {
+        ESP_LOGI(TAG, "Full input report mode enabled");
+        input_on = true;
+      }
+      break;
+    case 0x04:  // Trigger buttons elapsed time
+      reply.data[PRO_REPLY_ACK] = 0x83;
+      break;
+    case 0x10: {  // SPI flash read: address (LE32), size
+      if (len < 5) return;
+      uint32_t addr = args[0] | (args[1] << 8) | (args[2] << 16) | ((uint32_t)args[3] << 24);
+      uint8_t size = std::min<uint8_t>(args[4], PRO_REPLY_DATA_MAX - 5);
+      memcpy(data, args, 4);
+      data[4] = size;
+      spi_read(addr, data + 5, size);
+      reply.data[PRO_REPLY_ACK] = 0x90;
+      break;
+    }
+    case 0x21: {  // NFC/IR MCU configuration
+      const uint8_t mcu[] = {0x01, 0x00, 0xFF, 0x00, 0x03, 0x00, 0x05, 0x01};
+      memcpy(data, mcu, sizeof(mcu));
+      reply.data[PRO_REPLY_ACK] = 0xA0;
+      break;
+    }
+    default:  // Player lights, IMU, vibration, etc: simple ACK
+      break;
+  }
+  queue_reply(reply);
+}
+
+// Handle output report
+void on_output_report(uint8_t report_id, const uint8_t* data, uint16_t len) {
+  // OUT endpoint data starts with report ID
+  if (report_id == 0) {
+    if (len == 0) return;
+    report_id = data[0];
+    data++;
+    len--;
+  }
+
+  switch (report_id) {
+    case PRO_OUTPUT_USB:
+      if (len >= 1) usb_command(data[0]);
+      break;
+    case PRO_OUTPUT_SUBCMD:
+      // Packet counter, rumble data (8 bytes), subcommand ID, arguments
+      if (len >= 10) subcommand(data[9], data + 10, len - 10);
+      break;
+    case PRO_OUTPUT_RUMBLE:  // No rumble motors
+    default:
+      break;
+  }
+}
+
+// Copy last sent input report
+uint16_t get_input_report(uint8_t* buffer, uint16_t len) {
+  uint16_t size = std::min<uint16_t>(len, PRO_REPORT_SIZE);
+  taskENTER_CRITICAL(&last_input_mux);
+  memcpy(buffer, last_input, size);
+  taskEXIT_CRITICAL(&last_input_mux);
+  return size;
+}
+
+}  // namespace HID::ProController
+
+#endif
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file pro_controller.hpp
+ * @brief Pro Controller protocol of the HID component (internal interface)
+ *
+ * Used by hid.cpp, when Pro Controller device personality is selected
+ * (NSG_HID_PERSONALITY_PRO_CONTROLLER). Implements USB handshake (0x80 commands),
+ * subcommands (0x01 output report, replied with 0x21 input report) and standard full mode
+ * input reports (0x30) with 12-bit sticks.
+ *
+ * Output reports are handled in TinyUSB task: replies are queued and sent by HID task
+ * before input reports, so report path never blocks on host requests.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "hid.hpp"
+
+namespace HID::ProController {
+
+// Input & output reports size (with report ID)
+#define PRO_REPORT_SIZE 64
+
+// Create reply queue & read device MAC address
+esp_err_t init();
+
+// Host enabled input reports (handshake or input report mode subcommand)
+bool input_enabled();
+
+// Reset protocol state (device is re-enumerated)
+void reset();
+
+// Reply to host request is queued
+bool reply_pending();
+
+// Send queued reply, if IN endpoint is ready
+// Called from HID task. Returns true, if reply is sent
+bool send_reply();
+
+// Send standard full mode input report (0x30) with gamepad state
+// Called from HID task, IN endpoint should be ready. Returns TinyUSB result
+bool send_input(const hid_device_report_t* report);
+
+// Handle output report (from OUT endpoint or SET_REPORT request)
+// Called from TinyUSB task, doesn't block
+void on_output_report(uint8_t report_id, const uint8_t* data, uint16_t len);
+
+// Copy last sent input report (GET_REPORT request), returns report size
+uint16_t get_input_report(uint8_t* buffer, uint16_t len);
+
+}  // namespace HID::ProController
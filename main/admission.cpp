@@ -0,0 +1,493 @@
+#include "admission.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "lwip/sockets.h"
+#include "meminfo.hpp"
+#include "tasks.hpp"
+
+namespace Admission {
+
+// Routes of non-control lanes, other routes are control lane
+static const struct {
+  const char* uri;
+  httpd_method_t method;
+  Lane lane;
+} routes[] = {
+    {"/api/stream", HTTP_GET, Stream},
+    {"/api/events", HTTP_GET, Stream},
+    {"/api/scripts", HTTP_POST, Bulk},
+    {"/api/scripts", HTTP_DELETE, Bulk},
+    {"/api/scripts/run", HTTP_POST, Bulk},
+    {"/api/ota", HTTP_POST, Bulk},
+    {"/api/click", HTTP_POST, Job},
+};
+
+// Get lane of route
+Lane classify(const char* uri, httpd_method_t method) {
+  for (const auto& r : routes) {
+    if (r.method == method && strcmp(r.uri, uri) == 0) return r.lane;
+  }
+  return Control;
+}
+
+// Get lane name
+const char* lane_name(Lane lane) {
+  switch (lane) {
+    case Control:
+      return "control";
+    case Bulk:
+      return "bulk";
+    case Job:
+      return "job";
+    case Stream:
+      return "stream";
+    default:
+      return "unknown";
+  }
+}
+
+#if CONFIG_NSG_WEB_ADMISSION
+
+static const char* TAG = "app admission";
+
+// Token bucket in millitokens, one request takes one token
+#define BUCKET_TOKEN 1000
+#define BUCKET_CAPACITY (CONFIG_NSG_WEB_RATE_LIMIT_BURST * BUCKET_TOKEN)
+
+// Retry-After of rejected bulk request (s)
+#define BULK_RETRY_AFTER_S 1
+
+// Idle sockets check period (us)
+#define SOCK_SWEEP_PERIOD_US 1000000
+#define SOCK_IDLE_US (CONFIG_NSG_HTTPD_IDLE_TIMEOUT_S * 1000000LL)
+
+// Client token bucket, used only from HTTP server task
+typedef struct {
+  uint8_t addr[16];  // IPv6 address (IPv4 is mapped)
+  bool used;
+  uint32_t tokens;  // Millitokens
+  int64_t last_us;  // Last refill & LRU time
+} client_t;
+
+static client_t clients[CONFIG_NSG_WEB_RATE_LIMIT_CLIENTS];
+
+// Socket of HTTP server, used only from HTTP server task (busy flag is cleared by bulk task)
+typedef struct {
+  int fd;
+  bool used;
+  Lane lane;               // Lane of last request
+  std::atomic<bool> busy;  // Bulk request is in progress
+  int64_t last_us;         // Last request time
+} sock_t;
+
+static sock_t socks[CONFIG_NSG_HTTPD_MAX_SOCKETS];
+
+static httpd_handle_t server = NULL;
+
+// Queued request of worker lane
+typedef struct {
+  httpd_req_t* req;  // Async copy of request
+  handler_t handler;
+  void* arg;
+  sock_t* sock;  // Socket of request
+} work_t;
+
+// Worker queue of lane
+typedef struct {
+  QueueHandle_t queue;
+  uint32_t size;                    // Limit of pending & running requests
+  std::atomic<uint32_t> depth;      // Pending & running requests
+  std::atomic<uint32_t> depth_max;  // Maximum of depth
+} work_queue_t;
+
+static uint8_t bulk_queue_storage[CONFIG_NSG_WEB_BULK_QUEUE_DEPTH * sizeof(work_t)];
+static StaticQueue_t bulk_queue_buf;
+static work_queue_t bulk_queue;
+
+// Each job request gets its own worker, so all of them reach job scheduler
+static uint8_t job_queue_storage[CONFIG_NSG_WEB_JOB_WORKERS * sizeof(work_t)];
+static StaticQueue_t job_queue_buf;
+static work_queue_t job_queue;
+
+// Statistics
+static std::atomic<uint32_t> admitted[LanesNum] = {};
+static std::atomic<uint32_t> rate_limited = 0;
+static std::atomic<uint32_t> queue_full = 0;
+static std::atomic<uint32_t> clients_num = 0;
+static std::atomic<uint32_t> sockets_open = 0;
+static std::atomic<uint32_t> sockets_max = 0;
+static std::atomic<uint32_t> sockets_full = 0;
+static std::atomic<uint32_t> idle_closed = 0;
+
+// Get client address of request (IPv4 is stored as IPv4-mapped IPv6)
+static bool client_addr(httpd_req_t* req, uint8_t addr[16]) {
+  struct sockaddr_storage sa;
+  socklen_t len = sizeof(sa);
+  if (getpeername(httpd_req_to_sockfd(req), (struct sockaddr*)&sa, &len) != 0) return false;
+
+  memset(addr, 0, 16);
+  if (sa.ss_family == AF_INET6) {
+    memcpy(addr, &((struct sockaddr_in6*)&sa)->sin6_addr, 16);
+  } else if (sa.ss_family == AF_INET) {
+    addr[10] = addr[11] = 0xFF;
+    memcpy(addr + 12, &((struct sockaddr_in*)&sa)->sin_addr, 4);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Find client bucket, unknown client replaces least recently seen client
+static client_t* find_client(const uint8_t addr[16], int64_t now) {
+  client_t* lru = &clients[0];
+  for (client_t& c : clients) {
+    if (c.used && memcmp(c.addr, addr, sizeof(c.addr)) == 0) return &c;
+    if (!c.used || (lru->used && c.last_us < lru->last_us)) lru = &c;
+  }
+
+  if (!lru->used) clients_num.fetch_add(1, std::memory_order_relaxed);
+  memcpy(lru->addr, addr, sizeof(lru->addr));
+  lru->used = true;
+  lru->tokens = BUCKET_CAPACITY;
+  lru->last_us = now;
+  return lru;
+}
+
+// Take token of client, returns 0 or seconds until next token
+static uint32_t take_token(httpd_req_t* req) {
+  uint8_t addr[16];
+  if (!client_addr(req, addr)) return 0;
+
+  int64_t now = esp_timer_get_time();
+  client_t* c = find_client(addr, now);
+  uint64_t refill = (uint64_t)(now - c->last_us) * CONFIG_NSG_WEB_RATE_LIMIT_RPS / 1000;
+  c->tokens = refill >= BUCKET_CAPACITY - c->tokens ? BUCKET_CAPACITY : c->tokens + refill;
+  c->last_us = now;
+
+  if (c->tokens >= BUCKET_TOKEN) {
+    c->tokens -= BUCKET_TOKEN;
+    return 0;
+  }
+  uint32_t wait_ms = (BUCKET_TOKEN - c->tokens + CONFIG_NSG_WEB_RATE_LIMIT_RPS - 1) /
+                     CONFIG_NSG_WEB_RATE_LIMIT_RPS;
+  return (wait_ms + 999) / 1000;
+}
+
+// Find socket slot
+static sock_t* find_sock(int fd) {
+  for (sock_t& s : socks) {
+    if (s.used && s.fd == fd) return &s;
+  }
+  return NULL;
+}
+
+// Socket is opened
+void on_sock_open(int sockfd) {
+  sock_t* s = NULL;
+  for (sock_t& slot : socks) {
+    if (!slot.used) {
+      s = &slot;
+      break;
+    }
+  }
+  if (!s) {
+    ESP_LOGW(TAG, "No slot for socket %d", sockfd);
+    return;
+  }
+  s->used = true;
+  s->fd = sockfd;
+  s->lane = Control;
+  s->busy = false;
+  s->last_us = esp_timer_get_time();
+
+  uint32_t open = sockets_open.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (open > sockets_max.load(std::memory_order_relaxed)) {
+    sockets_max.store(open, std::memory_order_relaxed);
+  }
+}
+
+// Socket is closed
+void on_sock_close(int sockfd) {
+  sock_t* s = find_sock(sockfd);
+  if (!s) return;
+  s->used = false;
+  sockets_open.fetch_sub(1, std::memory_order_relaxed);
+}
+
+#if CONFIG_NSG_HTTPD_IDLE_TIMEOUT_S
+static int64_t sweep_us = 0;  // Last idle sockets check, used only from web task
+
+// Close idle keep-alive sockets
+// Called from HTTP server task (see update())
+static void sweep_idle(void* arg) {
+  int64_t now = esp_timer_get_time();
+  for (sock_t& s : socks) {
+    if (!s.used) continue;
+    // Stream sockets are long-lived, bulk request holds socket till its end
+    if (s.lane == Stream || s.busy.load(std::memory_order_relaxed)) {
+      s.last_us = now;
+      continue;
+    }
+    if (now - s.last_us > SOCK_IDLE_US) {
+      ESP_LOGD(TAG, "Close idle socket %d", s.fd);
+      s.last_us = now;  // Closing is deferred, don't trigger it twice
+      idle_closed.fetch_add(1, std::memory_order_relaxed);
+      httpd_sess_trigger_close(server, s.fd);
+    }
+  }
+}
+#endif
+
+// Close idle sockets
+void update() {
+#if CONFIG_NSG_HTTPD_IDLE_TIMEOUT_S
+  int64_t now = esp_timer_get_time();
+  if (!server || now - sweep_us < SOCK_SWEEP_PERIOD_US) return;
+  sweep_us = now;
+  // Socket table belongs to HTTP server task
+  httpd_queue_work(server, sweep_idle, NULL);
+#endif
+}
+
+// Send rejection with Retry-After header
+static esp_err_t reject(httpd_req_t* req, const char* status, uint32_t retry_after_s,
+                        const char* message) {
+  char retry_after[12];
+  snprintf(retry_after, sizeof(retry_after), "%lu", (unsigned long)retry_after_s);
+  httpd_resp_set_status(req, status);
+  httpd_resp_set_hdr(req, "Retry-After", retry_after);
+  httpd_resp_sendstr(req, message);
+  return ESP_OK;
+}
+
+// Run queued requests of worker lane
+static void run_worker(work_queue_t& q) {
+  MemInfo::Scope mem_scope(MemInfo::Web);
+  work_t work;
+
+  while (1) {
+    xQueueReceive(q.queue, &work, portMAX_DELAY);
+    work.handler(work.req, work.arg);
+    if (work.sock) work.sock->busy.store(false, std::memory_order_relaxed);
+    httpd_req_async_handler_complete(work.req);
+    q.depth.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+// Task for bulk requests, runs below HTTP server priority
+static void bulk_task(void* arg) {
+  ESP_LOGI(TAG, "Bulk task %d runned", (int)(intptr_t)arg);
+  run_worker(bulk_queue);
+}
+
+// Task for job requests, waits for the controller outside of HTTP server task
+static void job_task(void* arg) {
+  ESP_LOGI(TAG, "Job task %d runned", (int)(intptr_t)arg);
+  run_worker(job_queue);
+}
+
+// Queue request to lane workers, returns false if queue is full
+static bool queue_work(work_queue_t& q, httpd_req_t* req, sock_t* sock, handler_t handler,
+                       void* arg) {
+  // Depth counts running request too, so queue is bounded by its size
+  uint32_t depth = q.depth.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (depth > q.size) {
+    q.depth.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  work_t work = {.req = NULL, .handler = handler, .arg = arg, .sock = sock};
+  if (sock) sock->busy.store(true, std::memory_order_relaxed);
+  if (httpd_req_async_handler_begin(req, &work.req) != ESP_OK) {
+    if (sock) sock->busy.store(false, std::memory_order_relaxed);
+    q.depth.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (xQueueSend(q.queue, &work, 0) != pdTRUE) {
+    if (sock) sock->busy.store(false, std::memory_order_relaxed);
+    httpd_req_async_handler_complete(work.req);
+    q.depth.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint32_t prev = q.depth_max.load(std::memory_order_relaxed);
+  while (depth > prev &&
+         !q.depth_max.compare_exchange_weak(prev, depth, std::memory_order_relaxed)) {
+  }
+  return true;
+}
+
+// Start worker tasks
+esp_err_t init(httpd_handle_t server_handle) {
+  ESP_LOGI(TAG, "Admission control, %d req/s per client (burst %d), bulk queue: %d, workers: %d",
+           CONFIG_NSG_WEB_RATE_LIMIT_RPS, CONFIG_NSG_WEB_RATE_LIMIT_BURST,
+           CONFIG_NSG_WEB_BULK_QUEUE_DEPTH, CONFIG_NSG_WEB_BULK_WORKERS);
+  MemInfo::add_static(MemInfo::Web, "admission",
+                      sizeof(clients) + sizeof(socks) + sizeof(bulk_queue_storage) +
+                          sizeof(job_queue_storage));
+  server = server_handle;
+  bulk_queue.size = CONFIG_NSG_WEB_BULK_QUEUE_DEPTH;
+  bulk_queue.queue = xQueueCreateStatic(CONFIG_NSG_WEB_BULK_QUEUE_DEPTH, sizeof(work_t),
+                                        bulk_queue_storage, &bulk_queue_buf);
+  job_queue.size = CONFIG_NSG_WEB_JOB_WORKERS;
+  job_queue.queue = xQueueCreateStatic(CONFIG_NSG_WEB_JOB_WORKERS, sizeof(work_t),
+                                       job_queue_storage, &job_queue_buf);
+  // Several workers run bulk jobs of different clients at once (see Jobs)
+  NSG_TASKS_CREATE(bulk_task, "bulk_task", CONFIG_NSG_WEB_BULK_WORKERS,
+                   CONFIG_NSG_BULK_TASK_STACK_SIZE, CONFIG_NSG_BULK_TASK_PRIORITY,
+                   CONFIG_NSG_BULK_TASK_CORE_ID);
+  NSG_TASKS_CREATE(job_task, "job_task", CONFIG_NSG_WEB_JOB_WORKERS,
+                   CONFIG_NSG_JOB_TASK_STACK_SIZE, CONFIG_NSG_JOB_TASK_PRIORITY,
+                   CONFIG_NSG_JOB_TASK_CORE_ID);
+  return ESP_OK;
+}
+
+// Admit request & run handler
+esp_err_t handle(httpd_req_t* req, Lane lane, handler_t handler, void* arg) {
+  if (lane == Stream) {
+    if (sock_t* sock = find_sock(httpd_req_to_sockfd(req))) sock->lane = Stream;
+    admitted[lane].fetch_add(1, std::memory_order_relaxed);
+    return handler(req, arg);
+  }
+
+  sock_t* sock = find_sock(httpd_req_to_sockfd(req));
+  if (sock) {
+    sock->lane = lane;
+    sock->last_us = esp_timer_get_time();
+  }
+
+  if (uint32_t retry_after_s = take_token(req)) {
+    rate_limited.fetch_add(1, std::memory_order_relaxed);
+    ESP_LOGD(TAG, "Request %s is rate limited", req->uri);
+    return reject(req, "429 Too Many Requests", retry_after_s, "Too many requests");
+  }
+
+  if (lane == Bulk) {
+    // Bulk requests hold sockets long, keep sockets reserve for controllers
+    if (sockets_open.load(std::memory_order_relaxed) >
+        CONFIG_NSG_HTTPD_MAX_SOCKETS - CONFIG_NSG_WEB_CONTROL_SOCKETS) {
+      sockets_full.fetch_add(1, std::memory_order_relaxed);
+      ESP_LOGW(TAG, "Too many connections, request %s is rejected", req->uri);
+      reject(req, "503 Service Unavailable", BULK_RETRY_AFTER_S, "Too many connections");
+      httpd_sess_trigger_close(req->handle, httpd_req_to_sockfd(req));
+      return ESP_OK;
+    }
+    if (!queue_work(bulk_queue, req, sock, handler, arg)) {
+      queue_full.fetch_add(1, std::memory_order_relaxed);
+      ESP_LOGW(TAG, "Bulk queue is full, request %s is rejected", req->uri);
+      return reject(req, "503 Service Unavailable", BULK_RETRY_AFTER_S, "Bulk queue is full");
+    }
+    admitted[lane].fetch_add(1, std::memory_order_relaxed);
+    return ESP_OK;
+  }
+
+  if (lane == Job) {
+    if (!queue_work(job_queue, req, sock, handler, arg)) {
+      queue_full.fetch_add(1, std::memory_order_relaxed);
+      ESP_LOGW(TAG, "All job workers are busy, request %s is rejected", req->uri);
+      return reject(req, "503 Service Unavailable", BULK_RETRY_AFTER_S, "Job queue is full");
+    }
+    admitted[lane].fetch_add(1, std::memory_order_relaxed);
+    return ESP_OK;
+  }
+
+  admitted[lane].fetch_add(1, std::memory_order_relaxed);
+  return handler(req, arg);
+}
+
+// Get admission statistics
+admission_stats_t get_stats() {
+  admission_stats_t s = {};
+  for (int l = 0; l < LanesNum; l++) {
+    s.admitted[l] = admitted[l].load(std::memory_order_relaxed);
+  }
+  s.rate_limited = rate_limited.load(std::memory_order_relaxed);
+  s.queue_full = queue_full.load(std::memory_order_relaxed);
+  s.queue_depth = bulk_queue.depth.load(std::memory_order_relaxed);
+  s.queue_depth_max = bulk_queue.depth_max.load(std::memory_order_relaxed);
+  s.jobs_running = job_queue.depth.load(std::memory_order_relaxed);
+  s.jobs_running_max = job_queue.depth_max.load(std::memory_order_relaxed);
+  s.clients = clients_num.load(std::memory_order_relaxed);
+  s.sockets = sockets_open.load(std::memory_order_relaxed);
+  s.sockets_max = sockets_max.load(std::memory_order_relaxed);
+  s.sockets_full = sockets_full.load(std::memory_order_relaxed);
+  s.idle_closed = idle_closed.load(std::memory_order_relaxed);
+  return s;
+}
+
+// CMD: Prints admission control information
+static int cmd_admission(int argc, char** argv) {
+  admission_stats_t s = get_stats();
+  printf("Admission control: %d req/s per client (burst %d), %lu clients tracked\r\n",
+         CONFIG_NSG_WEB_RATE_LIMIT_RPS, CONFIG_NSG_WEB_RATE_LIMIT_BURST,
+         (unsigned long)s.clients);
+  printf("  Admitted: control %lu, bulk %lu, job %lu, stream %lu\r\n",
+         (unsigned long)s.admitted[Control], (unsigned long)s.admitted[Bulk],
+         (unsigned long)s.admitted[Job], (unsigned long)s.admitted[Stream]);
+  printf("  Rejected: rate limit %lu, queue full %lu, sockets reserve %lu\r\n",
+         (unsigned long)s.rate_limited, (unsigned long)s.queue_full,
+         (unsigned long)s.sockets_full);
+  printf("  Bulk queue: %lu/%d (max %lu), %d workers\r\n", (unsigned long)s.queue_depth,
+         CONFIG_NSG_WEB_BULK_QUEUE_DEPTH, (unsigned long)s.queue_depth_max,
+         CONFIG_NSG_WEB_BULK_WORKERS);
+  printf("  Job workers: %lu/%d busy (max %lu)\r\n", (unsigned long)s.jobs_running,
+         CONFIG_NSG_WEB_JOB_WORKERS, (unsigned long)s.jobs_running_max);
+  printf("  Sockets: %lu/%d (max %lu), %d reserved for control, idle closed %lu\r\n",
+         (unsigned long)s.sockets, CONFIG_NSG_HTTPD_MAX_SOCKETS, (unsigned long)s.sockets_max,
+         CONFIG_NSG_WEB_CONTROL_SOCKETS, (unsigned long)s.idle_closed);
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_admission_cfg = {
+      .command = "admission",
+      .help = "Get admission control information",
+      .hint = NULL,
+      .func = &cmd_admission,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_admission_cfg));
+
+  return ESP_OK;
+}
+
+#else
+
+// Admission control is disabled, all requests run in HTTP server task
+esp_err_t init(httpd_handle_t server) {
+  return ESP_OK;
+}
+
+void on_sock_open(int sockfd) {}
+
+void on_sock_close(int sockfd) {}
+
+void update() {}
+
+esp_err_t handle(httpd_req_t* req, Lane lane, handler_t handler, void* arg) {
+  return handler(req, arg);
+}
+
+// Get admission statistics
+admission_stats_t get_stats() {
+  return {};
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  return ESP_OK;
+}
+
+#endif
+
+}  // namespace Admission
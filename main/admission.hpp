@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+// Admission control of API requests
+// Requests are split into lanes: control requests are handled by HTTP server task, bulk requests
+// (script upload, run & delete, OTA image) are handed over to bulk task through bounded queue,
+// job requests (clicks) wait for the controller in job workers.
+// Each client (IP address) is limited by token bucket. Sockets of HTTP server are tracked: idle
+// keep-alive sockets are closed & bulk requests can't take sockets reserved for control traffic
+namespace Admission {
+
+// Request lanes
+enum Lane : uint8_t {
+  Control,  // Input, clock sync & status, handled in HTTP server task
+  Bulk,     // Long uploads & jobs, queued to bulk task
+  Job,      // Input jobs, wait for the controller in job worker
+  Stream,   // Long-lived connections (WebSocket frames, events), not limited
+  LanesNum
+};
+
+// Admission statistics
+typedef struct {
+  uint32_t admitted[LanesNum];  // Admitted requests by lane
+  uint32_t rate_limited;        // Rejected by client token bucket (429)
+  uint32_t queue_full;          // Rejected by full bulk queue or busy job workers (503)
+  uint32_t queue_depth;         // Pending & running bulk requests
+  uint32_t queue_depth_max;     // Maximum of bulk queue depth
+  uint32_t jobs_running;        // Job requests in workers
+  uint32_t jobs_running_max;    // Maximum of job requests in workers
+  uint32_t clients;             // Tracked clients
+  uint32_t sockets;             // Open sockets
+  uint32_t sockets_max;         // Maximum of open sockets
+  uint32_t sockets_full;        // Bulk requests rejected by control sockets reserve (503)
+  uint32_t idle_closed;         // Idle sockets closed
+} admission_stats_t;
+
+// Request handler with argument
+typedef esp_err_t (*handler_t)(httpd_req_t* req, void* arg);
+
+// Start worker tasks
+esp_err_t init(httpd_handle_t server);
+
+// Socket is opened
+// Called from HTTP server task
+void on_sock_open(int sockfd);
+
+// Socket is closed
+// Called from HTTP server task
+void on_sock_close(int sockfd);
+
+// Close idle sockets
+void update();
+
+// Get lane of route
+Lane classify(const char* uri, httpd_method_t method);
+
+// Get lane name
+const char* lane_name(Lane lane);
+
+// Admit request & run handler
+// Control & stream requests run in calling task, bulk & job requests are queued to workers.
+// Rejected request gets 429 or 503 response with Retry-After header
+// Called from HTTP server task
+esp_err_t handle(httpd_req_t* req, Lane lane, handler_t handler, void* arg);
+
+// Get admission statistics
+// Thread-safe
+admission_stats_t get_stats();
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace Admission
@@ -0,0 +1,120 @@
+#include "alloc_guard.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+#include "esp_attr.h"
+#include "esp_console.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "json_pool.hpp"
+#include "meminfo.hpp"
+
+namespace AllocGuard {
+
+static const char* TAG = "app alloc";
+
+// Watched tasks names, HID task is first
+static const char* task_names[ALLOC_GUARD_TASKS_NUM] = {"app_hid_task", "httpd", "web_task",
+                                                        "events_task", "other"};
+
+// Counters, updated from heap hooks
+static TaskHandle_t task_handles[ALLOC_GUARD_TASKS_NUM - 1] = {};
+static std::atomic<uint32_t> task_allocs[ALLOC_GUARD_TASKS_NUM] = {};
+static std::atomic<uint32_t> task_bytes[ALLOC_GUARD_TASKS_NUM] = {};
+static volatile bool armed = false;
+
+#if (CONFIG_NSG_STATIC_ALLOCATION || CONFIG_NSG_MEMINFO_ACCOUNTING) && CONFIG_HEAP_USE_HOOKS
+
+// Heap allocation hook
+// Called for every allocation, may be called with flash cache disabled, so it should be in IRAM
+extern "C" IRAM_ATTR void esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+  if (!ptr) return;
+#if CONFIG_NSG_MEMINFO_ACCOUNTING
+  MemInfo::on_alloc(size);
+#endif
+
+#if CONFIG_NSG_STATIC_ALLOCATION
+  if (!armed) return;
+
+  TaskHandle_t current = xTaskGetCurrentTaskHandle();
+  int t = 0;
+  while (t < ALLOC_GUARD_TASKS_NUM - 1 && task_handles[t] != current) t++;
+  task_allocs[t].fetch_add(1, std::memory_order_relaxed);
+  task_bytes[t].fetch_add(size, std::memory_order_relaxed);
+
+#if CONFIG_NSG_STATIC_ALLOCATION_ASSERT
+  // HID task should never use heap after boot
+  if (t == 0) abort();
+#endif
+#endif
+}
+
+// Heap free hook
+extern "C" IRAM_ATTR void esp_heap_trace_free_hook(void* ptr) {
+#if CONFIG_NSG_MEMINFO_ACCOUNTING
+  if (ptr) MemInfo::on_free();
+#endif
+}
+
+#endif
+
+// Start counting heap allocations
+void arm() {
+  for (int t = 0; t < ALLOC_GUARD_TASKS_NUM - 1; t++) {
+    task_handles[t] = xTaskGetHandle(task_names[t]);
+  }
+  armed = true;
+#if CONFIG_NSG_STATIC_ALLOCATION && CONFIG_HEAP_USE_HOOKS
+  ESP_LOGI(TAG, "Boot finished, heap allocations are counted from now");
+#endif
+}
+
+// Get heap allocations after boot for watched tasks
+void get_stats(task_allocs_t stats[ALLOC_GUARD_TASKS_NUM]) {
+  for (int t = 0; t < ALLOC_GUARD_TASKS_NUM; t++) {
+    stats[t].task = task_names[t];
+    stats[t].allocs = task_allocs[t].load(std::memory_order_relaxed);
+    stats[t].bytes = task_bytes[t].load(std::memory_order_relaxed);
+  }
+}
+
+// CMD: Prints heap allocations after boot
+static int cmd_allocinfo(int argc, char** argv) {
+#if CONFIG_NSG_STATIC_ALLOCATION && CONFIG_HEAP_USE_HOOKS
+  task_allocs_t stats[ALLOC_GUARD_TASKS_NUM];
+  get_stats(stats);
+  printf("Heap allocations after boot%s:\r\n", armed ? "" : " (boot is not finished)");
+  for (const task_allocs_t& s : stats) {
+    printf("  %-14s %8lu allocs, %10lu bytes\r\n", s.task, (unsigned long)s.allocs,
+           (unsigned long)s.bytes);
+  }
+
+  JsonPool::pool_stats_t pool = JsonPool::get_stats();
+  printf("JSON pool: %u/%u bytes max used, exhausted: %lu, outside of scope: %lu\r\n",
+         pool.max_used, pool.size, (unsigned long)pool.exhausted, (unsigned long)pool.outside);
+#else
+  printf("Static allocation mode is disabled\r\n");
+#endif
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_allocinfo_cfg = {
+      .command = "allocinfo",
+      .help = "Get heap allocations after boot",
+      .hint = NULL,
+      .func = &cmd_allocinfo,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_allocinfo_cfg));
+
+  return ESP_OK;
+}
+
+}  // namespace AllocGuard
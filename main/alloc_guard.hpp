@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+namespace AllocGuard {
+
+// Watched tasks, last entry accounts all other tasks
+#define ALLOC_GUARD_TASKS_NUM 5
+
+// Heap allocations after boot of one task
+typedef struct {
+  const char* task;  // Task name
+  uint32_t allocs;   // Number of allocations
+  uint32_t bytes;    // Allocated bytes
+} task_allocs_t;
+
+// Start counting heap allocations (boot is finished)
+void arm();
+
+// Get heap allocations after boot for watched tasks
+void get_stats(task_allocs_t stats[ALLOC_GUARD_TASKS_NUM]);
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace AllocGuard
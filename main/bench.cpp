@@ -0,0 +1,228 @@
+#include "bench.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include "argtable3/argtable3.h"
+#include "cJSON.h"
+#include "esp_console.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/idf_additions.h"
+#include "hid.hpp"
+#include "json_pool.hpp"
+#include "nsgamepad.hpp"
+
+namespace Bench {
+
+static const char* TAG = "app bench";
+
+// Iterations of CPU-bound benchmarks
+#define BENCH_CPU_ITERATIONS 1000
+
+// Tasks with measured stack headroom
+static const char* stack_tasks[] = {"app_hid_task", "web_task", "httpd", "events_task",
+                                    "console_repl"};
+
+// Sample JSON request (as /api/click body)
+static const char* sample_json = "{\"buttons\":[\"A\",\"B\",\"ZL\",\"Home\"],\"delay\":100}";
+
+// Latency samples summary
+typedef struct {
+  uint32_t count;
+  int64_t min_us;
+  int64_t max_us;
+  int64_t sum_us;
+} samples_t;
+
+// Add latency sample
+static void samples_add(samples_t& s, int64_t us) {
+  if (s.count == 0 || us < s.min_us) s.min_us = us;
+  if (us > s.max_us) s.max_us = us;
+  s.sum_us += us;
+  s.count++;
+}
+
+// Average of samples
+static int64_t samples_avg(const samples_t& s) {
+  return s.count ? s.sum_us / s.count : 0;
+}
+
+// Print latency samples line
+static void samples_print(const char* name, const samples_t& s) {
+  if (s.count == 0) {
+    printf("  %-18s %s\r\n", name, "skipped");
+    return;
+  }
+  printf("  %-18s avg %6lld us, min %6lld us, max %6lld us (%lu runs)\r\n", name, samples_avg(s),
+         s.min_us, s.max_us, (unsigned long)s.count);
+}
+
+// Measure set_hid_report round trip (report is delivered to host)
+static samples_t bench_report_rt(int iterations) {
+  samples_t s = {};
+  HID::hid_device_report_t report = HID::get_hid_report();
+  for (int i = 0; i < iterations; i++) {
+    int64_t start = esp_timer_get_time();
+    if (HID::set_hid_report(report) != ESP_OK) break;
+    samples_add(s, esp_timer_get_time() - start);
+  }
+  return s;
+}
+
+// Measure NSGamepad::update() latency
+static samples_t bench_update(int iterations) {
+  samples_t s = {};
+  if (!HID::is_gamepad_connected()) return s;
+  for (int i = 0; i < iterations; i++) {
+    int64_t start = esp_timer_get_time();
+    NSGamepad::update();
+    samples_add(s, esp_timer_get_time() - start);
+  }
+  return s;
+}
+
+// Measure button name lookup (ns per lookup)
+static uint32_t bench_lookup() {
+  static const char* names[] = {"Y", "A", "ZR", "Home", "Capture", "Unknown"};
+  const int names_num = sizeof(names) / sizeof(names[0]);
+  uint32_t found = 0;
+
+  int64_t start = esp_timer_get_time();
+  for (int i = 0; i < BENCH_CPU_ITERATIONS; i++) {
+    NSGamepad::Buttons b;
+    found += NSGamepad::findButton(names[i % names_num], &b);
+  }
+  int64_t elapsed = esp_timer_get_time() - start;
+  ESP_LOGD(TAG, "Buttons found: %lu", (unsigned long)found);
+  return elapsed * 1000 / BENCH_CPU_ITERATIONS;
+}
+
+// Measure JSON parse & print of API request (us per request)
+static samples_t bench_json() {
+  samples_t s = {};
+  char out[128];
+  size_t len = strlen(sample_json);
+  for (int i = 0; i < BENCH_CPU_ITERATIONS / 10; i++) {
+    int64_t start = esp_timer_get_time();
+    {
+      JsonPool::Scope json_scope;
+      cJSON* root = cJSON_ParseWithLength(sample_json, len);
+      if (!root) break;
+      cJSON_PrintPreallocated(root, out, sizeof(out), false);
+      cJSON_Delete(root);
+    }
+    samples_add(s, esp_timer_get_time() - start);
+  }
+  return s;
+}
+
+// CMD: Run on-device benchmarks
+static struct {
+  struct arg_int* iterations =
+      arg_int0("n", "iterations", "<n>", "Report round trip iterations, default = 100");
+  struct arg_int* time = arg_int0("t", "time", "<s>", "Report rate measure duration, default = 5");
+  struct arg_end* end = arg_end(2);
+} cmd_bench_args;
+static int cmd_bench(int argc, char** argv) {
+  // Check argument parse error
+  int nerrors = arg_parse(argc, argv, (void**)&cmd_bench_args);
+  if (nerrors != 0) {
+    arg_print_errors(stderr, cmd_bench_args.end, argv[0]);
+    return 1;
+  }
+
+  int iterations = 100;
+  if (cmd_bench_args.iterations->count == 1) {
+    iterations = cmd_bench_args.iterations->ival[0];
+  }
+  int duration = 5;
+  if (cmd_bench_args.time->count == 1) {
+    duration = cmd_bench_args.time->ival[0];
+  }
+  if (iterations < 1 || duration < 1) {
+    printf("Iterations & duration should be positive\r\n");
+    return 1;
+  }
+
+  bool connected = HID::is_gamepad_connected();
+  printf("Benchmark (gamepad %s, tick %d ms)\r\n", connected ? "connected" : "not connected",
+         HID::get_poll_interval());
+
+  // Latencies
+  samples_t rt = bench_report_rt(iterations);
+  samples_t upd = bench_update(iterations);
+  uint32_t lookup_ns = bench_lookup();
+  samples_t json = bench_json();
+
+  // Achieved report rate
+  HID::hid_stats_t before = HID::get_stats();
+  int64_t rate_start = esp_timer_get_time();
+  vTaskDelay(pdMS_TO_TICKS(duration * 1000));
+  HID::hid_stats_t after = HID::get_stats();
+  int64_t rate_elapsed = esp_timer_get_time() - rate_start;
+  uint32_t reports = after.reports_completed - before.reports_completed;
+  uint32_t missed = after.ticks_missed - before.ticks_missed;
+  uint32_t rate_mhz = (uint64_t)reports * 1000000000ULL / rate_elapsed;
+
+  // Headroom
+  size_t heap_free = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+  size_t heap_min = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+  size_t heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+
+  // Summary
+  samples_print("Report round trip", rt);
+  samples_print("Gamepad update", upd);
+  printf("  %-18s %lu ns\r\n", "Button lookup", (unsigned long)lookup_ns);
+  samples_print("JSON request", json);
+  printf("  %-18s %lu.%03lu Hz (%lu reports, %lu missed ticks in %d s)\r\n", "Report rate",
+         (unsigned long)(rate_mhz / 1000), (unsigned long)(rate_mhz % 1000),
+         (unsigned long)reports, (unsigned long)missed, duration);
+  printf("  %-18s free %u, min free %u, largest block %u\r\n", "Heap", heap_free, heap_min,
+         heap_largest);
+  for (const char* name : stack_tasks) {
+    TaskHandle_t task = xTaskGetHandle(name);
+    if (task) {
+      printf("  Stack %-12s %u bytes free min\r\n", name, uxTaskGetStackHighWaterMark(task));
+    }
+  }
+
+  // Machine-readable line (one line, collected from UART)
+  printf("BENCH {\"connected\":%s,\"tick_ms\":%d,\"rt_avg_us\":%lld,\"rt_max_us\":%lld,"
+         "\"update_avg_us\":%lld,\"update_max_us\":%lld,\"lookup_ns\":%lu,\"json_avg_us\":%lld,"
+         "\"json_max_us\":%lld,\"rate_mhz\":%lu,\"missed\":%lu,\"heap_free\":%u,"
+         "\"heap_min\":%u,\"heap_largest\":%u,\"stack\":{",
+         connected ? "true" : "false", HID::get_poll_interval(), samples_avg(rt), rt.max_us,
+         samples_avg(upd), upd.max_us, (unsigned long)lookup_ns, samples_avg(json), json.max_us,
+         (unsigned long)rate_mhz, (unsigned long)missed, heap_free, heap_min, heap_largest);
+  const char* sep = "";
+  for (const char* name : stack_tasks) {
+    TaskHandle_t task = xTaskGetHandle(name);
+    if (task) {
+      printf("%s\"%s\":%u", sep, name, uxTaskGetStackHighWaterMark(task));
+      sep = ",";
+    }
+  }
+  printf("}}\r\n");
+
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_bench_cfg = {
+      .command = "bench",
+      .help = "Run on-device benchmarks (report latency & rate, lookup, JSON, headroom)",
+      .hint = NULL,
+      .func = &cmd_bench,
+      .argtable = &cmd_bench_args,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_bench_cfg));
+
+  return ESP_OK;
+}
+
+}  // namespace Bench
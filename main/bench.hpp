@@ -0,0 +1,10 @@
+#pragma once
+
+#include "esp_err.h"
+
+namespace Bench {
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace Bench
@@ -0,0 +1,89 @@
+#include "boot.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+#include "alloc_guard.hpp"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "hid.hpp"
+
+namespace Boot {
+
+static const char* TAG = "app boot";
+
+// Phases string list
+static const char* phase_names[] = {"NVS ready",      "WiFi started",    "USB installed",
+                                    "HID task runned", "Console ready",  "WEB server ready",
+                                    "WiFi connected"};
+static_assert(sizeof(phase_names) / sizeof(phase_names[0]) == PhasesNum);
+
+// Phases timestamps (us since start)
+static std::atomic<int64_t> phase_time[PhasesNum] = {};
+static std::atomic<bool> boot_finished = false;
+
+// Is boot finished? WiFi connection is not required, it may never happen
+static bool is_boot_finished() {
+  for (int p = 0; p <= WebServerReady; p++) {
+    if (phase_time[p] == 0) return false;
+  }
+  return true;
+}
+
+// Record timestamp of boot phase
+void mark(Phase phase) {
+  int64_t expected = 0;
+  int64_t now = esp_timer_get_time();
+  if (phase_time[phase].compare_exchange_strong(expected, now)) {
+    ESP_LOGI(TAG, "Boot phase \"%s\" at %lld us", phase_names[phase], now);
+    if (is_boot_finished() && !boot_finished.exchange(true)) {
+      AllocGuard::arm();
+    }
+  }
+}
+
+// Get timestamp of boot phase
+int64_t get(Phase phase) {
+  return phase_time[phase];
+}
+
+// Print timestamp line
+static void print_time(const char* name, int64_t time) {
+  if (time > 0) {
+    printf("  %-20s %8lld.%03lld ms\r\n", name, time / 1000, time % 1000);
+  } else {
+    printf("  %-20s %12s\r\n", name, "-");
+  }
+}
+
+// CMD: Prints boot timestamps
+static int cmd_bootinfo(int argc, char** argv) {
+  printf("Boot phases (since start):\r\n");
+  for (int p = 0; p < PhasesNum; p++) {
+    print_time(phase_names[p], get(static_cast<Phase>(p)));
+  }
+
+  HID::hid_timings_t hid = HID::get_timings();
+  print_time("USB mounted", hid.mounted_us);
+  print_time("Gamepad connected", hid.connected_us);
+  print_time("First report", hid.first_report_us);
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_bootinfo_cfg = {
+      .command = "bootinfo",
+      .help = "Get boot phases timestamps",
+      .hint = NULL,
+      .func = &cmd_bootinfo,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_bootinfo_cfg));
+
+  return ESP_OK;
+}
+
+}  // namespace Boot
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+namespace Boot {
+
+// Boot phases
+enum Phase : uint8_t {
+  NvsReady = 0,   // NVS initialized
+  WifiStarted,    // WiFi driver started, connection in progress
+  UsbInstalled,   // TinyUSB driver installed
+  HidTaskRunned,  // HID handler task created
+  ConsoleReady,   // Console REPL started
+  WebServerReady, // HTTP server started
+  WifiConnected,  // Got IP from AP
+  PhasesNum
+};
+
+// Record timestamp of boot phase (only first call for each phase is recorded)
+// Boot is finished, when all phases except WiFi connection are reached
+// Thread-safe
+void mark(Phase phase);
+
+// Get timestamp of boot phase in microseconds since start, 0 - not reached yet
+int64_t get(Phase phase);
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace Boot
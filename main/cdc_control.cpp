@@ -0,0 +1,303 @@
+#include "cdc_control.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#include "cdc_protocol.hpp"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/stream_buffer.h"
+#include "hid.hpp"
+#include "jobs.hpp"
+#include "meminfo.hpp"
+#include "nsgamepad.hpp"
+#include "script_store.hpp"
+#include "tasks.hpp"
+
+namespace CdcControl {
+
+#if CONFIG_NSG_HID_CDC_CONTROL
+
+static const char* TAG = "app cdc";
+
+static_assert(sizeof(HID::hid_device_report_t) == CDC_REPORT_SIZE);
+
+// Received bytes, filled from TinyUSB task
+static uint8_t rx_stream_storage[2048];
+static StaticStreamBuffer_t rx_stream_buf;
+static StreamBufferHandle_t rx_stream;
+
+// Frames parser & response buffer (used by CDC task only)
+static CdcProtocol::Parser parser;
+static uint8_t tx_buf[CDC_FRAME_PAYLOAD_MAX + CDC_FRAME_OVERHEAD];
+
+// Uploaded script (sequence of steps)
+static uint8_t script[CONFIG_NSG_CDC_SCRIPT_SIZE];
+static size_t script_len = 0;
+
+// Statistics
+static std::atomic<uint32_t> frames_num = 0;
+static std::atomic<uint32_t> rx_dropped = 0;
+
+// Receive callback, called from TinyUSB task
+static void on_receive(const uint8_t* data, size_t len) {
+  size_t sent = xStreamBufferSend(rx_stream, data, len, 0);
+  if (sent < len) {
+    rx_dropped.fetch_add(len - sent, std::memory_order_relaxed);
+  }
+}
+
+// Send response frame
+static void respond(uint8_t type, CdcProtocol::Status status, const uint8_t* data = NULL,
+                    uint16_t len = 0) {
+  static uint8_t payload[CDC_FRAME_PAYLOAD_MAX];
+  payload[0] = status;
+  if (len > sizeof(payload) - 1) len = sizeof(payload) - 1;
+  if (len) memcpy(payload + 1, data, len);
+  size_t frame_len =
+      CdcProtocol::encode(type | CdcProtocol::Response, payload, len + 1, tx_buf, sizeof(tx_buf));
+  HID::cdc_write(tx_buf, frame_len);
+}
+
+// Maximum lead time of scheduled batch
+#define CDC_SCHEDULE_HORIZON_US (60 * 1000 * 1000)
+
+// Execute steps (batch or script), first step starts at given device time (0 - immediately)
+static CdcProtocol::Status run_steps(const uint8_t* data, size_t len, uint16_t repeat,
+                                     int64_t at = 0) {
+  if (len % CDC_STEP_SIZE != 0) return CdcProtocol::BadPayload;
+  if (at - esp_timer_get_time() > CDC_SCHEDULE_HORIZON_US) return CdcProtocol::BadPayload;
+
+  // Job waits for its turn (scheduled batch goes first in its time)
+  size_t steps = len / CDC_STEP_SIZE;
+  uint64_t duration_us = 0;
+  for (size_t i = 0; i < steps; i++) {
+    duration_us += CdcProtocol::decode_step(data + i * CDC_STEP_SIZE).hold_us;
+  }
+  // Progress & expected start saturate for very long batches
+  size_t total = steps * repeat;
+  uint64_t duration_ms = duration_us * repeat / 1000;
+  Jobs::Job job;
+  if (job.begin(JOBS_CLIENT_CDC, total > UINT16_MAX ? UINT16_MAX : total,
+                duration_ms > UINT32_MAX ? UINT32_MAX : duration_ms, at) != ESP_OK) {
+    return CdcProtocol::NoSpace;
+  }
+
+  if (at != 0) {
+    if (esp_timer_get_time() > at) {
+      ESP_LOGW(TAG, "Scheduled batch is late by %lld us", esp_timer_get_time() - at);
+    }
+    HID::delay_until_us(at);
+  }
+
+  // Job pauses while gamepad is disconnected (also at start) & resumes from interrupted step
+  for (uint16_t r = 0; r < repeat; r++) {
+    for (size_t i = 0; i < steps; i++) {
+      CdcProtocol::step_t step = CdcProtocol::decode_step(data + i * CDC_STEP_SIZE);
+      HID::hid_device_report_t report;
+      memcpy(&report, step.report, sizeof(report));
+      if (NSGamepad::hold(report, step.hold_us) != ESP_OK) return CdcProtocol::NotReady;
+      job.step();
+    }
+  }
+  job.end();
+  return CdcProtocol::Ok;
+}
+
+// Convert script store error into response status
+static CdcProtocol::Status store_status(esp_err_t err) {
+  switch (err) {
+    case ESP_OK:
+      return CdcProtocol::Ok;
+    case ESP_ERR_NOT_FOUND:
+      return CdcProtocol::NotFound;
+    case ESP_ERR_NO_MEM:
+      return CdcProtocol::NoSpace;
+    case ESP_ERR_INVALID_STATE:
+    case ESP_ERR_TIMEOUT:
+      return CdcProtocol::NotReady;
+    case ESP_ERR_NOT_SUPPORTED:
+      return CdcProtocol::UnknownType;
+    default:
+      return CdcProtocol::BadPayload;
+  }
+}
+
+// Handle received frame
+static void handle_frame(const CdcProtocol::frame_t& frame, int64_t received_us) {
+  frames_num.fetch_add(1, std::memory_order_relaxed);
+
+  switch (frame.type) {
+    case CdcProtocol::Ping:
+      respond(frame.type, CdcProtocol::Ok, frame.payload, frame.len);
+      break;
+
+    case CdcProtocol::State: {
+      if (frame.len != CDC_REPORT_SIZE) {
+        respond(frame.type, CdcProtocol::BadPayload);
+        break;
+      }
+      HID::hid_device_report_t report;
+      memcpy(&report, frame.payload, sizeof(report));
+      NSGamepad::setReport(report, true);
+      respond(frame.type, CdcProtocol::Ok);
+      break;
+    }
+
+    case CdcProtocol::Batch:
+      respond(frame.type, run_steps(frame.payload, frame.len, 1));
+      break;
+
+    case CdcProtocol::TimeSync: {
+      if (frame.len != 8) {
+        respond(frame.type, CdcProtocol::BadPayload);
+        break;
+      }
+      uint8_t times[24];
+      memcpy(times, frame.payload, 8);
+      CdcProtocol::put_u64(times + 8, received_us);
+      CdcProtocol::put_u64(times + 16, esp_timer_get_time());
+      respond(frame.type, CdcProtocol::Ok, times, sizeof(times));
+      break;
+    }
+
+    case CdcProtocol::BatchAt:
+      if (frame.len < 8) {
+        respond(frame.type, CdcProtocol::BadPayload);
+        break;
+      }
+      respond(frame.type, run_steps(frame.payload + 8, frame.len - 8, 1,
+                                    CdcProtocol::get_u64(frame.payload)));
+      break;
+
+    case CdcProtocol::ScriptBegin:
+      script_len = 0;
+      respond(frame.type, CdcProtocol::Ok);
+      break;
+
+    case CdcProtocol::ScriptChunk:
+      if (script_len + frame.len > sizeof(script)) {
+        respond(frame.type, CdcProtocol::NoSpace);
+        break;
+      }
+      memcpy(script + script_len, frame.payload, frame.len);
+      script_len += frame.len;
+      respond(frame.type, CdcProtocol::Ok);
+      break;
+
+    case CdcProtocol::ScriptRun: {
+      if (frame.len != 2) {
+        respond(frame.type, CdcProtocol::BadPayload);
+        break;
+      }
+      uint16_t repeat = frame.payload[0] | frame.payload[1] << 8;
+      respond(frame.type, run_steps(script, script_len, repeat));
+      break;
+    }
+
+    case CdcProtocol::ScriptSave: {
+      char name[SCRIPT_NAME_MAX];
+      if (frame.len == 0 || frame.len >= sizeof(name)) {
+        respond(frame.type, CdcProtocol::BadPayload);
+        break;
+      }
+      memcpy(name, frame.payload, frame.len);
+      name[frame.len] = '\0';
+      uint8_t id = 0;
+      CdcProtocol::Status status = store_status(ScriptStore::save(name, script, script_len, &id));
+      respond(frame.type, status, &id, status == CdcProtocol::Ok ? 1 : 0);
+      break;
+    }
+
+    case CdcProtocol::ScriptStored: {
+      if (frame.len != 3) {
+        respond(frame.type, CdcProtocol::BadPayload);
+        break;
+      }
+      uint16_t repeat = frame.payload[0] | frame.payload[1] << 8;
+      esp_err_t err = ScriptStore::run(frame.payload[2], repeat, JOBS_CLIENT_CDC);
+      respond(frame.type, store_status(err));
+      break;
+    }
+
+    default:
+      respond(frame.type, CdcProtocol::UnknownType);
+      break;
+  }
+}
+
+// Task for CDC control channel
+static void cdc_task(void*) {
+  ESP_LOGI(TAG, "CDC control task runned");
+  MemInfo::Scope mem_scope(MemInfo::Gamepad);
+  uint8_t buf[64];
+
+  while (1) {
+    size_t len = xStreamBufferReceive(rx_stream, buf, sizeof(buf), portMAX_DELAY);
+    int64_t received_us = esp_timer_get_time();
+    for (size_t i = 0; i < len; i++) {
+      if (parser.feed(buf[i])) {
+        handle_frame(parser.frame(), received_us);
+      }
+    }
+  }
+}
+
+// Run CDC control channel task
+esp_err_t init() {
+  ESP_LOGI(TAG, "CDC control channel initialization");
+  MemInfo::Scope mem_scope(MemInfo::Gamepad);
+  MemInfo::add_static(MemInfo::Gamepad, "cdc",
+                      sizeof(rx_stream_storage) + sizeof(parser) + sizeof(tx_buf) + sizeof(script));
+  rx_stream = xStreamBufferCreateStatic(sizeof(rx_stream_storage) - 1, 1, rx_stream_storage,
+                                        &rx_stream_buf);
+  NSG_TASK_CREATE(cdc_task, "cdc_task", CONFIG_NSG_CDC_TASK_STACK_SIZE,
+                  CONFIG_NSG_CDC_TASK_PRIORITY, CONFIG_NSG_CDC_TASK_CORE_ID);
+  return HID::cdc_set_rx_callback(on_receive);
+}
+
+// CMD: Prints CDC control channel information
+static int cmd_cdcinfo(int argc, char** argv) {
+  printf("CDC control channel:\r\n");
+  printf("  Frames: %lu, broken: %lu, dropped bytes: %lu\r\n",
+         (unsigned long)frames_num.load(), (unsigned long)parser.errors(),
+         (unsigned long)rx_dropped.load());
+  printf("  Script: %u/%u bytes (%u steps)\r\n", (unsigned)script_len, (unsigned)sizeof(script),
+         (unsigned)(script_len / CDC_STEP_SIZE));
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_cdcinfo_cfg = {
+      .command = "cdcinfo",
+      .help = "Get CDC control channel information",
+      .hint = NULL,
+      .func = &cmd_cdcinfo,
+      .argtable = NULL,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_cdcinfo_cfg));
+
+  return ESP_OK;
+}
+
+#else
+
+// CDC control channel is disabled
+esp_err_t init() {
+  return ESP_OK;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  return ESP_OK;
+}
+
+#endif
+
+}  // namespace CdcControl
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "esp_err.h"
+
+namespace CdcControl {
+
+// Run CDC control channel task (if CDC control channel is enabled)
+// Should be called after HID initialization
+esp_err_t init();
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace CdcControl
@@ -0,0 +1,102 @@
+#include "cdc_protocol.hpp"
+
+#include <cstring>
+
+namespace CdcProtocol {
+
+// Calculate CRC-8 (poly 0x07)
+uint8_t crc8(const uint8_t* data, size_t len, uint8_t crc) {
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++) {
+      crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+// Encode frame into buffer
+size_t encode(uint8_t type, const uint8_t* payload, uint16_t len, uint8_t* out, size_t size) {
+  if (len > CDC_FRAME_PAYLOAD_MAX || size < (size_t)len + CDC_FRAME_OVERHEAD) return 0;
+  out[0] = CDC_FRAME_MAGIC;
+  out[1] = type;
+  out[2] = len & 0xFF;
+  out[3] = len >> 8;
+  if (len) memcpy(out + 4, payload, len);
+  out[4 + len] = crc8(out + 1, len + 3);
+  return len + CDC_FRAME_OVERHEAD;
+}
+
+// Decode step from payload
+step_t decode_step(const uint8_t* data) {
+  step_t step;
+  memcpy(step.report, data, CDC_REPORT_SIZE);
+  const uint8_t* hold = data + CDC_REPORT_SIZE;
+  step.hold_us = hold[0] | (uint32_t)hold[1] << 8 | (uint32_t)hold[2] << 16 |
+                 (uint32_t)hold[3] << 24;
+  return step;
+}
+
+// Read 64-bit little endian value
+uint64_t get_u64(const uint8_t* data) {
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; i--) value = value << 8 | data[i];
+  return value;
+}
+
+// Write 64-bit little endian value
+void put_u64(uint8_t* data, uint64_t value) {
+  for (int i = 0; i < 8; i++, value >>= 8) data[i] = value & 0xFF;
+}
+
+// Feed byte into parser
+bool Parser::feed(uint8_t byte) {
+  switch (state_) {
+    case Magic:
+      if (byte == CDC_FRAME_MAGIC) state_ = Type;
+      return false;
+
+    case Type:
+      frame_.type = byte;
+      crc_ = crc8(&byte, 1);
+      state_ = LenLo;
+      return false;
+
+    case LenLo:
+      frame_.len = byte;
+      crc_ = crc8(&byte, 1, crc_);
+      state_ = LenHi;
+      return false;
+
+    case LenHi:
+      frame_.len |= (uint16_t)byte << 8;
+      crc_ = crc8(&byte, 1, crc_);
+      if (frame_.len > CDC_FRAME_PAYLOAD_MAX) {
+        errors_++;
+        state_ = Magic;
+        return false;
+      }
+      received_ = 0;
+      state_ = frame_.len ? Payload : Crc;
+      return false;
+
+    case Payload:
+      frame_.payload[received_++] = byte;
+      if (received_ == frame_.len) {
+        crc_ = crc8(frame_.payload, frame_.len, crc_);
+        state_ = Crc;
+      }
+      return false;
+
+    case Crc:
+      state_ = Magic;
+      if (byte != crc_) {
+        errors_++;
+        return false;
+      }
+      return true;
+  }
+  return false;
+}
+
+}  // namespace CdcProtocol
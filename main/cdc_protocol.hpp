@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Binary protocol of CDC control channel
+// Doesn't depend on ESP-IDF, so it can be built on host with stand-in for USB stack
+//
+// Frame: | 0xA5 | type (1) | length (2, LE) | payload (length) | crc8 (1) |
+// CRC-8 (poly 0x07, init 0x00) covers type, length & payload
+//
+// Requests (response type is request type | 0x80, first payload byte is status):
+//   Ping         any payload, echoed back after status
+//   State        gamepad report (8 bytes), applied immediately
+//   Batch        steps (12 bytes each), executed sequentially, response after last step
+//   ScriptBegin  empty, clears script buffer
+//   ScriptChunk  steps, appended to script buffer
+//   ScriptRun    repeat count (2, LE), script is executed like batch
+//   TimeSync     client time t0 (8, LE), response: t0 (8) | t1, frame received (8) | t2, sent (8)
+//                t1 & t2 are device monotonic clock, us (all values LE)
+//   BatchAt      device time, us (8, LE) | steps, batch starts at given time
+//   ScriptSave   script name, script buffer is saved into flash script store,
+//                response: stored script id (1)
+//   ScriptStored repeat count (2, LE) | stored script id (1), script is executed from flash
+//
+// Step: | report (8) | hold time, us (4, LE) |
+// Report: | buttons (2, LE) | dpad (1) | lx (1) | ly (1) | rx (1) | ry (1) | filler (1) |
+namespace CdcProtocol {
+
+#define CDC_FRAME_MAGIC 0xA5
+#define CDC_FRAME_PAYLOAD_MAX 1020
+#define CDC_FRAME_OVERHEAD 5
+#define CDC_REPORT_SIZE 8
+#define CDC_STEP_SIZE 12
+
+// Frame types
+enum FrameType : uint8_t {
+  Ping = 0x01,
+  State = 0x02,
+  Batch = 0x03,
+  ScriptBegin = 0x04,
+  ScriptChunk = 0x05,
+  ScriptRun = 0x06,
+  TimeSync = 0x07,
+  BatchAt = 0x08,
+  ScriptSave = 0x09,
+  ScriptStored = 0x0A,
+  Response = 0x80  // Flag of response frame
+};
+
+// Response status
+enum Status : uint8_t {
+  Ok = 0,
+  BadPayload,   // Wrong payload length or values
+  UnknownType,  // Unsupported frame type
+  NoSpace,      // Script buffer or job queue is full
+  NotReady,     // Gamepad isn't reconnected during resume timeout (job is aborted) or script runs
+  NotFound,     // Stored script is not found
+};
+
+// Decoded frame
+typedef struct {
+  uint8_t type;
+  uint16_t len;
+  uint8_t payload[CDC_FRAME_PAYLOAD_MAX];
+} frame_t;
+
+// Input sequence step
+typedef struct {
+  uint8_t report[CDC_REPORT_SIZE];
+  uint32_t hold_us;
+} step_t;
+
+// Calculate CRC-8 (poly 0x07)
+uint8_t crc8(const uint8_t* data, size_t len, uint8_t crc = 0);
+
+// Encode frame into buffer, returns frame length (0 - buffer is too small)
+size_t encode(uint8_t type, const uint8_t* payload, uint16_t len, uint8_t* out, size_t size);
+
+// Decode step from payload
+step_t decode_step(const uint8_t* data);
+
+// Read & write 64-bit little endian value
+uint64_t get_u64(const uint8_t* data);
+void put_u64(uint8_t* data, uint64_t value);
+
+// Stream parser
+// Bytes are fed one by one, broken frames are skipped until next magic byte
+class Parser {
+ public:
+  // Feed byte, returns true when frame is complete
+  // Frame is valid until next feed() call
+  bool feed(uint8_t byte);
+
+  // Last complete frame
+  const frame_t& frame() const { return frame_; }
+
+  // Number of broken frames (CRC mismatch or too long)
+  uint32_t errors() const { return errors_; }
+
+ private:
+  enum ParserState : uint8_t { Magic, Type, LenLo, LenHi, Payload, Crc };
+
+  ParserState state_ = Magic;
+  frame_t frame_ = {};
+  uint16_t received_ = 0;
+  uint8_t crc_ = 0;
+  uint32_t errors_ = 0;
+};
+
+}  // namespace CdcProtocol
@@ -0,0 +1,702 @@
+#include "jobs.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
+#include "meminfo.hpp"
+#include "metrics.hpp"
+#include "nsgamepad.hpp"
+
+namespace Jobs {
+
+static const char* TAG = "app jobs";
+
+// Identifier of the next job (job progress of gamepad uses the same identifiers)
+static std::atomic<uint32_t> next_id = 1;
+
+// Get client name of API request (IP address)
+void client_name(httpd_req_t* req, char* name, size_t len) {
+  strlcpy(name, "unknown", len);
+  struct sockaddr_storage sa;
+  socklen_t sa_len = sizeof(sa);
+  if (getpeername(httpd_req_to_sockfd(req), (struct sockaddr*)&sa, &sa_len) != 0) return;
+
+  if (sa.ss_family == AF_INET6) {
+    // IPv4-mapped address is shown as IPv4
+    static const uint8_t mapped[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+    const uint8_t* addr = (const uint8_t*)&((struct sockaddr_in6*)&sa)->sin6_addr;
+    if (memcmp(addr, mapped, sizeof(mapped)) == 0) {
+      inet_ntop(AF_INET, addr + sizeof(mapped), name, len);
+    } else {
+      inet_ntop(AF_INET6, addr, name, len);
+    }
+  } else if (sa.ss_family == AF_INET) {
+    inet_ntop(AF_INET, &((struct sockaddr_in*)&sa)->sin_addr, name, len);
+  }
+}
+
+#if CONFIG_NSG_JOB_SCHEDULER
+
+// Time slice of client, waiting client preempts running one, when it's behind by slice
+// Scheduled jobs become ready one slice before their time
+#define QUANTUM_US (CONFIG_NSG_JOB_QUANTUM_MS * 1000LL)
+
+// Job state
+enum State : uint8_t {
+  Free,       // Slot isn't used
+  Waiting,    // Job waits for the first step
+  Running,    // Job owns the controller
+  Preempted,  // Job yielded the controller between steps & waits for its turn
+};
+
+// Scheduler client
+typedef struct {
+  char name[JOBS_CLIENT_NAME_MAX];
+  uint8_t weight;
+  uint8_t jobs;        // Queued & running jobs
+  uint32_t completed;  // Finished jobs
+  int64_t vtime_us;    // Controller time divided by weight
+  int64_t last_us;     // Last job time (LRU)
+} client_t;
+
+// Scheduler slot of job
+typedef struct {
+  State state;
+  uint8_t client;
+  uint16_t steps;
+  uint16_t step;
+  uint32_t id;
+  int64_t duration_us;    // Estimated duration of all steps
+  int64_t start_us;       // Scheduled time (0 - as soon as possible)
+  int64_t queued_us;      // Time of begin()
+  int64_t started_us;     // Time of the first step (0 - not started)
+  int64_t charged_us;     // Controller time is charged to client until this time
+  bool resumed;           // Job was preempted, saved state is restored on its turn
+  NSGamepad::job_progress_t progress;  // Progress of preempted job
+  HID::hid_device_report_t report;     // Gamepad state of preempted job
+  SemaphoreHandle_t turn;              // Given, when job gets the controller
+} slot_t;
+
+static client_t clients[CONFIG_NSG_JOB_CLIENTS];
+static slot_t slots[CONFIG_NSG_JOB_QUEUE_DEPTH];
+static StaticSemaphore_t turn_bufs[CONFIG_NSG_JOB_QUEUE_DEPTH];
+
+// Slot of job, which owns the controller (-1 - controller is free)
+static int running = -1;
+
+static SemaphoreHandle_t jobs_mtx = NULL;
+static StaticSemaphore_t jobs_mtx_buf;
+
+// Statistics
+static std::atomic<uint32_t> completed = 0;
+static std::atomic<uint32_t> preempted = 0;
+static std::atomic<uint32_t> rejected = 0;
+static std::atomic<uint32_t> wait_max_ms = 0;
+
+// Released gamepad, set while preempted job is away
+static const HID::hid_device_report_t neutral_report = {
+    .buttons = 0x0,
+    .dPad = 0xF,
+    .leftXAxis = 0x80,
+    .leftYAxis = 0x80,
+    .rightXAxis = 0x80,
+    .rightYAxis = 0x80,
+    .filler = 0,
+};
+
+// Scheduled job in its time
+static bool is_urgent(const slot_t& s, int64_t now) {
+  return s.start_us != 0 && s.start_us - QUANTUM_US <= now;
+}
+
+// Job can get the controller
+static bool is_ready(const slot_t& s, int64_t now) {
+  return (s.state == Waiting || s.state == Preempted) && (s.start_us == 0 || is_urgent(s, now));
+}
+
+// Job goes before other job: scheduled jobs in their time by time, then jobs of the least served
+// client, then the oldest job (jobs of one client keep their order)
+static bool is_before(const slot_t& a, const slot_t& b, int64_t now) {
+  bool urgent_a = is_urgent(a, now);
+  bool urgent_b = is_urgent(b, now);
+  if (urgent_a != urgent_b) return urgent_a;
+  if (urgent_a && a.start_us != b.start_us) return a.start_us < b.start_us;
+  int64_t vtime_a = clients[a.client].vtime_us;
+  int64_t vtime_b = clients[b.client].vtime_us;
+  if (vtime_a != vtime_b) return vtime_a < vtime_b;
+  return a.id < b.id;
+}
+
+// Find the next job (-1 - no ready jobs)
+static int pick(int64_t now) {
+  int next = -1;
+  for (int i = 0; i < CONFIG_NSG_JOB_QUEUE_DEPTH; i++) {
+    if (!is_ready(slots[i], now)) continue;
+    if (next < 0 || is_before(slots[i], slots[next], now)) next = i;
+  }
+  return next;
+}
+
+// Waiting job preempts running job: scheduled job in its time or job of client, which is behind
+// running client by time slice. Scheduled jobs are not preempted
+static bool preempts(const slot_t& next, const slot_t& run, int64_t now) {
+  if (run.start_us != 0 || next.client == run.client) return false;
+  if (is_urgent(next, now)) return true;
+  return clients[next.client].vtime_us + QUANTUM_US <= clients[run.client].vtime_us;
+}
+
+// Charge controller time of running job to its client
+static void charge(int64_t now) {
+  if (running < 0) return;
+  slot_t& s = slots[running];
+  client_t& c = clients[s.client];
+  c.vtime_us += (now - s.charged_us) / c.weight;
+  s.charged_us = now;
+}
+
+// Pass the controller to job
+static void dispatch(int slot, int64_t now) {
+  slot_t& s = slots[slot];
+  s.state = Running;
+  s.charged_us = now;
+  running = slot;
+
+  if (s.started_us == 0) {
+    // Scheduled job waits from the time, when it becomes ready
+    s.started_us = now;
+    uint32_t wait_ms = (now - std::max<int64_t>(s.queued_us, s.start_us - QUANTUM_US)) / 1000;
+    uint32_t prev = wait_max_ms.load(std::memory_order_relaxed);
+    while (wait_ms > prev &&
+           !wait_max_ms.compare_exchange_weak(prev, wait_ms, std::memory_order_relaxed)) {
+    }
+  }
+  xSemaphoreGive(s.turn);
+}
+
+// Least weighted time of clients with jobs
+static bool min_vtime(int64_t* vtime) {
+  bool found = false;
+  for (const client_t& c : clients) {
+    if (c.jobs == 0) continue;
+    if (!found || c.vtime_us < *vtime) *vtime = c.vtime_us;
+    found = true;
+  }
+  return found;
+}
+
+// Find client by name (-1 - not found)
+static int find_client(const char* name) {
+  for (int i = 0; i < CONFIG_NSG_JOB_CLIENTS; i++) {
+    if (clients[i].name[0] && strcmp(clients[i].name, name) == 0) return i;
+  }
+  return -1;
+}
+
+// Find or add client, unknown client replaces least recently seen client without jobs
+// Returns -1, if all clients have jobs
+static int add_client(const char* name, int64_t now) {
+  int found = find_client(name);
+  if (found >= 0) return found;
+
+  int lru = -1;
+  for (int i = 0; i < CONFIG_NSG_JOB_CLIENTS; i++) {
+    if (clients[i].jobs > 0) continue;
+    if (lru < 0 || !clients[i].name[0] ||
+        (clients[lru].name[0] && clients[i].last_us < clients[lru].last_us)) {
+      lru = i;
+    }
+  }
+  if (lru < 0) return -1;
+
+  client_t& c = clients[lru];
+  memset(&c, 0, sizeof(c));
+  strlcpy(c.name, name, sizeof(c.name));
+  c.weight = 1;
+  c.last_us = now;
+  return lru;
+}
+
+// Wait until job gets the controller
+static void wait_turn(int slot) {
+  slot_t& s = slots[slot];
+  while (1) {
+    xSemaphoreTake(jobs_mtx, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    if (running < 0) {
+      int next = pick(now);
+      if (next >= 0) dispatch(next, now);
+    }
+    bool turn = s.state == Running;
+    // Scheduled job wakes up by itself in its time, when the controller is free
+    TickType_t ticks = portMAX_DELAY;
+    if (!turn && s.start_us != 0 && !is_urgent(s, now)) {
+      ticks = pdMS_TO_TICKS((uint32_t)((s.start_us - QUANTUM_US - now) / 1000)) + 1;
+    }
+    xSemaphoreGive(jobs_mtx);
+
+    if (turn) return;
+    xSemaphoreTake(s.turn, ticks);
+  }
+}
+
+// Take the controller: start job or restore state of preempted job
+static void take_controller(slot_t& s) {
+  if (!s.resumed) {
+    NSGamepad::jobBegin(s.id, s.steps);
+    return;
+  }
+  ESP_LOGI(TAG, "Job %lu resumed at step %u/%u", (unsigned long)s.id, s.step, s.steps);
+  NSGamepad::jobRestore(s.progress);
+  NSGamepad::setReport(s.report, true);
+}
+
+// Queue job & wait for its turn
+esp_err_t Job::begin(const char* client, uint16_t steps, uint32_t duration_ms, int64_t start_us) {
+  if (slot_ >= 0) end();
+
+  xSemaphoreTake(jobs_mtx, portMAX_DELAY);
+  int64_t now = esp_timer_get_time();
+  int c = add_client(client, now);
+  int slot = -1;
+  for (int i = 0; i < CONFIG_NSG_JOB_QUEUE_DEPTH && slot < 0; i++) {
+    if (slots[i].state == Free) slot = i;
+  }
+  if (c < 0 || slot < 0) {
+    xSemaphoreGive(jobs_mtx);
+    rejected.fetch_add(1, std::memory_order_relaxed);
+    ESP_LOGW(TAG, "Job queue is full, job of %s is rejected", client);
+    return ESP_ERR_NO_MEM;
+  }
+
+  // Client with new jobs keeps neither credit nor debt of idle time, it goes one time slice
+  // before the least served client, so its first job preempts running job at the next step
+  client_t& cl = clients[c];
+  int64_t vtime;
+  if (cl.jobs == 0 && min_vtime(&vtime)) cl.vtime_us = vtime - QUANTUM_US;
+  cl.jobs++;
+  cl.last_us = now;
+
+  slot_t& s = slots[slot];
+  s.state = Waiting;
+  s.client = c;
+  s.steps = steps;
+  s.step = 0;
+  s.id = next_id.fetch_add(1, std::memory_order_relaxed);
+  s.duration_us = (int64_t)duration_ms * 1000;
+  s.start_us = start_us;
+  s.queued_us = now;
+  s.started_us = 0;
+  s.resumed = false;
+  xSemaphoreTake(s.turn, 0);
+  slot_ = slot;
+  xSemaphoreGive(jobs_mtx);
+
+  wait_turn(slot);
+  take_controller(s);
+  return ESP_OK;
+}
+
+// Mark one step as completed, yield the controller to waiting job
+void Job::step() {
+  if (slot_ < 0) return;
+  NSGamepad::jobStep();
+  slot_t& s = slots[slot_];
+
+  xSemaphoreTake(jobs_mtx, portMAX_DELAY);
+  int64_t now = esp_timer_get_time();
+  if (s.step < s.steps) s.step++;
+  charge(now);
+  int next = pick(now);
+  bool yield = next >= 0 && preempts(slots[next], s, now);
+  if (yield) {
+    s.progress = NSGamepad::jobProgress();
+    s.report = NSGamepad::getReport();
+    s.resumed = true;
+  }
+  xSemaphoreGive(jobs_mtx);
+  if (!yield) return;
+
+  // Release gamepad before the next job gets the controller
+  ESP_LOGI(TAG, "Job %lu preempted at step %u/%u", (unsigned long)s.id, s.step, s.steps);
+  preempted.fetch_add(1, std::memory_order_relaxed);
+  NSGamepad::setReport(neutral_report, true);
+
+  xSemaphoreTake(jobs_mtx, portMAX_DELAY);
+  now = esp_timer_get_time();
+  charge(now);
+  s.state = Preempted;
+  running = -1;
+  next = pick(now);
+  if (next >= 0) dispatch(next, now);
+  xSemaphoreGive(jobs_mtx);
+
+  wait_turn(slot_);
+  take_controller(s);
+}
+
+// Finish job & pass the controller to the next job
+void Job::end() {
+  if (slot_ < 0) return;
+  NSGamepad::jobEnd();
+
+  xSemaphoreTake(jobs_mtx, portMAX_DELAY);
+  int64_t now = esp_timer_get_time();
+  slot_t& s = slots[slot_];
+  if (running == slot_) {
+    charge(now);
+    running = -1;
+  }
+  client_t& c = clients[s.client];
+  c.jobs--;
+  c.completed++;
+  c.last_us = now;
+  s.state = Free;
+  int next = pick(now);
+  if (next >= 0) dispatch(next, now);
+  xSemaphoreGive(jobs_mtx);
+
+  completed.fetch_add(1, std::memory_order_relaxed);
+  slot_ = -1;
+}
+
+Job::~Job() {
+  end();
+}
+
+// Setup scheduler
+esp_err_t init() {
+  ESP_LOGI(TAG, "Job scheduler, queue: %d, clients: %d, time slice: %d ms",
+           CONFIG_NSG_JOB_QUEUE_DEPTH, CONFIG_NSG_JOB_CLIENTS, CONFIG_NSG_JOB_QUANTUM_MS);
+  MemInfo::add_static(MemInfo::Gamepad, "jobs",
+                      sizeof(clients) + sizeof(slots) + sizeof(turn_bufs));
+  jobs_mtx = xSemaphoreCreateMutexStatic(&jobs_mtx_buf);
+  for (int i = 0; i < CONFIG_NSG_JOB_QUEUE_DEPTH; i++) {
+    slots[i].turn = xSemaphoreCreateBinaryStatic(&turn_bufs[i]);
+  }
+  return ESP_OK;
+}
+
+// Set client weight
+esp_err_t set_weight(const char* client, uint8_t weight) {
+  if (weight < 1 || weight > JOBS_WEIGHT_MAX || !client[0]) return ESP_ERR_INVALID_ARG;
+
+  xSemaphoreTake(jobs_mtx, portMAX_DELAY);
+  int c = add_client(client, esp_timer_get_time());
+  if (c >= 0) {
+    // Time of running job is charged with the old weight
+    charge(esp_timer_get_time());
+    clients[c].weight = weight;
+  }
+  xSemaphoreGive(jobs_mtx);
+  return c >= 0 ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+// Get scheduler statistics
+jobs_stats_t get_stats() {
+  jobs_stats_t s = {};
+  xSemaphoreTake(jobs_mtx, portMAX_DELAY);
+  for (const slot_t& slot : slots) {
+    if (slot.state == Waiting || slot.state == Preempted) s.queued++;
+  }
+  xSemaphoreGive(jobs_mtx);
+  s.completed = completed.load(std::memory_order_relaxed);
+  s.preempted = preempted.load(std::memory_order_relaxed);
+  s.rejected = rejected.load(std::memory_order_relaxed);
+  s.wait_max_ms = wait_max_ms.load(std::memory_order_relaxed);
+  return s;
+}
+
+// Get state name
+static const char* state_name(State state) {
+  switch (state) {
+    case Waiting:
+      return "waiting";
+    case Running:
+      return "running";
+    case Preempted:
+      return "preempted";
+    default:
+      return "free";
+  }
+}
+
+// Job in queue order with expected start
+typedef struct {
+  uint32_t id;
+  char client[JOBS_CLIENT_NAME_MAX];
+  State state;
+  uint16_t step;
+  uint16_t steps;
+  uint32_t position;     // 0 - running job
+  int64_t queued_us;     // Time of begin()
+  int64_t expected_us;   // Expected start (or resume) time, device clock
+} job_info_t;
+
+// Remaining time of job by completed steps
+static int64_t remaining_us(const slot_t& s) {
+  if (s.steps == 0) return s.duration_us;
+  return s.duration_us * (s.steps - s.step) / s.steps;
+}
+
+// Get jobs in queue order, expected start assumes that jobs run to the end in this order
+static size_t get_queue(job_info_t* jobs) {
+  size_t num = 0;
+  bool taken[CONFIG_NSG_JOB_QUEUE_DEPTH] = {};
+
+  xSemaphoreTake(jobs_mtx, portMAX_DELAY);
+  int64_t now = esp_timer_get_time();
+  int64_t t = now;
+  int slot = running;
+  while (1) {
+    if (slot < 0) {
+      // The next job at simulated time, the controller idles until the next scheduled job
+      int64_t ready_us = INT64_MAX;
+      for (int i = 0; i < CONFIG_NSG_JOB_QUEUE_DEPTH; i++) {
+        const slot_t& s = slots[i];
+        if (taken[i] || s.state == Free || s.state == Running) continue;
+        if (!is_ready(s, t)) {
+          ready_us = std::min<int64_t>(ready_us, s.start_us - QUANTUM_US);
+        } else if (slot < 0 || is_before(s, slots[slot], t)) {
+          slot = i;
+        }
+      }
+      if (slot < 0 && ready_us == INT64_MAX) break;
+      if (slot < 0) {
+        t = ready_us;
+        continue;
+      }
+    }
+
+    const slot_t& s = slots[slot];
+    job_info_t& j = jobs[num];
+    j.id = s.id;
+    strlcpy(j.client, clients[s.client].name, sizeof(j.client));
+    j.state = s.state;
+    j.step = s.step;
+    j.steps = s.steps;
+    j.position = num + (running < 0 ? 1 : 0);
+    j.queued_us = s.queued_us;
+    j.expected_us = s.state == Running ? s.started_us : std::max(t, s.start_us);
+    t = std::max(t, j.expected_us) + remaining_us(s);
+    taken[slot] = true;
+    num++;
+    slot = -1;
+  }
+  xSemaphoreGive(jobs_mtx);
+  return num;
+}
+
+// API: Jobs in queue order with position & expected start, clients with weights
+// Expected start is device clock in us (see /api/time)
+static esp_err_t api_jobs_get(httpd_req_t* req) {
+  static job_info_t jobs[CONFIG_NSG_JOB_QUEUE_DEPTH];
+  size_t num = get_queue(jobs);
+  int64_t now = esp_timer_get_time();
+  httpd_resp_set_type(req, "application/json");
+
+  // Response is sent by chunks, one job or client per chunk
+  char buf[256];
+  httpd_resp_send_chunk(req, "{\"jobs\":[", HTTPD_RESP_USE_STRLEN);
+  for (size_t i = 0; i < num; i++) {
+    const job_info_t& j = jobs[i];
+    int64_t wait_us = j.expected_us - now;
+    snprintf(buf, sizeof(buf),
+             "%s{\"id\":%lu,\"client\":\"%s\",\"state\":\"%s\",\"position\":%lu,\"step\":%u,"
+             "\"steps\":%u,\"queued_ms\":%lld,\"expected_start_us\":%lld,"
+             "\"expected_wait_ms\":%lld}",
+             i ? "," : "", (unsigned long)j.id, j.client, state_name(j.state),
+             (unsigned long)j.position, j.step, j.steps, (long long)(now - j.queued_us) / 1000,
+             (long long)j.expected_us, wait_us > 0 ? (long long)wait_us / 1000 : 0LL);
+    httpd_resp_send_chunk(req, buf, HTTPD_RESP_USE_STRLEN);
+  }
+
+  httpd_resp_send_chunk(req, "],\"clients\":[", HTTPD_RESP_USE_STRLEN);
+  bool first = true;
+  for (int i = 0; i < CONFIG_NSG_JOB_CLIENTS; i++) {
+    xSemaphoreTake(jobs_mtx, portMAX_DELAY);
+    client_t c = clients[i];
+    xSemaphoreGive(jobs_mtx);
+    if (!c.name[0]) continue;
+    snprintf(buf, sizeof(buf),
+             "%s{\"client\":\"%s\",\"weight\":%u,\"jobs\":%u,\"completed\":%lu,\"vtime_ms\":%lld}",
+             first ? "" : ",", c.name, c.weight, c.jobs, (unsigned long)c.completed,
+             (long long)c.vtime_us / 1000);
+    httpd_resp_send_chunk(req, buf, HTTPD_RESP_USE_STRLEN);
+    first = false;
+  }
+
+  httpd_resp_send_chunk(req, "]}", HTTPD_RESP_USE_STRLEN);
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// API: Set client weight (?client=s&weight=n)
+static esp_err_t api_jobs_weight(httpd_req_t* req) {
+  char query[96];
+  char client[JOBS_CLIENT_NAME_MAX];
+  char value[8];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+      httpd_query_key_value(query, "client", client, sizeof(client)) != ESP_OK ||
+      httpd_query_key_value(query, "weight", value, sizeof(value)) != ESP_OK) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missed client or weight");
+    return ESP_FAIL;
+  }
+
+  int weight = atoi(value);
+  esp_err_t err = weight < 1 || weight > JOBS_WEIGHT_MAX ? ESP_ERR_INVALID_ARG
+                                                          : set_weight(client, weight);
+  if (err == ESP_ERR_INVALID_ARG) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong weight");
+    return ESP_FAIL;
+  }
+  if (err != ESP_OK) {
+    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "No free client slots");
+    return ESP_FAIL;
+  }
+  httpd_resp_sendstr(req, "OK");
+  return ESP_OK;
+}
+
+// Register jobs API endpoints
+esp_err_t api_register(httpd_handle_t server) {
+  // API: Job queue
+  httpd_uri_t cfg_api_jobs_get = {
+      .uri = "/api/jobs", .method = HTTP_GET, .handler = api_jobs_get, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_jobs_get);
+
+  // API: Client weight
+  httpd_uri_t cfg_api_jobs_weight = {.uri = "/api/jobs/weight",
+                                     .method = HTTP_POST,
+                                     .handler = api_jobs_weight,
+                                     .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_jobs_weight);
+
+  return ESP_OK;
+}
+
+// CMD: Print job queue & clients, set client weight
+static struct {
+  struct arg_str* client = arg_str0(NULL, NULL, "<client>", "Client (IP address, console, cdc)");
+  struct arg_int* weight = arg_int0("w", "weight", "<1-16>", "Set client weight");
+  struct arg_end* end = arg_end(2);
+} cmd_jobs_args;
+static int cmd_jobs(int argc, char** argv) {
+  // Check argument parse error
+  int nerrors = arg_parse(argc, argv, (void**)&cmd_jobs_args);
+  if (nerrors != 0) {
+    arg_print_errors(stderr, cmd_jobs_args.end, argv[0]);
+    return 1;
+  }
+
+  if (cmd_jobs_args.weight->count) {
+    if (!cmd_jobs_args.client->count) {
+      printf("No client setted\r\n");
+      return 1;
+    }
+    esp_err_t err = set_weight(cmd_jobs_args.client->sval[0], cmd_jobs_args.weight->ival[0]);
+    if (err != ESP_OK) {
+      printf("Failed to set weight: %s\r\n", esp_err_to_name(err));
+      return 1;
+    }
+  }
+
+  static job_info_t jobs[CONFIG_NSG_JOB_QUEUE_DEPTH];
+  size_t num = get_queue(jobs);
+  int64_t now = esp_timer_get_time();
+  jobs_stats_t s = get_stats();
+  printf("Jobs: %lu queued, %lu completed, %lu preempted, %lu rejected, max wait %lu ms\r\n",
+         (unsigned long)s.queued, (unsigned long)s.completed, (unsigned long)s.preempted,
+         (unsigned long)s.rejected, (unsigned long)s.wait_max_ms);
+  for (size_t i = 0; i < num; i++) {
+    const job_info_t& j = jobs[i];
+    int64_t wait_us = j.expected_us - now;
+    printf("  %2lu. job %lu of %-16s %-9s step %u/%u, start in %lld ms\r\n",
+           (unsigned long)j.position, (unsigned long)j.id, j.client, state_name(j.state), j.step,
+           j.steps, wait_us > 0 ? (long long)wait_us / 1000 : 0LL);
+  }
+
+  printf("Clients:\r\n");
+  for (int i = 0; i < CONFIG_NSG_JOB_CLIENTS; i++) {
+    xSemaphoreTake(jobs_mtx, portMAX_DELAY);
+    client_t c = clients[i];
+    xSemaphoreGive(jobs_mtx);
+    if (!c.name[0]) continue;
+    printf("  %-16s weight %2u, %u jobs, %lu completed, vtime %lld ms\r\n", c.name, c.weight,
+           c.jobs, (unsigned long)c.completed, (long long)c.vtime_us / 1000);
+  }
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_jobs_cfg = {
+      .command = "jobs",
+      .help = "Get job queue & clients, set client weight",
+      .hint = NULL,
+      .func = &cmd_jobs,
+      .argtable = &cmd_jobs_args,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_jobs_cfg));
+
+  return ESP_OK;
+}
+
+#else
+
+// Job scheduler is disabled, jobs run at once in calling tasks
+esp_err_t Job::begin(const char* client, uint16_t steps, uint32_t duration_ms, int64_t start_us) {
+  NSGamepad::jobBegin(next_id.fetch_add(1, std::memory_order_relaxed), steps);
+  slot_ = 0;
+  return ESP_OK;
+}
+
+void Job::step() {
+  if (slot_ >= 0) NSGamepad::jobStep();
+}
+
+void Job::end() {
+  if (slot_ < 0) return;
+  NSGamepad::jobEnd();
+  slot_ = -1;
+}
+
+Job::~Job() {
+  end();
+}
+
+esp_err_t init() {
+  return ESP_OK;
+}
+
+esp_err_t set_weight(const char* client, uint8_t weight) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t api_register(httpd_handle_t server) {
+  return ESP_OK;
+}
+
+// Get scheduler statistics
+jobs_stats_t get_stats() {
+  return {};
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  return ESP_OK;
+}
+
+#endif
+
+}  // namespace Jobs
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+// Job scheduler: fair sharing of the single controller between clients
+// Jobs (clicks, batches, scripts) of each client wait in client queue, the next job is chosen by
+// weighted fair dispatch (the client with the least weighted controller time goes first), jobs
+// with scheduled time go first, when their time comes. Running job is preempted between steps,
+// so short interactive jobs don't wait for long bulk jobs
+namespace Jobs {
+
+// Maximum client name length (with null terminator), enough for IPv6 address
+#define JOBS_CLIENT_NAME_MAX 48
+// Clients of local jobs
+#define JOBS_CLIENT_CONSOLE "console"
+#define JOBS_CLIENT_CDC "cdc"
+// Maximum client weight
+#define JOBS_WEIGHT_MAX 16
+
+// Job of scheduler, lives in calling task between begin() & end()
+// Job steps are executed by calling task, while job owns the controller
+class Job {
+ public:
+  Job() = default;
+  ~Job();
+  Job(const Job&) = delete;
+  Job& operator=(const Job&) = delete;
+
+  // Queue job & wait for its turn
+  // Duration is estimated time of all steps, start_us - scheduled time of first step (device
+  // clock in us, 0 - as soon as possible). Returns ESP_ERR_NO_MEM, if queue is full
+  esp_err_t begin(const char* client, uint16_t steps, uint32_t duration_ms, int64_t start_us = 0);
+
+  // Mark one step as completed
+  // Preemption point: job can yield the controller to waiting job & wait for its turn again
+  void step();
+
+  // Finish job & pass the controller to the next job
+  void end();
+
+ private:
+  int slot_ = -1;  // Scheduler slot (-1 - job isn't queued)
+};
+
+// Scheduler statistics
+typedef struct {
+  uint32_t queued;       // Waiting & preempted jobs
+  uint32_t completed;    // Finished jobs
+  uint32_t preempted;    // Preemptions of running jobs
+  uint32_t rejected;     // Jobs rejected by full queue
+  uint32_t wait_max_ms;  // Maximum wait for the first step
+} jobs_stats_t;
+
+// Setup scheduler
+esp_err_t init();
+
+// Get client name of API request (IP address)
+void client_name(httpd_req_t* req, char* name, size_t len);
+
+// Set client weight (1 - JOBS_WEIGHT_MAX), client gets controller time in proportion to weight
+esp_err_t set_weight(const char* client, uint8_t weight);
+
+// Register jobs API endpoints
+esp_err_t api_register(httpd_handle_t server);
+
+// Get scheduler statistics
+// Thread-safe
+jobs_stats_t get_stats();
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace Jobs
@@ -0,0 +1,112 @@
+#include "json_pool.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include "cJSON.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "meminfo.hpp"
+
+namespace JsonPool {
+
+#if CONFIG_NSG_STATIC_ALLOCATION
+
+static const char* TAG = "app json";
+
+// Pool memory, cJSON nodes are allocated sequentially & freed all at once at the scope end
+static uint8_t pool[CONFIG_NSG_JSON_POOL_SIZE] __attribute__((aligned(8)));
+static size_t pool_used = 0;
+
+// Scope holder
+static StaticSemaphore_t pool_mtx_buf;
+static SemaphoreHandle_t pool_mtx;
+static TaskHandle_t pool_owner = NULL;
+
+// Statistics
+static size_t pool_max_used = 0;
+static std::atomic<uint32_t> pool_exhausted = 0;
+static std::atomic<uint32_t> pool_outside = 0;
+
+// cJSON malloc hook
+static void* pool_malloc(size_t size) {
+  if (xTaskGetCurrentTaskHandle() != pool_owner) {
+    // JSON handling outside of scope
+    pool_outside.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size);
+  }
+
+  size = (size + 7) & ~(size_t)7;
+  if (pool_used + size > sizeof(pool)) {
+    pool_exhausted.fetch_add(1, std::memory_order_relaxed);
+    return NULL;
+  }
+  void* ptr = pool + pool_used;
+  pool_used += size;
+  if (pool_used > pool_max_used) pool_max_used = pool_used;
+  return ptr;
+}
+
+// cJSON free hook
+static void pool_free(void* ptr) {
+  // Pool memory is released at the scope end
+  if ((uint8_t*)ptr >= pool && (uint8_t*)ptr < pool + sizeof(pool)) return;
+  free(ptr);
+}
+
+// Install cJSON allocation hooks
+esp_err_t init() {
+  ESP_LOGI(TAG, "JSON pool initialization, size: %d", CONFIG_NSG_JSON_POOL_SIZE);
+  pool_mtx = xSemaphoreCreateMutexStatic(&pool_mtx_buf);
+  MemInfo::add_static(MemInfo::Web, "json_pool", sizeof(pool));
+
+  cJSON_Hooks hooks = {.malloc_fn = pool_malloc, .free_fn = pool_free};
+  cJSON_InitHooks(&hooks);
+  return ESP_OK;
+}
+
+Scope::Scope() {
+  xSemaphoreTake(pool_mtx, portMAX_DELAY);
+  pool_owner = xTaskGetCurrentTaskHandle();
+  pool_used = 0;
+}
+
+Scope::~Scope() {
+  pool_owner = NULL;
+  pool_used = 0;
+  xSemaphoreGive(pool_mtx);
+}
+
+// Get JSON pool statistics
+pool_stats_t get_stats() {
+  pool_stats_t stats = {};
+  stats.size = sizeof(pool);
+  stats.max_used = pool_max_used;
+  stats.exhausted = pool_exhausted.load(std::memory_order_relaxed);
+  stats.outside = pool_outside.load(std::memory_order_relaxed);
+  return stats;
+}
+
+#else
+
+// Install cJSON allocation hooks
+esp_err_t init() {
+  // cJSON uses heap
+  return ESP_OK;
+}
+
+Scope::Scope() {}
+
+Scope::~Scope() {}
+
+// Get JSON pool statistics
+pool_stats_t get_stats() {
+  return {};
+}
+
+#endif
+
+}  // namespace JsonPool
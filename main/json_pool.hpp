@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+namespace JsonPool {
+
+// Install cJSON allocation hooks
+// In static allocation mode cJSON trees are placed in fixed pool instead of heap
+esp_err_t init();
+
+// Scope of JSON handling
+// All cJSON memory of current task is taken from pool until scope ends,
+// pool is cleared at the scope end. Only one task can hold scope at the same time,
+// scopes are not reentrant
+class Scope {
+ public:
+  Scope();
+  ~Scope();
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+};
+
+// JSON pool statistics
+typedef struct {
+  size_t size;         // Pool size
+  size_t max_used;     // Pool high-water mark
+  uint32_t exhausted;  // Allocations failed because pool is full
+  uint32_t outside;    // Allocations outside of scope (taken from heap)
+} pool_stats_t;
+
+// Get JSON pool statistics
+pool_stats_t get_stats();
+
+}  // namespace JsonPool
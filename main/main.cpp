@@ -1,18 +1,35 @@
 #include <stdio.h>
 
+#include "admission.hpp"
+#include "alloc_guard.hpp"
+#include "bench.hpp"
+#include "boot.hpp"
+#include "cdc_control.hpp"
 #include "esp_console.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "hid.hpp"
+#include "jobs.hpp"
+#include "json_pool.hpp"
+#include "meminfo.hpp"
 #include "nsgamepad.hpp"
 #include "nvs_flash.h"
+#include "ota.hpp"
+#include "profiles.hpp"
+#include "script_store.hpp"
+#include "stream.hpp"
+#include "tasks.hpp"
 #include "web.hpp"
+#include "wifi_power.hpp"
 
 static const char* TAG = "app";
 
 void app(void) {
   ESP_LOGI(TAG, "App start");
 
+  // Heap accounting by subsystem
+  ESP_ERROR_CHECK(MemInfo::init());
+
   // Init NVS
   ESP_LOGI(TAG, "Init NVS");
   esp_err_t ret = nvs_flash_init();
@@ -22,12 +39,39 @@ void app(void) {
     ret = nvs_flash_init();
   }
   ESP_ERROR_CHECK(ret);
+  Boot::mark(Boot::NvsReady);
+
+  // JSON memory pool (static allocation mode)
+  ESP_ERROR_CHECK(JsonPool::init());
+
+  // Load gamepad profiles (remap & calibration)
+  ESP_ERROR_CHECK(Profiles::init());
+
+  // Gamepad state lock
+  ESP_ERROR_CHECK(NSGamepad::init());
+
+  // Map stored scripts
+  ESP_ERROR_CHECK(ScriptStore::init());
+
+  // Job scheduler of clients
+  ESP_ERROR_CHECK(Jobs::init());
+
+  // Downtime of OTA switch
+  ESP_ERROR_CHECK(Ota::init());
 
   // Init USB
-  ESP_ERROR_CHECK(HID::init());
-  ESP_ERROR_CHECK(HID::init_hid_task());
+  // USB enumeration & gamepad init sequence run in background, while WiFi connects
+  {
+    MemInfo::Scope mem_scope(MemInfo::Hid);
+    ESP_ERROR_CHECK(HID::init());
+    Boot::mark(Boot::UsbInstalled);
+    ESP_ERROR_CHECK(HID::init_hid_task());
+    Boot::mark(Boot::HidTaskRunned);
+  }
+  ESP_ERROR_CHECK(CdcControl::init());
 
   // Init WEB (& WiFi)
+  // Doesn't block, WiFi connection is established by web task
   ESP_ERROR_CHECK(WEB::init());
 
   // Init console
@@ -36,17 +80,33 @@ void app(void) {
 
   repl_config.prompt = ">";
   repl_config.max_cmdline_length = 1024;
+  repl_config.task_stack_size = CONFIG_NSG_CONSOLE_TASK_STACK_SIZE;
+  repl_config.task_priority = CONFIG_NSG_CONSOLE_TASK_PRIORITY;
+  repl_config.task_core_id = NSG_TASK_CORE(CONFIG_NSG_CONSOLE_TASK_CORE_ID);
 
   // Register console commands
   esp_console_register_help_command();
   ESP_ERROR_CHECK(HID::cmds_register());
   ESP_ERROR_CHECK(NSGamepad::cmds_register());
+  ESP_ERROR_CHECK(Profiles::cmds_register());
+  ESP_ERROR_CHECK(Stream::cmds_register());
+  ESP_ERROR_CHECK(Bench::cmds_register());
+  ESP_ERROR_CHECK(CdcControl::cmds_register());
+  ESP_ERROR_CHECK(ScriptStore::cmds_register());
+  ESP_ERROR_CHECK(Jobs::cmds_register());
   ESP_ERROR_CHECK(WEB::cmds_register());
+  ESP_ERROR_CHECK(WifiPower::cmds_register());
+  ESP_ERROR_CHECK(Admission::cmds_register());
+  ESP_ERROR_CHECK(Ota::cmds_register());
+  ESP_ERROR_CHECK(Boot::cmds_register());
+  ESP_ERROR_CHECK(AllocGuard::cmds_register());
+  ESP_ERROR_CHECK(MemInfo::cmds_register());
 
   // Start console
   esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
   ESP_ERROR_CHECK(esp_console_new_repl_uart(&hw_config, &repl_config, &repl));
   ESP_ERROR_CHECK(esp_console_start_repl(repl));
+  Boot::mark(Boot::ConsoleReady);
 }
 
 extern "C" void app_main(void) {
@@ -0,0 +1,260 @@
+#include "meminfo.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+#include "esp_attr.h"
+#include "esp_console.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "metrics.hpp"
+
+// Static data sections bounds (linker script)
+extern "C" int _data_start, _data_end, _bss_start, _bss_end;
+
+namespace MemInfo {
+
+static const char* TAG = "app meminfo";
+
+// Subsystems names
+static const char* subsystem_names[SubsystemsNum] = {"web", "hid", "gamepad", "other"};
+
+// Maximum number of registered static buffers
+#define MEMINFO_STATICS_MAX 16
+
+// Registered static buffer
+typedef struct {
+  Subsystem subsystem;
+  const char* name;
+  size_t bytes;
+} static_buf_t;
+
+// Static buffers, registered on initialization
+static static_buf_t statics[MEMINFO_STATICS_MAX];
+static size_t statics_num = 0;
+
+// Tasks with measured stack
+static const struct {
+  const char* name;
+  Subsystem subsystem;
+} stack_tasks[] = {
+    {"app_hid_task", Hid}, {"cdc_task", Gamepad},    {"web_task", Web},
+    {"httpd", Web},        {"events_task", Web},     {"console_repl", Other},
+};
+
+// Counters, updated from heap hooks
+static std::atomic<uint32_t> allocs[SubsystemsNum] = {};
+static std::atomic<uint32_t> frees[SubsystemsNum] = {};
+static std::atomic<uint32_t> bytes[SubsystemsNum] = {};
+static volatile bool accounting = false;
+
+// Subsystem tag & heap allocations of current task
+static thread_local Subsystem current_tag = Other;
+static thread_local task_allocs_t task_allocs = {};
+
+// Response buffer of /api/meminfo (used from HTTP server task only)
+static char body_buf[4096];
+
+Scope::Scope(Subsystem subsystem) : prev_(current_tag) {
+  current_tag = subsystem;
+}
+
+Scope::~Scope() {
+  current_tag = prev_;
+}
+
+// Start heap accounting
+esp_err_t init() {
+#if CONFIG_NSG_MEMINFO_ACCOUNTING
+  ESP_LOGI(TAG, "Heap accounting started");
+  accounting = true;
+#endif
+  return ESP_OK;
+}
+
+// Account heap allocation
+// Called for every allocation (heap hook), may be called with flash cache disabled
+IRAM_ATTR void on_alloc(size_t size) {
+  if (!accounting) return;
+
+  Subsystem s = current_tag;
+  allocs[s].fetch_add(1, std::memory_order_relaxed);
+  bytes[s].fetch_add(size, std::memory_order_relaxed);
+  task_allocs.allocs++;
+  task_allocs.bytes += size;
+}
+
+// Account heap free
+IRAM_ATTR void on_free() {
+  if (!accounting) return;
+  frees[current_tag].fetch_add(1, std::memory_order_relaxed);
+}
+
+// Register static buffer of subsystem
+void add_static(Subsystem subsystem, const char* name, size_t bytes) {
+  if (statics_num >= MEMINFO_STATICS_MAX) {
+    ESP_LOGW(TAG, "No free static buffer entries for %s", name);
+    return;
+  }
+  statics[statics_num++] = {.subsystem = subsystem, .name = name, .bytes = bytes};
+}
+
+// Get subsystems statistics
+void get_stats(subsystem_stats_t stats[SubsystemsNum]) {
+  for (int s = 0; s < SubsystemsNum; s++) {
+    stats[s].name = subsystem_names[s];
+    stats[s].allocs = allocs[s].load(std::memory_order_relaxed);
+    stats[s].frees = frees[s].load(std::memory_order_relaxed);
+    stats[s].bytes = bytes[s].load(std::memory_order_relaxed);
+    stats[s].static_bytes = 0;
+  }
+  for (size_t i = 0; i < statics_num; i++) {
+    stats[statics[i].subsystem].static_bytes += statics[i].bytes;
+  }
+}
+
+// Get heap allocations made by current task
+task_allocs_t get_task_allocs() {
+  return task_allocs;
+}
+
+// Append formatted string to buffer
+static void buf_append(char* buf, size_t size, size_t& len, const char* fmt, ...) {
+  if (len >= size) return;
+  va_list args;
+  va_start(args, fmt);
+  int written = vsnprintf(buf + len, size - len, fmt, args);
+  va_end(args);
+  if (written > 0) len = std::min(len + written, size - 1);
+}
+
+// API: Memory usage by subsystems
+static esp_err_t api_meminfo(httpd_req_t* req) {
+  httpd_resp_set_type(req, "application/json");
+  size_t len = 0;
+  const size_t size = sizeof(body_buf);
+
+  buf_append(body_buf, size, len,
+             "{\"heap\":{\"free\":%u,\"min_free\":%u,\"largest_block\":%u},"
+             "\"static\":{\"data\":%d,\"bss\":%d},\"subsystems\":[",
+             heap_caps_get_free_size(MALLOC_CAP_DEFAULT),
+             heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT),
+             heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT),
+             (int)((char*)&_data_end - (char*)&_data_start),
+             (int)((char*)&_bss_end - (char*)&_bss_start));
+
+  subsystem_stats_t stats[SubsystemsNum];
+  get_stats(stats);
+  for (int s = 0; s < SubsystemsNum; s++) {
+    buf_append(body_buf, size, len,
+               "%s{\"name\":\"%s\",\"allocs\":%lu,\"frees\":%lu,\"bytes\":%lu,\"static\":%lu}",
+               s ? "," : "", stats[s].name, (unsigned long)stats[s].allocs,
+               (unsigned long)stats[s].frees, (unsigned long)stats[s].bytes,
+               (unsigned long)stats[s].static_bytes);
+  }
+
+  buf_append(body_buf, size, len, "],\"stacks\":[");
+  const char* sep = "";
+  for (const auto& t : stack_tasks) {
+    TaskHandle_t task = xTaskGetHandle(t.name);
+    if (!task) continue;
+    buf_append(body_buf, size, len, "%s{\"task\":\"%s\",\"subsystem\":\"%s\",\"free_min\":%u}", sep,
+               t.name, subsystem_names[t.subsystem], uxTaskGetStackHighWaterMark(task));
+    sep = ",";
+  }
+
+  buf_append(body_buf, size, len, "],\"routes\":[");
+  Metrics::route_allocs_t routes[METRICS_ROUTES_MAX];
+  size_t routes_num = Metrics::get_route_allocs(routes, METRICS_ROUTES_MAX);
+  for (size_t r = 0; r < routes_num; r++) {
+    buf_append(body_buf, size, len,
+               "%s{\"route\":\"%s\",\"method\":\"%s\",\"allocs_max\":%lu,\"bytes_max\":%lu,"
+               "\"over_budget\":%lu}",
+               r ? "," : "", routes[r].uri, routes[r].method, (unsigned long)routes[r].allocs_max,
+               (unsigned long)routes[r].bytes_max, (unsigned long)routes[r].over_budget);
+  }
+  buf_append(body_buf, size, len, "]}");
+
+  httpd_resp_send(req, body_buf, len);
+  return ESP_OK;
+}
+
+// Register /api/meminfo endpoint
+esp_err_t api_register(httpd_handle_t server) {
+  httpd_uri_t cfg_api_meminfo = {
+      .uri = "/api/meminfo", .method = HTTP_GET, .handler = api_meminfo, .user_ctx = NULL};
+  return Metrics::register_uri_handler(server, &cfg_api_meminfo);
+}
+
+// CMD: Prints memory usage by subsystems
+static int cmd_meminfo(int argc, char** argv) {
+  printf("Heap: free %u, min free %u, largest block %u\r\n",
+         (unsigned)heap_caps_get_free_size(MALLOC_CAP_DEFAULT),
+         (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT),
+         (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT));
+  printf("Static: .data %d, .bss %d bytes\r\n", (int)((char*)&_data_end - (char*)&_data_start),
+         (int)((char*)&_bss_end - (char*)&_bss_start));
+
+#if CONFIG_NSG_MEMINFO_ACCOUNTING
+  printf("Heap by subsystem (since start):\r\n");
+#else
+  printf("Heap by subsystem: heap accounting is disabled\r\n");
+#endif
+  subsystem_stats_t stats[SubsystemsNum];
+  get_stats(stats);
+  for (const subsystem_stats_t& s : stats) {
+    printf("  %-8s %8lu allocs, %8lu frees, %10lu bytes, static %8lu bytes\r\n", s.name,
+           (unsigned long)s.allocs, (unsigned long)s.frees, (unsigned long)s.bytes,
+           (unsigned long)s.static_bytes);
+  }
+
+  printf("Static buffers:\r\n");
+  for (size_t i = 0; i < statics_num; i++) {
+    printf("  %-8s %-14s %8u bytes\r\n", subsystem_names[statics[i].subsystem], statics[i].name,
+           (unsigned)statics[i].bytes);
+  }
+
+  printf("Task stacks (free min):\r\n");
+  for (const auto& t : stack_tasks) {
+    TaskHandle_t task = xTaskGetHandle(t.name);
+    if (task) {
+      printf("  %-8s %-14s %8u bytes\r\n", subsystem_names[t.subsystem], t.name,
+             uxTaskGetStackHighWaterMark(task));
+    }
+  }
+
+#if CONFIG_NSG_MEMINFO_ACCOUNTING
+  printf("API requests heap (max per request, budget %d bytes):\r\n",
+         CONFIG_NSG_MEMINFO_ROUTE_BUDGET);
+  Metrics::route_allocs_t routes[METRICS_ROUTES_MAX];
+  size_t routes_num = Metrics::get_route_allocs(routes, METRICS_ROUTES_MAX);
+  for (size_t r = 0; r < routes_num; r++) {
+    printf("  %-6s %-14s %6lu allocs, %8lu bytes, over budget: %lu\r\n", routes[r].method,
+           routes[r].uri, (unsigned long)routes[r].allocs_max, (unsigned long)routes[r].bytes_max,
+           (unsigned long)routes[r].over_budget);
+  }
+#endif
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_meminfo_cfg = {
+      .command = "meminfo",
+      .help = "Get memory usage by subsystems (heap, static buffers, stacks, API requests)",
+      .hint = NULL,
+      .func = &cmd_meminfo,
+      .argtable = NULL,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_meminfo_cfg));
+
+  return ESP_OK;
+}
+
+}  // namespace MemInfo
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+namespace MemInfo {
+
+// Accounted subsystems, allocations without tag go to Other
+enum Subsystem : uint8_t { Web, Hid, Gamepad, Other, SubsystemsNum };
+
+// Tag heap allocations of current task with subsystem until scope ends
+// Scopes can be nested, inner scope wins
+class Scope {
+ public:
+  explicit Scope(Subsystem subsystem);
+  ~Scope();
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+ private:
+  Subsystem prev_;
+};
+
+// Heap allocations of subsystem (heap accounting) & static footprint
+typedef struct {
+  const char* name;       // Subsystem name
+  uint32_t allocs;        // Number of allocations
+  uint32_t frees;         // Number of frees
+  uint32_t bytes;         // Allocated bytes (total, frees are not subtracted)
+  uint32_t static_bytes;  // Registered static buffers
+} subsystem_stats_t;
+
+// Heap allocations of current task
+typedef struct {
+  uint32_t allocs;
+  uint32_t bytes;
+} task_allocs_t;
+
+// Start heap accounting (scheduler should be running)
+esp_err_t init();
+
+// Account heap allocation & free, called from heap hooks (IRAM)
+void on_alloc(size_t size);
+void on_free();
+
+// Register static buffer of subsystem (static footprint)
+void add_static(Subsystem subsystem, const char* name, size_t bytes);
+
+// Get subsystems statistics
+void get_stats(subsystem_stats_t stats[SubsystemsNum]);
+
+// Get heap allocations made by current task (used for per-request budget)
+task_allocs_t get_task_allocs();
+
+// Register /api/meminfo endpoint
+esp_err_t api_register(httpd_handle_t server);
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace MemInfo
@@ -0,0 +1,525 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstring>
+
+#include "admission.hpp"
+#include "alloc_guard.hpp"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/idf_additions.h"
+#include "hid.hpp"
+#include "jobs.hpp"
+#include "json_pool.hpp"
+#include "meminfo.hpp"
+#include "stream.hpp"
+#include "wifi_power.hpp"
+
+namespace Metrics {
+
+static const char* TAG = "app metrics";
+
+// Request latency histogram buckets (us)
+static const uint32_t latency_buckets_us[] = {1000, 5000, 10000, 50000, 100000, 500000, 1000000};
+#define LATENCY_BUCKETS_NUM (sizeof(latency_buckets_us) / sizeof(latency_buckets_us[0]))
+
+// Route counters
+typedef struct {
+  const char* uri;
+  httpd_method_t method;
+  esp_err_t (*handler)(httpd_req_t* r);
+  void* user_ctx;
+  Admission::Lane lane;
+
+  std::atomic<uint32_t> requests;
+  std::atomic<uint32_t> errors;
+  std::atomic<uint64_t> latency_sum_us;
+  std::atomic<uint32_t> latency_buckets[LATENCY_BUCKETS_NUM];
+
+  std::atomic<uint32_t> allocs_max;
+  std::atomic<uint32_t> alloc_bytes_max;
+  std::atomic<uint32_t> over_budget;
+} route_t;
+
+// Pre-allocated routes counters
+static route_t routes[METRICS_ROUTES_MAX];
+static size_t routes_num = 0;
+
+// WiFi counters
+static std::atomic<uint32_t> wifi_reconnects = 0;
+
+// Tasks with measured stack
+static const char* stack_tasks[] = {"app_hid_task", "web_task", "httpd", "events_task",
+                                    "bulk_task"};
+
+// Measured heap capabilities
+static const struct {
+  const char* name;
+  uint32_t caps;
+} heap_caps[] = {
+    {"default", MALLOC_CAP_DEFAULT},
+    {"internal", MALLOC_CAP_INTERNAL},
+    {"dma", MALLOC_CAP_DMA},
+    {"spiram", MALLOC_CAP_SPIRAM},
+};
+
+// Get method name
+static const char* method_name(httpd_method_t method) {
+  switch (method) {
+    case HTTP_GET:
+      return "GET";
+    case HTTP_POST:
+      return "POST";
+    case HTTP_PUT:
+      return "PUT";
+    case HTTP_DELETE:
+      return "DELETE";
+    default:
+      return "OTHER";
+  }
+}
+
+// Update maximum value
+static void update_max(std::atomic<uint32_t>& max, uint32_t value) {
+  uint32_t prev = max.load(std::memory_order_relaxed);
+  while (value > prev && !max.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+  }
+}
+
+// Measure request of route
+// Called from HTTP server task or bulk task (see Admission)
+static esp_err_t route_measure(httpd_req_t* req, void* arg) {
+  route_t* route = (route_t*)arg;
+
+  // Heap allocations of handler are accounted to web subsystem
+  MemInfo::Scope mem_scope(MemInfo::Web);
+  MemInfo::task_allocs_t allocs_start = MemInfo::get_task_allocs();
+
+  int64_t start = esp_timer_get_time();
+  esp_err_t ret = route->handler(req);
+  uint32_t elapsed = esp_timer_get_time() - start;
+
+#if CONFIG_NSG_MEMINFO_ACCOUNTING
+  MemInfo::task_allocs_t allocs_end = MemInfo::get_task_allocs();
+  uint32_t alloc_bytes = allocs_end.bytes - allocs_start.bytes;
+  update_max(route->allocs_max, allocs_end.allocs - allocs_start.allocs);
+  update_max(route->alloc_bytes_max, alloc_bytes);
+  if (alloc_bytes > CONFIG_NSG_MEMINFO_ROUTE_BUDGET) {
+    route->over_budget.fetch_add(1, std::memory_order_relaxed);
+    ESP_LOGW(TAG, "Request %s %s allocated %lu bytes of heap (budget %d)",
+             method_name(route->method), route->uri, (unsigned long)alloc_bytes,
+             CONFIG_NSG_MEMINFO_ROUTE_BUDGET);
+  }
+#endif
+
+  route->requests.fetch_add(1, std::memory_order_relaxed);
+  if (ret != ESP_OK) {
+    route->errors.fetch_add(1, std::memory_order_relaxed);
+  }
+  route->latency_sum_us.fetch_add(elapsed, std::memory_order_relaxed);
+  for (size_t b = 0; b < LATENCY_BUCKETS_NUM; b++) {
+    if (elapsed <= latency_buckets_us[b]) {
+      route->latency_buckets[b].fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+  }
+
+  return ret;
+}
+
+// Pass request of route through admission control
+static esp_err_t route_handler(httpd_req_t* req) {
+  route_t* route = (route_t*)req->user_ctx;
+  req->user_ctx = route->user_ctx;
+
+  // Control traffic keeps WiFi out of modem sleep
+  WifiPower::activity();
+
+  return Admission::handle(req, route->lane, route_measure, route);
+}
+
+// Register URI handler with request counters & latency measurement
+esp_err_t register_uri_handler(httpd_handle_t server, const httpd_uri_t* uri) {
+  if (routes_num >= METRICS_ROUTES_MAX) {
+    ESP_LOGW(TAG, "No free route counters for %s", uri->uri);
+    return httpd_register_uri_handler(server, uri);
+  }
+
+  route_t* route = &routes[routes_num++];
+  route->uri = uri->uri;
+  route->method = uri->method;
+  route->handler = uri->handler;
+  route->user_ctx = uri->user_ctx;
+  route->lane = Admission::classify(uri->uri, uri->method);
+
+  httpd_uri_t measured = *uri;
+  measured.handler = route_handler;
+  measured.user_ctx = route;
+  return httpd_register_uri_handler(server, &measured);
+}
+
+// Get heap allocations of routes
+size_t get_route_allocs(route_allocs_t* allocs, size_t max) {
+  size_t num = std::min(routes_num, max);
+  for (size_t r = 0; r < num; r++) {
+    allocs[r].uri = routes[r].uri;
+    allocs[r].method = method_name(routes[r].method);
+    allocs[r].allocs_max = routes[r].allocs_max.load(std::memory_order_relaxed);
+    allocs[r].bytes_max = routes[r].alloc_bytes_max.load(std::memory_order_relaxed);
+    allocs[r].over_budget = routes[r].over_budget.load(std::memory_order_relaxed);
+  }
+  return num;
+}
+
+// Count WiFi reconnect
+void count_wifi_reconnect() {
+  wifi_reconnects.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Metrics writer, sends metrics by chunks
+// Used only from HTTP server task, so static buffer is shared
+static struct {
+  httpd_req_t* req;
+  char buf[1024];
+  size_t len;
+} writer;
+
+// Send buffered metrics
+static void writer_flush() {
+  if (writer.len > 0) {
+    httpd_resp_send_chunk(writer.req, writer.buf, writer.len);
+    writer.len = 0;
+  }
+}
+
+// Write metrics line
+static void writer_line(const char* fmt, ...) {
+  char line[160];
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  if (len <= 0) return;
+  if (len >= (int)sizeof(line)) len = sizeof(line) - 1;
+
+  if (writer.len + len + 1 > sizeof(writer.buf)) {
+    writer_flush();
+  }
+  memcpy(writer.buf + writer.len, line, len);
+  writer.len += len;
+  writer.buf[writer.len++] = '\n';
+}
+
+// Write HID metrics
+static void write_hid_metrics() {
+  HID::hid_stats_t hid = HID::get_stats();
+
+  writer_line("# HELP nsg_hid_ticks_total HID task ticks");
+  writer_line("# TYPE nsg_hid_ticks_total counter");
+  writer_line("nsg_hid_ticks_total{result=\"sent\"} %lu", (unsigned long)hid.ticks_sent);
+  writer_line("nsg_hid_ticks_total{result=\"skipped\"} %lu", (unsigned long)hid.ticks_skipped);
+  writer_line("nsg_hid_ticks_total{result=\"missed\"} %lu", (unsigned long)hid.ticks_missed);
+
+  writer_line("# HELP nsg_hid_tick_jitter_us Deviation of HID tick period");
+  writer_line("# TYPE nsg_hid_tick_jitter_us histogram");
+  uint32_t cumulative = 0;
+  for (int b = 0; b < HID_JITTER_BUCKETS_NUM - 1; b++) {
+    cumulative += hid.tick_jitter_hist[b];
+    writer_line("nsg_hid_tick_jitter_us_bucket{le=\"%lu\"} %lu",
+                (unsigned long)HID::jitter_buckets_us[b], (unsigned long)cumulative);
+  }
+  cumulative += hid.tick_jitter_hist[HID_JITTER_BUCKETS_NUM - 1];
+  writer_line("nsg_hid_tick_jitter_us_bucket{le=\"+Inf\"} %lu", (unsigned long)cumulative);
+  writer_line("nsg_hid_tick_jitter_us_sum %llu", (unsigned long long)hid.tick_jitter_sum_us);
+  writer_line("nsg_hid_tick_jitter_us_count %lu", (unsigned long)cumulative);
+  writer_line("# TYPE nsg_hid_tick_jitter_max_us gauge");
+  writer_line("nsg_hid_tick_jitter_max_us %lu", (unsigned long)hid.tick_jitter_max_us);
+
+  writer_line("# HELP nsg_hid_report_wait_us Wait time of set_hid_report()");
+  writer_line("# TYPE nsg_hid_report_wait_us summary");
+  writer_line("nsg_hid_report_wait_us_sum %llu", (unsigned long long)hid.report_wait_sum_us);
+  writer_line("nsg_hid_report_wait_us_count %lu", (unsigned long)hid.report_waits);
+  writer_line("# TYPE nsg_hid_report_wait_max_us gauge");
+  writer_line("nsg_hid_report_wait_max_us %lu", (unsigned long)hid.report_wait_max_us);
+  writer_line("# TYPE nsg_hid_report_wait_timeouts_total counter");
+  writer_line("nsg_hid_report_wait_timeouts_total %lu", (unsigned long)hid.report_wait_timeouts);
+
+  writer_line("# HELP nsg_hid_reports_total HID reports by IN endpoint result");
+  writer_line("# TYPE nsg_hid_reports_total counter");
+  writer_line("nsg_hid_reports_total{result=\"completed\"} %lu",
+              (unsigned long)hid.reports_completed);
+  writer_line("nsg_hid_reports_total{result=\"dropped\"} %lu", (unsigned long)hid.reports_dropped);
+  writer_line("nsg_hid_reports_total{result=\"retried\"} %lu", (unsigned long)hid.reports_retried);
+  writer_line("# HELP nsg_hid_stalls_total IN endpoint stalls");
+  writer_line("# TYPE nsg_hid_stalls_total counter");
+  writer_line("nsg_hid_stalls_total %lu", (unsigned long)hid.stalls);
+
+  writer_line("# TYPE nsg_hid_gamepad_connected gauge");
+  writer_line("nsg_hid_gamepad_connected %d", HID::is_gamepad_connected() ? 1 : 0);
+}
+
+// Write HTTP routes metrics
+static void write_http_metrics() {
+  writer_line("# HELP nsg_http_requests_total Handled requests");
+  writer_line("# TYPE nsg_http_requests_total counter");
+  for (size_t r = 0; r < routes_num; r++) {
+    writer_line("nsg_http_requests_total{route=\"%s\",method=\"%s\"} %lu", routes[r].uri,
+                method_name(routes[r].method), (unsigned long)routes[r].requests.load());
+  }
+
+  writer_line("# HELP nsg_http_request_errors_total Failed requests");
+  writer_line("# TYPE nsg_http_request_errors_total counter");
+  for (size_t r = 0; r < routes_num; r++) {
+    writer_line("nsg_http_request_errors_total{route=\"%s\",method=\"%s\"} %lu", routes[r].uri,
+                method_name(routes[r].method), (unsigned long)routes[r].errors.load());
+  }
+
+  writer_line("# HELP nsg_http_request_duration_us Request handling time");
+  writer_line("# TYPE nsg_http_request_duration_us histogram");
+  for (size_t r = 0; r < routes_num; r++) {
+    const route_t& route = routes[r];
+    const char* method = method_name(route.method);
+    uint32_t cumulative = 0;
+    for (size_t b = 0; b < LATENCY_BUCKETS_NUM; b++) {
+      cumulative += route.latency_buckets[b].load();
+      writer_line("nsg_http_request_duration_us_bucket{route=\"%s\",method=\"%s\",le=\"%lu\"} %lu",
+                  route.uri, method, (unsigned long)latency_buckets_us[b],
+                  (unsigned long)cumulative);
+    }
+    writer_line("nsg_http_request_duration_us_bucket{route=\"%s\",method=\"%s\",le=\"+Inf\"} %lu",
+                route.uri, method, (unsigned long)route.requests.load());
+    writer_line("nsg_http_request_duration_us_sum{route=\"%s\",method=\"%s\"} %llu", route.uri,
+                method, (unsigned long long)route.latency_sum_us.load());
+    writer_line("nsg_http_request_duration_us_count{route=\"%s\",method=\"%s\"} %lu", route.uri,
+                method, (unsigned long)route.requests.load());
+  }
+
+#if CONFIG_NSG_WEB_ADMISSION
+  Admission::admission_stats_t adm = Admission::get_stats();
+  writer_line("# HELP nsg_http_admitted_total Admitted requests by lane");
+  writer_line("# TYPE nsg_http_admitted_total counter");
+  for (int l = 0; l < Admission::LanesNum; l++) {
+    writer_line("nsg_http_admitted_total{lane=\"%s\"} %lu",
+                Admission::lane_name((Admission::Lane)l), (unsigned long)adm.admitted[l]);
+  }
+  writer_line("# HELP nsg_http_rejected_total Requests rejected by admission control");
+  writer_line("# TYPE nsg_http_rejected_total counter");
+  writer_line("nsg_http_rejected_total{reason=\"rate_limit\"} %lu",
+              (unsigned long)adm.rate_limited);
+  writer_line("nsg_http_rejected_total{reason=\"queue_full\"} %lu", (unsigned long)adm.queue_full);
+  writer_line("nsg_http_rejected_total{reason=\"sockets\"} %lu", (unsigned long)adm.sockets_full);
+  writer_line("# TYPE nsg_http_bulk_queue_depth gauge");
+  writer_line("nsg_http_bulk_queue_depth %lu", (unsigned long)adm.queue_depth);
+  writer_line("# TYPE nsg_http_bulk_queue_depth_max gauge");
+  writer_line("nsg_http_bulk_queue_depth_max %lu", (unsigned long)adm.queue_depth_max);
+  writer_line("# TYPE nsg_http_job_workers_busy gauge");
+  writer_line("nsg_http_job_workers_busy %lu", (unsigned long)adm.jobs_running);
+  writer_line("# TYPE nsg_http_job_workers_busy_max gauge");
+  writer_line("nsg_http_job_workers_busy_max %lu", (unsigned long)adm.jobs_running_max);
+  writer_line("# TYPE nsg_http_rate_limit_clients gauge");
+  writer_line("nsg_http_rate_limit_clients %lu", (unsigned long)adm.clients);
+  writer_line("# HELP nsg_http_sockets_open Open sockets of HTTP server");
+  writer_line("# TYPE nsg_http_sockets_open gauge");
+  writer_line("nsg_http_sockets_open %lu", (unsigned long)adm.sockets);
+  writer_line("# TYPE nsg_http_sockets_open_max gauge");
+  writer_line("nsg_http_sockets_open_max %lu", (unsigned long)adm.sockets_max);
+  writer_line("# HELP nsg_http_sockets_idle_closed_total Idle keep-alive sockets closed");
+  writer_line("# TYPE nsg_http_sockets_idle_closed_total counter");
+  writer_line("nsg_http_sockets_idle_closed_total %lu", (unsigned long)adm.idle_closed);
+#endif
+
+#if CONFIG_NSG_MEMINFO_ACCOUNTING
+  writer_line("# HELP nsg_http_request_alloc_bytes_max Maximum heap allocated by one request");
+  writer_line("# TYPE nsg_http_request_alloc_bytes_max gauge");
+  for (size_t r = 0; r < routes_num; r++) {
+    writer_line("nsg_http_request_alloc_bytes_max{route=\"%s\",method=\"%s\"} %lu", routes[r].uri,
+                method_name(routes[r].method), (unsigned long)routes[r].alloc_bytes_max.load());
+  }
+
+  writer_line("# HELP nsg_http_request_over_budget_total Requests exceeded heap budget");
+  writer_line("# TYPE nsg_http_request_over_budget_total counter");
+  for (size_t r = 0; r < routes_num; r++) {
+    writer_line("nsg_http_request_over_budget_total{route=\"%s\",method=\"%s\"} %lu", routes[r].uri,
+                method_name(routes[r].method), (unsigned long)routes[r].over_budget.load());
+  }
+#endif
+}
+
+// Write system metrics
+static void write_system_metrics() {
+  writer_line("# TYPE nsg_uptime_seconds gauge");
+  writer_line("nsg_uptime_seconds %lld", esp_timer_get_time() / 1000000);
+
+  writer_line("# HELP nsg_heap_free_bytes Free heap");
+  writer_line("# TYPE nsg_heap_free_bytes gauge");
+  for (const auto& h : heap_caps) {
+    writer_line("nsg_heap_free_bytes{caps=\"%s\"} %u", h.name, heap_caps_get_free_size(h.caps));
+  }
+  writer_line("# HELP nsg_heap_min_free_bytes Minimum free heap since start");
+  writer_line("# TYPE nsg_heap_min_free_bytes gauge");
+  for (const auto& h : heap_caps) {
+    writer_line("nsg_heap_min_free_bytes{caps=\"%s\"} %u", h.name,
+                heap_caps_get_minimum_free_size(h.caps));
+  }
+  writer_line("# HELP nsg_heap_largest_free_block_bytes Largest free heap block");
+  writer_line("# TYPE nsg_heap_largest_free_block_bytes gauge");
+  for (const auto& h : heap_caps) {
+    writer_line("nsg_heap_largest_free_block_bytes{caps=\"%s\"} %u", h.name,
+                heap_caps_get_largest_free_block(h.caps));
+  }
+
+  writer_line("# HELP nsg_task_stack_free_min_bytes Task stack high-water mark");
+  writer_line("# TYPE nsg_task_stack_free_min_bytes gauge");
+  for (const char* name : stack_tasks) {
+    TaskHandle_t task = xTaskGetHandle(name);
+    if (task) {
+      writer_line("nsg_task_stack_free_min_bytes{task=\"%s\"} %u", name,
+                  uxTaskGetStackHighWaterMark(task));
+    }
+  }
+
+#if CONFIG_NSG_WEB_STREAM
+  Stream::stream_stats_t stream = Stream::get_stats();
+  writer_line("# TYPE nsg_stream_active gauge");
+  writer_line("nsg_stream_active %d", stream.active ? 1 : 0);
+  writer_line("# TYPE nsg_stream_buffer_depth gauge");
+  writer_line("nsg_stream_buffer_depth %lu", (unsigned long)stream.depth);
+  writer_line("# TYPE nsg_stream_playout_delay_us gauge");
+  writer_line("nsg_stream_playout_delay_us %lu", (unsigned long)stream.playout_delay_us);
+  writer_line("# TYPE nsg_stream_jitter_us gauge");
+  writer_line("nsg_stream_jitter_us %lu", (unsigned long)stream.jitter_us);
+  writer_line("# HELP nsg_stream_frames_total Input stream frames");
+  writer_line("# TYPE nsg_stream_frames_total counter");
+  writer_line("nsg_stream_frames_total{result=\"played\"} %lu", (unsigned long)stream.played);
+  writer_line("nsg_stream_frames_total{result=\"late\"} %lu", (unsigned long)stream.late);
+  writer_line("nsg_stream_frames_total{result=\"overflow\"} %lu", (unsigned long)stream.overflows);
+  writer_line("# TYPE nsg_stream_underrun_ticks_total counter");
+  writer_line("nsg_stream_underrun_ticks_total %lu", (unsigned long)stream.underruns);
+#endif
+
+#if CONFIG_NSG_JOB_SCHEDULER
+  Jobs::jobs_stats_t jobs = Jobs::get_stats();
+  writer_line("# TYPE nsg_jobs_queued gauge");
+  writer_line("nsg_jobs_queued %lu", (unsigned long)jobs.queued);
+  writer_line("# HELP nsg_jobs_total Jobs by result");
+  writer_line("# TYPE nsg_jobs_total counter");
+  writer_line("nsg_jobs_total{result=\"completed\"} %lu", (unsigned long)jobs.completed);
+  writer_line("nsg_jobs_total{result=\"rejected\"} %lu", (unsigned long)jobs.rejected);
+  writer_line("# TYPE nsg_jobs_preempted_total counter");
+  writer_line("nsg_jobs_preempted_total %lu", (unsigned long)jobs.preempted);
+  writer_line("# TYPE nsg_jobs_wait_max_ms gauge");
+  writer_line("nsg_jobs_wait_max_ms %lu", (unsigned long)jobs.wait_max_ms);
+#endif
+
+#if CONFIG_NSG_MEMINFO_ACCOUNTING
+  MemInfo::subsystem_stats_t subsystems[MemInfo::SubsystemsNum];
+  MemInfo::get_stats(subsystems);
+  writer_line("# HELP nsg_heap_subsystem_allocs_total Heap allocations by subsystem");
+  writer_line("# TYPE nsg_heap_subsystem_allocs_total counter");
+  for (const auto& m : subsystems) {
+    writer_line("nsg_heap_subsystem_allocs_total{subsystem=\"%s\"} %lu", m.name,
+                (unsigned long)m.allocs);
+  }
+  writer_line("# TYPE nsg_heap_subsystem_frees_total counter");
+  for (const auto& m : subsystems) {
+    writer_line("nsg_heap_subsystem_frees_total{subsystem=\"%s\"} %lu", m.name,
+                (unsigned long)m.frees);
+  }
+  writer_line("# TYPE nsg_heap_subsystem_alloc_bytes_total counter");
+  for (const auto& m : subsystems) {
+    writer_line("nsg_heap_subsystem_alloc_bytes_total{subsystem=\"%s\"} %lu", m.name,
+                (unsigned long)m.bytes);
+  }
+  writer_line("# HELP nsg_static_subsystem_bytes Registered static buffers by subsystem");
+  writer_line("# TYPE nsg_static_subsystem_bytes gauge");
+  for (const auto& m : subsystems) {
+    writer_line("nsg_static_subsystem_bytes{subsystem=\"%s\"} %lu", m.name,
+                (unsigned long)m.static_bytes);
+  }
+#endif
+
+#if CONFIG_NSG_STATIC_ALLOCATION
+  AllocGuard::task_allocs_t allocs[ALLOC_GUARD_TASKS_NUM];
+  AllocGuard::get_stats(allocs);
+  writer_line("# HELP nsg_heap_allocs_after_boot_total Heap allocations after boot");
+  writer_line("# TYPE nsg_heap_allocs_after_boot_total counter");
+  for (const auto& a : allocs) {
+    writer_line("nsg_heap_allocs_after_boot_total{task=\"%s\"} %lu", a.task,
+                (unsigned long)a.allocs);
+  }
+  writer_line("# TYPE nsg_heap_alloc_bytes_after_boot_total counter");
+  for (const auto& a : allocs) {
+    writer_line("nsg_heap_alloc_bytes_after_boot_total{task=\"%s\"} %lu", a.task,
+                (unsigned long)a.bytes);
+  }
+
+  JsonPool::pool_stats_t pool = JsonPool::get_stats();
+  writer_line("# TYPE nsg_json_pool_size_bytes gauge");
+  writer_line("nsg_json_pool_size_bytes %u", pool.size);
+  writer_line("# TYPE nsg_json_pool_max_used_bytes gauge");
+  writer_line("nsg_json_pool_max_used_bytes %u", pool.max_used);
+  writer_line("# TYPE nsg_json_pool_exhausted_total counter");
+  writer_line("nsg_json_pool_exhausted_total %lu", (unsigned long)pool.exhausted);
+  writer_line("# TYPE nsg_json_pool_outside_total counter");
+  writer_line("nsg_json_pool_outside_total %lu", (unsigned long)pool.outside);
+#endif
+
+  writer_line("# TYPE nsg_wifi_reconnects_total counter");
+  writer_line("nsg_wifi_reconnects_total %lu", (unsigned long)wifi_reconnects.load());
+
+#if CONFIG_NSG_WIFI_POWER_SAVE
+  WifiPower::ps_stats_t ps = WifiPower::get_stats();
+  writer_line("# TYPE nsg_wifi_modem_sleep gauge");
+  writer_line("nsg_wifi_modem_sleep %d", ps.sleeping ? 1 : 0);
+  writer_line("# HELP nsg_wifi_ps_seconds_total Time spent in power save mode");
+  writer_line("# TYPE nsg_wifi_ps_seconds_total counter");
+  writer_line("nsg_wifi_ps_seconds_total{mode=\"none\"} %llu", ps.active_us / 1000000);
+  writer_line("nsg_wifi_ps_seconds_total{mode=\"modem\"} %llu", ps.sleep_us / 1000000);
+  writer_line("# TYPE nsg_wifi_ps_wakeups_total counter");
+  writer_line("nsg_wifi_ps_wakeups_total %lu", (unsigned long)ps.wakeups);
+  writer_line("# HELP nsg_wifi_wake_latency_us Connection accept to first request after sleep");
+  writer_line("# TYPE nsg_wifi_wake_latency_us summary");
+  writer_line("nsg_wifi_wake_latency_us_sum %llu", ps.wake_latency_sum_us);
+  writer_line("nsg_wifi_wake_latency_us_count %lu", (unsigned long)ps.wake_latency_num);
+  writer_line("# TYPE nsg_wifi_wake_latency_max_us gauge");
+  writer_line("nsg_wifi_wake_latency_max_us %lu", (unsigned long)ps.wake_latency_max_us);
+#endif
+
+  wifi_ap_record_t ap_info;
+  if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+    writer_line("# TYPE nsg_wifi_rssi_dbm gauge");
+    writer_line("nsg_wifi_rssi_dbm %d", ap_info.rssi);
+  }
+}
+
+// API: Metrics in text exposition format
+static esp_err_t api_metrics(httpd_req_t* req) {
+  httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+  writer.req = req;
+  writer.len = 0;
+  write_hid_metrics();
+  write_http_metrics();
+  write_system_metrics();
+  writer_flush();
+
+  // Finish chunked response
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// Register /api/metrics endpoint
+esp_err_t init(httpd_handle_t server) {
+  ESP_LOGI(TAG, "Metrics initialization");
+  MemInfo::add_static(MemInfo::Web, "metrics", sizeof(routes) + sizeof(writer));
+
+  // API: Metrics
+  httpd_uri_t cfg_api_metrics = {
+      .uri = "/api/metrics", .method = HTTP_GET, .handler = api_metrics, .user_ctx = NULL};
+  return register_uri_handler(server, &cfg_api_metrics);
+}
+
+}  // namespace Metrics
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+namespace Metrics {
+
+// Maximum number of measured routes
+#define METRICS_ROUTES_MAX 24
+
+// Heap allocations of route handler (maximum per request)
+typedef struct {
+  const char* uri;
+  const char* method;
+  uint32_t allocs_max;   // Allocations
+  uint32_t bytes_max;    // Allocated bytes
+  uint32_t over_budget;  // Requests exceeded allocation budget
+} route_allocs_t;
+
+// Register URI handler with request counters & latency measurement
+// Use it instead of httpd_register_uri_handler() for API routes
+esp_err_t register_uri_handler(httpd_handle_t server, const httpd_uri_t* uri);
+
+// Get heap allocations of routes, returns number of routes
+size_t get_route_allocs(route_allocs_t* allocs, size_t max);
+
+// Count WiFi reconnect
+void count_wifi_reconnect();
+
+// Register /api/metrics endpoint
+esp_err_t init(httpd_handle_t server);
+
+}  // namespace Metrics
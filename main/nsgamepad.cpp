@@ -6,7 +6,10 @@
 #include "esp_console.h"
 #include "esp_log.h"
 #include "freertos/idf_additions.h"
+#include "freertos/semphr.h"
 #include "hid.hpp"
+#include "jobs.hpp"
+#include "profiles.hpp"
 
 namespace NSGamepad {
 
@@ -20,6 +23,7 @@ HID::hid_device_report_t hid_report = {
     .leftYAxis = 0x80,
     .rightXAxis = 0x80,
     .rightYAxis = 0x80,
+    .filler = 0,
 };
 
 // Buttons string list
@@ -33,14 +37,96 @@ static const char* dpad_names[] = {"U", "UR", "R", "DR", "D", "DL", "L", "UL",
                                    "0", "",   "",  "",   "",  "",   "",  ""};
 const int dpad_names_num = 9;
 
+// Gamepad state lock (hid_report & its update)
+static SemaphoreHandle_t state_mtx = NULL;
+static StaticSemaphore_t state_mtx_buf;
+
+// Current job progress
+static job_progress_t job_progress = {};
+static portMUX_TYPE job_progress_mux = portMUX_INITIALIZER_UNLOCKED;
+
+template <typename Change>
+static esp_err_t holdChange(Change change, uint32_t hold_us);
+
+// Init gamepad state lock
+esp_err_t init() {
+  state_mtx = xSemaphoreCreateRecursiveMutexStatic(&state_mtx_buf);
+  return ESP_OK;
+}
+
+Lock::Lock() {
+  xSemaphoreTakeRecursive(state_mtx, portMAX_DELAY);
+}
+
+Lock::~Lock() {
+  xSemaphoreGiveRecursive(state_mtx);
+}
+
+// Find button by name
+bool findButton(const char* name, Buttons* button) {
+  if (!name) return false;
+  for (uint16_t b = 0; b < button_names_num; b++) {
+    if (strcmp(button_names[b], name) == 0) {
+      *button = static_cast<Buttons>(b);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Find dpad direction by name
+bool findDpad(const char* name, DpadDirection* direction) {
+  if (!name) return false;
+  for (uint16_t d = 0; d < dpad_names_num; d++) {
+    if (strcmp(dpad_names[d], name) == 0) {
+      // "0" is the last name & means centered
+      *direction = d == dpad_names_num - 1 ? DpadDirection::centered : static_cast<DpadDirection>(d);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Get button name
+const char* buttonName(Buttons button) {
+  return button < button_names_num ? button_names[button] : "";
+}
+
+// Get dpad direction name
+const char* dpadName(DpadDirection direction) {
+  if (direction == DpadDirection::centered) return dpad_names[dpad_names_num - 1];
+  return direction < dpad_names_num ? dpad_names[direction] : "";
+}
+
 // Update gamepad state (send report to console)
+// Active profile (remap & calibration) is applied to report
 void update() {
-  HID::set_hid_report(hid_report);
+  Lock lock;
+  HID::set_hid_report(Profiles::apply(hid_report));
+}
+
+// Set whole gamepad state
+void setReport(const HID::hid_device_report_t& report, bool u) {
+  ESP_LOGD(TAG, "Set report: buttons: 0x%04x, dpad: %d (%s)", report.buttons, report.dPad,
+           u ? "+upd" : "noupd");
+  Lock lock;
+  hid_report = report;
+
+  if (u) {
+    update();
+  }
+}
+
+// Get whole gamepad state
+HID::hid_device_report_t getReport() {
+  Lock lock;
+  return hid_report;
 }
 
 // Press button
 void press(Buttons button, bool u) {
   ESP_LOGI(TAG, "Press button %i [%s] (%s)", button, button_names[button], u ? "+upd" : "noupd");
+  Lock lock;
   hid_report.buttons |= (uint16_t)1 << button;
 
   if (u) {
@@ -51,6 +137,7 @@ void press(Buttons button, bool u) {
 // Release button
 void release(Buttons button, bool u) {
   ESP_LOGI(TAG, "Release button %i [%s] (%s)", button, button_names[button], u ? "+upd" : "noupd");
+  Lock lock;
   hid_report.buttons &= ~((uint16_t)1 << button);
 
   if (u) {
@@ -61,6 +148,7 @@ void release(Buttons button, bool u) {
 // Release all buttons
 void releaseAll(bool u) {
   ESP_LOGI(TAG, "Release all buttons (%s)", u ? "+upd" : "noupd");
+  Lock lock;
   memset(&hid_report.buttons, 0x00, sizeof(hid_report.buttons));
 
   if (u) {
@@ -69,17 +157,19 @@ void releaseAll(bool u) {
 }
 
 // Press and release button
-void click(Buttons button, uint16_t delay) {
+esp_err_t click(Buttons button, uint16_t delay) {
   ESP_LOGI(TAG, "Click button %i [%s], delay: %ims", button, button_names[button], delay);
-  press(button, true);
-  vTaskDelay(pdMS_TO_TICKS(delay));
-  release(button, true);
-  vTaskDelay(pdMS_TO_TICKS(delay));
+  uint16_t mask = (uint16_t)1 << button;
+  esp_err_t err = holdChange([mask](HID::hid_device_report_t& r) { r.buttons |= mask; },
+                             delay * 1000);
+  if (err != ESP_OK) return err;
+  return holdChange([mask](HID::hid_device_report_t& r) { r.buttons &= ~mask; }, delay * 1000);
 }
 
 // Set dpad direction
 void dpad(DpadDirection d, bool u) {
   ESP_LOGI(TAG, "Set dpad direction [%s] (%s)", dpad_names[d], u ? "+upd" : "noupd");
+  Lock lock;
   hid_report.dPad = d;
 
   if (u) {
@@ -88,19 +178,20 @@ void dpad(DpadDirection d, bool u) {
 }
 
 // Press and release dpad
-void dpadClick(DpadDirection d, uint16_t delay) {
+esp_err_t dpadClick(DpadDirection d, uint16_t delay) {
   ESP_LOGI(TAG, "Click dpad in direction [%s], delay: %ims", dpad_names[d], delay);
 
-  dpad(d, true);
-  vTaskDelay(pdMS_TO_TICKS(delay));
-  dpad(DpadDirection::centered, true);
-  vTaskDelay(pdMS_TO_TICKS(delay));
+  esp_err_t err = holdChange([d](HID::hid_device_report_t& r) { r.dPad = d; }, delay * 1000);
+  if (err != ESP_OK) return err;
+  return holdChange([](HID::hid_device_report_t& r) { r.dPad = DpadDirection::centered; },
+                    delay * 1000);
 }
 
 // Left stick axis
 void leftAxis(uint8_t x, uint8_t y, bool u) {
   ESP_LOGI(TAG, "Set left axis value: x: %d / y: %d (%s)", x, y, u ? "+upd" : "noupd");
 
+  Lock lock;
   hid_report.leftXAxis = x;
   hid_report.leftYAxis = y;
 
@@ -113,6 +204,7 @@ void leftAxis(uint8_t x, uint8_t y, bool u) {
 void rightAxis(uint8_t x, uint8_t y, bool u) {
   ESP_LOGI(TAG, "Set right axis value: x: %d / y: %d (%s)", x, y, u ? "+upd" : "noupd");
 
+  Lock lock;
   hid_report.rightXAxis = x;
   hid_report.rightYAxis = y;
 
@@ -121,6 +213,118 @@ void rightAxis(uint8_t x, uint8_t y, bool u) {
   }
 }
 
+// Start new job with total steps
+void jobBegin(uint32_t id, uint16_t total) {
+  taskENTER_CRITICAL(&job_progress_mux);
+  job_progress.id = id;
+  job_progress.step = 0;
+  job_progress.total = total;
+  job_progress.active = true;
+  job_progress.paused = false;
+  job_progress.aborted = false;
+  taskEXIT_CRITICAL(&job_progress_mux);
+}
+
+// Mark one job step as completed
+void jobStep() {
+  taskENTER_CRITICAL(&job_progress_mux);
+  if (job_progress.active && job_progress.step < job_progress.total) {
+    job_progress.step++;
+  }
+  taskEXIT_CRITICAL(&job_progress_mux);
+}
+
+// Finish current job
+void jobEnd() {
+  taskENTER_CRITICAL(&job_progress_mux);
+  job_progress.active = false;
+  job_progress.paused = false;
+  taskEXIT_CRITICAL(&job_progress_mux);
+}
+
+// Make preempted job current again
+void jobRestore(const job_progress_t& progress) {
+  taskENTER_CRITICAL(&job_progress_mux);
+  job_progress = progress;
+  job_progress.active = true;
+  taskEXIT_CRITICAL(&job_progress_mux);
+}
+
+// Get current (or last) job progress
+job_progress_t jobProgress() {
+  taskENTER_CRITICAL(&job_progress_mux);
+  job_progress_t progress = job_progress;
+  taskEXIT_CRITICAL(&job_progress_mux);
+  return progress;
+}
+
+// Gamepad reconnection timeout of paused job
+#if CONFIG_NSG_JOB_RESUME_TIMEOUT_S
+#define JOB_RESUME_TIMEOUT_MS (CONFIG_NSG_JOB_RESUME_TIMEOUT_S * 1000)
+#else
+#define JOB_RESUME_TIMEOUT_MS UINT32_MAX
+#endif
+
+// Pause job until gamepad is connected
+static esp_err_t jobPause() {
+  taskENTER_CRITICAL(&job_progress_mux);
+  job_progress.paused = true;
+  job_progress_t progress = job_progress;
+  taskEXIT_CRITICAL(&job_progress_mux);
+  ESP_LOGI(TAG, "Job %lu paused at step %u/%u, waiting for gamepad", (unsigned long)progress.id,
+           progress.step, progress.total);
+
+  // Wake up suspended host, resume takes the init sequence time only
+  HID::request_remote_wakeup();
+  bool connected = HID::wait_gamepad_connected(JOB_RESUME_TIMEOUT_MS);
+
+  taskENTER_CRITICAL(&job_progress_mux);
+  job_progress.paused = false;
+  job_progress.aborted = !connected;
+  taskEXIT_CRITICAL(&job_progress_mux);
+  if (!connected) {
+    ESP_LOGW(TAG, "Job %lu aborted, gamepad isn't connected", (unsigned long)progress.id);
+    return ESP_ERR_TIMEOUT;
+  }
+  ESP_LOGI(TAG, "Job %lu resumed", (unsigned long)progress.id);
+  return ESP_OK;
+}
+
+// Change gamepad state & hold it for given time, job is paused while gamepad is disconnected
+// State is changed & sent under state lock, but isn't locked during hold & pause, so inputs of
+// other tasks meanwhile are kept
+template <typename Change>
+static esp_err_t holdChange(Change change, uint32_t hold_us) {
+  bool changed = false;
+  while (1) {
+    job_progress_t progress = jobProgress();
+    if (progress.active && progress.aborted) return ESP_ERR_INVALID_STATE;
+
+    uint32_t connection = HID::get_connection_num();
+    esp_err_t ret;
+    {
+      Lock lock;
+      if (!changed) change(hid_report);
+      changed = true;
+      ret = HID::set_hid_report(Profiles::apply(hid_report));
+    }
+    if (ret == ESP_ERR_INVALID_STATE) {
+      esp_err_t err = jobPause();
+      if (err != ESP_OK) return err;
+      continue;
+    }
+    HID::delay_us(hold_us);
+
+    // Connection is lost during hold, state is sent again after reconnection
+    if (HID::get_connection_num() == connection && HID::is_gamepad_connected()) return ESP_OK;
+  }
+}
+
+// Set whole gamepad state & hold it for given time
+esp_err_t hold(const HID::hid_device_report_t& report, uint32_t hold_us) {
+  return holdChange([&report](HID::hid_device_report_t& r) { r = report; }, hold_us);
+}
+
 // Args for press & release cmds
 static struct {
   struct arg_str* button =
@@ -232,13 +436,22 @@ static int cmd_click(int argc, char** argv) {
     delay = cmd_click_args.delay->ival[0];
   }
 
+  Jobs::Job job;
+  if (job.begin(JOBS_CLIENT_CONSOLE, cmd_click_args.button->count,
+                cmd_click_args.button->count * delay * 2) != ESP_OK) {
+    printf("Job queue is full\r\n");
+    return 1;
+  }
   for (int i = 0; i < cmd_click_args.button->count; i++) {
     // Search button
     bool clicked = false;
     for (uint16_t b = 0; b < button_names_num; b++) {
       if (strcmp(button_names[b], cmd_click_args.button->sval[i]) == 0) {
         // Click button
-        click(static_cast<Buttons>(b), delay);
+        if (click(static_cast<Buttons>(b), delay) != ESP_OK) {
+          printf("Job aborted: gamepad is disconnected\r\n");
+          return 1;
+        }
         clicked = true;
         break;
       }
@@ -246,7 +459,9 @@ static int cmd_click(int argc, char** argv) {
     if (!clicked) {
       printf("Unrecognized button: \"%s\"\r\n", cmd_click_args.button->sval[i]);
     }
+    job.step();
   }
+  job.end();
 
   return 0;
 }
@@ -314,13 +529,22 @@ static int cmd_dpad(int argc, char** argv) {
     delay = cmd_dpad_args.delay->ival[0];
   }
 
+  Jobs::Job job;
+  if (job.begin(JOBS_CLIENT_CONSOLE, cmd_dpad_args.direction->count,
+                cmd_dpad_args.direction->count * delay * 2) != ESP_OK) {
+    printf("Job queue is full\r\n");
+    return 1;
+  }
   for (int i = 0; i < cmd_dpad_args.direction->count; i++) {
     // Search direction
     bool clicked = false;
     for (uint16_t d = 0; d < dpad_names_num; d++) {
       if (strcmp(dpad_names[d], cmd_dpad_args.direction->sval[i]) == 0) {
         // Set direction
-        dpadClick(static_cast<DpadDirection>(d), delay);
+        if (dpadClick(static_cast<DpadDirection>(d), delay) != ESP_OK) {
+          printf("Job aborted: gamepad is disconnected\r\n");
+          return 1;
+        }
         clicked = true;
         break;
       }
@@ -328,7 +552,9 @@ static int cmd_dpad(int argc, char** argv) {
     if (!clicked) {
       printf("Unrecognized direction: \"%s\"\r\n", cmd_dpad_args.direction->sval[i]);
     }
+    job.step();
   }
+  job.end();
 
   return 0;
 }
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include "esp_err.h"
+#include "hid.hpp"
 
 namespace NSGamepad {
 
@@ -38,9 +39,41 @@ enum DpadDirection : uint8_t {
   centered = 0xF
 };
 
+// Find button by name (e.g. "A", "ZL", "Home")
+// Returns false, if name is unknown
+bool findButton(const char* name, Buttons* button);
+// Find dpad direction by name (e.g. "U", "DL", "0")
+// Returns false, if name is unknown
+bool findDpad(const char* name, DpadDirection* direction);
+
+// Get button name
+const char* buttonName(Buttons button);
+// Get dpad direction name
+const char* dpadName(DpadDirection direction);
+
+// Gamepad state lock
+// Keeps several state changes & update() together, so inputs of other tasks (HTTP server,
+// input task, job workers, CDC control) aren't lost in between. Recursive, state functions
+// below take it as well, so single calls don't need it
+class Lock {
+ public:
+  Lock();
+  ~Lock();
+  Lock(const Lock&) = delete;
+  Lock& operator=(const Lock&) = delete;
+};
+
+// Init gamepad state lock
+esp_err_t init();
+
 // Update gamepad state (send report to console)
 void update();
 
+// Set whole gamepad state (buttons, dpad & axes at once)
+void setReport(const HID::hid_device_report_t& report, bool update = false);
+// Get whole gamepad state (before profile is applied)
+HID::hid_device_report_t getReport();
+
 // Press button
 void press(Buttons button, bool update = false);
 // Release button
@@ -49,18 +82,49 @@ void release(Buttons button, bool update = false);
 void releaseAll(bool update = false);
 
 // Press and release button
-void click(Buttons button, uint16_t delay = 100);
+// Returns error, if job is aborted (gamepad isn't reconnected during resume timeout)
+esp_err_t click(Buttons button, uint16_t delay = 100);
 
 // Set dpad pressed buttons
 void dpad(DpadDirection direction, bool update = false);
 // Press and release dpad
-void dpadClick(DpadDirection direction, uint16_t delay = 100);
+// Returns error, if job is aborted (gamepad isn't reconnected during resume timeout)
+esp_err_t dpadClick(DpadDirection direction, uint16_t delay = 100);
 
 // Left stick axis
 void leftAxis(uint8_t x, uint8_t y, bool update = false);
 // Right stick axis
 void rightAxis(uint8_t x, uint8_t y, bool update = false);
 
+// Job progress (multi-step input sequence, e.g. several clicks)
+typedef struct {
+  uint32_t id;     // Job identifier, incremented for each job (0 - no jobs yet)
+  uint16_t step;   // Completed steps
+  uint16_t total;  // Total steps of job
+  bool active;     // Job is running
+  bool paused;     // Job waits for gamepad connection (USB suspended or unmounted)
+  bool aborted;    // Gamepad isn't connected during resume timeout, remaining steps are skipped
+} job_progress_t;
+
+// Start new job with total steps, jobs are started by scheduler (see jobs.hpp)
+void jobBegin(uint32_t id, uint16_t total);
+// Mark one job step as completed
+void jobStep();
+// Finish current job
+void jobEnd();
+// Make preempted job current again with its saved progress
+void jobRestore(const job_progress_t& progress);
+// Get current (or last) job progress
+// Thread-safe
+job_progress_t jobProgress();
+
+// Set whole gamepad state & hold it for given time (one part of job step)
+// While gamepad is disconnected, job is paused at this state. After reconnection state is sent
+// again & hold is restarted, so host doesn't miss input, which was interrupted by suspend.
+// Returns ESP_ERR_TIMEOUT, if gamepad isn't connected during resume timeout (job is aborted),
+// after that it returns ESP_ERR_INVALID_STATE until the job ends
+esp_err_t hold(const HID::hid_device_report_t& report, uint32_t hold_us);
+
 // Register console commands
 esp_err_t cmds_register();
 
@@ -0,0 +1,486 @@
+#include "ota.hpp"
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#include "esp_app_desc.h"
+#include "esp_attr.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "hid.hpp"
+#include "mbedtls/sha256.h"
+#include "meminfo.hpp"
+#include "metrics.hpp"
+#include "nsgamepad.hpp"
+#include "stream.hpp"
+
+namespace Ota {
+
+#if CONFIG_NSG_OTA
+
+static const char* TAG = "app ota";
+
+// Receive chunk & flash write slice (one slice per gap between HID ticks)
+#define OTA_RECV_CHUNK 4096
+#define OTA_WRITE_SLICE 1024
+
+// Idle period before switch to staged image
+#define OTA_IDLE_US ((int64_t)CONFIG_NSG_OTA_IDLE_S * 1000000)
+
+// Switch record, kept in RTC memory over software restart
+#define OTA_SWITCH_MAGIC 0x4F544131
+typedef struct {
+  uint32_t magic;
+  int64_t restart_time_us;  // System time of restart
+} switch_record_t;
+static RTC_NOINIT_ATTR switch_record_t switch_record;
+
+// Receive buffer & hash, used by one update at the same time
+static uint8_t recv_buf[OTA_RECV_CHUNK];
+static mbedtls_sha256_context sha_ctx;
+static std::atomic<bool> busy = false;
+
+// Status & partition with staged image, changed under mutex
+static StaticSemaphore_t status_mtx_buf;
+static SemaphoreHandle_t status_mtx;
+static ota_status_t status = {.state = Idle, .downtime_ms = -1, .restart_ms = -1};
+static const esp_partition_t* staged_part = NULL;
+
+// Downtime of previous switch is measured on gamepad connection
+static bool downtime_pending = false;
+static int64_t restart_time_us = 0;
+// Running image is confirmed (rollback is cancelled)
+static bool app_confirmed = false;
+
+// Idle tracking for switch (used only from web task)
+static int64_t idle_since_us = 0;
+static HID::hid_device_report_t idle_report = {};
+
+// Get system time, it is kept over software restart (RTC timer)
+static int64_t system_time_us() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// Get reboot mode name
+static const char* reboot_name(Reboot reboot) {
+  switch (reboot) {
+    case RebootIdle:
+      return "idle";
+    case RebootNow:
+      return "now";
+    default:
+      return "manual";
+  }
+}
+
+// Parse reboot mode name
+static bool parse_reboot(const char* name, Reboot* reboot) {
+  for (Reboot r : {RebootIdle, RebootNow, RebootManual}) {
+    if (strcmp(name, reboot_name(r)) == 0) {
+      *reboot = r;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Get state name
+static const char* state_name(State state) {
+  switch (state) {
+    case Idle:
+      return "idle";
+    case Receiving:
+      return "receiving";
+    case Staged:
+      return "staged";
+    default:
+      return "failed";
+  }
+}
+
+// Check result of previous switch
+esp_err_t init() {
+  status_mtx = xSemaphoreCreateMutexStatic(&status_mtx_buf);
+  MemInfo::add_static(MemInfo::Web, "ota", sizeof(recv_buf) + sizeof(sha_ctx));
+
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  ESP_LOGI(TAG, "Running partition: %s, version: %s", running->label,
+           esp_app_get_description()->version);
+
+  if (switch_record.magic == OTA_SWITCH_MAGIC) {
+    switch_record.magic = 0;
+    restart_time_us = switch_record.restart_time_us;
+    status.restart_ms = (system_time_us() - restart_time_us) / 1000;
+    downtime_pending = true;
+    ESP_LOGI(TAG, "Switched to new image, restart took %ld ms", (long)status.restart_ms);
+  }
+  return ESP_OK;
+}
+
+// Update status under mutex
+template <typename F>
+static void with_status(F fn) {
+  xSemaphoreTake(status_mtx, portMAX_DELAY);
+  fn(status);
+  xSemaphoreGive(status_mtx);
+}
+
+// Write image data by slices, each slice right after HID report is delivered,
+// so flash operation (cache is disabled) falls into gap between HID ticks
+static esp_err_t write_aligned(esp_ota_handle_t handle, const uint8_t* data, size_t len) {
+  for (size_t done = 0; done < len; done += OTA_WRITE_SLICE) {
+    if (HID::is_gamepad_connected()) {
+      HID::wait_report_completed(HID::get_poll_interval() * 2);
+    }
+    esp_err_t err =
+        esp_ota_write(handle, data + done, std::min<size_t>(OTA_WRITE_SLICE, len - done));
+    if (err != ESP_OK) return err;
+  }
+  return ESP_OK;
+}
+
+// Stream request body into inactive partition, hash it & verify image
+static esp_err_t receive_image(httpd_req_t* req, const esp_partition_t* part, char* sha256) {
+  esp_ota_handle_t handle;
+  // Sectors are erased with sequential writes, not whole partition at once
+  esp_err_t err = esp_ota_begin(part, OTA_WITH_SEQUENTIAL_WRITES, &handle);
+  if (err != ESP_OK) return err;
+
+  mbedtls_sha256_init(&sha_ctx);
+  mbedtls_sha256_starts(&sha_ctx, 0);
+  size_t received = 0;
+  while (received < req->content_len) {
+    int len = httpd_req_recv(req, (char*)recv_buf,
+                             std::min(sizeof(recv_buf), req->content_len - received));
+    if (len == HTTPD_SOCK_ERR_TIMEOUT) continue;
+    if (len <= 0) {
+      err = ESP_ERR_INVALID_SIZE;
+      break;
+    }
+    mbedtls_sha256_update(&sha_ctx, recv_buf, len);
+    err = write_aligned(handle, recv_buf, len);
+    if (err != ESP_OK) break;
+    received += len;
+    with_status([received](ota_status_t& s) { s.received = received; });
+  }
+
+  uint8_t digest[32];
+  mbedtls_sha256_finish(&sha_ctx, digest);
+  mbedtls_sha256_free(&sha_ctx);
+  for (size_t i = 0; i < sizeof(digest); i++) {
+    sprintf(sha256 + i * 2, "%02x", digest[i]);
+  }
+
+  if (err != ESP_OK) {
+    esp_ota_abort(handle);
+    return err;
+  }
+  // Image header, segments & checksum are validated
+  return esp_ota_end(handle);
+}
+
+// Send API error response for update error
+static esp_err_t send_error(httpd_req_t* req, esp_err_t err) {
+  switch (err) {
+    case ESP_ERR_INVALID_SIZE:
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Image is truncated or too large");
+      break;
+    case ESP_ERR_INVALID_CRC:
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "SHA-256 mismatch");
+      break;
+    case ESP_ERR_OTA_VALIDATE_FAILED:
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Image validation failed");
+      break;
+    default:
+      httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, esp_err_to_name(err));
+      break;
+  }
+  return ESP_FAIL;
+}
+
+// API: Upload firmware image (?sha256=hex&reboot=idle|now|manual, body is image)
+static esp_err_t api_ota_post(httpd_req_t* req) {
+  char query[128];
+  char value[72];
+  char expected[65] = "";
+  Reboot reboot = RebootIdle;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    if (httpd_query_key_value(query, "sha256", value, sizeof(value)) == ESP_OK) {
+      if (strlen(value) != 64) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong SHA-256");
+        return ESP_FAIL;
+      }
+      strlcpy(expected, value, sizeof(expected));
+    }
+    if (httpd_query_key_value(query, "reboot", value, sizeof(value)) == ESP_OK &&
+        !parse_reboot(value, &reboot)) {
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong reboot mode");
+      return ESP_FAIL;
+    }
+  }
+
+  const esp_partition_t* part = esp_ota_get_next_update_partition(NULL);
+  if (!part) {
+    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "No OTA partition");
+    return ESP_FAIL;
+  }
+  if (req->content_len == 0 || req->content_len > part->size) {
+    return send_error(req, ESP_ERR_INVALID_SIZE);
+  }
+  if (busy.exchange(true)) {
+    httpd_resp_set_status(req, "409 Conflict");
+    httpd_resp_sendstr(req, "Update is in progress");
+    return ESP_OK;
+  }
+
+  ESP_LOGI(TAG, "Update started: %u bytes into %s", req->content_len, part->label);
+  with_status([req](ota_status_t& s) {
+    staged_part = NULL;
+    s.state = Receiving;
+    s.received = 0;
+    s.total = req->content_len;
+    s.sha256[0] = '\0';
+  });
+  HID::hid_stats_t hid_start = HID::get_stats();
+  int64_t start = esp_timer_get_time();
+
+  char sha256[65];
+  esp_err_t err = receive_image(req, part, sha256);
+  if (err == ESP_OK && expected[0] && strcasecmp(sha256, expected) != 0) {
+    err = ESP_ERR_INVALID_CRC;
+  }
+
+  HID::hid_stats_t hid_end = HID::get_stats();
+  with_status([&](ota_status_t& s) {
+    s.state = err == ESP_OK ? Staged : Failed;
+    s.reboot = reboot;
+    if (err == ESP_OK) staged_part = part;
+    s.elapsed_ms = (esp_timer_get_time() - start) / 1000;
+    s.ticks_sent = hid_end.ticks_sent - hid_start.ticks_sent;
+    s.ticks_missed = hid_end.ticks_missed - hid_start.ticks_missed;
+    strlcpy(s.sha256, sha256, sizeof(s.sha256));
+  });
+  ota_status_t s = get_status();
+
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Update failed: %s", esp_err_to_name(err));
+    busy = false;
+    return send_error(req, err);
+  }
+  busy = false;
+  ESP_LOGI(TAG, "Image is staged in %s: %lu ms, HID ticks missed: %lu, switch: %s", part->label,
+           (unsigned long)s.elapsed_ms, (unsigned long)s.ticks_missed, reboot_name(reboot));
+
+  char buf[256];
+  snprintf(buf, sizeof(buf),
+           "{\"bytes\":%lu,\"sha256\":\"%s\",\"partition\":\"%s\",\"elapsed_ms\":%lu,"
+           "\"hid_ticks_sent\":%lu,\"hid_ticks_missed\":%lu,\"reboot\":\"%s\"}",
+           (unsigned long)s.total, s.sha256, part->label, (unsigned long)s.elapsed_ms,
+           (unsigned long)s.ticks_sent, (unsigned long)s.ticks_missed, reboot_name(reboot));
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_sendstr(req, buf);
+  return ESP_OK;
+}
+
+// API: Switch to staged image (?reboot=now|idle)
+static esp_err_t api_ota_apply(httpd_req_t* req) {
+  char query[32];
+  char value[8];
+  Reboot reboot = RebootNow;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "reboot", value, sizeof(value)) == ESP_OK &&
+      (!parse_reboot(value, &reboot) || reboot == RebootManual)) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong reboot mode");
+    return ESP_FAIL;
+  }
+
+  bool staged = false;
+  with_status([&](ota_status_t& s) {
+    staged = s.state == Staged;
+    if (staged) s.reboot = reboot;
+  });
+  if (!staged) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No staged image");
+    return ESP_FAIL;
+  }
+  httpd_resp_sendstr(req, "OK");
+  return ESP_OK;
+}
+
+// API: Update status & downtime of last switch
+static esp_err_t api_ota_get(httpd_req_t* req) {
+  ota_status_t s = get_status();
+  char buf[384];
+  snprintf(buf, sizeof(buf),
+           "{\"running\":\"%s\",\"version\":\"%s\",\"state\":\"%s\",\"reboot\":\"%s\","
+           "\"received\":%lu,\"total\":%lu,\"elapsed_ms\":%lu,\"sha256\":\"%s\","
+           "\"hid_ticks_sent\":%lu,\"hid_ticks_missed\":%lu,\"downtime_ms\":%ld,"
+           "\"restart_ms\":%ld}",
+           esp_ota_get_running_partition()->label, esp_app_get_description()->version,
+           state_name(s.state), reboot_name(s.reboot), (unsigned long)s.received,
+           (unsigned long)s.total, (unsigned long)s.elapsed_ms, s.sha256,
+           (unsigned long)s.ticks_sent, (unsigned long)s.ticks_missed, (long)s.downtime_ms,
+           (long)s.restart_ms);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_sendstr(req, buf);
+  return ESP_OK;
+}
+
+// Register OTA API endpoints
+esp_err_t api_register(httpd_handle_t server) {
+  // API: Update status
+  httpd_uri_t cfg_api_ota_get = {
+      .uri = "/api/ota", .method = HTTP_GET, .handler = api_ota_get, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_ota_get);
+
+  // API: Upload image
+  httpd_uri_t cfg_api_ota_post = {
+      .uri = "/api/ota", .method = HTTP_POST, .handler = api_ota_post, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_ota_post);
+
+  // API: Switch to staged image
+  httpd_uri_t cfg_api_ota_apply = {
+      .uri = "/api/ota/apply", .method = HTTP_POST, .handler = api_ota_apply, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_ota_apply);
+
+  return ESP_OK;
+}
+
+// Gamepad is idle: no job & stream, buttons are released & report isn't changed for idle period
+static bool is_idle(int64_t now) {
+  HID::hid_device_report_t report = HID::get_hid_report();
+  if (NSGamepad::jobProgress().active || Stream::get_stats().active || report.buttons != 0 ||
+      memcmp(&report, &idle_report, sizeof(report)) != 0) {
+    idle_report = report;
+    idle_since_us = now;
+    return false;
+  }
+  return now - idle_since_us >= OTA_IDLE_US;
+}
+
+// Switch to staged image
+static void switch_image(const esp_partition_t* part) {
+  esp_err_t err = esp_ota_set_boot_partition(part);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
+    with_status([](ota_status_t& s) { s.state = Failed; });
+    return;
+  }
+
+  ESP_LOGI(TAG, "Switching to new image in %s", part->label);
+  // Host sees released input until reconnection
+  NSGamepad::releaseAll(true);
+  switch_record.restart_time_us = system_time_us();
+  switch_record.magic = OTA_SWITCH_MAGIC;
+  esp_restart();
+}
+
+// Switch to staged image at chosen moment, measure downtime after switch
+void update() {
+  int64_t now = esp_timer_get_time();
+
+  if (HID::is_gamepad_connected()) {
+    // Downtime of switch: restart to gamepad connection
+    if (downtime_pending) {
+      downtime_pending = false;
+      int32_t downtime_ms = (system_time_us() - restart_time_us) / 1000;
+      with_status([downtime_ms](ota_status_t& s) { s.downtime_ms = downtime_ms; });
+      ESP_LOGI(TAG, "Gamepad is connected after switch, downtime: %ld ms", (long)downtime_ms);
+    }
+    // New image works, cancel rollback (if it is enabled in bootloader)
+    if (!app_confirmed) {
+      app_confirmed = true;
+      esp_ota_mark_app_valid_cancel_rollback();
+    }
+  }
+
+  bool idle = is_idle(now);
+  const esp_partition_t* part = NULL;
+  Reboot reboot = RebootManual;
+  with_status([&](ota_status_t& s) {
+    if (s.state == Staged) part = staged_part;
+    reboot = s.reboot;
+  });
+  if (part && (reboot == RebootNow || (reboot == RebootIdle && idle))) switch_image(part);
+}
+
+// Get update status
+ota_status_t get_status() {
+  if (!status_mtx) return {};
+  xSemaphoreTake(status_mtx, portMAX_DELAY);
+  ota_status_t s = status;
+  xSemaphoreGive(status_mtx);
+  return s;
+}
+
+// CMD: Prints OTA update information
+static int cmd_ota(int argc, char** argv) {
+  ota_status_t s = get_status();
+  printf("OTA: running %s (version %s), update %s\r\n", esp_ota_get_running_partition()->label,
+         esp_app_get_description()->version, state_name(s.state));
+  if (s.total) {
+    printf("  Image: %lu/%lu bytes in %lu ms, SHA-256 %s\r\n", (unsigned long)s.received,
+           (unsigned long)s.total, (unsigned long)s.elapsed_ms, s.sha256[0] ? s.sha256 : "-");
+    printf("  HID ticks during download: sent %lu, missed %lu\r\n",
+           (unsigned long)s.ticks_sent, (unsigned long)s.ticks_missed);
+  }
+  if (s.state == Staged) printf("  Switch: %s\r\n", reboot_name(s.reboot));
+  if (s.restart_ms >= 0) {
+    printf("  Last switch: restart %ld ms, downtime (to gamepad connection) %ld ms\r\n",
+           (long)s.restart_ms, (long)s.downtime_ms);
+  }
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_ota_cfg = {
+      .command = "ota",
+      .help = "Get OTA update information",
+      .hint = NULL,
+      .func = &cmd_ota,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_ota_cfg));
+
+  return ESP_OK;
+}
+
+#else
+
+// OTA update is disabled
+esp_err_t init() {
+  return ESP_OK;
+}
+
+esp_err_t api_register(httpd_handle_t server) {
+  return ESP_OK;
+}
+
+void update() {}
+
+// Get update status
+ota_status_t get_status() {
+  return {};
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  return ESP_OK;
+}
+
+#endif
+
+}  // namespace Ota
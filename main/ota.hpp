@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+// Streaming OTA update
+// Image is streamed from request body into inactive app partition in small chunks & hashed
+// on the fly, flash writes are aligned with gaps between HID ticks. Device switches to new image
+// at chosen moment (immediately, when gamepad is idle or on request), downtime is measured
+namespace Ota {
+
+// Update state
+enum State : uint8_t {
+  Idle,       // No update
+  Receiving,  // Image is streamed into inactive partition
+  Staged,     // Image is written & verified, waits for switch
+  Failed,     // Last update is failed
+};
+
+// Moment of switch to new image
+enum Reboot : uint8_t {
+  RebootIdle,    // When gamepad is idle (no job, stream & pressed input)
+  RebootNow,     // Immediately after update
+  RebootManual,  // On /api/ota/apply request
+};
+
+// Update status
+typedef struct {
+  State state;
+  Reboot reboot;               // Moment of switch for staged image
+  uint32_t received;           // Received bytes of image
+  uint32_t total;              // Image size
+  uint32_t elapsed_ms;         // Download & write time
+  uint32_t ticks_sent;         // HID ticks with report during download
+  uint32_t ticks_missed;       // HID ticks missed during download
+  char sha256[65];             // SHA-256 of image (hex)
+  int32_t downtime_ms;         // Last switch: restart to gamepad connection (-1 - unknown)
+  int32_t restart_ms;          // Last switch: restart to application start (-1 - unknown)
+} ota_status_t;
+
+// Check result of previous switch (downtime measurement)
+esp_err_t init();
+
+// Register OTA API endpoints
+esp_err_t api_register(httpd_handle_t server);
+
+// Switch to staged image at chosen moment, measure downtime after switch
+// Called periodically from web task
+void update();
+
+// Get update status
+// Thread-safe
+ota_status_t get_status();
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace Ota
@@ -0,0 +1,603 @@
+#include "profiles.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include "argtable3/argtable3.h"
+#include "cJSON.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "json_pool.hpp"
+#include "meminfo.hpp"
+#include "metrics.hpp"
+#include "nsgamepad.hpp"
+#include "nvs.h"
+
+namespace Profiles {
+
+static const char* TAG = "app profiles";
+
+// NVS storage
+#define PROFILES_NVS_NAMESPACE "nsg_profiles"
+#define PROFILES_NVS_KEY_ACTIVE "active"
+
+// Axes string list
+static const char* axis_names[AxesNum] = {"lx", "ly", "rx", "ry"};
+
+// Compiled profile
+// Lookup tables, so report mapping takes constant time per tick
+typedef struct {
+  uint16_t buttons_lo[256];    // Output buttons mask for low byte of input buttons
+  uint16_t buttons_hi[256];    // Output buttons mask for high byte of input buttons
+  uint8_t dpad[16];            // Output direction for input direction (hat value)
+  uint8_t axes[AxesNum][256];  // Output value for input axis value
+} compiled_t;
+
+// Compiled profiles, active one is used by apply(), another one is compiled on switch.
+// Switches are serialized & take NVS access time, while apply() reads table for
+// less than microsecond, so table is never rewritten while it is read
+static compiled_t tables[2];
+static std::atomic<const compiled_t*> active_table = &tables[0];
+static uint8_t active_slot = 0;
+
+// Serializes profiles changes
+static StaticSemaphore_t profiles_mtx_buf;
+static SemaphoreHandle_t profiles_mtx;
+
+// Request body buffer for API
+static char body_buf[1024];
+
+// Get identity profile (no remap, no calibration)
+profile_t identity() {
+  profile_t p = {};
+  strlcpy(p.name, "default", sizeof(p.name));
+  for (uint8_t b = 0; b < 16; b++) p.buttons[b] = b;
+  for (uint8_t d = 0; d < 8; d++) p.dpad[d] = d;
+  for (axis_cfg_t& a : p.axes) {
+    a.deadzone = 0;
+    a.curve = 100;
+    a.invert = false;
+  }
+  return p;
+}
+
+// Check profile values
+static bool is_valid(const profile_t& p) {
+  for (uint8_t b : p.buttons) {
+    if (b >= 16) return false;
+  }
+  for (uint8_t d : p.dpad) {
+    if (d >= 8) return false;
+  }
+  for (const axis_cfg_t& a : p.axes) {
+    if (a.deadzone > 127 || a.curve < 25) return false;
+  }
+  return true;
+}
+
+// Compile axis lookup table
+static void compile_axis(const axis_cfg_t& cfg, uint8_t lut[256]) {
+  const float deadzone = cfg.deadzone / 127.0f;
+  const float exponent = cfg.curve / 100.0f;
+  for (int v = 0; v < 256; v++) {
+    // Normalize to -1..1 around center (0x80), range is 128 down & 127 up
+    float x = v < 0x80 ? (v - 0x80) / 128.0f : (v - 0x80) / 127.0f;
+    float magnitude = std::fabs(x);
+    float y = 0;
+    if (magnitude > deadzone) {
+      y = std::pow((magnitude - deadzone) / (1.0f - deadzone), exponent);
+      if (x < 0) y = -y;
+    }
+    if (cfg.invert) y = -y;
+    float out = 0x80 + y * (y < 0 ? 128.0f : 127.0f);
+    lut[v] = (uint8_t)std::lround(std::fmax(0.0f, std::fmin(255.0f, out)));
+  }
+}
+
+// Compile profile to lookup tables
+static void compile(const profile_t& p, compiled_t& t) {
+  for (int v = 0; v < 256; v++) {
+    uint16_t lo = 0;
+    uint16_t hi = 0;
+    for (int b = 0; b < 8; b++) {
+      if (v & (1 << b)) {
+        lo |= (uint16_t)1 << p.buttons[b];
+        hi |= (uint16_t)1 << p.buttons[b + 8];
+      }
+    }
+    t.buttons_lo[v] = lo;
+    t.buttons_hi[v] = hi;
+  }
+
+  // Only directions are remapped, other hat values (centered) stay as is
+  for (int d = 0; d < 16; d++) {
+    t.dpad[d] = d < 8 ? p.dpad[d] : d;
+  }
+
+  for (int a = 0; a < AxesNum; a++) {
+    compile_axis(p.axes[a], t.axes[a]);
+  }
+}
+
+// Apply active profile to gamepad report
+HID::hid_device_report_t apply(const HID::hid_device_report_t& report) {
+  const compiled_t* t = active_table.load(std::memory_order_acquire);
+  HID::hid_device_report_t r = report;
+  r.buttons = t->buttons_lo[report.buttons & 0xFF] | t->buttons_hi[report.buttons >> 8];
+  r.dPad = t->dpad[report.dPad & 0x0F];
+  r.leftXAxis = t->axes[LeftX][report.leftXAxis];
+  r.leftYAxis = t->axes[LeftY][report.leftYAxis];
+  r.rightXAxis = t->axes[RightX][report.rightXAxis];
+  r.rightYAxis = t->axes[RightY][report.rightYAxis];
+  return r;
+}
+
+// NVS key of profile slot
+static void slot_key(uint8_t slot, char key[8]) {
+  snprintf(key, 8, "slot%u", slot);
+}
+
+// Get profile definition
+esp_err_t get(uint8_t slot, profile_t* profile) {
+  if (slot >= PROFILES_NUM) return ESP_ERR_INVALID_ARG;
+  *profile = identity();
+
+  nvs_handle_t nvs;
+  if (nvs_open(PROFILES_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) return ESP_OK;
+  char key[8];
+  slot_key(slot, key);
+  profile_t stored;
+  size_t len = sizeof(stored);
+  if (nvs_get_blob(nvs, key, &stored, &len) == ESP_OK && len == sizeof(stored) &&
+      is_valid(stored)) {
+    stored.name[sizeof(stored.name) - 1] = '\0';
+    *profile = stored;
+  }
+  nvs_close(nvs);
+  return ESP_OK;
+}
+
+// Compile profile of slot into inactive table & make it active
+// Should be called with profiles mutex taken
+static void activate(uint8_t slot) {
+  profile_t p;
+  get(slot, &p);
+  compiled_t* next = active_table.load() == &tables[0] ? &tables[1] : &tables[0];
+  compile(p, *next);
+  active_table.store(next, std::memory_order_release);
+  active_slot = slot;
+  ESP_LOGI(TAG, "Profile %u \"%s\" is active", slot, p.name);
+}
+
+// Get active profile slot
+uint8_t get_active() {
+  return active_slot;
+}
+
+// Switch active profile
+esp_err_t set_active(uint8_t slot) {
+  if (slot >= PROFILES_NUM) return ESP_ERR_INVALID_ARG;
+
+  xSemaphoreTake(profiles_mtx, portMAX_DELAY);
+  activate(slot);
+  nvs_handle_t nvs;
+  esp_err_t err = nvs_open(PROFILES_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+  if (err == ESP_OK) {
+    err = nvs_set_u8(nvs, PROFILES_NVS_KEY_ACTIVE, slot);
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+  }
+  xSemaphoreGive(profiles_mtx);
+  return err;
+}
+
+// Save profile definition to NVS
+esp_err_t set(uint8_t slot, const profile_t& profile) {
+  if (slot >= PROFILES_NUM || !is_valid(profile)) return ESP_ERR_INVALID_ARG;
+
+  MemInfo::Scope mem_scope(MemInfo::Gamepad);
+  xSemaphoreTake(profiles_mtx, portMAX_DELAY);
+  nvs_handle_t nvs;
+  esp_err_t err = nvs_open(PROFILES_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+  if (err == ESP_OK) {
+    char key[8];
+    slot_key(slot, key);
+    err = nvs_set_blob(nvs, key, &profile, sizeof(profile));
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+  }
+  if (err == ESP_OK && slot == active_slot) {
+    activate(slot);
+  }
+  xSemaphoreGive(profiles_mtx);
+  return err;
+}
+
+// Load profiles from NVS & compile active profile
+esp_err_t init() {
+  ESP_LOGI(TAG, "Profiles initialization");
+  MemInfo::Scope mem_scope(MemInfo::Gamepad);
+  MemInfo::add_static(MemInfo::Gamepad, "profiles", sizeof(tables) + sizeof(body_buf));
+  profiles_mtx = xSemaphoreCreateMutexStatic(&profiles_mtx_buf);
+
+  uint8_t slot = 0;
+  nvs_handle_t nvs;
+  if (nvs_open(PROFILES_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+    if (nvs_get_u8(nvs, PROFILES_NVS_KEY_ACTIVE, &slot) != ESP_OK || slot >= PROFILES_NUM) {
+      slot = 0;
+    }
+    nvs_close(nvs);
+  }
+
+  xSemaphoreTake(profiles_mtx, portMAX_DELAY);
+  activate(slot);
+  xSemaphoreGive(profiles_mtx);
+  return ESP_OK;
+}
+
+// Append formatted string to buffer
+static void buf_append(char* buf, size_t size, size_t& len, const char* fmt, ...) {
+  if (len >= size) return;
+  va_list args;
+  va_start(args, fmt);
+  int written = vsnprintf(buf + len, size - len, fmt, args);
+  va_end(args);
+  if (written > 0) len += written;
+}
+
+// Format profile as JSON, only remapped buttons & directions are listed
+static size_t format_profile(char* buf, size_t size, uint8_t slot, const profile_t& p) {
+  size_t len = 0;
+  buf_append(buf, size, len, "{\"slot\":%u,\"active\":%s,\"name\":\"%s\",\"buttons\":{", slot,
+             slot == active_slot ? "true" : "false", p.name);
+  const char* sep = "";
+  for (uint8_t b = 0; b < 16; b++) {
+    if (p.buttons[b] == b) continue;
+    buf_append(buf, size, len, "%s\"%s\":\"%s\"", sep,
+               NSGamepad::buttonName(static_cast<NSGamepad::Buttons>(b)),
+               NSGamepad::buttonName(static_cast<NSGamepad::Buttons>(p.buttons[b])));
+    sep = ",";
+  }
+  buf_append(buf, size, len, "},\"dpad\":{");
+  sep = "";
+  for (uint8_t d = 0; d < 8; d++) {
+    if (p.dpad[d] == d) continue;
+    buf_append(buf, size, len, "%s\"%s\":\"%s\"", sep,
+               NSGamepad::dpadName(static_cast<NSGamepad::DpadDirection>(d)),
+               NSGamepad::dpadName(static_cast<NSGamepad::DpadDirection>(p.dpad[d])));
+    sep = ",";
+  }
+  buf_append(buf, size, len, "},\"axes\":{");
+  for (int a = 0; a < AxesNum; a++) {
+    buf_append(buf, size, len, "%s\"%s\":{\"deadzone\":%u,\"curve\":%u,\"invert\":%s}",
+               a ? "," : "", axis_names[a], p.axes[a].deadzone, p.axes[a].curve,
+               p.axes[a].invert ? "true" : "false");
+  }
+  buf_append(buf, size, len, "}}");
+  return len;
+}
+
+// Find axis by name
+static bool find_axis(const char* name, Axis* axis) {
+  if (!name) return false;
+  for (int a = 0; a < AxesNum; a++) {
+    if (strcmp(axis_names[a], name) == 0) {
+      *axis = static_cast<Axis>(a);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Update profile from JSON definition
+// {"name": "...", "buttons": {"A": "B"}, "dpad": {"U": "D"},
+//  "axes": {"lx": {"deadzone": 10, "curve": 150, "invert": false}}}
+static bool update_from_json(profile_t& p, const cJSON* root) {
+  const cJSON* name = cJSON_GetObjectItem(root, "name");
+  if (cJSON_IsString(name)) {
+    strlcpy(p.name, name->valuestring, sizeof(p.name));
+  }
+
+  const cJSON* item;
+  cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "buttons")) {
+    NSGamepad::Buttons from, to;
+    if (!NSGamepad::findButton(item->string, &from) ||
+        !NSGamepad::findButton(cJSON_GetStringValue(item), &to)) {
+      return false;
+    }
+    p.buttons[from] = to;
+  }
+
+  cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "dpad")) {
+    NSGamepad::DpadDirection from, to;
+    if (!NSGamepad::findDpad(item->string, &from) ||
+        !NSGamepad::findDpad(cJSON_GetStringValue(item), &to) ||
+        from == NSGamepad::DpadDirection::centered || to == NSGamepad::DpadDirection::centered) {
+      return false;
+    }
+    p.dpad[from] = to;
+  }
+
+  cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "axes")) {
+    Axis axis;
+    if (!find_axis(item->string, &axis)) return false;
+    const cJSON* deadzone = cJSON_GetObjectItem(item, "deadzone");
+    const cJSON* curve = cJSON_GetObjectItem(item, "curve");
+    const cJSON* invert = cJSON_GetObjectItem(item, "invert");
+    if (cJSON_IsNumber(deadzone)) p.axes[axis].deadzone = deadzone->valueint;
+    if (cJSON_IsNumber(curve)) p.axes[axis].curve = curve->valueint;
+    if (cJSON_IsBool(invert)) p.axes[axis].invert = cJSON_IsTrue(invert);
+  }
+
+  return is_valid(p);
+}
+
+// API: Get profiles (or one profile definition with ?slot=n)
+static esp_err_t api_profile_get(httpd_req_t* req) {
+  httpd_resp_set_type(req, "application/json");
+
+  char query[32];
+  char value[8];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "slot", value, sizeof(value)) == ESP_OK) {
+    int slot = atoi(value);
+    profile_t p;
+    if (slot < 0 || get(slot, &p) != ESP_OK) {
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong profile slot");
+      return ESP_FAIL;
+    }
+    size_t len = format_profile(body_buf, sizeof(body_buf), slot, p);
+    httpd_resp_send(req, body_buf, len);
+    return ESP_OK;
+  }
+
+  size_t len = 0;
+  buf_append(body_buf, sizeof(body_buf), len, "{\"active\":%u,\"profiles\":[", active_slot);
+  for (uint8_t slot = 0; slot < PROFILES_NUM; slot++) {
+    profile_t p;
+    get(slot, &p);
+    buf_append(body_buf, sizeof(body_buf), len, "%s\"%s\"", slot ? "," : "", p.name);
+  }
+  buf_append(body_buf, sizeof(body_buf), len, "]}");
+  httpd_resp_send(req, body_buf, len);
+  return ESP_OK;
+}
+
+// API: Update profile definition and/or switch active profile
+// {"slot": 1, "reset": false, <definition>} - update profile of slot
+// {"active": 1} - switch active profile
+static esp_err_t api_profile_post(httpd_req_t* req) {
+  int total = req->content_len;
+  int current = 0;
+
+  // Check content length
+  if ((size_t)total >= sizeof(body_buf) - 1) {
+    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "content too long");
+    return ESP_FAIL;
+  }
+
+  // Get data by chunks
+  while (current < total) {
+    int received = httpd_req_recv(req, body_buf + current, sizeof(body_buf) - current);
+    if (received <= 0) {
+      httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to receive data");
+      return ESP_FAIL;
+    }
+    current += received;
+  }
+
+  // Read JSON
+  JsonPool::Scope json_scope;
+  cJSON* root = cJSON_ParseWithLength(body_buf, total);
+  if (!root) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "JSON parse error");
+    return ESP_FAIL;
+  }
+
+  // Update profile definition
+  const cJSON* slot = cJSON_GetObjectItem(root, "slot");
+  if (cJSON_IsNumber(slot)) {
+    profile_t p;
+    if (slot->valueint < 0 || get(slot->valueint, &p) != ESP_OK) {
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong profile slot");
+      cJSON_Delete(root);
+      return ESP_FAIL;
+    }
+    if (cJSON_IsTrue(cJSON_GetObjectItem(root, "reset"))) {
+      p = identity();
+    }
+    if (!update_from_json(p, root) || set(slot->valueint, p) != ESP_OK) {
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong profile definition");
+      cJSON_Delete(root);
+      return ESP_FAIL;
+    }
+  }
+
+  // Switch active profile
+  const cJSON* active = cJSON_GetObjectItem(root, "active");
+  if (cJSON_IsNumber(active)) {
+    if (active->valueint < 0 || set_active(active->valueint) != ESP_OK) {
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong profile slot");
+      cJSON_Delete(root);
+      return ESP_FAIL;
+    }
+    // Resend current state with new profile
+    NSGamepad::update();
+  }
+
+  httpd_resp_sendstr(req, "OK");
+
+  cJSON_Delete(root);
+  return ESP_OK;
+}
+
+// Register profile API endpoints
+esp_err_t api_register(httpd_handle_t server) {
+  // API: Get profiles
+  httpd_uri_t cfg_api_profile_get = {
+      .uri = "/api/profile", .method = HTTP_GET, .handler = api_profile_get, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_profile_get);
+
+  // API: Update & switch profiles
+  httpd_uri_t cfg_api_profile_post = {
+      .uri = "/api/profile", .method = HTTP_POST, .handler = api_profile_post, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_profile_post);
+
+  return ESP_OK;
+}
+
+// CMD: List profiles or switch active profile
+static struct {
+  struct arg_int* slot = arg_int0(NULL, NULL, "<slot>", "Profile slot to activate");
+  struct arg_end* end = arg_end(2);
+} cmd_profile_args;
+static int cmd_profile(int argc, char** argv) {
+  // Check argument parse error
+  int nerrors = arg_parse(argc, argv, (void**)&cmd_profile_args);
+  if (nerrors != 0) {
+    arg_print_errors(stderr, cmd_profile_args.end, argv[0]);
+    return 1;
+  }
+
+  if (cmd_profile_args.slot->count == 1) {
+    int slot = cmd_profile_args.slot->ival[0];
+    if (slot < 0 || set_active(slot) != ESP_OK) {
+      printf("Failed to activate profile %d\r\n", slot);
+      return 1;
+    }
+    NSGamepad::update();
+  }
+
+  printf("Profiles:\r\n");
+  for (uint8_t slot = 0; slot < PROFILES_NUM; slot++) {
+    profile_t p;
+    get(slot, &p);
+    printf("  %c %u: %s\r\n", slot == active_slot ? '*' : ' ', slot, p.name);
+  }
+  return 0;
+}
+
+// CMD: Show or edit profile definition
+static struct {
+  struct arg_int* slot = arg_int1(NULL, NULL, "<slot>", "Profile slot");
+  struct arg_str* name = arg_str0("n", "name", "<name>", "Profile name");
+  struct arg_str* button = arg_strn("b", "button", "<from=to>", 0, 16, "Remap button, e.g. A=B");
+  struct arg_str* dpad = arg_strn("d", "dpad", "<from=to>", 0, 8, "Remap dpad, e.g. U=D");
+  struct arg_str* axis = arg_strn("a", "axis", "<axis:deadzone:curve:invert>", 0, 4,
+                                  "Axis calibration, e.g. lx:10:150:0");
+  struct arg_lit* reset = arg_lit0("r", "reset", "Start from identity profile");
+  struct arg_end* end = arg_end(20);
+} cmd_profileset_args;
+
+// Parse "from=to" pair into buffers
+static bool parse_pair(const char* s, char* from, char* to, size_t size) {
+  const char* eq = strchr(s, '=');
+  if (!eq || (size_t)(eq - s) >= size || strlen(eq + 1) >= size) return false;
+  strlcpy(from, s, eq - s + 1);
+  strlcpy(to, eq + 1, size);
+  return true;
+}
+
+static int cmd_profileset(int argc, char** argv) {
+  // Check argument parse error
+  int nerrors = arg_parse(argc, argv, (void**)&cmd_profileset_args);
+  if (nerrors != 0) {
+    arg_print_errors(stderr, cmd_profileset_args.end, argv[0]);
+    return 1;
+  }
+
+  int slot = cmd_profileset_args.slot->ival[0];
+  profile_t p;
+  if (slot < 0 || get(slot, &p) != ESP_OK) {
+    printf("Wrong profile slot: %d\r\n", slot);
+    return 1;
+  }
+
+  bool changed = cmd_profileset_args.reset->count > 0;
+  if (changed) p = identity();
+  if (cmd_profileset_args.name->count == 1) {
+    strlcpy(p.name, cmd_profileset_args.name->sval[0], sizeof(p.name));
+    changed = true;
+  }
+
+  char from[16], to[16];
+  for (int i = 0; i < cmd_profileset_args.button->count; i++) {
+    NSGamepad::Buttons b_from, b_to;
+    if (!parse_pair(cmd_profileset_args.button->sval[i], from, to, sizeof(from)) ||
+        !NSGamepad::findButton(from, &b_from) || !NSGamepad::findButton(to, &b_to)) {
+      printf("Unrecognized button remap: \"%s\"\r\n", cmd_profileset_args.button->sval[i]);
+      return 1;
+    }
+    p.buttons[b_from] = b_to;
+    changed = true;
+  }
+
+  for (int i = 0; i < cmd_profileset_args.dpad->count; i++) {
+    NSGamepad::DpadDirection d_from, d_to;
+    if (!parse_pair(cmd_profileset_args.dpad->sval[i], from, to, sizeof(from)) ||
+        !NSGamepad::findDpad(from, &d_from) || !NSGamepad::findDpad(to, &d_to) ||
+        d_from == NSGamepad::DpadDirection::centered ||
+        d_to == NSGamepad::DpadDirection::centered) {
+      printf("Unrecognized dpad remap: \"%s\"\r\n", cmd_profileset_args.dpad->sval[i]);
+      return 1;
+    }
+    p.dpad[d_from] = d_to;
+    changed = true;
+  }
+
+  for (int i = 0; i < cmd_profileset_args.axis->count; i++) {
+    char name[4];
+    unsigned deadzone, curve, invert;
+    Axis axis;
+    if (sscanf(cmd_profileset_args.axis->sval[i], "%3[a-z]:%u:%u:%u", name, &deadzone, &curve,
+               &invert) != 4 ||
+        !find_axis(name, &axis) || deadzone > 127 || curve < 25 || curve > 255) {
+      printf("Wrong axis calibration: \"%s\"\r\n", cmd_profileset_args.axis->sval[i]);
+      return 1;
+    }
+    p.axes[axis] = {(uint8_t)deadzone, (uint8_t)curve, invert != 0};
+    changed = true;
+  }
+
+  if (changed && set(slot, p) != ESP_OK) {
+    printf("Failed to save profile %d\r\n", slot);
+    return 1;
+  }
+
+  char buf[512];
+  format_profile(buf, sizeof(buf), slot, p);
+  printf("%s\r\n", buf);
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_profile_cfg = {
+      .command = "profile",
+      .help = "List profiles or switch active profile",
+      .hint = NULL,
+      .func = &cmd_profile,
+      .argtable = &cmd_profile_args,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_profile_cfg));
+
+  const esp_console_cmd_t cmd_profileset_cfg = {
+      .command = "profileset",
+      .help = "Show or edit profile (button & dpad remap, axes calibration)",
+      .hint = NULL,
+      .func = &cmd_profileset,
+      .argtable = &cmd_profileset_args,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_profileset_cfg));
+
+  return ESP_OK;
+}
+
+}  // namespace Profiles
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "hid.hpp"
+
+namespace Profiles {
+
+// Number of profile slots in NVS
+#define PROFILES_NUM 4
+
+// Axes order in profile
+enum Axis : uint8_t { LeftX = 0, LeftY, RightX, RightY, AxesNum };
+
+// Stick axis calibration
+typedef struct {
+  uint8_t deadzone;  // Deadzone radius around center (0-127)
+  uint8_t curve;     // Response curve exponent in percent (100 - linear, 200 - quadratic)
+  bool invert;       // Invert axis direction
+} axis_cfg_t;
+
+// Profile definition (stored in NVS)
+typedef struct {
+  char name[16];             // Profile name
+  uint8_t buttons[16];       // Output button for each input button
+  uint8_t dpad[8];           // Output direction for each input direction
+  axis_cfg_t axes[AxesNum];  // Axes calibration
+} profile_t;
+
+// Load profiles from NVS & compile active profile
+// Should be called after NVS initialization
+esp_err_t init();
+
+// Apply active profile to gamepad report
+// Thread-safe, lock-free, O(1)
+HID::hid_device_report_t apply(const HID::hid_device_report_t& report);
+
+// Get active profile slot
+uint8_t get_active();
+
+// Switch active profile (compiled & saved as active to NVS)
+esp_err_t set_active(uint8_t slot);
+
+// Get profile definition (identity profile, if slot is empty)
+esp_err_t get(uint8_t slot, profile_t* profile);
+
+// Save profile definition to NVS, active profile is recompiled
+esp_err_t set(uint8_t slot, const profile_t& profile);
+
+// Get identity profile (no remap, no calibration)
+profile_t identity();
+
+// Register profile API endpoints
+esp_err_t api_register(httpd_handle_t server);
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace Profiles
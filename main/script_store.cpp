@@ -0,0 +1,834 @@
+#include "script_store.hpp"
+
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "argtable3/argtable3.h"
+#include "cdc_protocol.hpp"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "hid.hpp"
+#include "meminfo.hpp"
+#include "metrics.hpp"
+#include "nsgamepad.hpp"
+
+namespace ScriptStore {
+
+#if CONFIG_NSG_SCRIPT_STORE
+
+static const char* TAG = "app scripts";
+
+// Partition layout:
+// | directory (first sector, SCRIPT_STORE_ENTRIES entries) | scripts (sector aligned) |
+// Entries are written once & deleted by clearing magic, so directory sector is erased
+// only on compaction, when there are no free entries left
+#define SCRIPT_STORE_MAGIC 0x5347534E  // "NSGS"
+#define SCRIPT_STORE_FREE 0xFFFFFFFF
+#define SCRIPT_STORE_DELETED 0
+
+// Name index size (open addressing, at most half full)
+#define SCRIPT_NAME_INDEX_SIZE (SCRIPT_STORE_ENTRIES * 2)
+
+// Upload chunk size, multiple of step size
+#define SCRIPT_STORE_CHUNK (CDC_STEP_SIZE * 20)
+
+// FNV-1a parameters
+#define FNV32_OFFSET 0x811C9DC5
+#define FNV32_PRIME 0x01000193
+#define FNV64_OFFSET 0xCBF29CE484222325ULL
+#define FNV64_PRIME 0x00000100000001B3ULL
+
+// Directory entry (flash layout)
+typedef struct {
+  uint32_t magic;              // SCRIPT_STORE_MAGIC - live, SCRIPT_STORE_FREE, SCRIPT_STORE_DELETED
+  uint32_t offset;             // Script offset in partition
+  uint32_t len;                // Script size, bytes
+  uint32_t duration_ms;        // Estimated duration of one run
+  uint32_t crc32;              // Checksum of script
+  uint32_t reserved;
+  uint64_t hash;               // Content hash (FNV-1a 64)
+  char name[SCRIPT_NAME_MAX];  // Script name, null terminated
+} entry_t;
+
+static_assert(sizeof(entry_t) == 64);
+static_assert(SCRIPT_STORE_ENTRIES <= INT8_MAX);
+
+// Store partition, mapped into data address space
+static const esp_partition_t* part = NULL;
+static const uint8_t* flash = NULL;
+static esp_partition_mmap_handle_t flash_handle;
+
+// Directory copy & name index, changed under mutex
+static entry_t dir[SCRIPT_STORE_ENTRIES];
+static bool valid[SCRIPT_STORE_ENTRIES];
+static int8_t name_index[SCRIPT_NAME_INDEX_SIZE];
+
+// Number of running instances of every script, running script can't be deleted or replaced
+static std::atomic<uint8_t> running[SCRIPT_STORE_ENTRIES];
+
+// Serializes store changes
+static StaticSemaphore_t store_mtx_buf;
+static SemaphoreHandle_t store_mtx;
+
+// Entry is live script
+static bool is_live(const entry_t& e) {
+  return e.magic == SCRIPT_STORE_MAGIC;
+}
+
+// Script size rounded up to sectors
+static uint32_t aligned(uint32_t len) {
+  return (len + part->erase_size - 1) / part->erase_size * part->erase_size;
+}
+
+// Calculate FNV-1a 32 hash of name
+static uint32_t name_hash(const char* name) {
+  uint32_t hash = FNV32_OFFSET;
+  for (; *name; name++) {
+    hash = (hash ^ (uint8_t)*name) * FNV32_PRIME;
+  }
+  return hash;
+}
+
+// Calculate FNV-1a 64 hash of content
+static uint64_t content_hash(const uint8_t* data, size_t len, uint64_t hash = FNV64_OFFSET) {
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ data[i]) * FNV64_PRIME;
+  }
+  return hash;
+}
+
+// Check script name: letter or '_' first (so name is never taken for id), then [A-Za-z0-9_.-]
+static bool is_valid_name(const char* name) {
+  size_t len = strnlen(name, SCRIPT_NAME_MAX);
+  if (len == 0 || len == SCRIPT_NAME_MAX) return false;
+  if (!isalpha((uint8_t)name[0]) && name[0] != '_') return false;
+  for (size_t i = 1; i < len; i++) {
+    if (!isalnum((uint8_t)name[i]) && !strchr("_.-", name[i])) return false;
+  }
+  return true;
+}
+
+// Rebuild name index from directory
+static void index_rebuild() {
+  memset(name_index, -1, sizeof(name_index));
+  for (uint8_t id = 0; id < SCRIPT_STORE_ENTRIES; id++) {
+    if (!is_live(dir[id])) continue;
+    uint32_t h = name_hash(dir[id].name) % SCRIPT_NAME_INDEX_SIZE;
+    while (name_index[h] >= 0) h = (h + 1) % SCRIPT_NAME_INDEX_SIZE;
+    name_index[h] = id;
+  }
+}
+
+// Find live script by name in index, returns -1 if not found
+static int index_find(const char* name) {
+  uint32_t h = name_hash(name) % SCRIPT_NAME_INDEX_SIZE;
+  for (size_t n = 0; n < SCRIPT_NAME_INDEX_SIZE; n++) {
+    int8_t id = name_index[h];
+    if (id < 0) return -1;
+    if (strncmp(dir[id].name, name, SCRIPT_NAME_MAX) == 0) return id;
+    h = (h + 1) % SCRIPT_NAME_INDEX_SIZE;
+  }
+  return -1;
+}
+
+// Find free space for script (first fit between stored scripts), returns offset (0 - no space)
+static uint32_t allocate(uint32_t len) {
+  uint32_t size = aligned(len);
+  uint32_t offset = part->erase_size;  // First sector is directory
+  while (offset + size <= part->size) {
+    const entry_t* overlap = NULL;
+    for (const entry_t& e : dir) {
+      if (is_live(e) && e.offset < offset + size && offset < e.offset + aligned(e.len)) {
+        overlap = &e;
+        break;
+      }
+    }
+    if (!overlap) return offset;
+    offset = overlap->offset + aligned(overlap->len);
+  }
+  return 0;
+}
+
+// Find free directory entry, deleted entries are reclaimed by directory compaction
+static int free_entry() {
+  for (uint8_t id = 0; id < SCRIPT_STORE_ENTRIES; id++) {
+    if (dir[id].magic == SCRIPT_STORE_FREE) return id;
+  }
+
+  bool deleted = false;
+  for (const entry_t& e : dir) deleted |= !is_live(e);
+  if (!deleted) return -1;
+
+  // Compaction: rewrite directory sector with live entries only, ids are kept
+  ESP_LOGI(TAG, "Directory compaction");
+  for (entry_t& e : dir) {
+    if (!is_live(e)) memset(&e, 0xFF, sizeof(e));
+  }
+  if (esp_partition_erase_range(part, 0, part->erase_size) != ESP_OK ||
+      esp_partition_write(part, 0, dir, sizeof(dir)) != ESP_OK) {
+    ESP_LOGE(TAG, "Directory compaction failed");
+    return -1;
+  }
+  return free_entry();
+}
+
+// Mark directory entry as deleted
+static esp_err_t delete_entry(uint8_t id) {
+  uint32_t magic = SCRIPT_STORE_DELETED;
+  esp_err_t err = esp_partition_write(part, id * sizeof(entry_t), &magic, sizeof(magic));
+  if (err == ESP_OK) dir[id].magic = magic;
+  return err;
+}
+
+// Find & map store partition, load directory & verify checksums
+esp_err_t init() {
+  ESP_LOGI(TAG, "Script store initialization");
+  MemInfo::Scope mem_scope(MemInfo::Gamepad);
+  MemInfo::add_static(MemInfo::Gamepad, "scripts",
+                      sizeof(dir) + sizeof(valid) + sizeof(name_index) + sizeof(running));
+  store_mtx = xSemaphoreCreateMutexStatic(&store_mtx_buf);
+  memset(name_index, -1, sizeof(name_index));
+
+  part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                  CONFIG_NSG_SCRIPT_STORE_PARTITION);
+  if (!part || part->size < part->erase_size * 2 || part->erase_size < sizeof(dir)) {
+    ESP_LOGW(TAG, "Partition \"%s\" is not found, script store is disabled",
+             CONFIG_NSG_SCRIPT_STORE_PARTITION);
+    part = NULL;
+    return ESP_OK;
+  }
+
+  const void* ptr;
+  esp_err_t err =
+      esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &ptr, &flash_handle);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to map partition: %s", esp_err_to_name(err));
+    part = NULL;
+    return ESP_OK;
+  }
+  flash = (const uint8_t*)ptr;
+
+  // Load directory, entries out of partition are treated as deleted
+  memcpy(dir, flash, sizeof(dir));
+  uint8_t scripts_num = 0;
+  for (uint8_t id = 0; id < SCRIPT_STORE_ENTRIES; id++) {
+    entry_t& e = dir[id];
+    if (e.magic != SCRIPT_STORE_MAGIC && e.magic != SCRIPT_STORE_FREE) {
+      e.magic = SCRIPT_STORE_DELETED;
+      continue;
+    }
+    if (!is_live(e)) continue;
+    if (e.len == 0 || e.len % CDC_STEP_SIZE != 0 || e.offset < part->erase_size ||
+        e.len > part->size || e.offset > part->size - e.len ||
+        strnlen(e.name, SCRIPT_NAME_MAX) == SCRIPT_NAME_MAX) {
+      ESP_LOGW(TAG, "Broken directory entry %u", id);
+      e.magic = SCRIPT_STORE_DELETED;
+      continue;
+    }
+    valid[id] = esp_rom_crc32_le(0, flash + e.offset, e.len) == e.crc32;
+    if (!valid[id]) {
+      ESP_LOGW(TAG, "Checksum mismatch of script %u \"%s\"", id, e.name);
+    }
+    scripts_num++;
+  }
+  index_rebuild();
+
+  size_t size, free;
+  get_space(&size, &free);
+  ESP_LOGI(TAG, "Scripts: %u, free: %u/%u bytes", scripts_num, free, size);
+  return ESP_OK;
+}
+
+// Write script data & directory entry, called under mutex
+static esp_err_t save_locked(const char* name, size_t len, read_cb_t read, void* ctx,
+                             uint8_t* id) {
+  int old = index_find(name);
+  if (old >= 0 && running[old].load() > 0) return ESP_ERR_INVALID_STATE;
+
+  // Check free directory entry before data is written
+  bool entry_available = false;
+  for (const entry_t& e : dir) entry_available |= !is_live(e);
+  if (!entry_available) return ESP_ERR_NO_MEM;
+
+  uint32_t offset = allocate(len);
+  if (offset == 0) return ESP_ERR_NO_MEM;
+  esp_err_t err = esp_partition_erase_range(part, offset, aligned(len));
+  if (err != ESP_OK) return err;
+
+  // Stream data into flash by chunks of whole steps
+  uint8_t buf[SCRIPT_STORE_CHUNK];
+  uint32_t crc = 0;
+  uint64_t hash = FNV64_OFFSET;
+  uint64_t duration_us = 0;
+  size_t done = 0;
+  size_t fill = 0;
+  while (done < len) {
+    size_t want = sizeof(buf) - fill;
+    if (want > len - done - fill) want = len - done - fill;
+    int received = read(ctx, buf + fill, want);
+    if (received <= 0) return ESP_FAIL;
+    fill += received;
+    if (fill < sizeof(buf) && done + fill < len) continue;
+
+    err = esp_partition_write(part, offset + done, buf, fill);
+    if (err != ESP_OK) return err;
+    crc = esp_rom_crc32_le(crc, buf, fill);
+    hash = content_hash(buf, fill, hash);
+    for (size_t i = 0; i < fill; i += CDC_STEP_SIZE) {
+      duration_us += CdcProtocol::decode_step(buf + i).hold_us;
+    }
+    done += fill;
+    fill = 0;
+  }
+
+  // Verify written data through mapping, which is used to run script
+  if (esp_rom_crc32_le(0, flash + offset, len) != crc) return ESP_ERR_INVALID_CRC;
+
+  // The same content is already stored, written copy stays in free space
+  if (old >= 0 && valid[old] && dir[old].hash == hash && dir[old].len == len) {
+    *id = old;
+    return ESP_OK;
+  }
+
+  int new_id = free_entry();
+  if (new_id < 0) return ESP_ERR_NO_MEM;
+
+  entry_t e;
+  memset(&e, 0xFF, sizeof(e));
+  e.magic = SCRIPT_STORE_MAGIC;
+  e.offset = offset;
+  e.len = len;
+  e.duration_ms = duration_us / 1000;
+  e.crc32 = crc;
+  e.hash = hash;
+  memset(e.name, 0, sizeof(e.name));
+  strlcpy(e.name, name, sizeof(e.name));
+  err = esp_partition_write(part, new_id * sizeof(entry_t), &e, sizeof(e));
+  if (err != ESP_OK) return err;
+  dir[new_id] = e;
+  valid[new_id] = true;
+
+  // Replace script with the same name
+  if (old >= 0) delete_entry(old);
+  index_rebuild();
+
+  ESP_LOGI(TAG, "Script %d \"%s\" saved: %u bytes, %lu ms", new_id, name, len,
+           (unsigned long)e.duration_ms);
+  *id = new_id;
+  return ESP_OK;
+}
+
+// Save compiled script, data is read with callback in chunks
+esp_err_t save(const char* name, size_t len, read_cb_t read, void* ctx, uint8_t* id) {
+  if (!part) return ESP_ERR_NOT_SUPPORTED;
+  if (!is_valid_name(name)) return ESP_ERR_INVALID_ARG;
+  if (len == 0 || len % CDC_STEP_SIZE != 0 || len > part->size) return ESP_ERR_INVALID_SIZE;
+
+  xSemaphoreTake(store_mtx, portMAX_DELAY);
+  esp_err_t err = save_locked(name, len, read, ctx, id);
+  xSemaphoreGive(store_mtx);
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Failed to save script \"%s\": %s", name, esp_err_to_name(err));
+  }
+  return err;
+}
+
+// Buffer reader for save()
+typedef struct {
+  const uint8_t* data;
+  size_t pos;
+} buffer_reader_t;
+
+static int read_buffer(void* ctx, uint8_t* buf, size_t len) {
+  buffer_reader_t* reader = (buffer_reader_t*)ctx;
+  memcpy(buf, reader->data + reader->pos, len);
+  reader->pos += len;
+  return len;
+}
+
+// Save compiled script from buffer
+esp_err_t save(const char* name, const uint8_t* data, size_t len, uint8_t* id) {
+  buffer_reader_t reader = {.data = data, .pos = 0};
+  return save(name, len, read_buffer, &reader, id);
+}
+
+// Find script by name
+bool find(const char* name, uint8_t* id) {
+  if (!part) return false;
+  xSemaphoreTake(store_mtx, portMAX_DELAY);
+  int found = index_find(name);
+  xSemaphoreGive(store_mtx);
+  if (found < 0) return false;
+  *id = found;
+  return true;
+}
+
+// Find script by content hash
+bool find_hash(uint64_t hash, uint8_t* id) {
+  if (!part) return false;
+  int found = -1;
+  xSemaphoreTake(store_mtx, portMAX_DELAY);
+  for (uint8_t i = 0; i < SCRIPT_STORE_ENTRIES && found < 0; i++) {
+    if (is_live(dir[i]) && dir[i].hash == hash) found = i;
+  }
+  xSemaphoreGive(store_mtx);
+  if (found < 0) return false;
+  *id = found;
+  return true;
+}
+
+// Get script information
+esp_err_t get_info(uint8_t id, script_info_t* info) {
+  if (!part) return ESP_ERR_NOT_SUPPORTED;
+  if (id >= SCRIPT_STORE_ENTRIES) return ESP_ERR_NOT_FOUND;
+
+  esp_err_t err = ESP_ERR_NOT_FOUND;
+  xSemaphoreTake(store_mtx, portMAX_DELAY);
+  const entry_t& e = dir[id];
+  if (is_live(e)) {
+    info->id = id;
+    strlcpy(info->name, e.name, sizeof(info->name));
+    info->bytes = e.len;
+    info->steps = e.len / CDC_STEP_SIZE;
+    info->duration_ms = e.duration_ms;
+    info->crc32 = e.crc32;
+    info->hash = e.hash;
+    info->valid = valid[id];
+    err = ESP_OK;
+  }
+  xSemaphoreGive(store_mtx);
+  return err;
+}
+
+// Run stored script, steps are read directly from mapped flash
+esp_err_t run(uint8_t id, uint16_t repeat, const char* client) {
+  if (!part) return ESP_ERR_NOT_SUPPORTED;
+  if (id >= SCRIPT_STORE_ENTRIES) return ESP_ERR_NOT_FOUND;
+
+  xSemaphoreTake(store_mtx, portMAX_DELAY);
+  esp_err_t err = !is_live(dir[id]) ? ESP_ERR_NOT_FOUND : !valid[id] ? ESP_ERR_INVALID_CRC : ESP_OK;
+  const uint8_t* data = flash + dir[id].offset;
+  size_t steps = dir[id].len / CDC_STEP_SIZE;
+  uint32_t duration_ms = dir[id].duration_ms;
+  if (err == ESP_OK) running[id].fetch_add(1);
+  xSemaphoreGive(store_mtx);
+  if (err != ESP_OK) return err;
+
+  // Job waits for its turn, it's preempted between steps by jobs of other clients.
+  // Job pauses while gamepad is disconnected (also at start) & resumes from interrupted step
+  size_t total = steps * repeat;
+  uint64_t total_ms = (uint64_t)duration_ms * repeat;
+  Jobs::Job job;
+  err = job.begin(client, total > UINT16_MAX ? UINT16_MAX : total,
+                  total_ms > UINT32_MAX ? UINT32_MAX : total_ms);
+  for (uint16_t r = 0; r < repeat && err == ESP_OK; r++) {
+    for (size_t i = 0; i < steps && err == ESP_OK; i++) {
+      CdcProtocol::step_t step = CdcProtocol::decode_step(data + i * CDC_STEP_SIZE);
+      HID::hid_device_report_t report;
+      memcpy(&report, step.report, sizeof(report));
+      err = NSGamepad::hold(report, step.hold_us);
+      job.step();
+    }
+  }
+  job.end();
+
+  running[id].fetch_sub(1);
+  return err;
+}
+
+// Delete stored script
+esp_err_t remove(uint8_t id) {
+  if (!part) return ESP_ERR_NOT_SUPPORTED;
+  if (id >= SCRIPT_STORE_ENTRIES) return ESP_ERR_NOT_FOUND;
+
+  xSemaphoreTake(store_mtx, portMAX_DELAY);
+  esp_err_t err = ESP_OK;
+  if (!is_live(dir[id])) {
+    err = ESP_ERR_NOT_FOUND;
+  } else if (running[id].load() > 0) {
+    err = ESP_ERR_INVALID_STATE;
+  } else {
+    err = delete_entry(id);
+    index_rebuild();
+  }
+  xSemaphoreGive(store_mtx);
+  return err;
+}
+
+// Get store capacity & free space
+void get_space(size_t* size, size_t* free) {
+  *size = 0;
+  *free = 0;
+  if (!part) return;
+
+  *size = part->size - part->erase_size;
+  *free = *size;
+  xSemaphoreTake(store_mtx, portMAX_DELAY);
+  for (const entry_t& e : dir) {
+    if (is_live(e)) *free -= aligned(e.len);
+  }
+  xSemaphoreGive(store_mtx);
+}
+
+// Find script by id or name string, O(1)
+static bool parse_script(const char* s, uint8_t* id) {
+  if (isdigit((uint8_t)s[0])) {
+    char* end;
+    long value = strtol(s, &end, 10);
+    if (*end != '\0' || value < 0 || value >= SCRIPT_STORE_ENTRIES) return false;
+    *id = value;
+    return true;
+  }
+  return find(s, id);
+}
+
+// Send API error response for store error
+static esp_err_t send_error(httpd_req_t* req, esp_err_t err) {
+  switch (err) {
+    case ESP_ERR_NOT_FOUND:
+      httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Script not found");
+      break;
+    case ESP_ERR_INVALID_ARG:
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong script name");
+      break;
+    case ESP_ERR_INVALID_SIZE:
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong script size");
+      break;
+    case ESP_ERR_INVALID_CRC:
+      httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Script checksum mismatch");
+      break;
+    case ESP_ERR_INVALID_STATE:
+    case ESP_ERR_TIMEOUT:
+      httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                          "Script is running or gamepad is not connected");
+      break;
+    case ESP_ERR_NO_MEM:
+      httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "No space in script store");
+      break;
+    case ESP_ERR_NOT_SUPPORTED:
+      httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Script store is disabled");
+      break;
+    default:
+      httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Script store error");
+      break;
+  }
+  return ESP_FAIL;
+}
+
+// Find script of API request by ?id=n or ?name=s
+static esp_err_t query_script(httpd_req_t* req, const char* query, uint8_t* id) {
+  char value[SCRIPT_NAME_MAX];
+  if (httpd_query_key_value(query, "id", value, sizeof(value)) != ESP_OK &&
+      httpd_query_key_value(query, "name", value, sizeof(value)) != ESP_OK) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  return parse_script(value, id) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+// API: List stored scripts with metadata
+static esp_err_t api_scripts_get(httpd_req_t* req) {
+  httpd_resp_set_type(req, "application/json");
+
+  // Response is sent by chunks, one script per chunk
+  char buf[256];
+  size_t size, free;
+  get_space(&size, &free);
+  snprintf(buf, sizeof(buf), "{\"size\":%u,\"free\":%u,\"scripts\":[", size, free);
+  httpd_resp_send_chunk(req, buf, HTTPD_RESP_USE_STRLEN);
+
+  bool first = true;
+  for (uint8_t id = 0; id < SCRIPT_STORE_ENTRIES; id++) {
+    script_info_t info;
+    if (get_info(id, &info) != ESP_OK) continue;
+    snprintf(buf, sizeof(buf),
+             "%s{\"id\":%u,\"name\":\"%s\",\"bytes\":%lu,\"steps\":%lu,\"duration_ms\":%lu,"
+             "\"crc32\":\"%08lx\",\"hash\":\"%016llx\",\"valid\":%s}",
+             first ? "" : ",", id, info.name, (unsigned long)info.bytes,
+             (unsigned long)info.steps, (unsigned long)info.duration_ms,
+             (unsigned long)info.crc32, (unsigned long long)info.hash,
+             info.valid ? "true" : "false");
+    httpd_resp_send_chunk(req, buf, HTTPD_RESP_USE_STRLEN);
+    first = false;
+  }
+
+  httpd_resp_send_chunk(req, "]}", HTTPD_RESP_USE_STRLEN);
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// Request body reader for save()
+static int read_request(void* ctx, uint8_t* buf, size_t len) {
+  httpd_req_t* req = (httpd_req_t*)ctx;
+  int received;
+  do {
+    received = httpd_req_recv(req, (char*)buf, len);
+  } while (received == HTTPD_SOCK_ERR_TIMEOUT);
+  return received;
+}
+
+// API: Upload compiled script (?name=s, body is sequence of steps)
+// Body is streamed into flash, the same content isn't written again
+static esp_err_t api_scripts_post(httpd_req_t* req) {
+  char query[64];
+  char name[SCRIPT_NAME_MAX];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+      httpd_query_key_value(query, "name", name, sizeof(name)) != ESP_OK) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missed script name");
+    return ESP_FAIL;
+  }
+
+  uint8_t id;
+  esp_err_t err = save(name, req->content_len, read_request, req, &id);
+  if (err != ESP_OK) return send_error(req, err);
+
+  script_info_t info;
+  get_info(id, &info);
+  char buf[96];
+  snprintf(buf, sizeof(buf), "{\"id\":%u,\"duration_ms\":%lu,\"hash\":\"%016llx\"}", id,
+           (unsigned long)info.duration_ms, (unsigned long long)info.hash);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_sendstr(req, buf);
+  return ESP_OK;
+}
+
+// API: Run stored script (?id=n or ?name=s, &repeat=n)
+static esp_err_t api_scripts_run(httpd_req_t* req) {
+  char query[80];
+  char value[8];
+  uint8_t id;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
+    return send_error(req, ESP_ERR_NOT_FOUND);
+  }
+  esp_err_t err = query_script(req, query, &id);
+  if (err != ESP_OK) return send_error(req, err);
+
+  int repeat = 1;
+  if (httpd_query_key_value(query, "repeat", value, sizeof(value)) == ESP_OK) {
+    repeat = atoi(value);
+    if (repeat < 1 || repeat > UINT16_MAX) {
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong repeat count");
+      return ESP_FAIL;
+    }
+  }
+
+  char client[JOBS_CLIENT_NAME_MAX];
+  Jobs::client_name(req, client, sizeof(client));
+  err = run(id, repeat, client);
+  if (err == ESP_ERR_NO_MEM) {
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_sendstr(req, "Job queue is full");
+    return ESP_FAIL;
+  }
+  if (err != ESP_OK) return send_error(req, err);
+  httpd_resp_sendstr(req, "OK");
+  return ESP_OK;
+}
+
+// API: Delete stored script (?id=n or ?name=s)
+static esp_err_t api_scripts_delete(httpd_req_t* req) {
+  char query[64];
+  uint8_t id;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
+    return send_error(req, ESP_ERR_NOT_FOUND);
+  }
+  esp_err_t err = query_script(req, query, &id);
+  if (err == ESP_OK) err = remove(id);
+  if (err != ESP_OK) return send_error(req, err);
+  httpd_resp_sendstr(req, "OK");
+  return ESP_OK;
+}
+
+// Register script store API endpoints
+esp_err_t api_register(httpd_handle_t server) {
+  // API: List & upload scripts
+  httpd_uri_t cfg_api_scripts_get = {
+      .uri = "/api/scripts", .method = HTTP_GET, .handler = api_scripts_get, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_scripts_get);
+  httpd_uri_t cfg_api_scripts_post = {
+      .uri = "/api/scripts", .method = HTTP_POST, .handler = api_scripts_post, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_scripts_post);
+
+  // API: Delete script
+  httpd_uri_t cfg_api_scripts_delete = {.uri = "/api/scripts",
+                                        .method = HTTP_DELETE,
+                                        .handler = api_scripts_delete,
+                                        .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_scripts_delete);
+
+  // API: Run script
+  httpd_uri_t cfg_api_scripts_run = {.uri = "/api/scripts/run",
+                                     .method = HTTP_POST,
+                                     .handler = api_scripts_run,
+                                     .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_scripts_run);
+
+  return ESP_OK;
+}
+
+// CMD: List stored scripts
+static int cmd_scripts(int argc, char** argv) {
+  if (!part) {
+    printf("Script store is disabled\r\n");
+    return 1;
+  }
+
+  size_t size, free;
+  get_space(&size, &free);
+  printf("Scripts (free %u/%u bytes):\r\n", free, size);
+  for (uint8_t id = 0; id < SCRIPT_STORE_ENTRIES; id++) {
+    script_info_t info;
+    if (get_info(id, &info) != ESP_OK) continue;
+    printf("  %2u: %-20s %5lu steps, %7lu ms, crc %08lx, hash %016llx%s\r\n", id, info.name,
+           (unsigned long)info.steps, (unsigned long)info.duration_ms,
+           (unsigned long)info.crc32, (unsigned long long)info.hash,
+           info.valid ? "" : " (broken)");
+  }
+  return 0;
+}
+
+// CMD: Run stored script
+static struct {
+  struct arg_str* script = arg_str1(NULL, NULL, "<name|id>", "Stored script");
+  struct arg_int* repeat = arg_int0("r", "repeat", "<n>", "Repeat count, default = 1");
+  struct arg_end* end = arg_end(2);
+} cmd_scriptrun_args;
+static int cmd_scriptrun(int argc, char** argv) {
+  // Check argument parse error
+  int nerrors = arg_parse(argc, argv, (void**)&cmd_scriptrun_args);
+  if (nerrors != 0) {
+    arg_print_errors(stderr, cmd_scriptrun_args.end, argv[0]);
+    return 1;
+  }
+
+  uint8_t id;
+  if (!parse_script(cmd_scriptrun_args.script->sval[0], &id)) {
+    printf("Script not found: \"%s\"\r\n", cmd_scriptrun_args.script->sval[0]);
+    return 1;
+  }
+  int repeat = cmd_scriptrun_args.repeat->count ? cmd_scriptrun_args.repeat->ival[0] : 1;
+  if (repeat < 1 || repeat > UINT16_MAX) {
+    printf("Wrong repeat count: %d\r\n", repeat);
+    return 1;
+  }
+
+  esp_err_t err = run(id, repeat);
+  if (err != ESP_OK) {
+    printf("Failed to run script: %s\r\n", esp_err_to_name(err));
+    return 1;
+  }
+  return 0;
+}
+
+// CMD: Delete stored script
+static struct {
+  struct arg_str* script = arg_str1(NULL, NULL, "<name|id>", "Stored script");
+  struct arg_end* end = arg_end(1);
+} cmd_scriptdel_args;
+static int cmd_scriptdel(int argc, char** argv) {
+  // Check argument parse error
+  int nerrors = arg_parse(argc, argv, (void**)&cmd_scriptdel_args);
+  if (nerrors != 0) {
+    arg_print_errors(stderr, cmd_scriptdel_args.end, argv[0]);
+    return 1;
+  }
+
+  uint8_t id;
+  esp_err_t err = ESP_ERR_NOT_FOUND;
+  if (parse_script(cmd_scriptdel_args.script->sval[0], &id)) err = remove(id);
+  if (err != ESP_OK) {
+    printf("Failed to delete script: %s\r\n", esp_err_to_name(err));
+    return 1;
+  }
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_scripts_cfg = {
+      .command = "scripts",
+      .help = "List stored scripts",
+      .hint = NULL,
+      .func = &cmd_scripts,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_scripts_cfg));
+
+  const esp_console_cmd_t cmd_scriptrun_cfg = {
+      .command = "scriptrun",
+      .help = "Run stored script",
+      .hint = NULL,
+      .func = &cmd_scriptrun,
+      .argtable = &cmd_scriptrun_args,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_scriptrun_cfg));
+
+  const esp_console_cmd_t cmd_scriptdel_cfg = {
+      .command = "scriptdel",
+      .help = "Delete stored script",
+      .hint = NULL,
+      .func = &cmd_scriptdel,
+      .argtable = &cmd_scriptdel_args,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_scriptdel_cfg));
+
+  return ESP_OK;
+}
+
+#else
+
+// Script store is disabled
+esp_err_t init() {
+  return ESP_OK;
+}
+
+esp_err_t save(const char* name, size_t len, read_cb_t read, void* ctx, uint8_t* id) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t save(const char* name, const uint8_t* data, size_t len, uint8_t* id) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+bool find(const char* name, uint8_t* id) {
+  return false;
+}
+
+bool find_hash(uint64_t hash, uint8_t* id) {
+  return false;
+}
+
+esp_err_t get_info(uint8_t id, script_info_t* info) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t run(uint8_t id, uint16_t repeat, const char* client) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t remove(uint8_t id) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+void get_space(size_t* size, size_t* free) {
+  *size = 0;
+  *free = 0;
+}
+
+esp_err_t api_register(httpd_handle_t server) {
+  return ESP_OK;
+}
+
+esp_err_t cmds_register() {
+  return ESP_OK;
+}
+
+#endif
+
+}  // namespace ScriptStore
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "jobs.hpp"
+
+// Script store: compiled scripts on flash partition
+// Scripts are stored in compiled form (steps of CDC protocol, 12 bytes each, see cdc_protocol.hpp)
+// and executed directly from memory-mapped flash, without parsing & RAM copies
+namespace ScriptStore {
+
+// Maximum number of stored scripts
+#define SCRIPT_STORE_ENTRIES 32
+// Maximum script name length (with null terminator)
+#define SCRIPT_NAME_MAX 32
+
+// Stored script information
+typedef struct {
+  uint8_t id;                  // Directory slot, stable while script is stored
+  char name[SCRIPT_NAME_MAX];  // Script name
+  uint32_t bytes;              // Compiled script size
+  uint32_t steps;              // Number of steps
+  uint32_t duration_ms;        // Estimated duration of one run (sum of hold times)
+  uint32_t crc32;              // Checksum of compiled script
+  uint64_t hash;               // Content hash (FNV-1a 64)
+  bool valid;                  // Checksum is verified on boot
+} script_info_t;
+
+// Read callback for script upload, returns number of read bytes (<= 0 - error)
+typedef int (*read_cb_t)(void* ctx, uint8_t* buf, size_t len);
+
+// Find & map store partition, load directory & verify checksums
+// Store is disabled (functions return ESP_ERR_NOT_SUPPORTED), if partition is not found
+esp_err_t init();
+
+// Save compiled script, data is read with callback in chunks (no full copy in RAM)
+// Script with the same name is replaced, the same content is not written again
+// Returns id of saved script
+esp_err_t save(const char* name, size_t len, read_cb_t read, void* ctx, uint8_t* id);
+
+// Save compiled script from buffer
+esp_err_t save(const char* name, const uint8_t* data, size_t len, uint8_t* id);
+
+// Find script by name, O(1)
+// Returns false, if script is not found
+bool find(const char* name, uint8_t* id);
+
+// Find script by content hash
+bool find_hash(uint64_t hash, uint8_t* id);
+
+// Get script information
+esp_err_t get_info(uint8_t id, script_info_t* info);
+
+// Run stored script as job of client (blocks until script is done)
+// Job pauses while gamepad is disconnected. Returns ESP_ERR_NO_MEM, if job queue is full,
+// ESP_ERR_TIMEOUT, if gamepad isn't reconnected during resume timeout
+esp_err_t run(uint8_t id, uint16_t repeat = 1, const char* client = JOBS_CLIENT_CONSOLE);
+
+// Delete stored script (running script can't be deleted)
+esp_err_t remove(uint8_t id);
+
+// Get store capacity & free space for scripts, bytes
+void get_space(size_t* size, size_t* free);
+
+// Register script store API endpoints
+esp_err_t api_register(httpd_handle_t server);
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace ScriptStore
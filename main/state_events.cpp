@@ -0,0 +1,245 @@
+#include "state_events.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstring>
+
+#include "esp_log.h"
+#include "freertos/idf_additions.h"
+#include "hid.hpp"
+#include "meminfo.hpp"
+#include "metrics.hpp"
+#include "nsgamepad.hpp"
+#include "tasks.hpp"
+
+namespace StateEvents {
+
+static const char* TAG = "app events";
+
+// Published state
+typedef struct {
+  HID::hid_device_report_t report;
+  bool connected;
+  NSGamepad::job_progress_t job;
+} state_t;
+
+// Subscriber slot
+typedef struct {
+  int fd;       // Subscriber socket, -1 - free slot
+  bool synced;  // Full state was sent, only diffs are needed
+} subscriber_t;
+
+static httpd_handle_t server_handle = NULL;
+
+// Subscribers list
+// Slots are changed only from HTTP server task (handler, close callback & send work)
+static subscriber_t subscribers[CONFIG_NSG_WEB_EVENTS_MAX_CLIENTS];
+static std::atomic<int> subscribers_num = 0;
+static std::atomic<int> subscribers_unsynced_num = 0;
+
+// Events, prepared by publisher task for send work
+static char event_full_buf[512];
+static char event_diff_buf[512];
+static size_t event_full_len = 0;
+static size_t event_diff_len = 0;
+
+// Unlocks, when send work is done
+static SemaphoreHandle_t send_done_semaphore;
+
+// Append formatted string to buffer
+static void buf_append(char* buf, size_t size, size_t& len, const char* fmt, ...) {
+  if (len >= size) return;
+  va_list args;
+  va_start(args, fmt);
+  int written = vsnprintf(buf + len, size - len, fmt, args);
+  va_end(args);
+  if (written > 0) len += written;
+}
+
+// Format state event (as HTTP chunk)
+// If prev is NULL, full state is formatted, otherwise only changed fields
+static size_t format_event(char* buf, size_t size, uint32_t version, const state_t& s,
+                           const state_t* prev) {
+  char data[384];
+  size_t len = 0;
+  const HID::hid_device_report_t& r = s.report;
+  const HID::hid_device_report_t* p = prev ? &prev->report : NULL;
+
+  buf_append(data, sizeof(data), len, "id: %lu\nevent: %s\ndata: {", (unsigned long)version,
+             prev ? "diff" : "state");
+  const char* sep = "";
+#define EVENT_FIELD(changed, fmt, ...)                                 \
+  if (!prev || (changed)) {                                            \
+    buf_append(data, sizeof(data), len, "%s" fmt, sep, __VA_ARGS__); \
+    sep = ",";                                                         \
+  }
+  EVENT_FIELD(r.buttons != p->buttons, "\"buttons\":%u", r.buttons);
+  EVENT_FIELD(r.dPad != p->dPad, "\"dpad\":%u", r.dPad);
+  EVENT_FIELD(r.leftXAxis != p->leftXAxis, "\"lx\":%u", r.leftXAxis);
+  EVENT_FIELD(r.leftYAxis != p->leftYAxis, "\"ly\":%u", r.leftYAxis);
+  EVENT_FIELD(r.rightXAxis != p->rightXAxis, "\"rx\":%u", r.rightXAxis);
+  EVENT_FIELD(r.rightYAxis != p->rightYAxis, "\"ry\":%u", r.rightYAxis);
+  EVENT_FIELD(s.connected != prev->connected, "\"connected\":%s", s.connected ? "true" : "false");
+  EVENT_FIELD(memcmp(&s.job, &prev->job, sizeof(s.job)) != 0,
+              "\"job\":{\"id\":%lu,\"step\":%u,\"total\":%u,\"active\":%s,\"paused\":%s,"
+              "\"aborted\":%s}",
+              (unsigned long)s.job.id, s.job.step, s.job.total, s.job.active ? "true" : "false",
+              s.job.paused ? "true" : "false", s.job.aborted ? "true" : "false");
+#undef EVENT_FIELD
+  buf_append(data, sizeof(data), len, "}\n\n");
+
+  // Response is chunked, so wrap event into chunk
+  return snprintf(buf, size, "%x\r\n%.*s\r\n", (unsigned)len, (int)len, data);
+}
+
+// Is state changed?
+static bool is_state_changed(const state_t& a, const state_t& b) {
+  return memcmp(&a.report, &b.report, sizeof(a.report)) != 0 || a.connected != b.connected ||
+         memcmp(&a.job, &b.job, sizeof(a.job)) != 0;
+}
+
+// Send prepared events to subscribers
+// Runs in HTTP server task
+static void send_work(void*) {
+  for (subscriber_t& sub : subscribers) {
+    if (sub.fd < 0) continue;
+
+    const char* event = sub.synced ? event_diff_buf : event_full_buf;
+    size_t len = sub.synced ? event_diff_len : event_full_len;
+    if (len == 0) continue;
+
+    if (httpd_socket_send(server_handle, sub.fd, event, len, 0) < 0) {
+      // Subscriber is gone, slot will be freed by close callback
+      ESP_LOGW(TAG, "Failed to send event to socket %d", sub.fd);
+      httpd_sess_trigger_close(server_handle, sub.fd);
+      continue;
+    }
+    if (!sub.synced) {
+      sub.synced = true;
+      subscribers_unsynced_num--;
+    }
+  }
+  xSemaphoreGive(send_done_semaphore);
+}
+
+// Task for coalescing state changes & publish them with fixed rate
+static void publisher_task(void*) {
+  const TickType_t freq =
+      std::max<TickType_t>(pdMS_TO_TICKS(1000 / CONFIG_NSG_WEB_EVENTS_RATE_HZ), 1);
+  const TickType_t keepalive = pdMS_TO_TICKS(CONFIG_NSG_WEB_EVENTS_KEEPALIVE_S * 1000);
+  TickType_t last_wake_time = xTaskGetTickCount();
+  TickType_t last_send_time = last_wake_time;
+  ESP_LOGI(TAG, "State events publisher task runned, rate: %d Hz", CONFIG_NSG_WEB_EVENTS_RATE_HZ);
+  MemInfo::Scope mem_scope(MemInfo::Web);
+
+  state_t last_state = {};
+  uint32_t version = 0;
+
+  while (1) {
+    vTaskDelayUntil(&last_wake_time, freq);
+    if (subscribers_num == 0) continue;
+
+    // Take snapshot of state
+    state_t state = {};
+    state.report = HID::get_hid_report();
+    state.connected = HID::is_gamepad_connected();
+    state.job = NSGamepad::jobProgress();
+
+    bool changed = version == 0 || is_state_changed(state, last_state);
+    if (changed) {
+      version++;
+      event_diff_len =
+          format_event(event_diff_buf, sizeof(event_diff_buf), version, state, &last_state);
+      last_state = state;
+    } else if (xTaskGetTickCount() - last_send_time >= keepalive) {
+      // Comment line keeps connection alive & detects gone subscribers
+      event_diff_len = snprintf(event_diff_buf, sizeof(event_diff_buf), "3\r\n:\n\n\r\n");
+    } else if (subscribers_unsynced_num == 0) {
+      continue;
+    } else {
+      event_diff_len = 0;
+    }
+    event_full_len =
+        format_event(event_full_buf, sizeof(event_full_buf), version, last_state, NULL);
+
+    if (httpd_queue_work(server_handle, send_work, NULL) == ESP_OK) {
+      xSemaphoreTake(send_done_semaphore, portMAX_DELAY);
+      last_send_time = xTaskGetTickCount();
+    }
+  }
+}
+
+// API: Subscribe to state events
+static esp_err_t api_events(httpd_req_t* req) {
+  int fd = httpd_req_to_sockfd(req);
+
+  subscriber_t* slot = NULL;
+  for (subscriber_t& sub : subscribers) {
+    if (sub.fd < 0) {
+      slot = &sub;
+      break;
+    }
+  }
+  if (!slot) {
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_sendstr(req, "Too many subscribers");
+    return ESP_OK;
+  }
+
+  // Send headers, response stays opened for events
+  httpd_resp_set_type(req, "text/event-stream");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+  if (httpd_resp_send_chunk(req, "retry: 1000\n\n", HTTPD_RESP_USE_STRLEN) != ESP_OK) {
+    return ESP_FAIL;
+  }
+
+  // Full state will be sent by publisher with next tick
+  slot->fd = fd;
+  slot->synced = false;
+  subscribers_unsynced_num++;
+  subscribers_num++;
+  ESP_LOGI(TAG, "New subscriber (socket %d), total: %d", fd, subscribers_num.load());
+
+  return ESP_OK;
+}
+
+// Forget subscriber, when its socket is closed
+void on_sock_close(int sockfd) {
+  for (subscriber_t& sub : subscribers) {
+    if (sub.fd == sockfd) {
+      if (!sub.synced) subscribers_unsynced_num--;
+      sub.fd = -1;
+      subscribers_num--;
+      ESP_LOGI(TAG, "Subscriber gone (socket %d), total: %d", sockfd, subscribers_num.load());
+    }
+  }
+}
+
+// Get number of subscribers
+int subscribers_count() {
+  return subscribers_num.load();
+}
+
+// Register state events endpoint & run publisher task
+esp_err_t init(httpd_handle_t server) {
+  ESP_LOGI(TAG, "State events initialization");
+
+  server_handle = server;
+  for (subscriber_t& sub : subscribers) {
+    sub.fd = -1;
+  }
+  NSG_SEMAPHORE_CREATE_BINARY(send_done_semaphore);
+
+  // API: Subscribe to state events
+  httpd_uri_t cfg_api_events = {
+      .uri = "/api/events", .method = HTTP_GET, .handler = api_events, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_events);
+
+  NSG_TASK_CREATE(publisher_task, "events_task", CONFIG_NSG_EVENTS_TASK_STACK_SIZE,
+                  CONFIG_NSG_EVENTS_TASK_PRIORITY, CONFIG_NSG_EVENTS_TASK_CORE_ID);
+
+  return ESP_OK;
+}
+
+}  // namespace StateEvents
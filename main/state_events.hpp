@@ -0,0 +1,19 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+namespace StateEvents {
+
+// Register state events endpoint (Server-Sent Events) & run publisher task
+esp_err_t init(httpd_handle_t server);
+
+// Forget subscriber, when its socket is closed
+// Called from HTTP server task
+void on_sock_close(int sockfd);
+
+// Get number of subscribers
+// Thread-safe
+int subscribers_count();
+
+}  // namespace StateEvents
@@ -0,0 +1,351 @@
+#include "stream.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "hid.hpp"
+#include "meminfo.hpp"
+#include "metrics.hpp"
+#include "profiles.hpp"
+
+namespace Stream {
+
+#if CONFIG_NSG_WEB_STREAM
+
+static const char* TAG = "app stream";
+
+// Stream frame: | timestamp, us (4, LE) | report (8) |
+// Timestamp is client clock by default, or low 32 bits of device clock (see /api/time) in
+// device clock mode (/api/stream?clock=device), such frames are played exactly at given time
+#define STREAM_FRAME_SIZE 12
+// Maximum frames in one WebSocket message
+#define STREAM_MESSAGE_FRAMES_MAX 32
+
+// Playout delay limits
+#define STREAM_DELAY_MIN_US (CONFIG_NSG_STREAM_PLAYOUT_DELAY_MS * 1000)
+#define STREAM_DELAY_MAX_US (CONFIG_NSG_STREAM_PLAYOUT_DELAY_MAX_MS * 1000)
+// Playout delay increase on late frame
+#define STREAM_DELAY_LATE_STEP_US 2000
+// Stream is stopped, when there are no frames during timeout
+#define STREAM_TIMEOUT_US (CONFIG_NSG_STREAM_TIMEOUT_MS * 1000)
+
+// Buffered frame
+typedef struct {
+  int64_t playout_us;  // Local time, when frame should be released
+  HID::hid_device_report_t report;
+} frame_t;
+
+// Jitter buffer (ring ordered by playout time)
+// Filled from HTTP server task, drained from HID task
+static frame_t frames[CONFIG_NSG_STREAM_BUFFER_FRAMES];
+static size_t frames_head = 0;
+static size_t frames_num = 0;
+static bool active = false;
+static int64_t last_arrival_us = 0;
+static stream_stats_t stats = {};
+static portMUX_TYPE buffer_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Client clock mapping (HTTP server task only)
+static uint32_t last_client_ts = 0;
+static int64_t client_time_us = 0;   // Client timestamp, extended to 64 bits
+static int64_t base_transit_us = 0;  // Minimal transit time (clock offset)
+static int64_t last_playout_us = 0;  // Playout time of last buffered frame
+static int32_t playout_delay_us = STREAM_DELAY_MIN_US;
+static int32_t jitter_us = 0;
+
+// Released frame (HID task only)
+static frame_t current;
+static bool has_current = false;
+
+// Message buffer (HTTP server task only)
+static uint8_t message_buf[STREAM_MESSAGE_FRAMES_MAX * STREAM_FRAME_SIZE];
+
+// Put frame with known playout time into jitter buffer
+static void enqueue(int64_t playout, int64_t now, const HID::hid_device_report_t& report) {
+  bool late = playout <= last_playout_us || playout < now;
+
+  taskENTER_CRITICAL(&buffer_mux);
+  stats.received++;
+  stats.playout_delay_us = playout_delay_us;
+  stats.jitter_us = jitter_us;
+  last_arrival_us = now;
+  active = true;
+  if (late) {
+    // Out of order or arrived after its playout time, last state is held instead
+    stats.late++;
+  } else {
+    if (frames_num == CONFIG_NSG_STREAM_BUFFER_FRAMES) {
+      frames_head = (frames_head + 1) % CONFIG_NSG_STREAM_BUFFER_FRAMES;
+      frames_num--;
+      stats.overflows++;
+    }
+    frame_t& f = frames[(frames_head + frames_num) % CONFIG_NSG_STREAM_BUFFER_FRAMES];
+    f.playout_us = playout;
+    f.report = report;
+    frames_num++;
+  }
+  taskEXIT_CRITICAL(&buffer_mux);
+
+  if (!late) last_playout_us = playout;
+}
+
+// Check, if stream should be resynchronized (first frame or after timeout)
+static bool is_resync(int64_t now) {
+  taskENTER_CRITICAL(&buffer_mux);
+  bool resync = !active || now - last_arrival_us > STREAM_TIMEOUT_US;
+  taskEXIT_CRITICAL(&buffer_mux);
+  return resync;
+}
+
+// Put frame with device timestamp into jitter buffer
+static void push_device(uint32_t device_ts, const HID::hid_device_report_t& report) {
+  int64_t now = esp_timer_get_time();
+  if (is_resync(now)) last_playout_us = 0;
+
+  // Extend timestamp to 64 bits around current time (+-35 minutes)
+  int64_t playout = now + (int32_t)(device_ts - (uint32_t)now);
+  enqueue(playout, now, report);
+}
+
+// Put frame with client timestamp into jitter buffer
+static void push(uint32_t client_ts, const HID::hid_device_report_t& report) {
+  int64_t now = esp_timer_get_time();
+  bool resync = is_resync(now);
+
+  // Map client clock to local clock
+  if (resync) {
+    client_time_us = client_ts;
+    base_transit_us = now - client_time_us;
+    last_playout_us = 0;
+    playout_delay_us = STREAM_DELAY_MIN_US;
+    jitter_us = 0;
+  } else {
+    client_time_us += (int32_t)(client_ts - last_client_ts);
+  }
+  last_client_ts = client_ts;
+
+  // Estimate jitter from transit time variation, base transit slowly follows clocks drift
+  int64_t transit = now - client_time_us;
+  if (transit < base_transit_us) {
+    base_transit_us = transit;
+  } else {
+    base_transit_us += (transit - base_transit_us) >> 10;
+  }
+  int32_t variation = transit - base_transit_us;
+  jitter_us += (variation - jitter_us) / 16;
+
+#if CONFIG_NSG_STREAM_ADAPTIVE
+  // Grow delay fast, shrink slowly
+  int32_t desired = std::clamp<int32_t>(2 * jitter_us, STREAM_DELAY_MIN_US, STREAM_DELAY_MAX_US);
+  if (desired > playout_delay_us) {
+    playout_delay_us = desired;
+  } else {
+    playout_delay_us -= (playout_delay_us - desired) / 64;
+  }
+#endif
+
+  int64_t playout = client_time_us + base_transit_us + playout_delay_us;
+#if CONFIG_NSG_STREAM_ADAPTIVE
+  if (playout <= last_playout_us || playout < now) {
+    playout_delay_us =
+        std::min<int32_t>(playout_delay_us + STREAM_DELAY_LATE_STEP_US, STREAM_DELAY_MAX_US);
+  }
+#endif
+  enqueue(playout, now, report);
+}
+
+#if CONFIG_NSG_STREAM_INTERPOLATE
+// Interpolate axis value
+inline uint8_t lerp(uint8_t a, uint8_t b, int32_t t, int32_t span) {
+  return a + ((int32_t)b - a) * t / span;
+}
+#endif
+
+// HID report source, called from HID task on every tick
+static bool playout(int64_t now_us, HID::hid_device_report_t* report) {
+  bool has_next = false;
+  frame_t next;
+
+  taskENTER_CRITICAL(&buffer_mux);
+  if (!active) {
+    taskEXIT_CRITICAL(&buffer_mux);
+    return false;
+  }
+
+  // Release due frames, only the latest one is reported
+  while (frames_num > 0 && frames[frames_head].playout_us <= now_us) {
+    current = frames[frames_head];
+    has_current = true;
+    frames_head = (frames_head + 1) % CONFIG_NSG_STREAM_BUFFER_FRAMES;
+    frames_num--;
+    stats.played++;
+  }
+
+  if (frames_num > 0) {
+    next = frames[frames_head];
+    has_next = true;
+  } else if (now_us - last_arrival_us > STREAM_TIMEOUT_US) {
+    // Stream is stopped, last state stays in HID report
+    active = false;
+    has_current = false;
+  } else if (has_current) {
+    stats.underruns++;
+  }
+  bool release = active && has_current;
+  taskEXIT_CRITICAL(&buffer_mux);
+
+  if (!release) return false;
+  *report = current.report;
+
+#if CONFIG_NSG_STREAM_INTERPOLATE
+  // Smooth sticks between released & next frame
+  if (has_next) {
+    int32_t span = next.playout_us - current.playout_us;
+    int32_t t = std::min<int64_t>(now_us - current.playout_us, span);
+    if (span > 0) {
+      report->leftXAxis = lerp(current.report.leftXAxis, next.report.leftXAxis, t, span);
+      report->leftYAxis = lerp(current.report.leftYAxis, next.report.leftYAxis, t, span);
+      report->rightXAxis = lerp(current.report.rightXAxis, next.report.rightXAxis, t, span);
+      report->rightYAxis = lerp(current.report.rightYAxis, next.report.rightYAxis, t, span);
+    }
+  }
+#endif
+  return true;
+}
+
+// Session context marker of device clock mode (no allocation, nothing to free)
+static char device_clock_ctx;
+static void device_clock_ctx_free(void*) {}
+
+// API: Input stream (WebSocket)
+// Binary messages with one or more frames: | timestamp, us (4, LE) | report (8) |
+// Query "clock=device" on handshake switches timestamps to device clock
+static esp_err_t api_stream(httpd_req_t* req) {
+  if (req->method == HTTP_GET) {
+    char query[32];
+    char value[8];
+    bool device_clock = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+                        httpd_query_key_value(query, "clock", value, sizeof(value)) == ESP_OK &&
+                        strcmp(value, "device") == 0;
+    if (device_clock) {
+      req->sess_ctx = &device_clock_ctx;
+      req->free_ctx = device_clock_ctx_free;
+    }
+    ESP_LOGI(TAG, "Input stream opened (socket %d, %s clock)", httpd_req_to_sockfd(req),
+             device_clock ? "device" : "client");
+    return ESP_OK;
+  }
+  bool device_clock = req->sess_ctx == &device_clock_ctx;
+
+  httpd_ws_frame_t ws_frame = {};
+  ws_frame.type = HTTPD_WS_TYPE_BINARY;
+  // Get message length
+  esp_err_t ret = httpd_ws_recv_frame(req, &ws_frame, 0);
+  if (ret != ESP_OK) return ret;
+  if (ws_frame.len > sizeof(message_buf)) {
+    ESP_LOGW(TAG, "Stream message is too long: %u", ws_frame.len);
+    return ESP_FAIL;
+  }
+  ws_frame.payload = message_buf;
+  ret = httpd_ws_recv_frame(req, &ws_frame, ws_frame.len);
+  if (ret != ESP_OK) return ret;
+  if (ws_frame.type != HTTPD_WS_TYPE_BINARY) return ESP_OK;
+
+  for (size_t offset = 0; offset + STREAM_FRAME_SIZE <= ws_frame.len;
+       offset += STREAM_FRAME_SIZE) {
+    const uint8_t* f = message_buf + offset;
+    uint32_t ts = f[0] | (uint32_t)f[1] << 8 | (uint32_t)f[2] << 16 | (uint32_t)f[3] << 24;
+    HID::hid_device_report_t report;
+    memcpy(&report, f + 4, sizeof(report));
+    if (device_clock) {
+      push_device(ts, Profiles::apply(report));
+    } else {
+      push(ts, Profiles::apply(report));
+    }
+  }
+  return ESP_OK;
+}
+
+// Register input stream endpoint & install jitter buffer as HID report source
+esp_err_t init(httpd_handle_t server) {
+  ESP_LOGI(TAG, "Input stream initialization, playout delay: %d-%d ms",
+           CONFIG_NSG_STREAM_PLAYOUT_DELAY_MS, CONFIG_NSG_STREAM_PLAYOUT_DELAY_MAX_MS);
+  MemInfo::add_static(MemInfo::Web, "stream", sizeof(frames) + sizeof(message_buf));
+
+  // API: Input stream
+  httpd_uri_t cfg_api_stream = {.uri = "/api/stream",
+                                .method = HTTP_GET,
+                                .handler = api_stream,
+                                .user_ctx = NULL,
+                                .is_websocket = true};
+  Metrics::register_uri_handler(server, &cfg_api_stream);
+
+  HID::set_report_source(playout);
+  return ESP_OK;
+}
+
+// Get jitter buffer statistics
+stream_stats_t get_stats() {
+  taskENTER_CRITICAL(&buffer_mux);
+  stream_stats_t s = stats;
+  s.active = active;
+  s.depth = frames_num;
+  taskEXIT_CRITICAL(&buffer_mux);
+  return s;
+}
+
+// CMD: Prints input stream information
+static int cmd_streaminfo(int argc, char** argv) {
+  stream_stats_t s = get_stats();
+  printf("Input stream: %s\r\n", s.active ? "active" : "inactive");
+  printf("  Buffer depth: %lu/%d frames\r\n", (unsigned long)s.depth,
+         CONFIG_NSG_STREAM_BUFFER_FRAMES);
+  printf("  Playout delay: %lu us, jitter: %lu us\r\n", (unsigned long)s.playout_delay_us,
+         (unsigned long)s.jitter_us);
+  printf("  Frames received: %lu, played: %lu, late: %lu, overflows: %lu\r\n",
+         (unsigned long)s.received, (unsigned long)s.played, (unsigned long)s.late,
+         (unsigned long)s.overflows);
+  printf("  Underrun ticks: %lu\r\n", (unsigned long)s.underruns);
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_streaminfo_cfg = {
+      .command = "streaminfo",
+      .help = "Get input stream jitter buffer information",
+      .hint = NULL,
+      .func = &cmd_streaminfo,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_streaminfo_cfg));
+
+  return ESP_OK;
+}
+
+#else
+
+// Input stream is disabled
+esp_err_t init(httpd_handle_t server) {
+  return ESP_OK;
+}
+
+// Get jitter buffer statistics
+stream_stats_t get_stats() {
+  return {};
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  return ESP_OK;
+}
+
+#endif
+
+}  // namespace Stream
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+namespace Stream {
+
+// Jitter buffer statistics
+typedef struct {
+  bool active;                // Stream is playing (frames arrive within timeout)
+  uint32_t depth;             // Frames waiting for playout
+  uint32_t playout_delay_us;  // Current playout delay
+  uint32_t jitter_us;         // Arrival jitter estimate
+  uint32_t received;          // Received frames
+  uint32_t played;            // Frames released into HID ticks
+  uint32_t late;              // Frames arrived after their playout time (dropped)
+  uint32_t overflows;         // Frames dropped because buffer is full
+  uint32_t underruns;         // HID ticks without next frame in buffer (last state held)
+} stream_stats_t;
+
+// Register input stream endpoint (WebSocket) & install jitter buffer as HID report source
+esp_err_t init(httpd_handle_t server);
+
+// Get jitter buffer statistics
+// Thread-safe
+stream_stats_t get_stats();
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace Stream
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// Convert Kconfig core id (-1 - no affinity) to FreeRTOS core affinity
+#define NSG_TASK_CORE(id) ((id) < 0 ? tskNO_AFFINITY : (id))
+
+// FreeRTOS objects creation
+// In static allocation mode stacks, control blocks & buffers are placed in static memory,
+// otherwise they are allocated from heap
+#if CONFIG_NSG_STATIC_ALLOCATION
+
+// Create task pinned to core
+#define NSG_TASK_CREATE(fn, name, stack_size, priority, core_id)                              \
+  do {                                                                                        \
+    static StackType_t fn##_stack[stack_size];                                                \
+    static StaticTask_t fn##_tcb;                                                             \
+    xTaskCreateStaticPinnedToCore(fn, name, stack_size, NULL, priority, fn##_stack, &fn##_tcb, \
+                                  NSG_TASK_CORE(core_id));                                    \
+  } while (0)
+
+// Create several tasks with the same function, task index is passed as argument
+#define NSG_TASKS_CREATE(fn, name, num, stack_size, priority, core_id)                       \
+  do {                                                                                       \
+    static StackType_t fn##_stacks[num][stack_size];                                         \
+    static StaticTask_t fn##_tcbs[num];                                                      \
+    for (int fn##_i = 0; fn##_i < (num); fn##_i++) {                                         \
+      xTaskCreateStaticPinnedToCore(fn, name, stack_size, (void*)(intptr_t)fn##_i, priority, \
+                                    fn##_stacks[fn##_i], &fn##_tcbs[fn##_i],                 \
+                                    NSG_TASK_CORE(core_id));                                 \
+    }                                                                                        \
+  } while (0)
+
+// Create binary semaphore
+#define NSG_SEMAPHORE_CREATE_BINARY(handle)                  \
+  do {                                                       \
+    static StaticSemaphore_t handle##_buf;                   \
+    handle = xSemaphoreCreateBinaryStatic(&handle##_buf);    \
+  } while (0)
+
+// Create event group
+#define NSG_EVENT_GROUP_CREATE(handle)                   \
+  do {                                                   \
+    static StaticEventGroup_t handle##_buf;              \
+    handle = xEventGroupCreateStatic(&handle##_buf);     \
+  } while (0)
+
+#else
+
+// Create task pinned to core
+#define NSG_TASK_CREATE(fn, name, stack_size, priority, core_id) \
+  xTaskCreatePinnedToCore(fn, name, stack_size, NULL, priority, NULL, NSG_TASK_CORE(core_id))
+
+// Create several tasks with the same function, task index is passed as argument
+#define NSG_TASKS_CREATE(fn, name, num, stack_size, priority, core_id)                       \
+  do {                                                                                       \
+    for (int fn##_i = 0; fn##_i < (num); fn##_i++) {                                         \
+      xTaskCreatePinnedToCore(fn, name, stack_size, (void*)(intptr_t)fn##_i, priority, NULL, \
+                              NSG_TASK_CORE(core_id));                                       \
+    }                                                                                        \
+  } while (0)
+
+// Create binary semaphore
+#define NSG_SEMAPHORE_CREATE_BINARY(handle) handle = xSemaphoreCreateBinary()
+
+// Create event group
+#define NSG_EVENT_GROUP_CREATE(handle) handle = xEventGroupCreate()
+
+#endif
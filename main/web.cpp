@@ -1,20 +1,38 @@
 #include "web.hpp"
 
+#include <unistd.h>
+
+#include <algorithm>
 #include <cstring>
 #include <exception>
-#include <string>
-#include <unordered_map>
 
+#include "admission.hpp"
+#include "boot.hpp"
 #include "cJSON.h"
 #include "esp_err.h"
 #include "esp_event.h"
 #include "esp_http_server.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "esp_wifi_types_generic.h"
 #include "freertos/idf_additions.h"
+#include "hid.hpp"
+#include "jobs.hpp"
+#include "json_pool.hpp"
+#include "lwip/sockets.h"
+#include "meminfo.hpp"
+#include "metrics.hpp"
 #include "nsgamepad.hpp"
+#include "nvs.h"
+#include "ota.hpp"
+#include "profiles.hpp"
 #include "projdefs.h"
+#include "script_store.hpp"
+#include "state_events.hpp"
+#include "stream.hpp"
+#include "tasks.hpp"
+#include "wifi_power.hpp"
 
 // Convert option NSG_WIFI_SCAN_AUTH_MODE_THRESHOLD -> wifi_auth_mode_t
 #if CONFIG_NSG_WIFI_AUTH_OPEN
@@ -49,19 +67,97 @@ static EventGroupHandle_t wifi_event_group;
 // Number of tries connect to WiFi
 static size_t wifi_connect_retry_num = 0;
 
+// WiFi station interface
+static esp_netif_t* sta_netif = NULL;
+
+// Cached AP parameters for fast reconnect after power on
+typedef struct {
+  uint8_t bssid[6];
+  uint8_t channel;
+  esp_netif_ip_info_t ip_info;
+} wifi_ap_cache_t;
+
+#define WIFI_CACHE_NVS_NAMESPACE "nsg_wifi"
+#define WIFI_CACHE_NVS_KEY "ap_cache"
+
+// Loaded AP cache
+static wifi_ap_cache_t wifi_ap_cache = {};
+// Connection uses cached AP parameters
+static bool wifi_ap_cache_used = false;
+// Connection with cached AP parameters was established
+static bool wifi_ap_cache_connected = false;
+
+#if CONFIG_NSG_WIFI_FAST_RECONNECT
+// Load AP cache from NVS
+static bool wifi_cache_load(wifi_ap_cache_t* cache) {
+  nvs_handle_t nvs;
+  if (nvs_open(WIFI_CACHE_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) return false;
+  size_t len = sizeof(wifi_ap_cache_t);
+  esp_err_t err = nvs_get_blob(nvs, WIFI_CACHE_NVS_KEY, cache, &len);
+  nvs_close(nvs);
+  return err == ESP_OK && len == sizeof(wifi_ap_cache_t) && cache->channel != 0;
+}
+
+// Save AP cache to NVS, if it is changed
+static void wifi_cache_save(const wifi_ap_cache_t& cache) {
+  if (memcmp(&cache, &wifi_ap_cache, sizeof(wifi_ap_cache_t)) == 0) return;
+  wifi_ap_cache = cache;
+
+  nvs_handle_t nvs;
+  if (nvs_open(WIFI_CACHE_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) return;
+  if (nvs_set_blob(nvs, WIFI_CACHE_NVS_KEY, &cache, sizeof(wifi_ap_cache_t)) == ESP_OK) {
+    nvs_commit(nvs);
+    ESP_LOGI(TAG, "AP cache saved (channel %d)", cache.channel);
+  }
+  nvs_close(nvs);
+}
+#endif
+
+// Stop using AP cache & fallback to full scan with DHCP
+// If cached AP is failed before first connection, cache is erased
+static void wifi_cache_drop(bool erase) {
+  ESP_LOGW(TAG, "Connection with cached AP lost, fallback to full scan");
+  wifi_ap_cache_used = false;
+
+  wifi_config_t wifi_config = {};
+  esp_wifi_get_config(WIFI_IF_STA, &wifi_config);
+  wifi_config.sta.bssid_set = false;
+  wifi_config.sta.channel = 0;
+  wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+  esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+#if CONFIG_NSG_WIFI_FAST_RECONNECT_CACHED_IP
+  esp_netif_dhcpc_start(sta_netif);
+#endif
+  if (!erase) return;
+
+  memset(&wifi_ap_cache, 0, sizeof(wifi_ap_cache_t));
+  nvs_handle_t nvs;
+  if (nvs_open(WIFI_CACHE_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+    nvs_erase_key(nvs, WIFI_CACHE_NVS_KEY);
+    nvs_commit(nvs);
+    nvs_close(nvs);
+  }
+}
+
 void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id,
                         void* event_data) {
   if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
     // First connection
-    ESP_LOGI(TAG, "Connecting to %s", CONFIG_NSG_WIFI_SSID);
+    ESP_LOGI(TAG, "Connecting to %s%s", CONFIG_NSG_WIFI_SSID,
+             wifi_ap_cache_used ? " (cached AP)" : "");
     esp_wifi_connect();
   } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+    // Cached AP is not available anymore
+    if (wifi_ap_cache_used) {
+      wifi_cache_drop(!wifi_ap_cache_connected);
+    }
     // Connection failed
     if (wifi_connect_retry_num < CONFIG_NSG_WIFI_MAXIMUM_RETRY) {
       // Retry connection
       vTaskDelay(pdMS_TO_TICKS(200));
       esp_wifi_connect();
       wifi_connect_retry_num++;
+      Metrics::count_wifi_reconnect();
       ESP_LOGI(TAG, "Retry to connect to the AP (%i)", wifi_connect_retry_num);
     } else {
       // Faild to connect
@@ -72,22 +168,37 @@ void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id
     // Connect established and we got IP
     ip_event_got_ip_t* event = (ip_event_got_ip_t*)event_data;
     ESP_LOGI(TAG, "Got IP:  " IPSTR, IP2STR(&event->ip_info.ip));
+    Boot::mark(Boot::WifiConnected);
     xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
     // Clear connection tries
     wifi_connect_retry_num = 0;
+    wifi_ap_cache_connected = wifi_ap_cache_used;
+
+#if CONFIG_NSG_WIFI_FAST_RECONNECT
+    // Cache AP for fast reconnect after power on
+    wifi_ap_record_t ap_info;
+    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+      wifi_ap_cache_t cache = {};
+      memcpy(cache.bssid, ap_info.bssid, sizeof(cache.bssid));
+      cache.channel = ap_info.primary;
+      cache.ip_info = event->ip_info;
+      wifi_cache_save(cache);
+    }
+#endif
   }
 }
 
 // Setup WiFi connection
+// Connection is established in background, see wifi_wait_connection()
 esp_err_t wifi_init_sta() {
   ESP_LOGI(TAG, "WiFi STA initialization");
 
-  wifi_event_group = xEventGroupCreate();
+  NSG_EVENT_GROUP_CREATE(wifi_event_group);
 
   ESP_ERROR_CHECK(esp_netif_init());
 
   ESP_ERROR_CHECK(esp_event_loop_create_default());
-  esp_netif_create_default_wifi_sta();
+  sta_netif = esp_netif_create_default_wifi_sta();
 
   wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
   ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -107,13 +218,37 @@ esp_err_t wifi_init_sta() {
   wifi_config.sta.listen_interval = 10;
   wifi_config.sta.threshold.rssi = -127;
   wifi_config.sta.threshold.authmode = NSG_WIFI_SCAN_AUTH_MODE_THRESHOLD;
+
+#if CONFIG_NSG_WIFI_FAST_RECONNECT
+  // Skip scan, connect directly to cached AP on its channel
+  if (wifi_cache_load(&wifi_ap_cache)) {
+    wifi_ap_cache_used = true;
+    wifi_config.sta.bssid_set = true;
+    memcpy(wifi_config.sta.bssid, wifi_ap_cache.bssid, sizeof(wifi_config.sta.bssid));
+    wifi_config.sta.channel = wifi_ap_cache.channel;
+    wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+#if CONFIG_NSG_WIFI_FAST_RECONNECT_CACHED_IP
+    // Skip DHCP, reuse cached IP
+    ESP_ERROR_CHECK(esp_netif_dhcpc_stop(sta_netif));
+    ESP_ERROR_CHECK(esp_netif_set_ip_info(sta_netif, &wifi_ap_cache.ip_info));
+#endif
+  }
+#endif
+
   ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
   ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+  // Modem sleep is managed by adaptive power save policy, device starts active
   ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
   ESP_ERROR_CHECK(esp_wifi_start());
+  Boot::mark(Boot::WifiStarted);
 
   ESP_LOGI(TAG, "WiFi STA initialization DONE");
 
+  return ESP_OK;
+}
+
+// Wait WiFi connection
+esp_err_t wifi_wait_connection() {
   // Waiting until connection is established (WIFI_CONNECT_BIT) or connection failed
   // (WIFI_FAIL_BIT). The bits are set by wifi_event_handler()
   EventBits_t bits = xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
@@ -122,8 +257,10 @@ esp_err_t wifi_init_sta() {
     ESP_LOGI(TAG, "Connected to AP SSID: %s", CONFIG_NSG_WIFI_SSID);
   } else if (bits & WIFI_FAIL_BIT) {
     ESP_LOGE(TAG, "Failed to connect to AP SSID: %s", CONFIG_NSG_WIFI_SSID);
+    return ESP_FAIL;
   } else {
     ESP_LOGE(TAG, "Unexpected error while WiFi AP connection (SSID: %s)", CONFIG_NSG_WIFI_SSID);
+    return ESP_FAIL;
   }
 
   return ESP_OK;
@@ -132,35 +269,190 @@ esp_err_t wifi_init_sta() {
 // API: Test ping API
 esp_err_t api_rest_ping(httpd_req_t* req) {
   httpd_resp_set_type(req, "application/json");
+  JsonPool::Scope json_scope;
   cJSON* root = cJSON_CreateObject();
 
+  char data[64];
   cJSON_AddStringToObject(root, "answer", "pong");
-  const char* data = cJSON_Print(root);
+  if (!cJSON_PrintPreallocated(root, data, sizeof(data), true)) {
+    cJSON_Delete(root);
+    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON print error");
+    return ESP_FAIL;
+  }
   httpd_resp_sendstr(req, data);
-  free((void*)data);
   cJSON_Delete(root);
 
   return ESP_OK;
 }
 
-// Buttons mapping
-static const std::unordered_map<std::string, NSGamepad::Buttons> buttons_map = {
-    {"Y", NSGamepad::Buttons::Y},
-    {"B", NSGamepad::Buttons::B},
-    {"A", NSGamepad::Buttons::A},
-    {"X", NSGamepad::Buttons::X},
-    {"L", NSGamepad::Buttons::L},
-    {"R", NSGamepad::Buttons::R},
-    {"ZL", NSGamepad::Buttons::ZL},
-    {"ZR", NSGamepad::Buttons::ZR},
-    {"Minus", NSGamepad::Buttons::Minus},
-    {"Plus", NSGamepad::Buttons::Plus},
-    {"LStick", NSGamepad::Buttons::LStick},
-    {"RStick", NSGamepad::Buttons::RStick},
-    {"Home", NSGamepad::Buttons::Home},
-    {"Capture", NSGamepad::Buttons::Capture},
-    {"Reserved1", NSGamepad::Buttons::Reserved1},
-    {"Reserved2", NSGamepad::Buttons::Reserved2}};
+// Maximum lead time of scheduled input ("at" field)
+#define WEB_SCHEDULE_HORIZON_US (10 * 1000 * 1000)
+
+// Read optional scheduled time ("at" field, device clock in us, see /api/time)
+// Returns false, if value is wrong or too far in future. 0 - execute immediately
+static bool read_at(cJSON* root, int64_t* at) {
+  *at = 0;
+  cJSON* obj_at = cJSON_GetObjectItem(root, "at");
+  if (!obj_at) return true;
+  if (!cJSON_IsNumber(obj_at) || obj_at->valuedouble < 0) return false;
+  *at = (int64_t)obj_at->valuedouble;
+  return *at - esp_timer_get_time() <= WEB_SCHEDULE_HORIZON_US;
+}
+
+// Wait for scheduled time, late inputs are executed immediately
+static void wait_at(int64_t at) {
+  if (at == 0) return;
+  int64_t late_us = esp_timer_get_time() - at;
+  if (late_us > 0) {
+    ESP_LOGW(TAG, "Scheduled input is late by %lld us", late_us);
+    return;
+  }
+  HID::delay_until_us(at);
+}
+
+// Maximum number of pending scheduled press/release requests
+#define WEB_SCHEDULED_MAX 16
+// Retry-After of input rejected by full schedule (s)
+#define WEB_SCHEDULED_RETRY_AFTER_S "1"
+
+// Press/release input, masks are bits of NSGamepad::Buttons
+typedef struct {
+  int64_t at;
+  uint16_t press;
+  uint16_t release;
+  bool release_all;
+} scheduled_input_t;
+
+// Pending scheduled inputs sorted by time, applied by input task
+static scheduled_input_t scheduled_inputs[WEB_SCHEDULED_MAX];
+static size_t scheduled_inputs_num = 0;
+static portMUX_TYPE scheduled_inputs_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t input_task_handle = NULL;
+
+// Read array of button names into mask, "all" is accepted only with release_all pointer
+// Returns false, if some button is unknown
+static bool read_buttons(cJSON* buttons, uint16_t* mask, bool* release_all) {
+  *mask = 0;
+  cJSON* button;
+  cJSON_ArrayForEach(button, buttons) {
+    if (NSGamepad::Buttons b; NSGamepad::findButton(cJSON_GetStringValue(button), &b)) {
+      *mask |= (uint16_t)1 << b;
+    } else if (release_all && cJSON_IsString(button) && strcmp(button->valuestring, "all") == 0) {
+      *release_all = true;
+    } else {
+      ESP_LOGW(TAG, "Unrecognized button: \"%s\"", cJSON_GetStringValue(button));
+      return false;
+    }
+  }
+  return true;
+}
+
+// Apply input & report HID state
+// Runs in input task & HTTP server task, state lock keeps inputs of both whole
+static void apply_input(const scheduled_input_t& input) {
+  NSGamepad::Lock lock;
+  if (input.release_all) NSGamepad::releaseAll();
+  for (int b = 0; b < 16; b++) {
+    if (input.release & (1 << b)) NSGamepad::release((NSGamepad::Buttons)b);
+    if (input.press & (1 << b)) NSGamepad::press((NSGamepad::Buttons)b);
+  }
+  NSGamepad::update();
+}
+
+// Reject input, schedule is full until scheduled inputs are applied (as Admission rejects)
+static esp_err_t send_schedule_full(httpd_req_t* req) {
+  httpd_resp_set_status(req, "503 Service Unavailable");
+  httpd_resp_set_hdr(req, "Retry-After", WEB_SCHEDULED_RETRY_AFTER_S);
+  httpd_resp_sendstr(req, "Too many scheduled inputs");
+  return ESP_OK;
+}
+
+// Apply input immediately or pass it to input task, so HTTP server isn't blocked while waiting
+// Returns false, if there are too many pending inputs
+static bool schedule_input(const scheduled_input_t& input) {
+  if (input.at == 0 || input.at <= esp_timer_get_time()) {
+    wait_at(input.at);
+    apply_input(input);
+    return true;
+  }
+
+  taskENTER_CRITICAL(&scheduled_inputs_mux);
+  bool added = scheduled_inputs_num < WEB_SCHEDULED_MAX;
+  if (added) {
+    // Insert after inputs with the same time, so they are applied in arrival order
+    size_t i = scheduled_inputs_num;
+    for (; i > 0 && scheduled_inputs[i - 1].at > input.at; i--) {
+      scheduled_inputs[i] = scheduled_inputs[i - 1];
+    }
+    scheduled_inputs[i] = input;
+    scheduled_inputs_num++;
+  }
+  TaskHandle_t task = input_task_handle;
+  taskEXIT_CRITICAL(&scheduled_inputs_mux);
+
+  if (added && task) xTaskNotifyGive(task);
+  return added;
+}
+
+// Task for scheduled inputs
+// Sleeps in FreeRTOS ticks, so new earlier input can wake it, last tick is waited precisely
+void input_task(void*) {
+  ESP_LOGI(TAG, "Input task runned");
+  const int64_t tick_us = 1000000 / configTICK_RATE_HZ;
+
+  taskENTER_CRITICAL(&scheduled_inputs_mux);
+  input_task_handle = xTaskGetCurrentTaskHandle();
+  taskEXIT_CRITICAL(&scheduled_inputs_mux);
+
+  while (1) {
+    taskENTER_CRITICAL(&scheduled_inputs_mux);
+    bool pending = scheduled_inputs_num > 0;
+    int64_t at = pending ? scheduled_inputs[0].at : 0;
+    taskEXIT_CRITICAL(&scheduled_inputs_mux);
+
+    // Wait for new input or until the earliest one is within last tick
+    int64_t left = at - esp_timer_get_time();
+    if (!pending || left > tick_us) {
+      TickType_t ticks = pending ? std::max<int64_t>(1, left / tick_us - 1) : portMAX_DELAY;
+      ulTaskNotifyTake(pdTRUE, ticks);
+      continue;
+    }
+
+    HID::delay_until_us(at);
+    taskENTER_CRITICAL(&scheduled_inputs_mux);
+    scheduled_input_t input = scheduled_inputs[0];
+    scheduled_inputs_num--;
+    memmove(&scheduled_inputs[0], &scheduled_inputs[1],
+            scheduled_inputs_num * sizeof(scheduled_input_t));
+    taskEXIT_CRITICAL(&scheduled_inputs_mux);
+    apply_input(input);
+  }
+}
+
+// API: Clock synchronization (NTP-like exchange)
+// GET /api/time?t0=<client time> -> {"t0": <client time>, "t1": <request received>, "t2": <response
+// sent>}, t1 & t2 are device monotonic clock in us. Offset = ((t1 - t0) + (t2 - t3)) / 2, round
+// trip = (t3 - t0) - (t2 - t1), where t3 is client time of response receiving
+esp_err_t api_rest_time(httpd_req_t* req) {
+  int64_t t1 = esp_timer_get_time();
+
+  // Read client timestamp (echoed back as is)
+  char query[48];
+  char value[24];
+  long long t0 = 0;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "t0", value, sizeof(value)) == ESP_OK) {
+    t0 = strtoll(value, NULL, 10);
+  }
+
+  httpd_resp_set_type(req, "application/json");
+  char data[80];
+  int len = snprintf(data, sizeof(data), "{\"t0\":%lld,\"t1\":%lld,\"t2\":%lld}", t0,
+                     (long long)t1, (long long)esp_timer_get_time());
+  httpd_resp_send(req, data, len);
+
+  return ESP_OK;
+}
 
 // API: Press gamepad button
 esp_err_t api_rest_press(httpd_req_t* req) {
@@ -168,7 +460,7 @@ esp_err_t api_rest_press(httpd_req_t* req) {
   int current = 0;
 
   // Check content length
-  if (total >= sizeof(data_buf) - 1) {
+  if ((size_t)total >= sizeof(data_buf) - 1) {
     httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "content too long");
     return ESP_FAIL;
   }
@@ -184,12 +476,21 @@ esp_err_t api_rest_press(httpd_req_t* req) {
   }
 
   // Read JSON
+  JsonPool::Scope json_scope;
   cJSON* root = cJSON_ParseWithLength(data_buf, total);
   if (!root) {
     httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "JSON parse error");
     return ESP_FAIL;
   }
 
+  // Read scheduled time
+  int64_t at;
+  if (!read_at(root, &at)) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong scheduled time");
+    cJSON_Delete(root);
+    return ESP_FAIL;
+  }
+
   // Get buttons array
   cJSON* buttons = cJSON_GetObjectItem(root, "buttons");
   if (!buttons) {
@@ -198,24 +499,19 @@ esp_err_t api_rest_press(httpd_req_t* req) {
     return ESP_FAIL;
   }
 
-  // Reads array of buttons
-  cJSON* button;
-  cJSON_ArrayForEach(button, buttons) {
-    // Parse button & press
-    if (auto it = buttons_map.find(button->valuestring); it != buttons_map.end()) {
-      // Button recognized, press it
-      NSGamepad::Buttons b = it->second;
-      NSGamepad::press(b);
-    } else {
-      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown button in buttons array");
-      ESP_LOGW(TAG, "Unrecognized button: \"%s\"", button->valuestring);
-      cJSON_Delete(root);
-      return ESP_FAIL;
-    }
+  // Reads array of buttons, nothing is pressed if some button is unknown
+  scheduled_input_t input = {.at = at, .press = 0, .release = 0, .release_all = false};
+  if (!read_buttons(buttons, &input.press, NULL)) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown button in buttons array");
+    cJSON_Delete(root);
+    return ESP_FAIL;
   }
 
-  // Report HID state
-  NSGamepad::update();
+  // Press buttons (at scheduled time)
+  if (!schedule_input(input)) {
+    cJSON_Delete(root);
+    return send_schedule_full(req);
+  }
 
   httpd_resp_sendstr(req, "OK");
 
@@ -229,7 +525,7 @@ esp_err_t api_rest_release(httpd_req_t* req) {
   int current = 0;
 
   // Check content length
-  if (total >= sizeof(data_buf) - 1) {
+  if ((size_t)total >= sizeof(data_buf) - 1) {
     httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "content too long");
     return ESP_FAIL;
   }
@@ -245,12 +541,21 @@ esp_err_t api_rest_release(httpd_req_t* req) {
   }
 
   // Read JSON
+  JsonPool::Scope json_scope;
   cJSON* root = cJSON_ParseWithLength(data_buf, total);
   if (!root) {
     httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "JSON parse error");
     return ESP_FAIL;
   }
 
+  // Read scheduled time
+  int64_t at;
+  if (!read_at(root, &at)) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong scheduled time");
+    cJSON_Delete(root);
+    return ESP_FAIL;
+  }
+
   // Get buttons array
   cJSON* buttons = cJSON_GetObjectItem(root, "buttons");
   if (!buttons) {
@@ -259,27 +564,19 @@ esp_err_t api_rest_release(httpd_req_t* req) {
     return ESP_FAIL;
   }
 
-  // Reads array of buttons
-  cJSON* button;
-  cJSON_ArrayForEach(button, buttons) {
-    // Parse button & release
-    if (auto it = buttons_map.find(button->valuestring); it != buttons_map.end()) {
-      // Button recognized, release it
-      NSGamepad::Buttons b = it->second;
-      NSGamepad::release(b);
-    } else if (strcmp(button->valuestring, "all") == 0) {
-      // Release all buttons
-      NSGamepad::releaseAll();
-    } else {
-      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown button in buttons array");
-      ESP_LOGW(TAG, "Unrecognized button: \"%s\"", button->valuestring);
-      cJSON_Delete(root);
-      return ESP_FAIL;
-    }
+  // Reads array of buttons ("all" - release all), nothing is released if some button is unknown
+  scheduled_input_t input = {.at = at, .press = 0, .release = 0, .release_all = false};
+  if (!read_buttons(buttons, &input.release, &input.release_all)) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown button in buttons array");
+    cJSON_Delete(root);
+    return ESP_FAIL;
   }
 
-  // Report HID state
-  NSGamepad::update();
+  // Release buttons (at scheduled time)
+  if (!schedule_input(input)) {
+    cJSON_Delete(root);
+    return send_schedule_full(req);
+  }
 
   httpd_resp_sendstr(req, "OK");
 
@@ -287,13 +584,137 @@ esp_err_t api_rest_release(httpd_req_t* req) {
   return ESP_OK;
 }
 
+// Maximum body of click request, it is read into job worker stack
+#define WEB_CLICK_BODY_MAX 512
+// Maximum clicks in one request
+#define WEB_CLICK_BUTTONS_MAX 32
+// Maximum press & release time of click, ms (bounds job duration estimate)
+#define WEB_CLICK_DELAY_MAX 1000
+
 // API: Click gamepad button
+// Runs in job worker (see Admission), job waits for its turn & scheduled time there
 esp_err_t api_rest_click(httpd_req_t* req) {
   int total = req->content_len;
   int current = 0;
+  char body[WEB_CLICK_BODY_MAX];
+
+  // Check content length
+  if ((size_t)total >= sizeof(body)) {
+    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "content too long");
+    return ESP_FAIL;
+  }
+
+  // Get data by chunks
+  while (current < total) {
+    int received = httpd_req_recv(req, body + current, sizeof(body) - current);
+    if (received <= 0) {
+      httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to receive data");
+      return ESP_FAIL;
+    }
+    current += received;
+  }
+
+  // Read JSON, JSON scope ends before job waits for its turn
+  uint16_t delay = 100;
+  int64_t at = 0;
+  NSGamepad::Buttons clicks[WEB_CLICK_BUTTONS_MAX];
+  int clicks_num = 0;
+  {
+    JsonPool::Scope json_scope;
+    cJSON* root = cJSON_ParseWithLength(body, total);
+    if (!root) {
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "JSON parse error");
+      return ESP_FAIL;
+    }
+
+    // Read delay
+    cJSON* obj_delay = cJSON_GetObjectItem(root, "delay");
+    if (obj_delay) {
+      if (!cJSON_IsNumber(obj_delay) || obj_delay->valueint < 0 ||
+          obj_delay->valueint > WEB_CLICK_DELAY_MAX) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong delay");
+        cJSON_Delete(root);
+        return ESP_FAIL;
+      }
+      delay = obj_delay->valueint;
+    }
+
+    // Read scheduled time
+    if (!read_at(root, &at)) {
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong scheduled time");
+      cJSON_Delete(root);
+      return ESP_FAIL;
+    }
+
+    // Get buttons array
+    cJSON* buttons = cJSON_GetObjectItem(root, "buttons");
+    if (!buttons) {
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missed buttons array");
+      cJSON_Delete(root);
+      return ESP_FAIL;
+    }
+    if (cJSON_GetArraySize(buttons) > WEB_CLICK_BUTTONS_MAX) {
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Too many buttons");
+      cJSON_Delete(root);
+      return ESP_FAIL;
+    }
+
+    // Reads array of buttons
+    cJSON* button;
+    cJSON_ArrayForEach(button, buttons) {
+      if (!NSGamepad::findButton(cJSON_GetStringValue(button), &clicks[clicks_num++])) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown button in buttons array");
+        ESP_LOGW(TAG, "Unrecognized button: \"%s\"", button->valuestring);
+        cJSON_Delete(root);
+        return ESP_FAIL;
+      }
+    }
+    cJSON_Delete(root);
+  }
+
+  // Wait for turn of client's job, first click starts at scheduled time
+  char client[JOBS_CLIENT_NAME_MAX];
+  Jobs::client_name(req, client, sizeof(client));
+  Jobs::Job job;
+  if (job.begin(client, clicks_num, clicks_num * delay * 2, at) != ESP_OK) {
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_sendstr(req, "Job queue is full");
+    return ESP_FAIL;
+  }
+  wait_at(at);
+
+  for (int i = 0; i < clicks_num; i++) {
+    if (NSGamepad::click(clicks[i], delay) != ESP_OK) {
+      httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                          "Job aborted: gamepad is disconnected");
+      return ESP_FAIL;
+    }
+    job.step();
+  }
+  job.end();
+
+  httpd_resp_sendstr(req, "OK");
+  return ESP_OK;
+}
+
+// API: Get USB polling interval & state
+esp_err_t api_rest_usb_get(httpd_req_t* req) {
+  httpd_resp_set_type(req, "application/json");
+  char data[64];
+  int len = snprintf(data, sizeof(data), "{\"interval_ms\":%d,\"connected\":%s}",
+                     HID::get_poll_interval(), HID::is_gamepad_connected() ? "true" : "false");
+  httpd_resp_send(req, data, len);
+
+  return ESP_OK;
+}
+
+// API: Set USB polling interval ({"interval_ms": 1-255}), device is re-enumerated
+esp_err_t api_rest_usb_post(httpd_req_t* req) {
+  int total = req->content_len;
+  int current = 0;
 
   // Check content length
-  if (total >= sizeof(data_buf) - 1) {
+  if ((size_t)total >= sizeof(data_buf) - 1) {
     httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "content too long");
     return ESP_FAIL;
   }
@@ -309,41 +730,25 @@ esp_err_t api_rest_click(httpd_req_t* req) {
   }
 
   // Read JSON
+  JsonPool::Scope json_scope;
   cJSON* root = cJSON_ParseWithLength(data_buf, total);
   if (!root) {
     httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "JSON parse error");
     return ESP_FAIL;
   }
 
-  // Read delay
-  uint16_t delay = 100;
-  cJSON* obj_delay = cJSON_GetObjectItem(root, "delay");
-  if (obj_delay) {
-    delay = obj_delay->valueint;
-  }
-
-  // Get buttons array
-  cJSON* buttons = cJSON_GetObjectItem(root, "buttons");
-  if (!buttons) {
-    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missed buttons array");
+  // Read interval
+  cJSON* obj_interval = cJSON_GetObjectItem(root, "interval_ms");
+  if (!cJSON_IsNumber(obj_interval) || obj_interval->valueint < 1 ||
+      obj_interval->valueint > 255) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Wrong polling interval");
     cJSON_Delete(root);
     return ESP_FAIL;
   }
-
-  // Reads array of buttons
-  cJSON* button;
-  cJSON_ArrayForEach(button, buttons) {
-    // Parse button & click
-    if (auto it = buttons_map.find(button->valuestring); it != buttons_map.end()) {
-      // Button recognized, click it
-      NSGamepad::Buttons b = it->second;
-      NSGamepad::click(b, delay);
-    } else {
-      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown button in buttons array");
-      ESP_LOGW(TAG, "Unrecognized button: \"%s\"", button->valuestring);
-      cJSON_Delete(root);
-      return ESP_FAIL;
-    }
+  if (HID::set_poll_interval(obj_interval->valueint) != ESP_OK) {
+    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to set polling interval");
+    cJSON_Delete(root);
+    return ESP_FAIL;
   }
 
   httpd_resp_sendstr(req, "OK");
@@ -352,6 +757,23 @@ esp_err_t api_rest_click(httpd_req_t* req) {
   return ESP_OK;
 }
 
+// Socket open callback
+esp_err_t web_sock_open(httpd_handle_t hd, int sockfd) {
+  // Response header & body are sent separately, don't hold body till ACK of header
+  int nodelay = 1;
+  setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+  WifiPower::on_sock_open(sockfd);
+  Admission::on_sock_open(sockfd);
+  return ESP_OK;
+}
+
+// Socket close callback
+void web_sock_close(httpd_handle_t hd, int sockfd) {
+  StateEvents::on_sock_close(sockfd);
+  Admission::on_sock_close(sockfd);
+  close(sockfd);
+}
+
 // Setup HTTP/RESTful server
 esp_err_t web_server_init() {
   ESP_LOGI(TAG, "WEB server initialization");
@@ -360,29 +782,89 @@ esp_err_t web_server_init() {
   httpd_handle_t server = NULL;
   httpd_config_t config = HTTPD_DEFAULT_CONFIG();
   config.uri_match_fn = httpd_uri_match_wildcard;
+  config.max_uri_handlers = 24;
+  config.max_open_sockets = CONFIG_NSG_HTTPD_MAX_SOCKETS;
+  config.backlog_conn = CONFIG_NSG_HTTPD_BACKLOG;
+#if CONFIG_NSG_HTTPD_LRU_PURGE
+  config.lru_purge_enable = true;
+#endif
+  config.recv_wait_timeout = CONFIG_NSG_HTTPD_RECV_TIMEOUT_S;
+  config.send_wait_timeout = CONFIG_NSG_HTTPD_SEND_TIMEOUT_S;
+#if CONFIG_NSG_HTTPD_KEEP_ALIVE
+  config.keep_alive_enable = true;
+  config.keep_alive_idle = CONFIG_NSG_HTTPD_KEEP_ALIVE_IDLE_S;
+  config.keep_alive_interval = CONFIG_NSG_HTTPD_KEEP_ALIVE_INTERVAL_S;
+  config.keep_alive_count = CONFIG_NSG_HTTPD_KEEP_ALIVE_COUNT;
+#endif
+  config.open_fn = web_sock_open;
+  config.close_fn = web_sock_close;
+  config.task_priority = CONFIG_NSG_HTTPD_TASK_PRIORITY;
+  config.stack_size = CONFIG_NSG_HTTPD_TASK_STACK_SIZE;
+  config.core_id = NSG_TASK_CORE(CONFIG_NSG_HTTPD_TASK_CORE_ID);
 
   ESP_LOGI(TAG, "Starting HTTP Server");
   ESP_ERROR_CHECK(httpd_start(&server, &config));
+  ESP_ERROR_CHECK(WifiPower::init(server));
+  ESP_ERROR_CHECK(Admission::init(server));
+
+  // Scheduled press/release inputs are applied in own task
+  NSG_TASK_CREATE(input_task, "input_task", CONFIG_NSG_INPUT_TASK_STACK_SIZE,
+                  CONFIG_NSG_INPUT_TASK_PRIORITY, CONFIG_NSG_INPUT_TASK_CORE_ID);
 
   // API: Test ping API
   httpd_uri_t cfg_api_rest_ping = {
       .uri = "/api/ping", .method = HTTP_GET, .handler = api_rest_ping, .user_ctx = NULL};
-  httpd_register_uri_handler(server, &cfg_api_rest_ping);
+  Metrics::register_uri_handler(server, &cfg_api_rest_ping);
+
+  // API: Clock synchronization
+  httpd_uri_t cfg_api_rest_time = {
+      .uri = "/api/time", .method = HTTP_GET, .handler = api_rest_time, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_rest_time);
 
   // API: Press gamepad button
   httpd_uri_t cfg_api_rest_press = {
       .uri = "/api/press", .method = HTTP_POST, .handler = api_rest_press, .user_ctx = NULL};
-  httpd_register_uri_handler(server, &cfg_api_rest_press);
+  Metrics::register_uri_handler(server, &cfg_api_rest_press);
 
   // API: Release gamepad button
   httpd_uri_t cfg_api_rest_release = {
       .uri = "/api/release", .method = HTTP_POST, .handler = api_rest_release, .user_ctx = NULL};
-  httpd_register_uri_handler(server, &cfg_api_rest_release);
+  Metrics::register_uri_handler(server, &cfg_api_rest_release);
 
   // API: Click gamepad button
   httpd_uri_t cfg_api_rest_click = {
       .uri = "/api/click", .method = HTTP_POST, .handler = api_rest_click, .user_ctx = NULL};
-  httpd_register_uri_handler(server, &cfg_api_rest_click);
+  Metrics::register_uri_handler(server, &cfg_api_rest_click);
+
+  // API: USB polling interval
+  httpd_uri_t cfg_api_rest_usb_get = {
+      .uri = "/api/usb", .method = HTTP_GET, .handler = api_rest_usb_get, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_rest_usb_get);
+  httpd_uri_t cfg_api_rest_usb_post = {
+      .uri = "/api/usb", .method = HTTP_POST, .handler = api_rest_usb_post, .user_ctx = NULL};
+  Metrics::register_uri_handler(server, &cfg_api_rest_usb_post);
+
+  // API: State events
+  ESP_ERROR_CHECK(StateEvents::init(server));
+  ESP_ERROR_CHECK(Profiles::api_register(server));
+
+  // API: Input stream
+  ESP_ERROR_CHECK(Stream::init(server));
+
+  // API: Stored scripts
+  ESP_ERROR_CHECK(ScriptStore::api_register(server));
+
+  // API: Job queue
+  ESP_ERROR_CHECK(Jobs::api_register(server));
+
+  // API: Memory usage
+  ESP_ERROR_CHECK(MemInfo::api_register(server));
+
+  // API: OTA update
+  ESP_ERROR_CHECK(Ota::api_register(server));
+
+  // API: Metrics
+  ESP_ERROR_CHECK(Metrics::init(server));
 
   return ESP_OK;
 }
@@ -390,20 +872,30 @@ esp_err_t web_server_init() {
 // Task for init & manage web server
 void web_task(void*) {
   ESP_LOGI(TAG, "WEB task runned");
+  MemInfo::Scope mem_scope(MemInfo::Web);
 
+  // HTTP server doesn't need established connection, so start it while WiFi connects
   wifi_init_sta();
   web_server_init();
+  Boot::mark(Boot::WebServerReady);
+  wifi_wait_connection();
 
   while (1) {
     vTaskDelay(pdMS_TO_TICKS(100));
+    WifiPower::update();
+    Admission::update();
+    Ota::update();
   }
 }
 
 // Setup web component
 esp_err_t init() {
   ESP_LOGI(TAG, "WEB component initialization");
+  MemInfo::Scope mem_scope(MemInfo::Web);
+  MemInfo::add_static(MemInfo::Web, "data_buf", sizeof(data_buf));
 
-  xTaskCreate(web_task, "web_task", 4096, NULL, 3, NULL);
+  NSG_TASK_CREATE(web_task, "web_task", CONFIG_NSG_WEB_TASK_STACK_SIZE,
+                  CONFIG_NSG_WEB_TASK_PRIORITY, CONFIG_NSG_WEB_TASK_CORE_ID);
 
   return ESP_OK;
 }
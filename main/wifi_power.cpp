@@ -0,0 +1,209 @@
+#include "wifi_power.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "nsgamepad.hpp"
+#include "state_events.hpp"
+
+namespace WifiPower {
+
+#if CONFIG_NSG_WIFI_POWER_SAVE
+
+static const char* TAG = "app wifi ps";
+
+// Idle period before modem sleep
+#define WIFI_PS_IDLE_US ((int64_t)CONFIG_NSG_WIFI_POWER_SAVE_IDLE_S * 1000000)
+
+#if CONFIG_NSG_WIFI_POWER_SAVE_MAX_MODEM
+#define WIFI_PS_SLEEP_MODE WIFI_PS_MAX_MODEM
+#else
+#define WIFI_PS_SLEEP_MODE WIFI_PS_MIN_MODEM
+#endif
+
+static httpd_handle_t server_handle = NULL;
+
+// Last control traffic or busy state
+static std::atomic<int64_t> last_activity_us = 0;
+// Accept time of first connection after sleep (0 - no measurement)
+static std::atomic<int64_t> wake_open_us = 0;
+static std::atomic<bool> sleeping = false;
+
+// Mode switches & statistics
+static StaticSemaphore_t mode_mtx_buf;
+static SemaphoreHandle_t mode_mtx;
+static int64_t mode_since_us = 0;
+static ps_stats_t stats = {};
+
+// Switch power save mode
+static void set_mode(bool sleep) {
+  xSemaphoreTake(mode_mtx, portMAX_DELAY);
+  if (sleeping != sleep) {
+    int64_t now = esp_timer_get_time();
+    if (sleeping) {
+      stats.sleep_us += now - mode_since_us;
+      stats.wakeups++;
+    } else {
+      stats.active_us += now - mode_since_us;
+      stats.sleeps++;
+    }
+    mode_since_us = now;
+    esp_wifi_set_ps(sleep ? WIFI_PS_SLEEP_MODE : WIFI_PS_NONE);
+    sleeping = sleep;
+    ESP_LOGI(TAG, "%s", sleep ? "Device is idle, modem sleep enabled" : "Modem sleep disabled");
+  }
+  xSemaphoreGive(mode_mtx);
+}
+
+// Device is busy: running job, state events subscribers or WebSocket connections
+static bool is_busy() {
+  if (NSGamepad::jobProgress().active) return true;
+  if (StateEvents::subscribers_count() > 0) return true;
+
+#if CONFIG_HTTPD_WS_SUPPORT
+  int fds[CONFIG_LWIP_MAX_SOCKETS];
+  size_t fds_num = CONFIG_LWIP_MAX_SOCKETS;
+  if (server_handle && httpd_get_client_list(server_handle, &fds_num, fds) == ESP_OK) {
+    for (size_t i = 0; i < fds_num; i++) {
+      if (httpd_ws_get_fd_info(server_handle, fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET) return true;
+    }
+  }
+#endif
+  return false;
+}
+
+// Start adaptive power save policy
+esp_err_t init(httpd_handle_t server) {
+  ESP_LOGI(TAG, "Adaptive power save, idle period: %d s", CONFIG_NSG_WIFI_POWER_SAVE_IDLE_S);
+  server_handle = server;
+  mode_mtx = xSemaphoreCreateMutexStatic(&mode_mtx_buf);
+  mode_since_us = esp_timer_get_time();
+  last_activity_us = mode_since_us;
+  return ESP_OK;
+}
+
+// Control traffic
+void activity() {
+  int64_t now = esp_timer_get_time();
+  last_activity_us = now;
+
+  // First request after sleep, measure latency from connection accept
+  int64_t open_us = wake_open_us.exchange(0);
+  if (open_us) {
+    uint32_t latency = now - open_us;
+    xSemaphoreTake(mode_mtx, portMAX_DELAY);
+    stats.wake_latency_num++;
+    stats.wake_latency_last_us = latency;
+    stats.wake_latency_sum_us += latency;
+    if (latency > stats.wake_latency_max_us) stats.wake_latency_max_us = latency;
+    xSemaphoreGive(mode_mtx);
+  }
+
+  if (sleeping) set_mode(false);
+}
+
+// New connection accepted
+void on_sock_open(int sockfd) {
+  int64_t now = esp_timer_get_time();
+  last_activity_us = now;
+  if (sleeping) {
+    wake_open_us = now;
+    set_mode(false);
+  }
+}
+
+// Check idle period & connections
+void update() {
+  int64_t now = esp_timer_get_time();
+  if (is_busy()) {
+    last_activity_us = now;
+    if (sleeping) set_mode(false);
+  } else if (!sleeping && now - last_activity_us > WIFI_PS_IDLE_US) {
+    set_mode(true);
+  }
+}
+
+// Get power save statistics
+ps_stats_t get_stats() {
+  if (!mode_mtx) return {};  // Web server isn't started yet
+  xSemaphoreTake(mode_mtx, portMAX_DELAY);
+  ps_stats_t s = stats;
+  s.sleeping = sleeping;
+  // Add time of current mode
+  int64_t current = esp_timer_get_time() - mode_since_us;
+  if (s.sleeping) {
+    s.sleep_us += current;
+  } else {
+    s.active_us += current;
+  }
+  xSemaphoreGive(mode_mtx);
+  return s;
+}
+
+// CMD: Prints WiFi power save information
+static int cmd_wifips(int argc, char** argv) {
+  ps_stats_t s = get_stats();
+  uint64_t total_us = s.active_us + s.sleep_us;
+  printf("WiFi power save: %s (idle period %d s)\r\n", s.sleeping ? "modem sleep" : "none",
+         CONFIG_NSG_WIFI_POWER_SAVE_IDLE_S);
+  printf("  Active: %llu s (%llu%%), sleep: %llu s (%llu%%)\r\n",
+         (unsigned long long)(s.active_us / 1000000),
+         (unsigned long long)(total_us ? s.active_us * 100 / total_us : 0),
+         (unsigned long long)(s.sleep_us / 1000000),
+         (unsigned long long)(total_us ? s.sleep_us * 100 / total_us : 0));
+  printf("  Sleeps: %lu, wakeups: %lu\r\n", (unsigned long)s.sleeps, (unsigned long)s.wakeups);
+  printf("  Wake latency (accept to first request): last %lu us, avg %llu us, max %lu us\r\n",
+         (unsigned long)s.wake_latency_last_us,
+         (unsigned long long)(s.wake_latency_num ? s.wake_latency_sum_us / s.wake_latency_num : 0),
+         (unsigned long)s.wake_latency_max_us);
+  return 0;
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  ESP_LOGI(TAG, "Register console commands");
+
+  const esp_console_cmd_t cmd_wifips_cfg = {
+      .command = "wifips",
+      .help = "Get WiFi power save information",
+      .hint = NULL,
+      .func = &cmd_wifips,
+      .argtable = NULL,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_wifips_cfg));
+
+  return ESP_OK;
+}
+
+#else
+
+// Power save is disabled, WiFi stays in WIFI_PS_NONE
+esp_err_t init(httpd_handle_t server) {
+  return ESP_OK;
+}
+
+void activity() {}
+
+void on_sock_open(int sockfd) {}
+
+void update() {}
+
+// Get power save statistics
+ps_stats_t get_stats() {
+  return {};
+}
+
+// Register console commands
+esp_err_t cmds_register() {
+  return ESP_OK;
+}
+
+#endif
+
+}  // namespace WifiPower
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+namespace WifiPower {
+
+// WiFi power save statistics
+typedef struct {
+  bool sleeping;                  // Modem sleep is enabled now
+  uint64_t active_us;             // Time in WIFI_PS_NONE
+  uint64_t sleep_us;              // Time in modem sleep
+  uint32_t sleeps;                // Switches to modem sleep
+  uint32_t wakeups;               // Switches back to WIFI_PS_NONE
+  uint32_t wake_latency_num;      // Measured first requests after sleep
+  uint32_t wake_latency_last_us;  // Connection accept to first request after sleep
+  uint32_t wake_latency_max_us;   // Maximum of wake latency
+  uint64_t wake_latency_sum_us;   // Sum of wake latency
+} ps_stats_t;
+
+// Start adaptive power save policy (WiFi should be initialized)
+esp_err_t init(httpd_handle_t server);
+
+// Control traffic (API request), switches WiFi to WIFI_PS_NONE immediately
+// Called from HTTP server task
+void activity();
+
+// New connection accepted, switches WiFi to WIFI_PS_NONE immediately
+// Called from HTTP server task
+void on_sock_open(int sockfd);
+
+// Check idle period & connections, enable modem sleep when device is idle
+// Called periodically from web task
+void update();
+
+// Get power save statistics
+// Thread-safe
+ps_stats_t get_stats();
+
+// Register console commands
+esp_err_t cmds_register();
+
+}  // namespace WifiPower
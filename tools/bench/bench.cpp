@@ -0,0 +1,353 @@
+// Host microbenchmarks of gamepad hot paths with baseline regression check
+// Firmware sources are linked with stand-ins of ESP-IDF, TinyUSB & HTTP server (see standins/)
+//
+// Usage: nsg_bench [Google Benchmark flags] [--save-baseline=<file>] [--baseline=<file>]
+//                  [--threshold=<percent>]
+//   --save-baseline  store results (real time per iteration) as baseline of this machine
+//   --baseline       compare results with baseline, exit code 1 if any benchmark is slower
+//                    than baseline by more than threshold (default 20%)
+// With --benchmark_repetitions=N median of repetitions is stored & compared
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "hid.hpp"
+#include "jobs.hpp"
+#include "json_pool.hpp"
+#include "nsgamepad.hpp"
+#include "profiles.hpp"
+#include "standin.hpp"
+
+namespace WEB {
+
+// REST handlers of web.cpp (not exported by web.hpp)
+esp_err_t api_rest_press(httpd_req_t* req);
+esp_err_t api_rest_release(httpd_req_t* req);
+
+}  // namespace WEB
+
+namespace Bench {
+
+// Default allowed slowdown against baseline, percent
+#define BENCH_THRESHOLD_DEFAULT 20.0
+
+// Profile slots used by report building benchmarks
+#define BENCH_PROFILE_IDENTITY 0
+#define BENCH_PROFILE_REMAP 1
+
+// Button & dpad names, as they come in requests
+static const char* button_names[] = {"Y",     "B",     "A",      "X",      "L",
+                                     "R",     "ZL",    "ZR",     "Minus",  "Plus",
+                                     "LStick", "RStick", "Home", "Capture"};
+static const char* dpad_names[] = {"U", "UR", "R", "DR", "D", "DL", "L", "UL", "0"};
+
+// Sample request bodies (as sent by tools/client)
+static const char* press_json = "{\"buttons\":[\"A\",\"B\",\"ZL\",\"Home\"]}";
+static const char* release_json = "{\"buttons\":[\"A\",\"B\",\"ZL\",\"all\"]}";
+
+// Gamepad is connected by HID task after USB mount
+static void gamepad_connect() {
+  StandIn::usb_mount(true);
+  if (!HID::wait_gamepad_connected(1000)) {
+    fprintf(stderr, "Gamepad isn't connected\n");
+    abort();
+  }
+}
+
+// Gamepad is disconnected by HID task after USB unmount, reports aren't waited
+static void gamepad_disconnect() {
+  StandIn::usb_mount(false);
+  while (HID::is_gamepad_connected()) vTaskDelay(1);
+}
+
+// Report with changing buttons & axes
+static HID::hid_device_report_t sample_report(uint32_t i) {
+  HID::hid_device_report_t report = {};
+  report.buttons = i & 0x3FFF;
+  report.dPad = i % 9 < 8 ? i % 9 : (uint8_t)NSGamepad::DpadDirection::centered;
+  report.leftXAxis = i;
+  report.leftYAxis = i >> 1;
+  report.rightXAxis = ~i;
+  report.rightYAxis = i >> 2;
+  return report;
+}
+
+// Name lookup: all button names
+static void BM_FindButton(benchmark::State& state) {
+  for (auto _ : state) {
+    for (const char* name : button_names) {
+      NSGamepad::Buttons b;
+      benchmark::DoNotOptimize(NSGamepad::findButton(name, &b));
+      benchmark::DoNotOptimize(b);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * std::size(button_names));
+}
+BENCHMARK(BM_FindButton);
+
+// Name lookup: all dpad names
+static void BM_FindDpad(benchmark::State& state) {
+  for (auto _ : state) {
+    for (const char* name : dpad_names) {
+      NSGamepad::DpadDirection d;
+      benchmark::DoNotOptimize(NSGamepad::findDpad(name, &d));
+      benchmark::DoNotOptimize(d);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * std::size(dpad_names));
+}
+BENCHMARK(BM_FindDpad);
+
+// Name lookup: unknown name (full scan)
+static void BM_FindButtonUnknown(benchmark::State& state) {
+  for (auto _ : state) {
+    NSGamepad::Buttons b;
+    benchmark::DoNotOptimize(NSGamepad::findButton("Unknown", &b));
+  }
+}
+BENCHMARK(BM_FindButtonUnknown);
+
+// Report building with active profile
+static void profile_apply(benchmark::State& state, uint8_t slot) {
+  Profiles::set_active(slot);
+  uint32_t i = 0;
+  for (auto _ : state) {
+    HID::hid_device_report_t report = Profiles::apply(sample_report(i++));
+    benchmark::DoNotOptimize(report);
+  }
+  Profiles::set_active(BENCH_PROFILE_IDENTITY);
+}
+
+// Report building: identity profile
+static void BM_ProfileApplyIdentity(benchmark::State& state) {
+  profile_apply(state, BENCH_PROFILE_IDENTITY);
+}
+BENCHMARK(BM_ProfileApplyIdentity);
+
+// Report building: remapped buttons & calibrated axes
+static void BM_ProfileApplyRemap(benchmark::State& state) {
+  profile_apply(state, BENCH_PROFILE_REMAP);
+}
+BENCHMARK(BM_ProfileApplyRemap);
+
+// JSON request handling, gamepad is disconnected so state isn't waited for delivery
+static void api_request(benchmark::State& state, esp_err_t (*handler)(httpd_req_t*),
+                        const char* uri, const char* body) {
+  gamepad_disconnect();
+  httpd_req_t req = {};
+  StandIn::request_t r;
+  for (auto _ : state) {
+    StandIn::request_init(&req, &r, uri, body);
+    if (handler(&req) != ESP_OK || strcmp(r.status, "200 OK") != 0) {
+      state.SkipWithError("Request failed");
+      break;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * strlen(body));
+}
+
+// JSON request handling: POST /api/press
+static void BM_ApiPress(benchmark::State& state) {
+  api_request(state, WEB::api_rest_press, "/api/press", press_json);
+}
+BENCHMARK(BM_ApiPress);
+
+// JSON request handling: POST /api/release
+static void BM_ApiRelease(benchmark::State& state) {
+  api_request(state, WEB::api_rest_release, "/api/release", release_json);
+}
+BENCHMARK(BM_ApiRelease);
+
+// State submission: report is handed to HID task & delivered on its next tick
+// Timers run back-to-back, so time is cost of handoff, not polling interval
+static void BM_SetHidReport(benchmark::State& state) {
+  StandIn::timers_free_run(true);
+  gamepad_connect();
+  uint32_t i = 0;
+  for (auto _ : state) {
+    if (HID::set_hid_report(sample_report(i++)) != ESP_OK) {
+      state.SkipWithError("Report isn't delivered");
+      break;
+    }
+  }
+  StandIn::timers_free_run(false);
+}
+BENCHMARK(BM_SetHidReport)->UseRealTime();
+
+// State submission: gamepad state with active profile (NSGamepad::update())
+static void BM_GamepadUpdate(benchmark::State& state) {
+  StandIn::timers_free_run(true);
+  gamepad_connect();
+  Profiles::set_active(BENCH_PROFILE_REMAP);
+  uint32_t i = 0;
+  for (auto _ : state) {
+    NSGamepad::setReport(sample_report(i++), true);
+  }
+  Profiles::set_active(BENCH_PROFILE_IDENTITY);
+  StandIn::timers_free_run(false);
+}
+BENCHMARK(BM_GamepadUpdate)->UseRealTime();
+
+// Check, if benchmark run failed (field is renamed in Google Benchmark 1.8)
+template <typename Run>
+static bool run_failed(const Run& run) {
+  if constexpr (requires { run.skipped; }) {
+    return run.skipped;
+  } else {
+    return run.error_occurred;
+  }
+}
+
+// Console reporter, which collects real time per iteration (ns) of each benchmark
+// Median of repetitions replaces single runs
+class ResultsReporter : public benchmark::ConsoleReporter {
+ public:
+  void ReportRuns(const std::vector<Run>& runs) override {
+    ConsoleReporter::ReportRuns(runs);
+    for (const Run& run : runs) {
+      if (run_failed(run)) continue;
+      double ns = run.GetAdjustedRealTime() * 1e9 / benchmark::GetTimeUnitMultiplier(run.time_unit);
+      std::string name = run.run_name.str();
+      if (run.run_type == Run::RT_Aggregate) {
+        if (run.aggregate_name != "median") continue;
+        medians_[name] = ns;
+      }
+      results_[name] = medians_.count(name) ? medians_[name] : ns;
+    }
+  }
+
+  const std::map<std::string, double>& results() const { return results_; }
+
+ private:
+  std::map<std::string, double> results_;
+  std::map<std::string, double> medians_;
+};
+
+// Save results as baseline
+static bool save_baseline(const char* path, const std::map<std::string, double>& results) {
+  FILE* f = fopen(path, "w");
+  if (!f) {
+    fprintf(stderr, "Failed to write baseline %s\n", path);
+    return false;
+  }
+  fprintf(f, "# nsg_bench baseline: <benchmark> <real time per iteration, ns>\n");
+  for (const auto& [name, ns] : results) {
+    fprintf(f, "%s %.3f\n", name.c_str(), ns);
+  }
+  fclose(f);
+  printf("Baseline saved: %s (%zu benchmarks)\n", path, results.size());
+  return true;
+}
+
+// Load baseline
+static bool load_baseline(const char* path, std::map<std::string, double>* baseline) {
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Baseline %s is not found, record it with --save-baseline\n", path);
+    return false;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    char name[200];
+    double ns;
+    if (line[0] == '#') continue;
+    if (sscanf(line, "%199s %lf", name, &ns) == 2 && ns > 0) (*baseline)[name] = ns;
+  }
+  fclose(f);
+  return true;
+}
+
+// Compare results with baseline, returns number of regressions
+static int compare_baseline(const std::map<std::string, double>& baseline,
+                            const std::map<std::string, double>& results, double threshold) {
+  int regressions = 0;
+  printf("\n%-36s %12s %12s %9s\n", "Benchmark", "Baseline ns", "Current ns", "Change");
+  for (const auto& [name, ns] : results) {
+    auto it = baseline.find(name);
+    if (it == baseline.end()) {
+      printf("%-36s %12s %12.1f %9s\n", name.c_str(), "-", ns, "new");
+      continue;
+    }
+    double change = (ns - it->second) * 100.0 / it->second;
+    bool regression = change > threshold;
+    regressions += regression;
+    printf("%-36s %12.1f %12.1f %+8.1f%%%s\n", name.c_str(), it->second, ns, change,
+           regression ? "  REGRESSION" : "");
+  }
+  if (regressions) {
+    printf("%d benchmark(s) slower than baseline by more than %.1f%%\n", regressions, threshold);
+  } else {
+    printf("No regressions (threshold %.1f%%)\n", threshold);
+  }
+  return regressions;
+}
+
+// Profile with remapped buttons & calibrated axes
+static void setup_profiles() {
+  Profiles::profile_t p = Profiles::identity();
+  strncpy(p.name, "bench", sizeof(p.name));
+  std::swap(p.buttons[NSGamepad::Buttons::A], p.buttons[NSGamepad::Buttons::B]);
+  std::swap(p.dpad[NSGamepad::DpadDirection::up], p.dpad[NSGamepad::DpadDirection::down]);
+  for (Profiles::axis_cfg_t& axis : p.axes) {
+    axis.deadzone = 12;
+    axis.curve = 150;
+  }
+  p.axes[Profiles::Axis::LeftY].invert = true;
+  ESP_ERROR_CHECK(Profiles::set(BENCH_PROFILE_REMAP, p));
+}
+
+}  // namespace Bench
+
+int main(int argc, char** argv) {
+  // Own flags are removed, rest is parsed by Google Benchmark
+  const char* baseline_path = NULL;
+  const char* save_path = NULL;
+  double threshold = BENCH_THRESHOLD_DEFAULT;
+  int args = 1;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--baseline=", 11) == 0) {
+      baseline_path = argv[i] + 11;
+    } else if (strncmp(argv[i], "--save-baseline=", 16) == 0) {
+      save_path = argv[i] + 16;
+    } else if (strncmp(argv[i], "--threshold=", 12) == 0) {
+      threshold = atof(argv[i] + 12);
+    } else {
+      argv[args++] = argv[i];
+    }
+  }
+  argc = args;
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+  // Baseline is loaded before run, so missing file doesn't waste run time
+  std::map<std::string, double> baseline;
+  if (baseline_path && !Bench::load_baseline(baseline_path, &baseline)) return 2;
+
+  // Firmware modules under benchmark
+  ESP_ERROR_CHECK(JsonPool::init());
+  ESP_ERROR_CHECK(Profiles::init());
+  ESP_ERROR_CHECK(NSGamepad::init());
+  ESP_ERROR_CHECK(Jobs::init());
+  ESP_ERROR_CHECK(HID::init());
+  ESP_ERROR_CHECK(HID::init_hid_task());
+  Bench::setup_profiles();
+
+  Bench::ResultsReporter reporter;
+  benchmark::RunSpecifiedBenchmarks(&reporter);
+  benchmark::Shutdown();
+
+  if (save_path && !Bench::save_baseline(save_path, reporter.results())) return 2;
+  if (baseline_path && Bench::compare_baseline(baseline, reporter.results(), threshold) > 0) {
+    return 1;
+  }
+  return 0;
+}
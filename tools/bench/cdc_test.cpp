@@ -0,0 +1,280 @@
+// Host test of CDC control channel protocol
+// Parser is fed directly (resync, oversized frames, CRC), then frames go the firmware way:
+// CDC-ACM stand-in -> HID receive callback -> CDC task -> handle_frame -> HID::cdc_write
+// Exit code 1, if any check fails
+//
+// Usage: nsg_cdc_test
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "cdc_control.hpp"
+#include "cdc_protocol.hpp"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "hid.hpp"
+#include "jobs.hpp"
+#include "json_pool.hpp"
+#include "nsgamepad.hpp"
+#include "profiles.hpp"
+#include "standin.hpp"
+
+namespace CdcTest {
+
+// Response wait timeout, ms
+#define CDC_TEST_TIMEOUT_MS 1000
+
+static int failed = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+      failed++;                                                       \
+    }                                                                 \
+  } while (0)
+
+typedef std::vector<uint8_t> bytes_t;
+
+// Encode frame
+static bytes_t frame(uint8_t type, const bytes_t& payload = {}) {
+  bytes_t out(payload.size() + CDC_FRAME_OVERHEAD);
+  size_t len = CdcProtocol::encode(type, payload.data(), payload.size(), out.data(), out.size());
+  out.resize(len);
+  return out;
+}
+
+// Feed bytes, returns number of complete frames
+static int feed(CdcProtocol::Parser& parser, const bytes_t& bytes) {
+  int frames = 0;
+  for (uint8_t byte : bytes) {
+    if (parser.feed(byte)) frames++;
+  }
+  return frames;
+}
+
+// Step: report & hold time
+static bytes_t step(uint16_t buttons, uint32_t hold_us) {
+  bytes_t s(CDC_STEP_SIZE);
+  s[0] = buttons & 0xFF;
+  s[1] = buttons >> 8;
+  s[2] = NSGamepad::DpadDirection::centered;
+  s[3] = s[4] = s[5] = s[6] = 0x80;
+  for (int i = 0; i < 4; i++) s[CDC_REPORT_SIZE + i] = hold_us >> (8 * i);
+  return s;
+}
+
+static bytes_t concat(const bytes_t& a, const bytes_t& b) {
+  bytes_t out = a;
+  out.insert(out.end(), b.begin(), b.end());
+  return out;
+}
+
+// Garbage before frame is skipped
+static void test_resync_garbage() {
+  CdcProtocol::Parser parser;
+  bytes_t bytes = {0x00, 0x13, 0xFF, 0x42};
+  bytes = concat(bytes, frame(CdcProtocol::Ping, {1, 2, 3}));
+  CHECK(feed(parser, bytes) == 1);
+  CHECK(parser.frame().type == CdcProtocol::Ping);
+  CHECK(parser.frame().len == 3);
+  CHECK(memcmp(parser.frame().payload, "\x01\x02\x03", 3) == 0);
+  CHECK(parser.errors() == 0);
+
+  // Broken frame is dropped, parser resyncs on the next magic byte
+  bytes_t broken = frame(CdcProtocol::Ping, {4, 5});
+  broken.resize(broken.size() - 2);
+  CHECK(feed(parser, concat(broken, frame(CdcProtocol::State, step(1, 0)))) == 0);
+  CHECK(feed(parser, frame(CdcProtocol::Ping, {6})) == 1);
+  CHECK(parser.frame().payload[0] == 6);
+}
+
+// Length above payload maximum is rejected without reading payload
+static void test_too_long() {
+  CdcProtocol::Parser parser;
+  uint16_t len = CDC_FRAME_PAYLOAD_MAX + 1;
+  bytes_t bytes = {CDC_FRAME_MAGIC, CdcProtocol::Ping, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8)};
+  CHECK(feed(parser, bytes) == 0);
+  CHECK(parser.errors() == 1);
+  CHECK(feed(parser, frame(CdcProtocol::Ping, {7})) == 1);
+  CHECK(parser.frame().payload[0] == 7);
+
+  uint8_t out[CDC_FRAME_PAYLOAD_MAX + CDC_FRAME_OVERHEAD + 1];
+  uint8_t payload[CDC_FRAME_PAYLOAD_MAX + 1] = {};
+  CHECK(CdcProtocol::encode(CdcProtocol::Ping, payload, len, out, sizeof(out)) == 0);
+  CHECK(CdcProtocol::encode(CdcProtocol::Ping, payload, 8, out, 8 + CDC_FRAME_OVERHEAD - 1) == 0);
+}
+
+// Frame with CRC mismatch is dropped
+static void test_bad_crc() {
+  CdcProtocol::Parser parser;
+  bytes_t bytes = frame(CdcProtocol::Ping, {1, 2, 3});
+  bytes.back() ^= 0x01;
+  CHECK(feed(parser, bytes) == 0);
+  CHECK(parser.errors() == 1);
+
+  bytes = frame(CdcProtocol::Ping, {1, 2, 3});
+  bytes[5] ^= 0x10;
+  CHECK(feed(parser, bytes) == 0);
+  CHECK(parser.errors() == 2);
+}
+
+// Encoded frames are decoded back (empty, short & maximum payload)
+static void test_round_trip() {
+  CdcProtocol::Parser parser;
+  for (size_t len : {0, 1, 12, CDC_FRAME_PAYLOAD_MAX}) {
+    bytes_t payload(len);
+    for (size_t i = 0; i < len; i++) payload[i] = i * 7 + 1;
+    bytes_t bytes = frame(CdcProtocol::Batch, payload);
+    CHECK(bytes.size() == len + CDC_FRAME_OVERHEAD);
+    CHECK(feed(parser, bytes) == 1);
+    CHECK(parser.frame().type == CdcProtocol::Batch);
+    CHECK(parser.frame().len == len);
+    CHECK(memcmp(parser.frame().payload, payload.data(), len) == 0);
+  }
+  CHECK(parser.errors() == 0);
+
+  uint8_t u64[8];
+  CdcProtocol::put_u64(u64, 0x0123456789ABCDEFull);
+  CHECK(u64[0] == 0xEF && u64[7] == 0x01);
+  CHECK(CdcProtocol::get_u64(u64) == 0x0123456789ABCDEFull);
+}
+
+// Send bytes over CDC-ACM in chunks
+static void send(const bytes_t& bytes, size_t chunk = 64) {
+  for (size_t i = 0; i < bytes.size(); i += chunk) {
+    StandIn::cdc_receive(bytes.data() + i, std::min(chunk, bytes.size() - i));
+  }
+}
+
+// Wait for response frame
+static bool wait_response(CdcProtocol::frame_t* response) {
+  CdcProtocol::Parser parser;
+  int64_t deadline = esp_timer_get_time() + CDC_TEST_TIMEOUT_MS * 1000;
+  while (esp_timer_get_time() < deadline) {
+    uint8_t buf[64];
+    size_t len = StandIn::cdc_transmitted(buf, sizeof(buf));
+    for (size_t i = 0; i < len; i++) {
+      if (parser.feed(buf[i])) {
+        *response = parser.frame();
+        return true;
+      }
+    }
+    if (len == 0) vTaskDelay(1);
+  }
+  return false;
+}
+
+// Send bytes & wait for response frame
+static bool request(const bytes_t& bytes, CdcProtocol::frame_t* response, size_t chunk = 64) {
+  send(bytes, chunk);
+  return wait_response(response);
+}
+
+// Check response type & status
+static bool responded(const CdcProtocol::frame_t& response, uint8_t type, uint8_t status) {
+  return response.type == (type | CdcProtocol::Response) && response.len >= 1 &&
+         response.payload[0] == status;
+}
+
+// Frames are handled by CDC task, responses are written with HID::cdc_write
+static void test_handle_frame() {
+  static CdcProtocol::frame_t r;
+
+  // Ping is echoed, request is split into single bytes & preceded by garbage
+  bytes_t ping = concat({0x11, 0x22}, frame(CdcProtocol::Ping, {9, 8, 7}));
+  CHECK(request(ping, &r, 1));
+  CHECK(responded(r, CdcProtocol::Ping, CdcProtocol::Ok));
+  CHECK(r.len == 4 && memcmp(r.payload + 1, "\x09\x08\x07", 3) == 0);
+
+  // Broken frame gets no response, the next one is handled
+  bytes_t broken = frame(CdcProtocol::Ping, {1});
+  broken.back() ^= 0xFF;
+  CHECK(request(concat(broken, frame(CdcProtocol::Ping)), &r));
+  CHECK(responded(r, CdcProtocol::Ping, CdcProtocol::Ok) && r.len == 1);
+
+  // Unknown type & wrong payload
+  CHECK(request(frame(0x7F), &r));
+  CHECK(responded(r, 0x7F, CdcProtocol::UnknownType));
+  CHECK(request(frame(CdcProtocol::State, {1, 2, 3}), &r));
+  CHECK(responded(r, CdcProtocol::State, CdcProtocol::BadPayload));
+  CHECK(request(frame(CdcProtocol::Batch, {1, 2, 3}), &r));
+  CHECK(responded(r, CdcProtocol::Batch, CdcProtocol::BadPayload));
+
+  // State is applied immediately
+  bytes_t state = step(1 << NSGamepad::Buttons::A, 0);
+  state.resize(CDC_REPORT_SIZE);
+  CHECK(request(frame(CdcProtocol::State, state), &r));
+  CHECK(responded(r, CdcProtocol::State, CdcProtocol::Ok));
+  CHECK(NSGamepad::getReport().buttons == 1 << NSGamepad::Buttons::A);
+
+  // Batch ends with the last step state
+  bytes_t batch = concat(step(1 << NSGamepad::Buttons::B, 1000), step(0, 1000));
+  CHECK(request(frame(CdcProtocol::Batch, batch), &r));
+  CHECK(responded(r, CdcProtocol::Batch, CdcProtocol::Ok));
+  CHECK(NSGamepad::getReport().buttons == 0);
+
+  // Script upload & run
+  CHECK(request(frame(CdcProtocol::ScriptBegin), &r));
+  CHECK(responded(r, CdcProtocol::ScriptBegin, CdcProtocol::Ok));
+  CHECK(request(frame(CdcProtocol::ScriptChunk, batch), &r));
+  CHECK(responded(r, CdcProtocol::ScriptChunk, CdcProtocol::Ok));
+  CHECK(request(frame(CdcProtocol::ScriptRun, {2, 0}), &r));
+  CHECK(responded(r, CdcProtocol::ScriptRun, CdcProtocol::Ok));
+
+  // Time sync: t0 is echoed, t1 <= t2 are device clock
+  uint8_t t0[8];
+  CdcProtocol::put_u64(t0, 1234567);
+  int64_t before = esp_timer_get_time();
+  CHECK(request(frame(CdcProtocol::TimeSync, bytes_t(t0, t0 + 8)), &r));
+  CHECK(responded(r, CdcProtocol::TimeSync, CdcProtocol::Ok) && r.len == 25);
+  uint64_t t1 = CdcProtocol::get_u64(r.payload + 9);
+  uint64_t t2 = CdcProtocol::get_u64(r.payload + 17);
+  CHECK(CdcProtocol::get_u64(r.payload + 1) == 1234567);
+  CHECK((int64_t)t1 >= before && t1 <= t2 && (int64_t)t2 <= esp_timer_get_time());
+}
+
+// Batch sent before gamepad is connected pauses & completes after connection
+// Returns false, if gamepad isn't connected
+static bool test_paused_start() {
+  static CdcProtocol::frame_t r;
+  send(frame(CdcProtocol::Batch, step(1 << NSGamepad::Buttons::X, 1000)));
+  vTaskDelay(pdMS_TO_TICKS(100));
+  CHECK(NSGamepad::jobProgress().paused);
+
+  StandIn::timers_free_run(true);
+  StandIn::usb_mount(true);
+  if (!HID::wait_gamepad_connected(1000)) return false;
+  CHECK(wait_response(&r));
+  CHECK(responded(r, CdcProtocol::Batch, CdcProtocol::Ok));
+  CHECK(NSGamepad::getReport().buttons == 1 << NSGamepad::Buttons::X);
+  return true;
+}
+
+}  // namespace CdcTest
+
+int main(int argc, char** argv) {
+  CdcTest::test_resync_garbage();
+  CdcTest::test_too_long();
+  CdcTest::test_bad_crc();
+  CdcTest::test_round_trip();
+
+  ESP_ERROR_CHECK(JsonPool::init());
+  ESP_ERROR_CHECK(Profiles::init());
+  ESP_ERROR_CHECK(NSGamepad::init());
+  ESP_ERROR_CHECK(Jobs::init());
+  ESP_ERROR_CHECK(HID::init());
+  ESP_ERROR_CHECK(HID::init_hid_task());
+  ESP_ERROR_CHECK(CdcControl::init());
+
+  if (!CdcTest::test_paused_start()) {
+    fprintf(stderr, "Gamepad isn't connected\n");
+    return EXIT_FAILURE;
+  }
+  CdcTest::test_handle_frame();
+
+  printf("%d checks failed\n", CdcTest::failed);
+  return CdcTest::failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,203 @@
+// Host test of per-request heap budget of REST routes
+// Every route registered by web server init on host is called through stand-in of HTTP server
+// with sample request, heap allocations of handler are counted as by firmware heap accounting
+// (see Metrics::route_measure). Exit code 1, if any route allocates more than
+// CONFIG_NSG_MEMINFO_ROUTE_BUDGET bytes or has no sample request
+// Routes of modules, which are off on host (see sdkconfig.h), aren't registered & aren't checked,
+// they are listed in output
+//
+// Usage: nsg_route_budget
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "hid.hpp"
+#include "jobs.hpp"
+#include "json_pool.hpp"
+#include "nsgamepad.hpp"
+#include "profiles.hpp"
+#include "standin.hpp"
+
+// glibc allocator, heap functions below count allocations & forward to it
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace WEB {
+
+// Web server init of web.cpp (not exported by web.hpp)
+esp_err_t web_server_init();
+
+}  // namespace WEB
+
+namespace RouteBudget {
+
+// Heap allocations of current thread (as MemInfo::task_allocs_t)
+typedef struct {
+  uint32_t allocs;
+  uint32_t bytes;
+} thread_allocs_t;
+
+static thread_local thread_allocs_t thread_allocs = {};
+
+static void count_alloc(size_t size) {
+  thread_allocs.allocs++;
+  thread_allocs.bytes += size;
+}
+
+// Sample request of route
+typedef struct {
+  httpd_method_t method;
+  const char* uri;
+  const char* body;
+} sample_t;
+
+// Sample requests (as sent by tools/client), the largest bodies accepted by routes
+static const sample_t samples[] = {
+    {HTTP_GET, "/api/ping", ""},
+    {HTTP_GET, "/api/time?t0=1700000000000000", ""},
+    {HTTP_POST, "/api/press", "{\"buttons\":[\"A\",\"B\",\"X\",\"Y\",\"L\",\"R\",\"ZL\",\"ZR\"]}"},
+    {HTTP_POST, "/api/release", "{\"buttons\":[\"A\",\"B\",\"X\",\"Y\",\"ZL\",\"ZR\",\"all\"]}"},
+    {HTTP_POST, "/api/click", "{\"buttons\":[\"A\",\"B\",\"Home\"],\"delay\":1}"},
+    {HTTP_GET, "/api/usb", ""},
+    {HTTP_POST, "/api/usb", "{\"interval_ms\":10}"},
+    {HTTP_GET, "/api/profile", ""},
+    {HTTP_POST, "/api/profile",
+     "{\"slot\":1,\"name\":\"Remap\",\"buttons\":{\"A\":\"B\",\"B\":\"A\",\"X\":\"Y\","
+     "\"Y\":\"X\"},\"dpad\":{\"U\":\"D\",\"D\":\"U\"},"
+     "\"axes\":{\"lx\":{\"deadzone\":10,\"curve\":150,\"invert\":false},"
+     "\"ly\":{\"deadzone\":10,\"curve\":150,\"invert\":true},"
+     "\"rx\":{\"deadzone\":10,\"curve\":100,\"invert\":false},"
+     "\"ry\":{\"deadzone\":10,\"curve\":100,\"invert\":false}},\"active\":0}"},
+    {HTTP_GET, "/api/jobs", ""},
+    {HTTP_POST, "/api/jobs/weight?client=192.168.100.200&weight=16", ""},
+    {HTTP_GET, "/api/events", ""},
+    {HTTP_GET, "/api/meminfo", ""},
+    {HTTP_GET, "/api/metrics", ""},
+};
+
+// Route of module, which is off on host
+typedef struct {
+  httpd_method_t method;
+  const char* uri;
+  const char* module;
+} uncovered_t;
+
+// Routes, which aren't registered on host
+static const uncovered_t uncovered[] = {
+    {HTTP_GET, "/api/scripts", "script store"},
+    {HTTP_POST, "/api/scripts", "script store"},
+    {HTTP_DELETE, "/api/scripts", "script store"},
+    {HTTP_POST, "/api/scripts/run", "script store"},
+    {HTTP_GET, "/api/ota", "OTA"},
+    {HTTP_POST, "/api/ota", "OTA"},
+    {HTTP_POST, "/api/ota/apply", "OTA"},
+    {HTTP_GET, "/api/stream", "input stream (off by default)"},
+};
+
+static const char* method_name(int method) {
+  return method == HTTP_GET ? "GET" : method == HTTP_POST ? "POST" : "DELETE";
+}
+
+// Find sample request of registered route
+static const sample_t* find_sample(const httpd_uri_t* uri) {
+  for (const sample_t& sample : samples) {
+    size_t len = strcspn(sample.uri, "?");
+    if (sample.method == uri->method && httpd_uri_match_wildcard(uri->uri, sample.uri, len)) {
+      return &sample;
+    }
+  }
+  return NULL;
+}
+
+// Call route with sample request, returns false if route is over budget or fails
+static bool check_route(const httpd_uri_t* uri) {
+  const sample_t* sample = find_sample(uri);
+  if (!sample) {
+    printf("FAIL %-6s %-16s no sample request\n", method_name(uri->method), uri->uri);
+    return false;
+  }
+
+  httpd_req_t req = {};
+  StandIn::request_t r;
+  StandIn::request_init(&req, &r, sample->uri, sample->body);
+  req.method = sample->method;
+
+  thread_allocs_t start = thread_allocs;
+  esp_err_t ret = StandIn::request_dispatch(&req);
+  uint32_t allocs = thread_allocs.allocs - start.allocs;
+  uint32_t bytes = thread_allocs.bytes - start.bytes;
+
+  bool ok = ret == ESP_OK && strcmp(r.status, "200 OK") == 0;
+  bool in_budget = bytes <= CONFIG_NSG_MEMINFO_ROUTE_BUDGET;
+  printf("%s %-6s %-16s %3lu allocs %6lu bytes%s\n", ok && in_budget ? "OK  " : "FAIL",
+         method_name(uri->method), uri->uri, (unsigned long)allocs, (unsigned long)bytes,
+         ok ? "" : " (request failed)");
+  return ok && in_budget;
+}
+
+}  // namespace RouteBudget
+
+// Heap functions of whole process, allocations are counted by calling thread
+extern "C" {
+
+void* malloc(size_t size) {
+  RouteBudget::count_alloc(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size) {
+  RouteBudget::count_alloc(num * size);
+  return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  RouteBudget::count_alloc(size);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+  __libc_free(ptr);
+}
+
+}  // extern "C"
+
+int main(int argc, char** argv) {
+  ESP_ERROR_CHECK(JsonPool::init());
+  ESP_ERROR_CHECK(Profiles::init());
+  ESP_ERROR_CHECK(NSGamepad::init());
+  ESP_ERROR_CHECK(Jobs::init());
+  ESP_ERROR_CHECK(HID::init());
+  ESP_ERROR_CHECK(HID::init_hid_task());
+  ESP_ERROR_CHECK(WEB::web_server_init());
+
+  // Jobs wait for gamepad connection, reports are delivered on every HID task tick
+  StandIn::timers_free_run(true);
+  StandIn::usb_mount(true);
+  if (!HID::wait_gamepad_connected(1000)) {
+    fprintf(stderr, "Gamepad isn't connected\n");
+    return EXIT_FAILURE;
+  }
+
+  printf("Route heap budget: %d bytes\n", CONFIG_NSG_MEMINFO_ROUTE_BUDGET);
+  size_t failed = 0;
+  for (size_t i = 0; i < StandIn::uri_handlers_num(); i++) {
+    if (!RouteBudget::check_route(StandIn::uri_handler(i))) failed++;
+  }
+
+  for (const RouteBudget::uncovered_t& route : RouteBudget::uncovered) {
+    printf("SKIP %-6s %-16s not built on host: %s\n", RouteBudget::method_name(route.method),
+           route.uri, route.module);
+  }
+
+  printf("%zu of %zu routes failed, %zu routes aren't covered\n", failed,
+         StandIn::uri_handlers_num(), std::size(RouteBudget::uncovered));
+  return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+#include "device/usbd.h"
+
+// Host stand-in for TinyUSB CDC device class
+#define TUD_CDC_DESC_LEN (8 + 9 + 5 + 5 + 4 + 5 + 7 + 9 + 7 + 7)
+
+// Interface association, CDC control interface with functional descriptors & notification
+// endpoint, CDC data interface with OUT & IN endpoints
+#define TUD_CDC_DESCRIPTOR(_itfnum, _stridx, _ep_notif, _ep_notif_size, _epout, _epin, _epsize) \
+  8, TUSB_DESC_INTERFACE_ASSOCIATION, _itfnum, 2, TUSB_CLASS_CDC, 2, 0, 0,                       \
+      9, TUSB_DESC_INTERFACE, _itfnum, 0, 1, TUSB_CLASS_CDC, 2, 0, _stridx,                     \
+      5, TUSB_DESC_CS_INTERFACE, 0x00, U16_TO_U8S_LE(0x0120),                                   \
+      5, TUSB_DESC_CS_INTERFACE, 0x01, 0, (uint8_t)((_itfnum) + 1),                             \
+      4, TUSB_DESC_CS_INTERFACE, 0x02, 2,                                                       \
+      5, TUSB_DESC_CS_INTERFACE, 0x06, _itfnum, (uint8_t)((_itfnum) + 1),                       \
+      7, TUSB_DESC_ENDPOINT, _ep_notif, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(_ep_notif_size), 16, \
+      9, TUSB_DESC_INTERFACE, (uint8_t)((_itfnum) + 1), 0, 2, TUSB_CLASS_CDC_DATA, 0, 0, 0,     \
+      7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,                 \
+      7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+// Host stand-in for TinyUSB HID report descriptor items
+typedef enum {
+  HID_REPORT_TYPE_INVALID = 0,
+  HID_REPORT_TYPE_INPUT,
+  HID_REPORT_TYPE_OUTPUT,
+  HID_REPORT_TYPE_FEATURE
+} hid_report_type_t;
+
+#define HID_DESC_TYPE_HID 0x21
+#define HID_DESC_TYPE_REPORT 0x22
+
+// Short item: tag, type & size prefix, then 0, 1 or 2 data bytes
+#define HID_REPORT_DATA_0(data)
+#define HID_REPORT_DATA_1(data) , (uint8_t)(data)
+#define HID_REPORT_DATA_2(data) , U16_TO_U8S_LE(data)
+#define HID_REPORT_ITEM(data, tag, type, size) \
+  (uint8_t)(((tag) << 4) | ((type) << 2) | (size)) HID_REPORT_DATA_##size(data)
+
+#define RI_TYPE_MAIN 0
+#define RI_TYPE_GLOBAL 1
+#define RI_TYPE_LOCAL 2
+
+#define HID_INPUT(x) HID_REPORT_ITEM(x, 8, RI_TYPE_MAIN, 1)
+#define HID_OUTPUT(x) HID_REPORT_ITEM(x, 9, RI_TYPE_MAIN, 1)
+#define HID_COLLECTION(x) HID_REPORT_ITEM(x, 10, RI_TYPE_MAIN, 1)
+#define HID_COLLECTION_END HID_REPORT_ITEM(x, 12, RI_TYPE_MAIN, 0)
+
+#define HID_USAGE_PAGE(x) HID_REPORT_ITEM(x, 0, RI_TYPE_GLOBAL, 1)
+#define HID_LOGICAL_MIN(x) HID_REPORT_ITEM(x, 1, RI_TYPE_GLOBAL, 1)
+#define HID_LOGICAL_MAX(x) HID_REPORT_ITEM(x, 2, RI_TYPE_GLOBAL, 1)
+#define HID_LOGICAL_MAX_N(x, n) HID_REPORT_ITEM(x, 2, RI_TYPE_GLOBAL, n)
+#define HID_PHYSICAL_MIN(x) HID_REPORT_ITEM(x, 3, RI_TYPE_GLOBAL, 1)
+#define HID_PHYSICAL_MAX(x) HID_REPORT_ITEM(x, 4, RI_TYPE_GLOBAL, 1)
+#define HID_PHYSICAL_MAX_N(x, n) HID_REPORT_ITEM(x, 4, RI_TYPE_GLOBAL, n)
+#define HID_UNIT(x) HID_REPORT_ITEM(x, 6, RI_TYPE_GLOBAL, 1)
+#define HID_REPORT_SIZE(x) HID_REPORT_ITEM(x, 7, RI_TYPE_GLOBAL, 1)
+#define HID_REPORT_COUNT(x) HID_REPORT_ITEM(x, 9, RI_TYPE_GLOBAL, 1)
+
+#define HID_USAGE(x) HID_REPORT_ITEM(x, 0, RI_TYPE_LOCAL, 1)
+#define HID_USAGE_MIN(x) HID_REPORT_ITEM(x, 1, RI_TYPE_LOCAL, 1)
+#define HID_USAGE_MAX(x) HID_REPORT_ITEM(x, 2, RI_TYPE_LOCAL, 1)
+
+#define HID_DATA (0 << 0)
+#define HID_CONSTANT (1 << 0)
+#define HID_ARRAY (0 << 1)
+#define HID_VARIABLE (1 << 1)
+#define HID_ABSOLUTE (0 << 2)
+#define HID_WRAP_NO (0 << 3)
+#define HID_LINEAR (0 << 4)
+#define HID_PREFERRED_STATE (0 << 5)
+#define HID_NO_NULL_POSITION (0 << 6)
+#define HID_NULL_STATE (1 << 6)
+
+#define HID_USAGE_PAGE_DESKTOP 0x01
+#define HID_USAGE_PAGE_BUTTON 0x09
+#define HID_USAGE_DESKTOP_GAMEPAD 0x05
+#define HID_USAGE_DESKTOP_X 0x30
+#define HID_USAGE_DESKTOP_Y 0x31
+#define HID_USAGE_DESKTOP_Z 0x32
+#define HID_USAGE_DESKTOP_RZ 0x35
+#define HID_USAGE_DESKTOP_HAT_SWITCH 0x39
+#define HID_COLLECTION_APPLICATION 0x01
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "class/hid/hid.h"
+#include "device/usbd.h"
+
+// Host stand-in for TinyUSB HID device class
+// IN transfer is completed immediately (host polls endpoint without delay)
+#define CFG_TUD_HID_EP_BUFSIZE 64
+
+#define TUD_HID_DESC_LEN (9 + 9 + 7)
+
+// HID interface, HID descriptor & IN endpoint
+#define TUD_HID_DESCRIPTOR(_itfnum, _stridx, _boot_protocol, _report_desc_len, _epin, _epsize,    \
+                           _ep_interval)                                                          \
+  9, TUSB_DESC_INTERFACE, _itfnum, 0, 1, TUSB_CLASS_HID, 0, _boot_protocol, _stridx, 9,           \
+      HID_DESC_TYPE_HID, U16_TO_U8S_LE(0x0111), 0, 1, HID_DESC_TYPE_REPORT,                       \
+      U16_TO_U8S_LE(_report_desc_len), 7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_INTERRUPT,         \
+      U16_TO_U8S_LE(_epsize), _ep_interval
+
+bool tud_hid_ready();
+bool tud_hid_report(uint8_t report_id, const void* report, uint16_t len);
+
+// Invoked by stack, implemented by application
+extern "C" void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report,
+                                           uint16_t len);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+// Host stand-in for TinyUSB device stack
+// Bus state is driven by benchmark (see standin.hpp)
+#define TUSB_DESC_DEVICE 0x01
+#define TUSB_DESC_CONFIGURATION 0x02
+#define TUSB_DESC_INTERFACE 0x04
+#define TUSB_DESC_ENDPOINT 0x05
+#define TUSB_DESC_INTERFACE_ASSOCIATION 0x0B
+#define TUSB_DESC_CS_INTERFACE 0x24
+#define TUSB_CLASS_UNSPECIFIED 0x00
+#define TUSB_CLASS_CDC 0x02
+#define TUSB_CLASS_HID 0x03
+#define TUSB_CLASS_CDC_DATA 0x0A
+#define TUSB_CLASS_MISC 0xEF
+#define TUSB_XFER_BULK 0x02
+#define TUSB_XFER_INTERRUPT 0x03
+#define MISC_SUBCLASS_COMMON 0x02
+#define MISC_PROTOCOL_IAD 0x01
+#define TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP 0x20
+
+#define U16_TO_U8S_LE(u16) (uint8_t)((u16) & 0xff), (uint8_t)(((u16) >> 8) & 0xff)
+
+#define TUD_CONFIG_DESC_LEN 9
+
+// Configuration descriptor
+#define TUD_CONFIG_DESCRIPTOR(config_num, _itfcount, _stridx, _total_len, _attribute, _power_ma)  \
+  9, TUSB_DESC_CONFIGURATION, U16_TO_U8S_LE(_total_len), _itfcount, config_num, _stridx,          \
+      (uint8_t)(0x80 | (_attribute)), (_power_ma) / 2
+
+bool tud_mounted();
+bool tud_connected();
+bool tud_suspended();
+bool tud_connect();
+bool tud_disconnect();
+bool tud_remote_wakeup();
@@ -0,0 +1,4 @@
+#pragma once
+
+// Code placement attributes are meaningless on host
+#define IRAM_ATTR
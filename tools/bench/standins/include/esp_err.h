@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "sdkconfig.h"
+
+// Host stand-in for ESP-IDF error codes
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_NOT_SUPPORTED 0x106
+#define ESP_ERR_TIMEOUT 0x107
+
+// Newlib extension, which firmware gets with <string.h> (glibc has it since 2.38)
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t len = strlen(src);
+  if (size) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+#endif
+
+// Get error name
+const char* esp_err_to_name(esp_err_t code);
+
+// Abort on error, as firmware does
+#define ESP_ERROR_CHECK(x)                                                                  \
+  do {                                                                                      \
+    esp_err_t err_rc_ = (x);                                                                \
+    if (err_rc_ != ESP_OK) {                                                                \
+      fprintf(stderr, "%s failed: %s (%s:%d)\n", #x, esp_err_to_name(err_rc_), __FILE__,    \
+              __LINE__);                                                                    \
+      abort();                                                                              \
+    }                                                                                       \
+  } while (0)
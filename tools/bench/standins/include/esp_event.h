@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Host stand-in for ESP-IDF event loop (events are never posted)
+typedef const char* esp_event_base_t;
+typedef void* esp_event_handler_instance_t;
+typedef void (*esp_event_handler_t)(void* arg, esp_event_base_t base, int32_t id, void* data);
+
+#define ESP_EVENT_ANY_ID -1
+
+extern esp_event_base_t const WIFI_EVENT;
+extern esp_event_base_t const IP_EVENT;
+
+esp_err_t esp_event_loop_create_default();
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id,
+                                              esp_event_handler_t handler, void* arg,
+                                              esp_event_handler_instance_t* instance);
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+// Host stand-in for ESP-IDF HTTP server
+// No sockets: requests are built by benchmark (see standin.hpp), responses are counted
+typedef void* httpd_handle_t;
+
+typedef enum http_method {
+  HTTP_DELETE = 0,
+  HTTP_GET = 1,
+  HTTP_POST = 3,
+  HTTP_PUT = 4
+} httpd_method_t;
+
+typedef enum {
+  HTTPD_500_INTERNAL_SERVER_ERROR = 0,
+  HTTPD_400_BAD_REQUEST = 3,
+  HTTPD_404_NOT_FOUND = 6,
+} httpd_err_code_t;
+
+#define HTTPD_MAX_URI_LEN 512
+#define HTTPD_RESP_USE_STRLEN -1
+
+typedef struct httpd_req {
+  httpd_handle_t handle;
+  int method;
+  const char uri[HTTPD_MAX_URI_LEN + 1];
+  size_t content_len;
+  void* aux;
+  void* user_ctx;
+  void* sess_ctx;
+  void (*free_ctx)(void* ctx);
+  bool ignore_sess_ctx_changes;
+} httpd_req_t;
+
+typedef struct httpd_uri {
+  const char* uri;
+  httpd_method_t method;
+  esp_err_t (*handler)(httpd_req_t* r);
+  void* user_ctx;
+} httpd_uri_t;
+
+typedef esp_err_t (*httpd_open_func_t)(httpd_handle_t hd, int sockfd);
+typedef void (*httpd_close_func_t)(httpd_handle_t hd, int sockfd);
+typedef bool (*httpd_uri_match_func_t)(const char* reference_uri, const char* uri_to_match,
+                                       size_t match_upto);
+
+typedef struct httpd_config {
+  unsigned task_priority;
+  size_t stack_size;
+  BaseType_t core_id;
+  uint16_t server_port;
+  uint16_t max_open_sockets;
+  uint16_t max_uri_handlers;
+  uint16_t backlog_conn;
+  bool lru_purge_enable;
+  uint16_t recv_wait_timeout;
+  uint16_t send_wait_timeout;
+  bool keep_alive_enable;
+  int keep_alive_idle;
+  int keep_alive_interval;
+  int keep_alive_count;
+  httpd_open_func_t open_fn;
+  httpd_close_func_t close_fn;
+  httpd_uri_match_func_t uri_match_fn;
+} httpd_config_t;
+
+#define HTTPD_DEFAULT_CONFIG()                                                                 \
+  {                                                                                            \
+    .task_priority = 5, .stack_size = 4096, .core_id = tskNO_AFFINITY, .server_port = 80,      \
+    .max_open_sockets = 7, .max_uri_handlers = 8, .backlog_conn = 5, .lru_purge_enable = false,\
+    .recv_wait_timeout = 5, .send_wait_timeout = 5, .keep_alive_enable = false,                \
+    .keep_alive_idle = 0, .keep_alive_interval = 0, .keep_alive_count = 0,                     \
+    .open_fn = NULL, .close_fn = NULL, .uri_match_fn = NULL                                    \
+  }
+
+esp_err_t httpd_start(httpd_handle_t* handle, const httpd_config_t* config);
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t* uri);
+bool httpd_uri_match_wildcard(const char* reference_uri, const char* uri_to_match,
+                              size_t match_upto);
+
+int httpd_req_recv(httpd_req_t* r, char* buf, size_t buf_len);
+esp_err_t httpd_req_get_url_query_str(httpd_req_t* r, char* buf, size_t buf_len);
+esp_err_t httpd_query_key_value(const char* qry, const char* key, char* val, size_t val_size);
+
+esp_err_t httpd_resp_set_type(httpd_req_t* r, const char* type);
+esp_err_t httpd_resp_set_status(httpd_req_t* r, const char* status);
+esp_err_t httpd_resp_set_hdr(httpd_req_t* r, const char* field, const char* value);
+esp_err_t httpd_resp_send(httpd_req_t* r, const char* buf, ssize_t buf_len);
+esp_err_t httpd_resp_sendstr(httpd_req_t* r, const char* str);
+esp_err_t httpd_resp_send_chunk(httpd_req_t* r, const char* buf, ssize_t buf_len);
+esp_err_t httpd_resp_sendstr_chunk(httpd_req_t* r, const char* str);
+esp_err_t httpd_resp_send_err(httpd_req_t* r, httpd_err_code_t error, const char* msg);
+
+// Requests have no socket, returns -1
+int httpd_req_to_sockfd(httpd_req_t* r);
+
+// Work runs at once in calling thread, there is no server task
+typedef void (*httpd_work_fn_t)(void* arg);
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void* arg);
+
+// There are no sockets: send fails, close is ignored
+int httpd_socket_send(httpd_handle_t hd, int sockfd, const char* buf, size_t buf_len, int flags);
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd);
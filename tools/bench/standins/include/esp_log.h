@@ -0,0 +1,11 @@
+#pragma once
+
+// Host stand-in for ESP-IDF logging
+// Logs are dropped (arguments are still evaluated), so hot paths are measured without console
+inline void esp_log_discard(const char*, const char*, ...) {}
+
+#define ESP_LOGE(tag, ...) esp_log_discard(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) esp_log_discard(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) esp_log_discard(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) esp_log_discard(tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) esp_log_discard(tag, __VA_ARGS__)
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Host stand-in for ESP-IDF network interface
+typedef struct esp_netif_obj esp_netif_t;
+
+typedef struct {
+  uint32_t addr;
+} esp_ip4_addr_t;
+
+typedef struct {
+  esp_ip4_addr_t ip;
+  esp_ip4_addr_t netmask;
+  esp_ip4_addr_t gw;
+} esp_netif_ip_info_t;
+
+typedef struct {
+  esp_netif_t* esp_netif;
+  esp_netif_ip_info_t ip_info;
+  bool ip_changed;
+} ip_event_got_ip_t;
+
+enum { IP_EVENT_STA_GOT_IP };
+
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(ipaddr)                                                                \
+  (int)((ipaddr)->addr & 0xff), (int)(((ipaddr)->addr >> 8) & 0xff),                  \
+      (int)(((ipaddr)->addr >> 16) & 0xff), (int)(((ipaddr)->addr >> 24) & 0xff)
+
+esp_err_t esp_netif_init();
+esp_netif_t* esp_netif_create_default_wifi_sta();
+esp_err_t esp_netif_dhcpc_start(esp_netif_t* netif);
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t* netif);
+esp_err_t esp_netif_set_ip_info(esp_netif_t* netif, const esp_netif_ip_info_t* ip_info);
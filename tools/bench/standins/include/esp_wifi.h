@@ -0,0 +1,22 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi_types_generic.h"
+
+// Host stand-in for ESP-IDF WiFi driver (station never connects)
+typedef struct {
+  int unused;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT() {0}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t* config);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf);
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+esp_err_t esp_wifi_start();
+esp_err_t esp_wifi_connect();
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap_info);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+// Host stand-in for ESP-IDF WiFi types
+typedef enum {
+  WIFI_AUTH_OPEN = 0,
+  WIFI_AUTH_WEP,
+  WIFI_AUTH_WPA_PSK,
+  WIFI_AUTH_WPA2_PSK,
+  WIFI_AUTH_WPA_WPA2_PSK,
+  WIFI_AUTH_WPA3_PSK = 6,
+  WIFI_AUTH_WPA2_WPA3_PSK,
+  WIFI_AUTH_WAPI_PSK,
+} wifi_auth_mode_t;
+
+typedef enum { WIFI_MODE_NULL = 0, WIFI_MODE_STA } wifi_mode_t;
+typedef enum { WIFI_IF_STA = 0 } wifi_interface_t;
+typedef enum { WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM } wifi_ps_type_t;
+typedef enum { WIFI_FAST_SCAN = 0, WIFI_ALL_CHANNEL_SCAN } wifi_scan_method_t;
+
+typedef struct {
+  int8_t rssi;
+  wifi_auth_mode_t authmode;
+} wifi_scan_threshold_t;
+
+typedef struct {
+  uint8_t ssid[32];
+  uint8_t password[64];
+  wifi_scan_method_t scan_method;
+  bool bssid_set;
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint16_t listen_interval;
+  wifi_scan_threshold_t threshold;
+} wifi_sta_config_t;
+
+typedef union {
+  wifi_sta_config_t sta;
+} wifi_config_t;
+
+typedef struct {
+  uint8_t bssid[6];
+  uint8_t ssid[33];
+  uint8_t primary;
+  int8_t rssi;
+} wifi_ap_record_t;
+
+enum { WIFI_EVENT_STA_START = 2, WIFI_EVENT_STA_CONNECTED = 4, WIFI_EVENT_STA_DISCONNECTED };
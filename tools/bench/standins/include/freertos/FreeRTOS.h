@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_attr.h"
+#include "sdkconfig.h"
+
+// Host stand-in for FreeRTOS (ESP-IDF SMP flavour)
+// Tasks are host threads, priorities & core affinity are ignored
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000U))
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+#define BIT0 0x00000001
+#define BIT1 0x00000002
+#define BIT2 0x00000004
+#define BIT3 0x00000008
+
+// Critical section (spinlock)
+typedef struct {
+  volatile bool locked;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {false}
+
+void vPortEnterCritical(portMUX_TYPE* mux);
+void vPortExitCritical(portMUX_TYPE* mux);
+
+#define taskENTER_CRITICAL(mux) vPortEnterCritical(mux)
+#define taskEXIT_CRITICAL(mux) vPortExitCritical(mux)
+#define portENTER_CRITICAL(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) vPortExitCritical(mux)
+
+// Buffers of static objects, objects themselves live on host heap
+typedef struct {
+  void* unused;
+} StaticTask_t;
+typedef struct {
+  void* unused;
+} StaticSemaphore_t;
+typedef struct {
+  void* unused;
+} StaticEventGroup_t;
+typedef struct {
+  void* unused;
+} StaticStreamBuffer_t;
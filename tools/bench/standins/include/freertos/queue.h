@@ -0,0 +1,12 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+// Host stand-in for FreeRTOS queues
+// Queue API isn't implemented: queues are used only by admission workers, which are off on host
+// (see sdkconfig.h)
+typedef struct QueueDefinition* QueueHandle_t;
+
+typedef struct {
+  void* unused;
+} StaticQueue_t;
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct StreamBufferDef_t* StreamBufferHandle_t;
+
+StreamBufferHandle_t xStreamBufferCreateStatic(size_t size, size_t trigger_level, uint8_t* storage,
+                                               StaticStreamBuffer_t* buf);
+size_t xStreamBufferSend(StreamBufferHandle_t stream, const void* data, size_t len,
+                         TickType_t ticks);
+size_t xStreamBufferReceive(StreamBufferHandle_t stream, void* data, size_t len, TickType_t ticks);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct tskTaskControlBlock* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_size,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core_id);
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char* name,
+                                           uint32_t stack_size, void* arg, UBaseType_t priority,
+                                           StackType_t* stack, StaticTask_t* tcb,
+                                           BaseType_t core_id);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+// Tasks aren't named on host, returns NULL
+TaskHandle_t xTaskGetHandle(const char* name);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* prev_wake_time, TickType_t ticks);
+TickType_t xTaskGetTickCount();
+
+// Direct to task notifications (counting)
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* need_yield);
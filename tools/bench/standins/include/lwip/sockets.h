@@ -0,0 +1,7 @@
+#pragma once
+
+// lwIP sockets follow BSD API, host sockets stand in for them
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
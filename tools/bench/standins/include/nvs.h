@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Host stand-in for NVS (in-memory, empty on start)
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* handle);
+void nvs_close(nvs_handle_t handle);
+esp_err_t nvs_commit(nvs_handle_t handle);
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* value, size_t* length);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length);
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char* key, uint8_t* value);
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char* key, uint8_t value);
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* value);
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value);
@@ -0,0 +1,71 @@
+#pragma once
+
+// Host benchmark configuration
+// Mirrors Kconfig defaults of firmware: HORI personality, heap allocation, no CDC & stream,
+// job scheduler & WiFi power save are enabled. Defaults, which are off on host:
+// - CONFIG_NSG_WEB_ADMISSION: stand-in HTTP server calls handlers in caller thread, it has no
+//   sockets & no async handover of requests to workers, so all lanes run as control lane
+// - CONFIG_NSG_SCRIPT_STORE & CONFIG_NSG_OTA: there are no flash partitions & app images on host
+#define CONFIG_FREERTOS_HZ 100
+
+#define CONFIG_NSG_WIFI_SSID "bench"
+#define CONFIG_NSG_WIFI_PASSWORD "bench"
+#define CONFIG_NSG_WIFI_AUTH_WPA2_PSK 1
+#define CONFIG_NSG_WIFI_MAXIMUM_RETRY 10
+
+#define CONFIG_NSG_HID_STRDESC_MANUFACTURER "HORI CO.,LTD."
+#define CONFIG_NSG_HID_STRDESC_PRODUCT "HORIPAD S"
+#define CONFIG_NSG_HID_STRDESC_SERIAL "000000"
+#define CONFIG_NSG_HID_STRDESC_HID "NSGamepad HID"
+#define CONFIG_NSG_HID_PERSONALITY_HORI 1
+#define CONFIG_NSG_HID_POOLING_TICKRATE_MS 10
+#define CONFIG_NSG_HID_STALL_POLLS 100
+#define CONFIG_NSG_HID_TASK_CORE_ID 1
+#define CONFIG_NSG_HID_TASK_PRIORITY 6
+#define CONFIG_NSG_HID_TASK_STACK_SIZE 2560
+
+#define CONFIG_NSG_WEB_TASK_CORE_ID 0
+#define CONFIG_NSG_WEB_TASK_PRIORITY 3
+#define CONFIG_NSG_WEB_TASK_STACK_SIZE 4096
+#define CONFIG_NSG_HTTPD_TASK_CORE_ID 0
+#define CONFIG_NSG_HTTPD_TASK_PRIORITY 5
+#define CONFIG_NSG_HTTPD_TASK_STACK_SIZE 4096
+#define CONFIG_NSG_INPUT_TASK_CORE_ID 1
+#define CONFIG_NSG_INPUT_TASK_PRIORITY 5
+#define CONFIG_NSG_INPUT_TASK_STACK_SIZE 3072
+#define CONFIG_NSG_HTTPD_MAX_SOCKETS 12
+#define CONFIG_NSG_HTTPD_BACKLOG 8
+#define CONFIG_NSG_HTTPD_LRU_PURGE 1
+#define CONFIG_NSG_HTTPD_RECV_TIMEOUT_S 5
+#define CONFIG_NSG_HTTPD_SEND_TIMEOUT_S 5
+#define CONFIG_NSG_HTTPD_KEEP_ALIVE 1
+#define CONFIG_NSG_HTTPD_KEEP_ALIVE_IDLE_S 10
+#define CONFIG_NSG_HTTPD_KEEP_ALIVE_INTERVAL_S 5
+#define CONFIG_NSG_HTTPD_KEEP_ALIVE_COUNT 3
+#define CONFIG_NSG_EVENTS_TASK_CORE_ID 0
+#define CONFIG_NSG_EVENTS_TASK_PRIORITY 2
+#define CONFIG_NSG_EVENTS_TASK_STACK_SIZE 3072
+#define CONFIG_NSG_WEB_EVENTS_MAX_CLIENTS 4
+#define CONFIG_NSG_WEB_EVENTS_RATE_HZ 10
+#define CONFIG_NSG_WEB_EVENTS_KEEPALIVE_S 15
+
+#define CONFIG_NSG_JOB_SCHEDULER 1
+#define CONFIG_NSG_JOB_CLIENTS 8
+#define CONFIG_NSG_JOB_QUANTUM_MS 100
+#define CONFIG_NSG_JOB_QUEUE_DEPTH 8
+#define CONFIG_NSG_JOB_RESUME_TIMEOUT_S 300
+
+#define CONFIG_NSG_WIFI_POWER_SAVE 1
+#define CONFIG_NSG_WIFI_POWER_SAVE_IDLE_S 60
+
+#define CONFIG_NSG_MEMINFO_ACCOUNTING 1
+#define CONFIG_NSG_MEMINFO_ROUTE_BUDGET 4096
+
+// CDC control channel is enabled by host test target (CONFIG_NSG_HID_CDC_CONTROL)
+#if CONFIG_NSG_HID_CDC_CONTROL
+#define CONFIG_NSG_HID_STRDESC_CDC "WEB USB NS Gamepad Control"
+#define CONFIG_NSG_CDC_SCRIPT_SIZE 4800
+#define CONFIG_NSG_CDC_TASK_CORE_ID 1
+#define CONFIG_NSG_CDC_TASK_PRIORITY 5
+#define CONFIG_NSG_CDC_TASK_STACK_SIZE 3072
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_http_server.h"
+
+// Control of host stand-ins, used by benchmarks & host tests
+namespace StandIn {
+
+// Set USB bus state, gamepad is connected by HID task on the next tick after mount
+void usb_mount(bool mounted);
+
+// Receive data over CDC-ACM, driver's receive callback is called in caller's thread
+void cdc_receive(const uint8_t* data, size_t len);
+
+// Take data written by device to CDC-ACM, returns number of bytes
+size_t cdc_transmitted(uint8_t* data, size_t size);
+
+// Run periodic timers back-to-back, ignoring their period
+// HID task ticks as fast as it can, so report submission isn't bound by polling interval
+void timers_free_run(bool enabled);
+
+// Fake HTTP request state
+typedef struct {
+  const char* body;    // Request body
+  size_t received;     // Body bytes read by handler
+  const char* status;  // Response status ("200 OK" or error)
+  size_t sent;         // Response body bytes
+} request_t;
+
+// Setup request with URI & body, handler reads body with httpd_req_recv()
+void request_init(httpd_req_t* req, request_t* r, const char* uri, const char* body);
+
+// URI handlers registered with httpd_register_uri_handler()
+size_t uri_handlers_num();
+const httpd_uri_t* uri_handler(size_t index);
+
+// Call registered handler matching request URI (without query) & method
+// Returns ESP_ERR_NOT_FOUND, if there is no such route
+esp_err_t request_dispatch(httpd_req_t* req);
+
+}  // namespace StandIn
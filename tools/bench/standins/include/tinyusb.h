@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "device/usbd.h"
+#include "esp_err.h"
+
+// Host stand-in for esp_tinyusb driver
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+typedef struct __attribute__((packed)) {
+  uint8_t bLength;
+  uint8_t bDescriptorType;
+  uint16_t bcdUSB;
+  uint8_t bDeviceClass;
+  uint8_t bDeviceSubClass;
+  uint8_t bDeviceProtocol;
+  uint8_t bMaxPacketSize0;
+  uint16_t idVendor;
+  uint16_t idProduct;
+  uint16_t bcdDevice;
+  uint8_t iManufacturer;
+  uint8_t iProduct;
+  uint8_t iSerialNumber;
+  uint8_t bNumConfigurations;
+} tusb_desc_device_t;
+
+typedef struct {
+  const tusb_desc_device_t* device_descriptor;
+  const char** string_descriptor;
+  int string_descriptor_count;
+  bool external_phy;
+  const uint8_t* configuration_descriptor;
+} tinyusb_config_t;
+
+esp_err_t tinyusb_driver_install(const tinyusb_config_t* config);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "tinyusb.h"
+
+// Host stand-in for esp_tinyusb CDC-ACM driver
+// Received data is injected & written data is collected by host tests (see standin.hpp)
+typedef enum { TINYUSB_USBDEV_0 } tinyusb_usbdev_t;
+typedef enum { TINYUSB_CDC_ACM_0 = 0, TINYUSB_CDC_ACM_1, TINYUSB_CDC_ACM_MAX } tinyusb_cdcacm_itf_t;
+
+typedef enum { CDC_EVENT_RX } cdcacm_event_type_t;
+
+typedef struct {
+  cdcacm_event_type_t type;
+} cdcacm_event_t;
+
+typedef void (*tusb_cdcacm_callback_t)(int itf, cdcacm_event_t* event);
+
+typedef struct {
+  tinyusb_usbdev_t usb_dev;
+  tinyusb_cdcacm_itf_t cdc_port;
+  size_t rx_unread_buf_sz;
+  tusb_cdcacm_callback_t callback_rx;
+  tusb_cdcacm_callback_t callback_rx_wanted_char;
+  tusb_cdcacm_callback_t callback_line_state_changed;
+  tusb_cdcacm_callback_t callback_line_coding_changed;
+} tinyusb_config_cdcacm_t;
+
+esp_err_t tusb_cdc_acm_init(const tinyusb_config_cdcacm_t* cfg);
+esp_err_t tinyusb_cdcacm_read(tinyusb_cdcacm_itf_t itf, uint8_t* out_buf, size_t out_buf_sz,
+                              size_t* rx_data_size);
+size_t tinyusb_cdcacm_write_queue(tinyusb_cdcacm_itf_t itf, const uint8_t* in_buf, size_t in_size);
+esp_err_t tinyusb_cdcacm_write_flush(tinyusb_cdcacm_itf_t itf, uint32_t timeout_ticks);
@@ -0,0 +1,47 @@
+// Firmware modules, which are not under benchmark
+// Web server init paths reference them, benchmarks don't reach these calls
+#include "boot.hpp"
+#include "ota.hpp"
+#include "script_store.hpp"
+#include "stream.hpp"
+
+namespace Boot {
+
+void mark(Phase phase) {}
+
+}  // namespace Boot
+
+namespace Ota {
+
+esp_err_t api_register(httpd_handle_t server) {
+  return ESP_OK;
+}
+
+void update() {}
+
+}  // namespace Ota
+
+namespace ScriptStore {
+
+// Flash script store isn't available on host
+esp_err_t save(const char* name, const uint8_t* data, size_t len, uint8_t* id) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t run(uint8_t id, uint16_t repeat, const char* client) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t api_register(httpd_handle_t server) {
+  return ESP_OK;
+}
+
+}  // namespace ScriptStore
+
+namespace Stream {
+
+esp_err_t init(httpd_handle_t server) {
+  return ESP_OK;
+}
+
+}  // namespace Stream
@@ -0,0 +1,118 @@
+#include "esp_timer.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include "standin.hpp"
+
+// Timer state, guarded by timers mutex
+struct esp_timer {
+  esp_timer_create_args_t args;
+  bool armed;
+  int64_t alarm_us;
+  uint64_t period_us;  // 0 - one-shot
+};
+
+// Timers are used by detached threads until process exit, so they are never destroyed
+static std::mutex& timers_mtx = *new std::mutex();
+static std::condition_variable& timers_cv = *new std::condition_variable();
+static std::list<esp_timer*>& timers = *new std::list<esp_timer*>();
+static std::atomic<bool> free_run = false;
+
+static const auto start_time = std::chrono::steady_clock::now();
+
+int64_t esp_timer_get_time() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                               start_time)
+      .count();
+}
+
+// Dispatcher thread, callbacks are called without lock
+static void timer_task() {
+  std::unique_lock<std::mutex> lock(timers_mtx);
+  while (true) {
+    int64_t now = esp_timer_get_time();
+    esp_timer* next = NULL;
+    for (esp_timer* t : timers) {
+      if (!t->armed) continue;
+      if (free_run && t->period_us && t->alarm_us > now) t->alarm_us = now;
+      if (!next || t->alarm_us < next->alarm_us) next = t;
+    }
+
+    if (!next) {
+      timers_cv.wait(lock);
+      continue;
+    }
+    if (next->alarm_us > now) {
+      timers_cv.wait_for(lock, std::chrono::microseconds(next->alarm_us - now));
+      continue;
+    }
+
+    // Periodic timer skips missed periods (skip_unhandled_events)
+    if (next->period_us) {
+      next->alarm_us += next->period_us;
+      if (next->alarm_us < now) next->alarm_us = now + next->period_us;
+    } else {
+      next->armed = false;
+    }
+    esp_timer_create_args_t args = next->args;
+    lock.unlock();
+    args.callback(args.arg);
+    if (free_run) std::this_thread::yield();
+    lock.lock();
+  }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle) {
+  static std::once_flag dispatcher_once;
+  std::call_once(dispatcher_once, [] { std::thread(timer_task).detach(); });
+
+  esp_timer* timer = new esp_timer();
+  timer->args = *args;
+  std::lock_guard<std::mutex> lock(timers_mtx);
+  timers.push_back(timer);
+  *handle = timer;
+  return ESP_OK;
+}
+
+// Arm timer
+static esp_err_t timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us) {
+  {
+    std::lock_guard<std::mutex> lock(timers_mtx);
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+    timer->armed = true;
+    timer->alarm_us = esp_timer_get_time() + timeout_us;
+    timer->period_us = period_us;
+  }
+  timers_cv.notify_one();
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+  return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+  return timer_start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  std::lock_guard<std::mutex> lock(timers_mtx);
+  if (!timer->armed) return ESP_ERR_INVALID_STATE;
+  timer->armed = false;
+  return ESP_OK;
+}
+
+namespace StandIn {
+
+// Run periodic timers back-to-back
+void timers_free_run(bool enabled) {
+  free_run = enabled;
+  timers_cv.notify_one();
+}
+
+}  // namespace StandIn
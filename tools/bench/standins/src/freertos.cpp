@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "freertos/task.h"
+
+// Task: host thread with notification counter
+// Threads, which are not created as tasks (e.g. main), get control block on first use
+struct tskTaskControlBlock {
+  std::mutex mtx;
+  std::condition_variable cv;
+  uint32_t notify = 0;
+};
+
+// Semaphore: counter with maximum of 1 (binary semaphore & mutex without priority inheritance)
+// Recursive mutex also tracks owner thread & its nesting depth
+struct QueueDefinition {
+  std::mutex mtx;
+  std::condition_variable cv;
+  uint32_t count;
+  std::thread::id owner;
+  uint32_t depth = 0;
+};
+
+// Event group
+struct EventGroupDef_t {
+  std::mutex mtx;
+  std::condition_variable cv;
+  EventBits_t bits = 0;
+};
+
+// Stream buffer: bytes queue of fixed capacity, receiver waits for trigger level
+struct StreamBufferDef_t {
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::deque<uint8_t> bytes;
+  size_t size;
+  size_t trigger_level;
+};
+
+static thread_local TaskHandle_t current_task = NULL;
+
+// Convert ticks to wait deadline, false - wait forever
+static bool tick_deadline(TickType_t ticks, std::chrono::steady_clock::time_point* deadline) {
+  if (ticks == portMAX_DELAY) return false;
+  *deadline = std::chrono::steady_clock::now() +
+              std::chrono::microseconds((uint64_t)ticks * 1000000 / configTICK_RATE_HZ);
+  return true;
+}
+
+// Wait for predicate until ticks timeout
+template <typename Predicate>
+static bool wait_ticks(std::condition_variable& cv, std::unique_lock<std::mutex>& lock,
+                       TickType_t ticks, Predicate pred) {
+  std::chrono::steady_clock::time_point deadline;
+  if (!tick_deadline(ticks, &deadline)) {
+    cv.wait(lock, pred);
+    return true;
+  }
+  return cv.wait_until(lock, deadline, pred);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_size,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core_id) {
+  TaskHandle_t task = new tskTaskControlBlock();
+  if (handle) *handle = task;
+  std::thread([fn, arg, task] {
+    current_task = task;
+    fn(arg);
+  }).detach();
+  return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char* name,
+                                           uint32_t stack_size, void* arg, UBaseType_t priority,
+                                           StackType_t* stack, StaticTask_t* tcb,
+                                           BaseType_t core_id) {
+  TaskHandle_t task = NULL;
+  xTaskCreatePinnedToCore(fn, name, stack_size, arg, priority, &task, core_id);
+  return task;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  if (!current_task) current_task = new tskTaskControlBlock();
+  return current_task;
+}
+
+TaskHandle_t xTaskGetHandle(const char* name) {
+  return NULL;
+}
+
+// Host threads have no fixed stacks
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  return 0;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::microseconds((uint64_t)ticks * 1000000 /
+                                                        configTICK_RATE_HZ));
+}
+
+void vTaskDelayUntil(TickType_t* prev_wake_time, TickType_t ticks) {
+  *prev_wake_time += ticks;
+  TickType_t now = xTaskGetTickCount();
+  if ((int32_t)(*prev_wake_time - now) > 0) vTaskDelay(*prev_wake_time - now);
+}
+
+TickType_t xTaskGetTickCount() {
+  auto since_start = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::microseconds>(since_start).count() *
+         configTICK_RATE_HZ / 1000000;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->mtx);
+  if (!wait_ticks(task->cv, lock, ticks, [task] { return task->notify > 0; })) return 0;
+  uint32_t value = task->notify;
+  task->notify = clear_on_exit ? 0 : value - 1;
+  return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  {
+    std::lock_guard<std::mutex> lock(task->mtx);
+    task->notify++;
+  }
+  task->cv.notify_one();
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* need_yield) {
+  xTaskNotifyGive(task);
+  if (need_yield) *need_yield = pdFALSE;
+}
+
+void vPortEnterCritical(portMUX_TYPE* mux) {
+  while (__atomic_exchange_n(&mux->locked, true, __ATOMIC_ACQUIRE)) {
+  }
+}
+
+void vPortExitCritical(portMUX_TYPE* mux) {
+  __atomic_store_n(&mux->locked, false, __ATOMIC_RELEASE);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  SemaphoreHandle_t sem = new QueueDefinition();
+  sem->count = 0;
+  return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  SemaphoreHandle_t sem = new QueueDefinition();
+  sem->count = 1;
+  return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* buf) {
+  return xSemaphoreCreateBinary();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* buf) {
+  return xSemaphoreCreateMutex();
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t* buf) {
+  return xSemaphoreCreateMutex();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(sem->mtx);
+  if (!wait_ticks(sem->cv, lock, ticks, [sem] { return sem->count > 0; })) return pdFALSE;
+  sem->count--;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  {
+    std::lock_guard<std::mutex> lock(sem->mtx);
+    if (sem->count > 0) return pdFALSE;
+    sem->count = 1;
+  }
+  sem->cv.notify_one();
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(sem->mtx);
+  if (sem->depth > 0 && sem->owner == std::this_thread::get_id()) {
+    sem->depth++;
+    return pdTRUE;
+  }
+  if (!wait_ticks(sem->cv, lock, ticks, [sem] { return sem->count > 0; })) return pdFALSE;
+  sem->count--;
+  sem->owner = std::this_thread::get_id();
+  sem->depth = 1;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem) {
+  {
+    std::lock_guard<std::mutex> lock(sem->mtx);
+    if (sem->depth == 0 || sem->owner != std::this_thread::get_id()) return pdFALSE;
+    if (--sem->depth > 0) return pdTRUE;
+    sem->owner = std::thread::id();
+    sem->count = 1;
+  }
+  sem->cv.notify_one();
+  return pdTRUE;
+}
+
+EventGroupHandle_t xEventGroupCreate() {
+  return new EventGroupDef_t();
+}
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t* buf) {
+  return xEventGroupCreate();
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+  EventBits_t value;
+  {
+    std::lock_guard<std::mutex> lock(group->mtx);
+    group->bits |= bits;
+    value = group->bits;
+  }
+  group->cv.notify_all();
+  return value;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+  std::lock_guard<std::mutex> lock(group->mtx);
+  EventBits_t value = group->bits;
+  group->bits &= ~bits;
+  return value;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+  std::lock_guard<std::mutex> lock(group->mtx);
+  return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                BaseType_t clear_on_exit, BaseType_t wait_for_all,
+                                TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(group->mtx);
+  auto satisfied = [&] {
+    return wait_for_all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+  };
+  bool ok = wait_ticks(group->cv, lock, ticks, satisfied);
+  EventBits_t value = group->bits;
+  if (ok && clear_on_exit) group->bits &= ~bits;
+  return value;
+}
+
+StreamBufferHandle_t xStreamBufferCreateStatic(size_t size, size_t trigger_level, uint8_t* storage,
+                                               StaticStreamBuffer_t* buf) {
+  StreamBufferHandle_t stream = new StreamBufferDef_t();
+  stream->size = size;
+  stream->trigger_level = trigger_level;
+  return stream;
+}
+
+size_t xStreamBufferSend(StreamBufferHandle_t stream, const void* data, size_t len,
+                         TickType_t ticks) {
+  size_t sent;
+  {
+    std::unique_lock<std::mutex> lock(stream->mtx);
+    wait_ticks(stream->cv, lock, ticks, [&] { return stream->size - stream->bytes.size() >= len; });
+    sent = std::min(len, stream->size - stream->bytes.size());
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    stream->bytes.insert(stream->bytes.end(), bytes, bytes + sent);
+  }
+  stream->cv.notify_all();
+  return sent;
+}
+
+size_t xStreamBufferReceive(StreamBufferHandle_t stream, void* data, size_t len, TickType_t ticks) {
+  size_t received;
+  {
+    std::unique_lock<std::mutex> lock(stream->mtx);
+    wait_ticks(stream->cv, lock, ticks,
+               [stream] { return stream->bytes.size() >= stream->trigger_level; });
+    received = std::min(len, stream->bytes.size());
+    std::copy_n(stream->bytes.begin(), received, static_cast<uint8_t*>(data));
+    stream->bytes.erase(stream->bytes.begin(), stream->bytes.begin() + received);
+  }
+  stream->cv.notify_all();
+  return received;
+}
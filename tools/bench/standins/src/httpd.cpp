@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "esp_http_server.h"
+#include "standin.hpp"
+
+namespace StandIn {
+
+// Setup request with URI & body
+void request_init(httpd_req_t* req, request_t* r, const char* uri, const char* body) {
+  r->body = body;
+  r->received = 0;
+  r->status = "200 OK";
+  r->sent = 0;
+  memset((void*)req, 0, sizeof(*req));
+  strncpy(const_cast<char*>(req->uri), uri, HTTPD_MAX_URI_LEN);
+  req->method = HTTP_POST;
+  req->content_len = strlen(body);
+  req->aux = r;
+}
+
+// Registered URI handlers
+static std::vector<httpd_uri_t> uri_handlers;
+
+size_t uri_handlers_num() {
+  return uri_handlers.size();
+}
+
+const httpd_uri_t* uri_handler(size_t index) {
+  return index < uri_handlers.size() ? &uri_handlers[index] : NULL;
+}
+
+// Call registered handler matching request URI & method
+esp_err_t request_dispatch(httpd_req_t* req) {
+  size_t uri_len = strcspn(req->uri, "?");
+  for (const httpd_uri_t& uri : uri_handlers) {
+    if (uri.method == req->method && httpd_uri_match_wildcard(uri.uri, req->uri, uri_len)) {
+      req->user_ctx = uri.user_ctx;
+      return uri.handler(req);
+    }
+  }
+  return ESP_ERR_NOT_FOUND;
+}
+
+}  // namespace StandIn
+
+// Request state of stand-in request
+static StandIn::request_t* request(httpd_req_t* r) {
+  return static_cast<StandIn::request_t*>(r->aux);
+}
+
+esp_err_t httpd_start(httpd_handle_t* handle, const httpd_config_t* config) {
+  static int server;
+  *handle = &server;
+  return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t* uri) {
+  StandIn::uri_handlers.push_back(*uri);
+  return ESP_OK;
+}
+
+bool httpd_uri_match_wildcard(const char* reference_uri, const char* uri_to_match,
+                              size_t match_upto) {
+  size_t len = strlen(reference_uri);
+  if (len > 0 && reference_uri[len - 1] == '*') {
+    return match_upto >= len - 1 && strncmp(reference_uri, uri_to_match, len - 1) == 0;
+  }
+  return len == match_upto && strncmp(reference_uri, uri_to_match, len) == 0;
+}
+
+// Body is returned in chunks of socket receive size
+int httpd_req_recv(httpd_req_t* r, char* buf, size_t buf_len) {
+  StandIn::request_t* state = request(r);
+  size_t left = r->content_len - state->received;
+  size_t len = std::min<size_t>({left, buf_len, 1460});
+  if (len == 0) return 0;
+  memcpy(buf, state->body + state->received, len);
+  state->received += len;
+  return len;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t* r, char* buf, size_t buf_len) {
+  const char* query = strchr(r->uri, '?');
+  if (!query) return ESP_ERR_NOT_FOUND;
+  strncpy(buf, query + 1, buf_len - 1);
+  buf[buf_len - 1] = '\0';
+  return strlen(query + 1) < buf_len ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+esp_err_t httpd_query_key_value(const char* qry, const char* key, char* val, size_t val_size) {
+  size_t key_len = strlen(key);
+  const char* p = qry;
+  while (p) {
+    if (strncmp(p, key, key_len) == 0 && p[key_len] == '=') {
+      const char* value = p + key_len + 1;
+      size_t len = strcspn(value, "&");
+      if (len >= val_size) return ESP_ERR_INVALID_SIZE;
+      memcpy(val, value, len);
+      val[len] = '\0';
+      return ESP_OK;
+    }
+    p = strchr(p, '&');
+    if (p) p++;
+  }
+  return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t* r, const char* type) {
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t* r, const char* status) {
+  request(r)->status = status;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t* r, const char* field, const char* value) {
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t* r, const char* buf, ssize_t buf_len) {
+  request(r)->sent += buf_len == HTTPD_RESP_USE_STRLEN ? strlen(buf) : buf_len;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_sendstr(httpd_req_t* r, const char* str) {
+  return httpd_resp_send(r, str, HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t* r, const char* buf, ssize_t buf_len) {
+  if (buf) return httpd_resp_send(r, buf, buf_len);
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_sendstr_chunk(httpd_req_t* r, const char* str) {
+  return httpd_resp_send_chunk(r, str, str ? HTTPD_RESP_USE_STRLEN : 0);
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t* r, httpd_err_code_t error, const char* msg) {
+  request(r)->status = error == HTTPD_400_BAD_REQUEST   ? "400 Bad Request"
+                       : error == HTTPD_404_NOT_FOUND ? "404 Not Found"
+                                                      : "500 Internal Server Error";
+  return httpd_resp_sendstr(r, msg);
+}
+
+int httpd_req_to_sockfd(httpd_req_t* r) {
+  return -1;
+}
+
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void* arg) {
+  work(arg);
+  return ESP_OK;
+}
+
+int httpd_socket_send(httpd_handle_t hd, int sockfd, const char* buf, size_t buf_len, int flags) {
+  return -1;
+}
+
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd) {
+  return ESP_OK;
+}
@@ -0,0 +1,89 @@
+#include "nvs.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Namespaces & keys, values are stored as blobs
+static std::mutex nvs_mtx;
+static std::vector<std::string> namespaces;
+static std::map<std::string, std::vector<uint8_t>> values;
+
+// Full key of value: namespace index & key
+static std::string full_key(nvs_handle_t handle, const char* key) {
+  return std::to_string(handle) + "/" + key;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* handle) {
+  std::lock_guard<std::mutex> lock(nvs_mtx);
+  for (size_t i = 0; i < namespaces.size(); i++) {
+    if (namespaces[i] == name) {
+      *handle = i + 1;
+      return ESP_OK;
+    }
+  }
+  // Namespace is created on first write, as on device
+  if (mode == NVS_READONLY) return ESP_ERR_NVS_NOT_FOUND;
+  namespaces.push_back(name);
+  *handle = namespaces.size();
+  return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+  return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+  std::lock_guard<std::mutex> lock(nvs_mtx);
+  return values.erase(full_key(handle, key)) ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* value, size_t* length) {
+  std::lock_guard<std::mutex> lock(nvs_mtx);
+  auto it = values.find(full_key(handle, key));
+  if (it == values.end()) return ESP_ERR_NVS_NOT_FOUND;
+  if (!value) {
+    *length = it->second.size();
+    return ESP_OK;
+  }
+  if (*length < it->second.size()) return ESP_ERR_INVALID_SIZE;
+  memcpy(value, it->second.data(), it->second.size());
+  *length = it->second.size();
+  return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+  std::lock_guard<std::mutex> lock(nvs_mtx);
+  const uint8_t* data = static_cast<const uint8_t*>(value);
+  values[full_key(handle, key)].assign(data, data + length);
+  return ESP_OK;
+}
+
+// Read integer value of exact size
+template <typename T>
+static esp_err_t get_int(nvs_handle_t handle, const char* key, T* value) {
+  size_t length = sizeof(T);
+  esp_err_t err = nvs_get_blob(handle, key, value, &length);
+  if (err == ESP_OK && length != sizeof(T)) return ESP_ERR_NVS_NOT_FOUND;
+  return err;
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char* key, uint8_t* value) {
+  return get_int(handle, key, value);
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char* key, uint8_t value) {
+  return nvs_set_blob(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* value) {
+  return get_int(handle, key, value);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value) {
+  return nvs_set_blob(handle, key, &value, sizeof(value));
+}
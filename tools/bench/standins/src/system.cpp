@@ -0,0 +1,174 @@
+#include <cstring>
+
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_heap_caps.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+
+const char* esp_err_to_name(esp_err_t code) {
+  switch (code) {
+    case ESP_OK:
+      return "ESP_OK";
+    case ESP_FAIL:
+      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+      return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+      return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+      return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+      return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+      return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+      return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+      return "ESP_ERR_TIMEOUT";
+    default:
+      return "UNKNOWN ERROR";
+  }
+}
+
+// Console
+esp_err_t esp_console_cmd_register(const esp_console_cmd_t* cmd) {
+  return ESP_OK;
+}
+
+// Argument tables are allocated once per firmware static table & never freed
+template <typename T>
+static T* arg_new() {
+  return new T();
+}
+
+struct arg_lit* arg_lit0(const char* shortopts, const char* longopts, const char* glossary) {
+  return arg_new<struct arg_lit>();
+}
+
+struct arg_int* arg_int0(const char* shortopts, const char* longopts, const char* datatype,
+                         const char* glossary) {
+  return arg_new<struct arg_int>();
+}
+
+struct arg_int* arg_int1(const char* shortopts, const char* longopts, const char* datatype,
+                         const char* glossary) {
+  return arg_new<struct arg_int>();
+}
+
+struct arg_str* arg_str0(const char* shortopts, const char* longopts, const char* datatype,
+                         const char* glossary) {
+  return arg_new<struct arg_str>();
+}
+
+struct arg_str* arg_str1(const char* shortopts, const char* longopts, const char* datatype,
+                         const char* glossary) {
+  return arg_new<struct arg_str>();
+}
+
+struct arg_str* arg_strn(const char* shortopts, const char* longopts, const char* datatype,
+                         int mincount, int maxcount, const char* glossary) {
+  return arg_new<struct arg_str>();
+}
+
+struct arg_end* arg_end(int maxcount) {
+  return arg_new<struct arg_end>();
+}
+
+int arg_parse(int argc, char** argv, void** argtable) {
+  return 1;
+}
+
+void arg_print_errors(FILE* fp, struct arg_end* end, const char* progname) {}
+
+// Heap
+size_t heap_caps_get_free_size(uint32_t caps) {
+  return 0;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+  return 0;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+  return 0;
+}
+
+// Static data sections bounds of firmware linker script, sections aren't measured on host
+extern "C" {
+int _data_start, _data_end, _bss_start, _bss_end;
+}
+
+// Event loop
+esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t const IP_EVENT = "IP_EVENT";
+
+esp_err_t esp_event_loop_create_default() {
+  return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id,
+                                              esp_event_handler_t handler, void* arg,
+                                              esp_event_handler_instance_t* instance) {
+  return ESP_OK;
+}
+
+// Network interface
+esp_err_t esp_netif_init() {
+  return ESP_OK;
+}
+
+esp_netif_t* esp_netif_create_default_wifi_sta() {
+  return NULL;
+}
+
+esp_err_t esp_netif_dhcpc_start(esp_netif_t* netif) {
+  return ESP_OK;
+}
+
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t* netif) {
+  return ESP_OK;
+}
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t* netif, const esp_netif_ip_info_t* ip_info) {
+  return ESP_OK;
+}
+
+// WiFi
+static wifi_config_t wifi_config = {};
+
+esp_err_t esp_wifi_init(const wifi_init_config_t* config) {
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf) {
+  *conf = wifi_config;
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf) {
+  wifi_config = *conf;
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type) {
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_start() {
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect() {
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap_info) {
+  return ESP_ERR_INVALID_STATE;
+}
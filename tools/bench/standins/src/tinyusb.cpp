@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "class/hid/hid_device.h"
+#include "device/usbd.h"
+#include "standin.hpp"
+#include "tinyusb.h"
+#include "tusb_cdc_acm.h"
+
+// Bus state, set by benchmark
+static std::atomic<bool> mounted = false;
+
+// CDC-ACM data: received (not read by driver user yet) & written by device
+static std::mutex cdc_mtx;
+static std::vector<uint8_t> cdc_rx;
+static std::vector<uint8_t> cdc_tx;
+static tusb_cdcacm_callback_t cdc_rx_callback = NULL;
+
+namespace StandIn {
+
+// Set USB bus state
+void usb_mount(bool state) {
+  mounted = state;
+}
+
+// Receive data from host, driver callback is called in caller's thread (as TinyUSB task)
+void cdc_receive(const uint8_t* data, size_t len) {
+  {
+    std::lock_guard<std::mutex> lock(cdc_mtx);
+    cdc_rx.insert(cdc_rx.end(), data, data + len);
+  }
+  cdcacm_event_t event = {.type = CDC_EVENT_RX};
+  if (cdc_rx_callback) cdc_rx_callback(TINYUSB_CDC_ACM_0, &event);
+}
+
+// Take data written by device
+size_t cdc_transmitted(uint8_t* data, size_t size) {
+  std::lock_guard<std::mutex> lock(cdc_mtx);
+  size_t len = std::min(size, cdc_tx.size());
+  std::copy_n(cdc_tx.begin(), len, data);
+  cdc_tx.erase(cdc_tx.begin(), cdc_tx.begin() + len);
+  return len;
+}
+
+}  // namespace StandIn
+
+esp_err_t tinyusb_driver_install(const tinyusb_config_t* config) {
+  return ESP_OK;
+}
+
+bool tud_mounted() {
+  return mounted;
+}
+
+bool tud_connected() {
+  return mounted;
+}
+
+bool tud_suspended() {
+  return false;
+}
+
+bool tud_connect() {
+  return true;
+}
+
+bool tud_disconnect() {
+  return true;
+}
+
+bool tud_remote_wakeup() {
+  return false;
+}
+
+bool tud_hid_ready() {
+  return mounted;
+}
+
+// Host polls endpoint immediately, transfer is completed before return
+bool tud_hid_report(uint8_t report_id, const void* report, uint16_t len) {
+  if (!mounted) return false;
+  tud_hid_report_complete_cb(0, static_cast<const uint8_t*>(report), len);
+  return true;
+}
+
+esp_err_t tusb_cdc_acm_init(const tinyusb_config_cdcacm_t* cfg) {
+  cdc_rx_callback = cfg->callback_rx;
+  return ESP_OK;
+}
+
+esp_err_t tinyusb_cdcacm_read(tinyusb_cdcacm_itf_t itf, uint8_t* out_buf, size_t out_buf_sz,
+                              size_t* rx_data_size) {
+  std::lock_guard<std::mutex> lock(cdc_mtx);
+  *rx_data_size = std::min(out_buf_sz, cdc_rx.size());
+  std::copy_n(cdc_rx.begin(), *rx_data_size, out_buf);
+  cdc_rx.erase(cdc_rx.begin(), cdc_rx.begin() + *rx_data_size);
+  return ESP_OK;
+}
+
+size_t tinyusb_cdcacm_write_queue(tinyusb_cdcacm_itf_t itf, const uint8_t* in_buf, size_t in_size) {
+  std::lock_guard<std::mutex> lock(cdc_mtx);
+  cdc_tx.insert(cdc_tx.end(), in_buf, in_buf + in_size);
+  return in_size;
+}
+
+esp_err_t tinyusb_cdcacm_write_flush(tinyusb_cdcacm_itf_t itf, uint32_t timeout_ticks) {
+  return ESP_OK;
+}
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file nsg_cli.cpp
+ * @brief Command line example for the nsg_client library
+ *
+ * Opens a device and runs commands in order, then prints used channel and latency statistics.
+ *
+ * Usage:
+ *   nsg_cli http://192.168.1.50 click:A press:ZL,ZR sleep:200 release:all
+ *   nsg_cli serial:/dev/ttyACM0 dpad:up axis:L,0,128 sleep:500 axis:L,128,128
+ *
+ * Commands:
+ *   press:<buttons>  release:<buttons|all>  click:<buttons>[,<ms>]  dpad:<direction|center>
+ *   axis:<L|R>,<x>,<y>  sleep:<ms>  batch  flush
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nsg_client.hpp"
+
+namespace {
+
+void usage(const char* argv0) {
+  fprintf(stderr,
+          "Usage: %s <url> [command...]\n"
+          "  url: http://host[:port] or serial:<tty path>\n"
+          "Commands:\n"
+          "  press:<buttons>        Press buttons, e.g. press:A,B\n"
+          "  release:<buttons|all>  Release buttons\n"
+          "  click:<buttons>[,<ms>] Click buttons one by one, e.g. click:A,100\n"
+          "  dpad:<direction>       up, upright, right, downright, down, downleft, left, upleft,\n"
+          "                         center (binary channels only)\n"
+          "  axis:<L|R>,<x>,<y>     Stick axis, 0..255 (binary channels only)\n"
+          "  sleep:<ms>             Wait\n"
+          "  batch / flush          Pipeline following commands until flush\n",
+          argv0);
+}
+
+// Split string by comma
+std::vector<std::string> split(const std::string& s) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  while (start <= s.size()) {
+    size_t end = s.find(',', start);
+    if (end == std::string::npos) end = s.size();
+    parts.push_back(s.substr(start, end - start));
+    start = end + 1;
+  }
+  return parts;
+}
+
+bool parse_button(const std::string& name, nsg::Button& button) {
+  for (int i = 0; i <= (int)nsg::Button::Capture; i++) {
+    if (strcasecmp(name.c_str(), nsg::buttonName((nsg::Button)i)) == 0) {
+      button = (nsg::Button)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parse_dpad(const std::string& name, nsg::Dpad& dpad) {
+  static const char* names[] = {"up",   "upright",  "right", "downright",
+                                "down", "downleft", "left",  "upleft"};
+  for (int i = 0; i < 8; i++) {
+    if (strcasecmp(name.c_str(), names[i]) == 0) {
+      dpad = (nsg::Dpad)i;
+      return true;
+    }
+  }
+  if (strcasecmp(name.c_str(), "center") == 0) {
+    dpad = nsg::Dpad::Centered;
+    return true;
+  }
+  return false;
+}
+
+// Run buttons command, buttons are applied one by one (initializer_list API)
+template <typename F>
+bool for_buttons(const std::vector<std::string>& names, F f) {
+  for (const std::string& name : names) {
+    nsg::Button button;
+    if (!parse_button(name, button)) {
+      fprintf(stderr, "Unknown button: \"%s\"\n", name.c_str());
+      return false;
+    }
+    if (!f(button)) return false;
+  }
+  return true;
+}
+
+bool run(nsg::Client& client, const std::string& command) {
+  size_t colon = command.find(':');
+  std::string name = command.substr(0, colon);
+  std::vector<std::string> args =
+      colon == std::string::npos ? std::vector<std::string>() : split(command.substr(colon + 1));
+
+  if (name == "batch") {
+    client.beginBatch();
+    return true;
+  }
+  if (name == "flush") return client.flush();
+  if (args.empty()) {
+    fprintf(stderr, "Missed arguments: \"%s\"\n", command.c_str());
+    return false;
+  }
+
+  if (name == "press") {
+    return for_buttons(args, [&](nsg::Button b) { return client.press({b}); });
+  }
+  if (name == "release") {
+    if (args[0] == "all") return client.releaseAll();
+    return for_buttons(args, [&](nsg::Button b) { return client.release({b}); });
+  }
+  if (name == "click") {
+    // Last numeric argument is hold time
+    uint16_t delay = 100;
+    if (args.size() > 1 && isdigit((unsigned char)args.back()[0])) {
+      delay = atoi(args.back().c_str());
+      args.pop_back();
+    }
+    return for_buttons(args, [&](nsg::Button b) { return client.click({b}, delay); });
+  }
+  if (name == "dpad") {
+    nsg::Dpad dpad;
+    if (!parse_dpad(args[0], dpad)) {
+      fprintf(stderr, "Unknown dpad direction: \"%s\"\n", args[0].c_str());
+      return false;
+    }
+    return client.dpad(dpad);
+  }
+  if (name == "axis" && args.size() == 3) {
+    uint8_t x = atoi(args[1].c_str());
+    uint8_t y = atoi(args[2].c_str());
+    if (args[0] == "L") return client.leftAxis(x, y);
+    if (args[0] == "R") return client.rightAxis(x, y);
+  }
+  if (name == "sleep") {
+    std::this_thread::sleep_for(std::chrono::milliseconds(atoi(args[0].c_str())));
+    return true;
+  }
+
+  fprintf(stderr, "Unknown command: \"%s\"\n", command.c_str());
+  return false;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2 || strcmp(argv[1], "--help") == 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  std::string error;
+  std::unique_ptr<nsg::Client> client = nsg::Client::open(argv[1], &error);
+  if (!client) {
+    fprintf(stderr, "Failed to open %s: %s\n", argv[1], error.c_str());
+    return 1;
+  }
+
+  int result = 0;
+  for (int i = 2; i < argc; i++) {
+    if (!run(*client, argv[i])) {
+      if (!client->error().empty()) fprintf(stderr, "%s: %s\n", argv[i], client->error().c_str());
+      result = 1;
+      break;
+    }
+  }
+
+  nsg::LatencyStats s = client->stats();
+  printf("Channel: %s\n", client->channel());
+  printf("Requests: %llu, errors: %llu, reconnects: %llu\n", (unsigned long long)s.requests,
+         (unsigned long long)s.errors, (unsigned long long)s.reconnects);
+  printf("Latency: avg %.2f ms, p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", s.avg_ms, s.p50_ms,
+         s.p99_ms, s.max_ms);
+  return result;
+}
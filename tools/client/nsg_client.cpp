@@ -0,0 +1,647 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file nsg_client.cpp
+ * @brief Host-side C++ client for the gamepad device (see nsg_client.hpp)
+ */
+
+#include "nsg_client.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "cdc_protocol.hpp"
+
+namespace nsg {
+
+namespace {
+
+// Response timeout
+constexpr int kTimeoutMs = 5000;
+// Maximum steps in one CDC batch frame
+constexpr size_t kCdcBatchSteps = CDC_FRAME_PAYLOAD_MAX / CDC_STEP_SIZE;
+// Input stream frame & maximum frames in one WebSocket message (see main/stream.cpp)
+constexpr size_t kStreamFrameSize = 12;
+constexpr size_t kStreamMessageFrames = 32;
+
+const char* kButtonNames[] = {"Y",  "B",     "A",    "X",      "L",      "R",    "ZL",
+                              "ZR", "Minus", "Plus", "LStick", "RStick", "Home", "Capture"};
+
+int64_t now_us() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Serialize report (HID report layout, 8 bytes)
+void put_report(uint8_t* out, const Report& r) {
+  out[0] = r.buttons & 0xFF;
+  out[1] = r.buttons >> 8;
+  out[2] = r.dpad;
+  out[3] = r.lx;
+  out[4] = r.ly;
+  out[5] = r.rx;
+  out[6] = r.ry;
+  out[7] = 0;
+}
+
+void put_u32(uint8_t* out, uint32_t v) {
+  for (int i = 0; i < 4; i++, v >>= 8) out[i] = v & 0xFF;
+}
+
+// Wait for fd readiness, returns false on timeout
+bool wait_fd(int fd, short events, int timeout_ms) {
+  pollfd pfd = {fd, events, 0};
+  return poll(&pfd, 1, timeout_ms) > 0;
+}
+
+// Write all bytes (socket or tty)
+bool write_all(int fd, const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  while (len > 0) {
+    // No SIGPIPE, when device closes connection
+    ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if (n < 0 && errno == ENOTSOCK) n = write(fd, p, len);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+      if (!wait_fd(fd, POLLOUT, kTimeoutMs)) return false;
+      continue;
+    }
+    if (n <= 0) return false;
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+// Try to parse complete HTTP response at the buffer start
+// Returns response length (0 - not complete yet, -1 - malformed), fills status
+ssize_t parse_response(const std::string& in, int& status) {
+  size_t hdr_end = in.find("\r\n\r\n");
+  if (hdr_end == std::string::npos) return 0;
+  if (in.compare(0, 5, "HTTP/") != 0) return -1;
+  status = atoi(in.c_str() + in.find(' ') + 1);
+
+  std::string headers = in.substr(0, hdr_end);
+  std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+  size_t body_start = hdr_end + 4;
+
+  size_t cl = headers.find("content-length:");
+  if (cl != std::string::npos) {
+    size_t len = strtoul(headers.c_str() + cl + 15, nullptr, 10);
+    return in.size() >= body_start + len ? (ssize_t)(body_start + len) : 0;
+  }
+  if (headers.find("transfer-encoding: chunked") != std::string::npos) {
+    size_t end = in.find("\r\n0\r\n\r\n", body_start - 2);
+    return end != std::string::npos ? (ssize_t)(end + 7) : 0;
+  }
+  return (ssize_t)body_start;
+}
+
+}  // namespace
+
+// Button name, as used by REST API
+const char* buttonName(Button button) {
+  size_t b = (size_t)button;
+  return b < sizeof(kButtonNames) / sizeof(kButtonNames[0]) ? kButtonNames[b] : "";
+}
+
+struct Client::Impl {
+  enum Channel { Rest, WebSocket, Cdc } channel = Rest;
+
+  // HTTP
+  std::string host;
+  sockaddr_in addr = {};
+  int http_fd = -1;
+  int ws_fd = -1;
+  std::string http_out;  // Queued requests (batch)
+  size_t http_queued = 0;
+
+  // WebSocket stream
+  std::string ws_frames;      // Queued stream frames (batch)
+  uint32_t ws_next_ts = 0;    // Next free timestamp of client timeline
+  bool ws_ts_valid = false;
+  std::mt19937 rng{std::random_device{}()};
+
+  // CDC
+  int tty_fd = -1;
+  CdcProtocol::Parser parser;
+  std::string cdc_out;  // Queued frames (batch)
+  std::vector<uint8_t> cdc_types;
+
+  bool batching = false;
+
+  // Statistics
+  std::vector<int64_t> latencies_us;
+  uint64_t unacked = 0;  // Sent stream messages (not acknowledged by device)
+  uint64_t errors = 0;
+  uint64_t reconnects = 0;
+  bool connected_once = false;
+
+  ~Impl() {
+    if (http_fd >= 0) close(http_fd);
+    if (ws_fd >= 0) close(ws_fd);
+    if (tty_fd >= 0) close(tty_fd);
+  }
+
+  // Open TCP connection to device
+  int connect_tcp() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    timeval tv = {kTimeoutMs / 1000, (kTimeoutMs % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (connect(fd, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  std::string make_request(const char* method, const char* path, const std::string& body) {
+    std::string req = std::string(method) + " " + path + " HTTP/1.1\r\n";
+    req += "Host: " + host + "\r\n";
+    req += "Connection: keep-alive\r\n";
+    if (!body.empty()) req += "Content-Type: application/json\r\n";
+    req += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    req += body;
+    return req;
+  }
+
+  // Send queued requests back to back & read responses in order
+  // Connection is reopened once, if it was closed by device before any response
+  bool http_exchange(const std::string& out, size_t responses, std::string& error) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+      if (http_fd < 0) {
+        http_fd = connect_tcp();
+        if (http_fd < 0) {
+          error = "Connection failed";
+          return false;
+        }
+        if (connected_once) reconnects++;
+        connected_once = true;
+      }
+
+      int64_t sent_us = now_us();
+      bool ok = write_all(http_fd, out.data(), out.size());
+      std::string in;
+      size_t received = 0;
+      bool failed = false;
+      while (ok && received < responses) {
+        int status = 0;
+        ssize_t len = parse_response(in, status);
+        if (len < 0) {
+          failed = true;
+          break;
+        }
+        if (len > 0) {
+          latencies_us.push_back(now_us() - sent_us);
+          if (status != 200) {
+            errors++;
+            failed = true;
+            size_t body = in.find("\r\n\r\n") + 4;
+            error = "HTTP " + std::to_string(status) + ": " + in.substr(body, len - body);
+          }
+          in.erase(0, len);
+          received++;
+          continue;
+        }
+        char buf[2048];
+        ssize_t n = recv(http_fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        in.append(buf, n);
+      }
+      if (received == responses) return !failed;
+
+      // Broken connection
+      close(http_fd);
+      http_fd = -1;
+      if (received > 0 || failed) {
+        errors += responses - received;
+        error = "Connection broken";
+        return false;
+      }
+    }
+    errors += responses;
+    error = "Connection broken";
+    return false;
+  }
+
+  // Upgrade separate connection to input stream WebSocket
+  bool ws_open() {
+    int fd = connect_tcp();
+    if (fd < 0) return false;
+
+    uint8_t key[16];
+    for (uint8_t& k : key) k = rng() & 0xFF;
+    static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string key64;
+    for (size_t i = 0; i < sizeof(key); i += 3) {
+      uint32_t v = key[i] << 16 | (i + 1 < sizeof(key) ? key[i + 1] << 8 : 0) |
+                   (i + 2 < sizeof(key) ? key[i + 2] : 0);
+      key64 += b64[v >> 18 & 63];
+      key64 += b64[v >> 12 & 63];
+      key64 += i + 1 < sizeof(key) ? b64[v >> 6 & 63] : '=';
+      key64 += i + 2 < sizeof(key) ? b64[v & 63] : '=';
+    }
+    std::string headers = "Upgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Version: 13\r\n"
+                          "Sec-WebSocket-Key: " +
+                          key64 + "\r\n";
+    std::string req = "GET /api/stream HTTP/1.1\r\nHost: " + host + "\r\n" + headers + "\r\n";
+    std::string in;
+    if (write_all(fd, req.data(), req.size())) {
+      char buf[1024];
+      while (in.find("\r\n\r\n") == std::string::npos) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        in.append(buf, n);
+      }
+    }
+    if (in.compare(0, 12, "HTTP/1.1 101") != 0) {
+      // Input stream is disabled in firmware
+      close(fd);
+      return false;
+    }
+    ws_fd = fd;
+    return true;
+  }
+
+  // Queue stream frame at client timestamp
+  void ws_queue(const Report& r, uint32_t ts) {
+    uint8_t frame[12];
+    put_u32(frame, ts);
+    put_report(frame + 4, r);
+    ws_frames.append((const char*)frame, sizeof(frame));
+  }
+
+  // Send queued frames as binary messages (masked, as required for client)
+  bool ws_send(std::string& error) {
+    const size_t max_len = kStreamFrameSize * kStreamMessageFrames;
+    for (size_t off = 0; off < ws_frames.size(); off += max_len) {
+      size_t len = std::min(max_len, ws_frames.size() - off);
+      std::string msg;
+      msg += (char)0x82;  // FIN | binary
+      if (len < 126) {
+        msg += (char)(0x80 | len);
+      } else {
+        msg += (char)(0x80 | 126);
+        msg += (char)(len >> 8);
+        msg += (char)(len & 0xFF);
+      }
+      uint8_t mask[4];
+      for (uint8_t& m : mask) m = rng() & 0xFF;
+      msg.append((const char*)mask, sizeof(mask));
+      for (size_t i = 0; i < len; i++) msg += (char)(ws_frames[off + i] ^ mask[i % 4]);
+
+      if (!write_all(ws_fd, msg.data(), msg.size())) {
+        errors++;
+        error = "Input stream connection broken";
+        close(ws_fd);
+        ws_fd = -1;
+        ws_frames.clear();
+        // Stream is gone, fall back to REST API
+        channel = Rest;
+        return false;
+      }
+      // Stream frames aren't acknowledged, so latency isn't measured
+      unacked++;
+    }
+    ws_frames.clear();
+    return true;
+  }
+
+  // Open CDC control channel tty
+  bool cdc_open(const std::string& path) {
+    tty_fd = ::open(path.c_str(), O_RDWR | O_NOCTTY);
+    if (tty_fd < 0) return false;
+    termios tio = {};
+    if (tcgetattr(tty_fd, &tio) == 0) {
+      cfmakeraw(&tio);
+      tcsetattr(tty_fd, TCSANOW, &tio);
+    }
+    tcflush(tty_fd, TCIOFLUSH);
+    return true;
+  }
+
+  // Queue CDC frame
+  void cdc_queue(uint8_t type, const uint8_t* payload, uint16_t len) {
+    uint8_t frame[CDC_FRAME_PAYLOAD_MAX + CDC_FRAME_OVERHEAD];
+    size_t n = CdcProtocol::encode(type, payload, len, frame, sizeof(frame));
+    cdc_out.append((const char*)frame, n);
+    cdc_types.push_back(type);
+  }
+
+  // Send queued frames & wait for responses in order
+  bool cdc_exchange(std::string& error) {
+    if (cdc_types.empty()) return true;
+    int64_t sent_us = now_us();
+    size_t expected = cdc_types.size();
+    bool ok = write_all(tty_fd, cdc_out.data(), cdc_out.size());
+    cdc_out.clear();
+    size_t received = 0;
+    bool failed = false;
+
+    while (ok && received < expected) {
+      // Batch responses arrive after all steps are played, wait accordingly
+      if (!wait_fd(tty_fd, POLLIN, kTimeoutMs + 60000)) break;
+      uint8_t buf[256];
+      ssize_t n = read(tty_fd, buf, sizeof(buf));
+      if (n <= 0) break;
+      for (ssize_t i = 0; i < n; i++) {
+        if (!parser.feed(buf[i])) continue;
+        const CdcProtocol::frame_t& f = parser.frame();
+        if (!(f.type & CdcProtocol::Response)) continue;
+        latencies_us.push_back(now_us() - sent_us);
+        if (f.len < 1 || f.payload[0] != CdcProtocol::Ok) {
+          errors++;
+          failed = true;
+          error = "CDC status " + std::to_string(f.len ? f.payload[0] : -1);
+        }
+        received++;
+      }
+    }
+    cdc_types.clear();
+    if (received < expected) {
+      errors += expected - received;
+      error = "CDC response timeout";
+      return false;
+    }
+    return !failed;
+  }
+};
+
+Client::Client(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+Client::~Client() = default;
+
+// Open client by URL
+std::unique_ptr<Client> Client::open(const std::string& url, std::string* error) {
+  auto fail = [&](const std::string& msg) {
+    if (error) *error = msg;
+    return nullptr;
+  };
+  auto impl = std::make_unique<Impl>();
+
+  if (url.compare(0, 7, "serial:") == 0) {
+    std::string path = url.substr(7);
+    if (!impl->cdc_open(path)) return fail("Failed to open " + path + ": " + strerror(errno));
+    impl->channel = Impl::Cdc;
+    // Check that CDC control channel answers
+    std::string err;
+    impl->cdc_queue(CdcProtocol::Ping, nullptr, 0);
+    if (!impl->cdc_exchange(err)) return fail("CDC control channel doesn't answer: " + err);
+    return std::unique_ptr<Client>(new Client(std::move(impl)));
+  }
+
+  if (url.compare(0, 7, "http://") != 0) return fail("Unsupported URL: " + url);
+  std::string hostport = url.substr(7);
+  hostport = hostport.substr(0, hostport.find('/'));
+  size_t colon = hostport.find(':');
+  impl->host = hostport.substr(0, colon);
+  int port = colon == std::string::npos ? 80 : atoi(hostport.c_str() + colon + 1);
+
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* res = nullptr;
+  if (getaddrinfo(impl->host.c_str(), nullptr, &hints, &res) != 0 || !res) {
+    return fail("Failed to resolve " + impl->host);
+  }
+  impl->addr = *(sockaddr_in*)res->ai_addr;
+  impl->addr.sin_port = htons(port);
+  freeaddrinfo(res);
+
+  // Check REST API, connection stays opened
+  std::string err;
+  if (!impl->http_exchange(impl->make_request("GET", "/api/ping", ""), 1, err)) {
+    return fail("Device doesn't answer: " + err);
+  }
+  // Prefer binary input stream, if firmware offers it
+  if (impl->ws_open()) impl->channel = Impl::WebSocket;
+  return std::unique_ptr<Client>(new Client(std::move(impl)));
+}
+
+// Used channel
+const char* Client::channel() const {
+  switch (impl_->channel) {
+    case Impl::WebSocket:
+      return "websocket";
+    case Impl::Cdc:
+      return "cdc";
+    default:
+      return "rest";
+  }
+}
+
+// Latency statistics
+LatencyStats Client::stats() const {
+  LatencyStats s;
+  std::vector<int64_t> sorted = impl_->latencies_us;
+  std::sort(sorted.begin(), sorted.end());
+  s.requests = sorted.size() + impl_->unacked;
+  s.errors = impl_->errors;
+  s.reconnects = impl_->reconnects;
+  if (sorted.empty()) return s;
+
+  int64_t sum = 0;
+  for (int64_t l : sorted) sum += l;
+  auto pct = [&](double p) {
+    size_t idx = std::min(sorted.size() - 1, (size_t)std::ceil(p / 100.0 * sorted.size()) - 1);
+    return sorted[idx] / 1000.0;
+  };
+  s.avg_ms = sum / 1000.0 / sorted.size();
+  s.p50_ms = pct(50);
+  s.p99_ms = pct(99);
+  s.max_ms = sorted.back() / 1000.0;
+  return s;
+}
+
+// Send whole state over binary channel
+bool Client::send_state(const Report& report) {
+  return send_steps({report}, {0});
+}
+
+// Send states sequence over binary channel, each state is held for its time
+bool Client::send_steps(const std::vector<Report>& states, const std::vector<uint32_t>& hold_us) {
+  Impl& d = *impl_;
+  if (d.channel == Impl::Rest) {
+    error_ = "Dpad & axes need binary channel (input stream or CDC)";
+    return false;
+  }
+  report_ = states.back();
+
+  if (d.channel == Impl::WebSocket) {
+    // Frames are scheduled on client timeline, device jitter buffer keeps their spacing
+    uint32_t now = (uint32_t)now_us();
+    uint32_t ts = d.ws_ts_valid && (int32_t)(d.ws_next_ts - now) > 0 ? d.ws_next_ts : now;
+    for (size_t i = 0; i < states.size(); i++) {
+      d.ws_queue(states[i], ts);
+      ts += std::max<uint32_t>(hold_us[i], 1);
+    }
+    d.ws_next_ts = ts;
+    d.ws_ts_valid = true;
+    return d.batching || d.ws_send(error_);
+  }
+
+  // CDC: single state or batch of steps
+  if (states.size() == 1 && hold_us[0] == 0) {
+    uint8_t payload[CDC_REPORT_SIZE];
+    put_report(payload, states[0]);
+    d.cdc_queue(CdcProtocol::State, payload, sizeof(payload));
+  } else {
+    for (size_t off = 0; off < states.size(); off += kCdcBatchSteps) {
+      size_t num = std::min(kCdcBatchSteps, states.size() - off);
+      uint8_t payload[kCdcBatchSteps * CDC_STEP_SIZE];
+      for (size_t i = 0; i < num; i++) {
+        put_report(payload + i * CDC_STEP_SIZE, states[off + i]);
+        put_u32(payload + i * CDC_STEP_SIZE + CDC_REPORT_SIZE, hold_us[off + i]);
+      }
+      d.cdc_queue(CdcProtocol::Batch, payload, num * CDC_STEP_SIZE);
+    }
+  }
+  return d.batching || d.cdc_exchange(error_);
+}
+
+// Send REST request (or queue it while batching)
+bool Client::rest(const char* path, const std::string& body) {
+  Impl& d = *impl_;
+  d.http_out += d.make_request("POST", path, body);
+  d.http_queued++;
+  if (d.batching) return true;
+  return flush();
+}
+
+// JSON array of button names
+static std::string buttons_json(std::initializer_list<Button> buttons) {
+  std::string json = "{\"buttons\":[";
+  for (Button b : buttons) {
+    if (json.back() != '[') json += ",";
+    json += std::string("\"") + buttonName(b) + "\"";
+  }
+  return json + "]";
+}
+
+// Press buttons
+bool Client::press(std::initializer_list<Button> buttons) {
+  Report r = report_;
+  for (Button b : buttons) r.buttons |= 1 << (int)b;
+  if (impl_->channel != Impl::Rest) return send_state(r);
+  report_ = r;
+  return rest("/api/press", buttons_json(buttons) + "}");
+}
+
+// Release buttons
+bool Client::release(std::initializer_list<Button> buttons) {
+  Report r = report_;
+  for (Button b : buttons) r.buttons &= ~(1 << (int)b);
+  if (impl_->channel != Impl::Rest) return send_state(r);
+  report_ = r;
+  return rest("/api/release", buttons_json(buttons) + "}");
+}
+
+// Release all buttons
+bool Client::releaseAll() {
+  Report r = report_;
+  r.buttons = 0;
+  if (impl_->channel != Impl::Rest) return send_state(r);
+  report_ = r;
+  return rest("/api/release", "{\"buttons\":[\"all\"]}");
+}
+
+// Press and release buttons one by one
+bool Client::click(std::initializer_list<Button> buttons, uint16_t delay) {
+  if (impl_->channel == Impl::Rest) {
+    return rest("/api/click", buttons_json(buttons) + ",\"delay\":" + std::to_string(delay) + "}");
+  }
+  std::vector<Report> states;
+  std::vector<uint32_t> holds;
+  Report r = report_;
+  for (Button b : buttons) {
+    r.buttons |= 1 << (int)b;
+    states.push_back(r);
+    holds.push_back(delay * 1000);
+    r.buttons &= ~(1 << (int)b);
+    states.push_back(r);
+    holds.push_back(delay * 1000);
+  }
+  return send_steps(states, holds);
+}
+
+// Set dpad direction
+bool Client::dpad(Dpad direction) {
+  Report r = report_;
+  r.dpad = (uint8_t)direction;
+  return send_state(r);
+}
+
+// Press and release dpad
+bool Client::dpadClick(Dpad direction, uint16_t delay) {
+  Report pressed = report_;
+  pressed.dpad = (uint8_t)direction;
+  Report released = report_;
+  released.dpad = (uint8_t)Dpad::Centered;
+  return send_steps({pressed, released}, {delay * 1000u, delay * 1000u});
+}
+
+// Left stick axis
+bool Client::leftAxis(uint8_t x, uint8_t y) {
+  Report r = report_;
+  r.lx = x;
+  r.ly = y;
+  return send_state(r);
+}
+
+// Right stick axis
+bool Client::rightAxis(uint8_t x, uint8_t y) {
+  Report r = report_;
+  r.rx = x;
+  r.ry = y;
+  return send_state(r);
+}
+
+// Set whole gamepad state
+bool Client::setReport(const Report& report) {
+  return send_state(report);
+}
+
+// Start batching
+void Client::beginBatch() {
+  impl_->batching = true;
+}
+
+// Send queued requests
+bool Client::flush() {
+  Impl& d = *impl_;
+  d.batching = false;
+  switch (d.channel) {
+    case Impl::WebSocket:
+      return d.ws_send(error_);
+    case Impl::Cdc:
+      return d.cdc_exchange(error_);
+    default: {
+      if (d.http_queued == 0) return true;
+      std::string out;
+      out.swap(d.http_out);
+      size_t num = d.http_queued;
+      d.http_queued = 0;
+      return d.http_exchange(out, num, error_);
+    }
+  }
+}
+
+}  // namespace nsg
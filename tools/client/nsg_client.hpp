@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file nsg_client.hpp
+ * @brief Host-side C++ client for the gamepad device
+ *
+ * Typed API mirroring NSGamepad (press/release/click/dpad/axes) over one of the channels the
+ * firmware offers:
+ *   - "http://host[:port]"   REST API over one keep-alive connection. Requests may be pipelined
+ *                            (beginBatch()/flush()). If the firmware has the input stream
+ *                            (/api/stream), state changes are sent as binary WebSocket frames.
+ *   - "serial:/dev/ttyACM0"  CDC control channel (binary frames, see main/cdc_protocol.hpp).
+ *
+ * Binary channels carry whole gamepad state, so dpad & axes are available only there; REST
+ * channel supports buttons only (the REST API has no dpad/axes routes).
+ *
+ * Not thread-safe: use one Client per thread.
+ */
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nsg {
+
+// Gamepad buttons (same order as firmware)
+enum class Button : uint8_t {
+  Y = 0,
+  B,
+  A,
+  X,
+  L,
+  R,
+  ZL,
+  ZR,
+  Minus,
+  Plus,
+  LStick,
+  RStick,
+  Home,
+  Capture
+};
+
+// Dpad directions (same values as firmware)
+enum class Dpad : uint8_t {
+  Up = 0,
+  UpRight,
+  Right,
+  DownRight,
+  Down,
+  DownLeft,
+  Left,
+  UpLeft,
+  Centered = 0xF
+};
+
+// Gamepad state (HID report layout)
+struct Report {
+  uint16_t buttons = 0;
+  uint8_t dpad = 0xF;
+  uint8_t lx = 0x80;
+  uint8_t ly = 0x80;
+  uint8_t rx = 0x80;
+  uint8_t ry = 0x80;
+};
+
+// Client-side latency of requests (request sent -> response received)
+// Input stream messages aren't acknowledged, they are counted without latency
+struct LatencyStats {
+  uint64_t requests = 0;  // Completed requests
+  uint64_t errors = 0;    // Failed requests (error status, timeout, broken connection)
+  uint64_t reconnects = 0;
+  double avg_ms = 0;
+  double p50_ms = 0;
+  double p99_ms = 0;
+  double max_ms = 0;
+};
+
+// Button name, as used by REST API
+const char* buttonName(Button button);
+
+class Client {
+ public:
+  // Open client, url: "http://host[:port]" or "serial:<tty path>"
+  // Returns nullptr & fills error, if device is not reachable
+  static std::unique_ptr<Client> open(const std::string& url, std::string* error = nullptr);
+
+  ~Client();
+  Client(const Client&) = delete;
+  Client& operator=(const Client&) = delete;
+
+  // Press buttons
+  bool press(std::initializer_list<Button> buttons);
+  // Release buttons
+  bool release(std::initializer_list<Button> buttons);
+  // Release all buttons
+  bool releaseAll();
+  // Press and release buttons (one by one), delay - hold time, ms
+  bool click(std::initializer_list<Button> buttons, uint16_t delay = 100);
+
+  // Set dpad direction (binary channels only)
+  bool dpad(Dpad direction);
+  // Press and release dpad (binary channels only)
+  bool dpadClick(Dpad direction, uint16_t delay = 100);
+  // Left stick axis (binary channels only)
+  bool leftAxis(uint8_t x, uint8_t y);
+  // Right stick axis (binary channels only)
+  bool rightAxis(uint8_t x, uint8_t y);
+  // Set whole gamepad state (binary channels only)
+  bool setReport(const Report& report);
+
+  // Queue requests until flush(), queued requests are sent back to back (pipelined) and
+  // responses are collected at once. Calls return true while batching, result is flush() result
+  void beginBatch();
+  bool flush();
+
+  // Last known gamepad state (as sent by this client)
+  const Report& report() const { return report_; }
+  // Used channel: "rest", "websocket" or "cdc"
+  const char* channel() const;
+  // Last error description
+  const std::string& error() const { return error_; }
+  // Latency statistics
+  LatencyStats stats() const;
+
+ private:
+  struct Impl;
+  explicit Client(std::unique_ptr<Impl> impl);
+
+  bool send_state(const Report& report);
+  bool send_steps(const std::vector<Report>& states, const std::vector<uint32_t>& hold_us);
+  bool rest(const char* path, const std::string& body);
+
+  std::unique_ptr<Impl> impl_;
+  Report report_;
+  std::string error_;
+};
+
+}  // namespace nsg
@@ -0,0 +1,397 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file nsg_client_test.cpp
+ * @brief Test of the nsg_client library against a loopback stand-in of the device
+ *
+ * Stand-in server answers REST routes (Content-Length or chunked bodies, optionally byte by
+ * byte), can hold responses until several requests arrive, close connections after a number of
+ * responses and accept the input stream WebSocket. Checks:
+ *   - keep-alive: requests reuse one connection
+ *   - pipelining: batched requests are sent back to back (server holds responses until all
+ *     arrive), responses are matched in order
+ *   - reconnect: connection closed by device is reopened once
+ *   - response parsing: Content-Length & chunked bodies, split over many TCP segments
+ *   - input stream: state changes are sent as masked binary WebSocket frames
+ *
+ * Usage: nsg_client_test (exit code 1, if any check fails)
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nsg_client.hpp"
+
+namespace {
+
+int failed = 0;
+
+#define CHECK(cond)                                              \
+  do {                                                           \
+    if (!(cond)) {                                               \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+      failed++;                                                  \
+    }                                                            \
+  } while (0)
+
+// Loopback stand-in of device HTTP server
+class StandInServer {
+ public:
+  struct Options {
+    bool chunked = false;         // Chunked response bodies (otherwise Content-Length)
+    bool split_writes = false;    // Write responses byte by byte
+    int close_after = -1;         // Close connection after that many responses (-1 - never)
+    bool websocket = false;       // Accept /api/stream upgrade
+    std::string fail_path;        // Route answered with 400
+  };
+
+  explicit StandInServer(const Options& options) : options_(options) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listen_fd_, (const sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(listen_fd_, (sockaddr*)&addr, &len);
+    port_ = ntohs(addr.sin_port);
+    listen(listen_fd_, 8);
+    accept_thread_ = std::thread([this] { accept_loop(); });
+  }
+
+  ~StandInServer() {
+    stop_ = true;
+    accept_thread_.join();
+    for (std::thread& t : threads_) t.join();
+    close(listen_fd_);
+  }
+
+  std::string url() const { return "http://127.0.0.1:" + std::to_string(port_); }
+
+  // Answer only when that many requests are received (pipelined requests are held)
+  void hold_responses(size_t num) { hold_responses_ = num; }
+
+  // Accepted REST connections (input stream upgrade isn't counted)
+  int connections() const { return connections_; }
+
+  // Received requests: "<method> <path>", in order of arrival
+  std::vector<std::string> requests() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return requests_;
+  }
+
+  // Unmasked payload of received WebSocket binary messages
+  std::string stream() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stream_;
+  }
+
+ private:
+  void accept_loop() {
+    while (!stop_) {
+      pollfd pfd = {listen_fd_, POLLIN, 0};
+      if (poll(&pfd, 1, 10) <= 0) continue;
+      int fd = accept(listen_fd_, nullptr, nullptr);
+      if (fd < 0) continue;
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      threads_.emplace_back([this, fd] { serve(fd); });
+    }
+  }
+
+  // Read more bytes, returns false if connection is closed or server stops
+  bool read_more(int fd, std::string& in) {
+    while (!stop_) {
+      pollfd pfd = {fd, POLLIN, 0};
+      if (poll(&pfd, 1, 10) <= 0) continue;
+      char buf[1024];
+      ssize_t n = recv(fd, buf, sizeof(buf), 0);
+      if (n <= 0) return false;
+      in.append(buf, n);
+      return true;
+    }
+    return false;
+  }
+
+  void write_out(int fd, const std::string& out) {
+    if (!options_.split_writes) {
+      send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+      return;
+    }
+    for (char c : out) {
+      send(fd, &c, 1, MSG_NOSIGNAL);
+      usleep(50);
+    }
+  }
+
+  std::string response(const std::string& status, const std::string& body) {
+    std::string out = "HTTP/1.1 " + status + "\r\nContent-Type: text/html\r\n";
+    if (!options_.chunked) {
+      return out + "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+    // Body is split into two chunks
+    out += "Transfer-Encoding: chunked\r\n\r\n";
+    size_t half = body.size() / 2;
+    for (const std::string& chunk : {body.substr(0, half), body.substr(half)}) {
+      if (chunk.empty()) continue;
+      char size[20];
+      snprintf(size, sizeof(size), "%zx\r\n", chunk.size());
+      out += size + chunk + "\r\n";
+    }
+    return out + "0\r\n\r\n";
+  }
+
+  // HTTP connection: requests are answered in order of arrival
+  void serve(int fd) {
+    std::string in;
+    std::vector<std::string> pending;
+    int responses = 0;
+    bool counted = false;
+    while (true) {
+      size_t hdr_end = in.find("\r\n\r\n");
+      if (hdr_end == std::string::npos) {
+        if (!read_more(fd, in)) break;
+        continue;
+      }
+      size_t body_len = 0;
+      size_t cl = in.find("Content-Length: ");
+      if (cl != std::string::npos && cl < hdr_end) {
+        body_len = strtoul(in.c_str() + cl + 16, nullptr, 10);
+      }
+      if (in.size() < hdr_end + 4 + body_len) {
+        if (!read_more(fd, in)) break;
+        continue;
+      }
+      std::string line = in.substr(0, in.find(' ', in.find(' ') + 1));
+      in.erase(0, hdr_end + 4 + body_len);
+
+      if (line == "GET /api/stream") {
+        if (options_.websocket) {
+          write_out(fd, "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                        "Connection: Upgrade\r\nSec-WebSocket-Accept: standin\r\n\r\n");
+          serve_websocket(fd, in);
+          break;
+        }
+        write_out(fd, response("404 Not Found", "Nothing matches the given URI"));
+        continue;
+      }
+      if (!counted) connections_++;
+      counted = true;
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        requests_.push_back(line);
+      }
+      pending.push_back(line);
+      if (pending.size() < hold_responses_) continue;
+
+      std::string out;
+      for (const std::string& request : pending) {
+        bool fail = !options_.fail_path.empty() &&
+                    request.compare(request.find(' ') + 1, std::string::npos,
+                                    options_.fail_path) == 0;
+        out += fail ? response("400 Bad Request", "Unknown button in buttons array")
+                    : response("200 OK", "OK");
+        responses++;
+      }
+      pending.clear();
+      write_out(fd, out);
+      if (options_.close_after >= 0 && responses >= options_.close_after) break;
+    }
+    close(fd);
+  }
+
+  // Input stream connection: masked binary messages
+  void serve_websocket(int fd, std::string& in) {
+    while (true) {
+      while (in.size() < 2) {
+        if (!read_more(fd, in)) return;
+      }
+      size_t len = in[1] & 0x7F;
+      size_t hdr = 2;
+      if (len == 126) {
+        while (in.size() < 4) {
+          if (!read_more(fd, in)) return;
+        }
+        len = (uint8_t)in[2] << 8 | (uint8_t)in[3];
+        hdr = 4;
+      }
+      bool masked = in[1] & 0x80;
+      size_t total = hdr + (masked ? 4 : 0) + len;
+      while (in.size() < total) {
+        if (!read_more(fd, in)) return;
+      }
+      std::string payload = in.substr(total - len, len);
+      if (masked) {
+        for (size_t i = 0; i < len; i++) payload[i] ^= in[hdr + i % 4];
+      }
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if ((uint8_t)in[0] == 0x82 && masked) stream_ += payload;
+      }
+      in.erase(0, total);
+    }
+  }
+
+  Options options_;
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::atomic<size_t> hold_responses_ = 1;
+  std::atomic<bool> stop_ = false;
+  std::atomic<int> connections_ = 0;
+  std::thread accept_thread_;
+  std::vector<std::thread> threads_;
+  std::mutex mtx_;
+  std::vector<std::string> requests_;
+  std::string stream_;
+};
+
+std::unique_ptr<nsg::Client> open(const StandInServer& server) {
+  std::string error;
+  auto client = nsg::Client::open(server.url(), &error);
+  if (!client) printf("Client::open: %s\n", error.c_str());
+  return client;
+}
+
+// Requests reuse one keep-alive connection
+void test_keep_alive() {
+  StandInServer server({});
+  auto client = open(server);
+  CHECK(client);
+  if (!client) return;
+  CHECK(strcmp(client->channel(), "rest") == 0);
+  CHECK(client->press({nsg::Button::A}));
+  CHECK(client->release({nsg::Button::A}));
+  CHECK(client->click({nsg::Button::B}, 10));
+  CHECK(client->releaseAll());
+  CHECK(server.connections() == 1);
+  CHECK(server.requests().size() == 5);
+  CHECK(client->stats().requests == 5 && client->stats().errors == 0);
+  CHECK(client->stats().reconnects == 0);
+}
+
+// Batched requests are sent back to back, responses are matched in order
+void test_pipelining() {
+  StandInServer::Options options;
+  options.fail_path = "/api/release";
+  StandInServer server(options);
+  auto client = open(server);
+  CHECK(client);
+  if (!client) return;
+
+  // Server answers only after all requests arrive, client waiting for each response times out
+  server.hold_responses(3);
+  client->beginBatch();
+  CHECK(client->press({nsg::Button::A}));
+  CHECK(client->release({nsg::Button::A}));
+  CHECK(client->click({nsg::Button::B}, 10));
+  // Failed request in the middle is reported, responses after it are still consumed
+  CHECK(!client->flush());
+  CHECK(client->error() == "HTTP 400: Unknown button in buttons array");
+  CHECK(client->stats().requests == 4 && client->stats().errors == 1);
+
+  std::vector<std::string> expected = {"GET /api/ping", "POST /api/press", "POST /api/release",
+                                       "POST /api/click"};
+  CHECK(server.requests() == expected);
+
+  // Connection stays usable
+  server.hold_responses(1);
+  CHECK(client->press({nsg::Button::X}));
+  CHECK(server.connections() == 1);
+}
+
+// Connection closed by device is reopened once
+void test_reconnect() {
+  StandInServer::Options options;
+  options.close_after = 1;
+  StandInServer server(options);
+  auto client = open(server);
+  CHECK(client);
+  if (!client) return;
+  CHECK(client->press({nsg::Button::A}));
+  CHECK(client->release({nsg::Button::A}));
+  CHECK(server.connections() == 3);
+  CHECK(client->stats().reconnects == 2);
+  CHECK(client->stats().errors == 0);
+}
+
+// Chunked & Content-Length bodies, written byte by byte
+void test_parse_response(bool chunked) {
+  StandInServer::Options options;
+  options.chunked = chunked;
+  options.split_writes = true;
+  options.fail_path = "/api/click";
+  StandInServer server(options);
+  auto client = open(server);
+  CHECK(client);
+  if (!client) return;
+
+  client->beginBatch();
+  CHECK(client->press({nsg::Button::A}));
+  CHECK(client->release({nsg::Button::A}));
+  CHECK(client->flush());
+  CHECK(!client->click({nsg::Button::A}, 10));
+  CHECK(client->error().compare(0, 9, "HTTP 400:") == 0);
+  CHECK(client->error().find("Unknown button") != std::string::npos);
+  CHECK(client->press({nsg::Button::B}));
+  CHECK(server.connections() == 1);
+  CHECK(client->stats().requests == 5 && client->stats().errors == 1);
+}
+
+// State changes go over input stream WebSocket as 12-byte frames
+void test_websocket() {
+  StandInServer::Options options;
+  options.websocket = true;
+  StandInServer server(options);
+  auto client = open(server);
+  CHECK(client);
+  if (!client) return;
+  CHECK(strcmp(client->channel(), "websocket") == 0);
+  CHECK(client->press({nsg::Button::A}));
+  CHECK(client->dpad(nsg::Dpad::Up));
+  CHECK(client->leftAxis(0, 255));
+
+  std::string stream;
+  for (int i = 0; i < 100 && stream.size() < 36; i++) {
+    usleep(1000);
+    stream = server.stream();
+  }
+  CHECK(stream.size() == 36);
+  if (stream.size() != 36) return;
+  const uint8_t* f = (const uint8_t*)stream.data();
+  CHECK(f[4] == 1 << (int)nsg::Button::A && f[5] == 0 && f[6] == 0xF);
+  CHECK(f[12 + 4] == 1 << (int)nsg::Button::A && f[12 + 6] == (uint8_t)nsg::Dpad::Up);
+  CHECK(f[24 + 7] == 0 && f[24 + 8] == 255);
+  // Timestamps of client timeline don't go back
+  uint32_t ts[3];
+  for (int i = 0; i < 3; i++) memcpy(&ts[i], f + i * 12, 4);
+  CHECK((int32_t)(ts[1] - ts[0]) > 0 && (int32_t)(ts[2] - ts[1]) > 0);
+  // Only ping went over REST connection
+  CHECK(server.requests().size() == 1);
+}
+
+}  // namespace
+
+int main() {
+  test_keep_alive();
+  test_pipelining();
+  test_reconnect();
+  test_parse_response(false);
+  test_parse_response(true);
+  test_websocket();
+
+  printf("%d checks failed\n", failed);
+  return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,956 @@
+// SPDX-License-Identifier: MIT
+/**
+ * @file loadgen.cpp
+ * @brief Host-side load generator for the gamepad REST API
+ *
+ * Drives a weighted mix of /api/ping, /api/press, /api/release and /api/click requests against a
+ * device (or any host serving the same API) with an open-loop Poisson arrival process. Requests
+ * are sent over a pool of keep-alive connections; latency is measured from the intended arrival
+ * time, so queueing delay caused by a saturated server is included (no coordinated omission).
+ *
+ * The "stream" route sends binary messages of input stream frames over a WebSocket to /api/stream
+ * (opened before the load). Frames sweep the left stick along the client timeline. The device
+ * doesn't acknowledge them, so the route reports sent messages and broken connections, but no
+ * latency; their playout shows up in nsg_stream_frames_total of /api/metrics.
+ *
+ * Idle connections emulate dashboards holding keep-alive sockets: they are opened & pinged before
+ * the load starts and stay open while it runs. Sweeping their number shows how many clients can
+ * stay connected while control latency holds (--max-p99 fails the run otherwise).
+ *
+ * With --max-jitter the HID tick jitter histogram is read from /api/metrics before and after the
+ * load, so the run doubles as a jitter benchmark under WiFi traffic: p99 jitter of the load window
+ * (upper bound of its histogram bucket) above the bound fails the run. The device console command
+ * "hidjitter -m <us>" checks the same histogram locally, while load comes from elsewhere.
+ *
+ * Usage:
+ *   nsg_loadgen --host 192.168.1.50 --rate 50 --duration 30 --connections 4 \
+ *               --mix press=4,release=4,click=1,ping=1
+ *   nsg_loadgen --host 192.168.1.50 --rate 100 --mix press=1,release=1,stream=8 --stream-frames 4
+ *   for n in 0 4 8 12 16; do nsg_loadgen --host 192.168.1.50 --idle $n --max-p99 50 || break; done
+ *   nsg_loadgen --host 192.168.1.50 --rate 200 --duration 60 --idle 8 --max-jitter 500
+ */
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Load generator options
+struct Options {
+  std::string host = "127.0.0.1";
+  int port = 80;
+  double rate = 10.0;      // Requests per second (all routes)
+  double duration = 10.0;  // Seconds of load
+  int connections = 2;     // Keep-alive connections
+  int timeout_ms = 5000;   // Response timeout
+  std::string mix = "press=4,release=4,click=1,ping=1";
+  std::string button = "A";
+  int click_delay = 50;  // Delay for /api/click, ms
+  bool json = false;     // Machine-readable output
+  unsigned seed = 1;
+  int idle = 0;              // Idle keep-alive connections
+  double idle_interval = 0;  // Ping period of idle connections, s (0 - only first ping)
+  double max_p99 = 0;        // Maximum p99 latency of load, ms (0 - not checked)
+  double max_jitter = 0;     // Maximum p99 HID tick jitter during load, us (0 - not checked)
+  int stream_frames = 4;     // Input stream frames per WebSocket message
+};
+
+// Input stream frame & maximum frames in one WebSocket message (see main/stream.cpp)
+constexpr size_t kStreamFrameSize = 12;
+constexpr int kStreamMessageFrames = 32;
+// Timestamp step between stream frames, us
+constexpr uint32_t kStreamFramePeriodUs = 1000;
+
+// Request route
+struct Route {
+  std::string name;
+  std::string request;  // Full HTTP request
+  double weight = 0;
+  bool stream = false;  // Sent over input stream WebSocket
+
+  std::vector<int64_t> latencies_us;
+  uint64_t ok = 0;
+  uint64_t errors = 0;
+  std::map<int, uint64_t> statuses;
+};
+
+// Scheduled request
+struct Request {
+  size_t route;
+  int64_t intended_us;  // Arrival time of open-loop schedule
+};
+
+// HID tick jitter histogram of /api/metrics (cumulative buckets)
+struct Jitter {
+  bool valid = false;
+  std::vector<double> le;  // Bucket upper bounds, us (last is +Inf)
+  std::vector<uint64_t> count;
+  uint64_t sum_us = 0;
+};
+
+// Input stream WebSocket connection
+struct Stream {
+  int fd = -1;
+  int status = 0;  // Handshake status (101 - upgraded)
+  std::string out;
+  size_t out_off = 0;
+  std::deque<size_t> ends;  // End offsets of unsent messages in out
+  uint32_t next_ts = 0;     // Next free timestamp of client timeline
+  bool ts_valid = false;
+  uint64_t frames = 0;  // Sent frames
+  uint64_t closed = 0;  // Closed by server
+};
+
+// Keep-alive connection
+struct Conn {
+  enum State { Closed, Connecting, Idle, Busy } state = Closed;
+  int fd = -1;
+  std::string out;
+  size_t out_off = 0;
+  std::string in;
+  Request req = {};
+  int64_t sent_us = 0;
+  int64_t next_us = 0;  // Next ping of idle connection (0 - none)
+  uint64_t ok = 0;      // Successful responses
+};
+
+// Idle connections
+struct Idle {
+  std::vector<Conn> conns;
+  std::string request;  // Ping request
+  uint64_t failed = 0;  // Failed connects & pings
+  uint64_t closed = 0;  // Closed by server
+  std::vector<int64_t> latencies_us;
+};
+
+int64_t now_us() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void usage(const char* argv0) {
+  printf(
+      "Usage: %s [options]\n"
+      "  --host <addr>        Device address (default 127.0.0.1)\n"
+      "  --port <n>           HTTP port (default 80)\n"
+      "  --rate <rps>         Open-loop arrival rate, requests/s (default 10)\n"
+      "  --duration <s>       Load duration, seconds (default 10)\n"
+      "  --connections <n>    Keep-alive connections (default 2)\n"
+      "  --timeout <ms>       Response timeout (default 5000)\n"
+      "  --mix <spec>         Weighted routes: ping,press,release,click,stream\n"
+      "                       (default press=4,release=4,click=1,ping=1)\n"
+      "  --button <name>      Button for press/release/click (default A)\n"
+      "  --click-delay <ms>   Delay for click requests (default 50)\n"
+      "  --stream-frames <n>  Input stream frames per message, 1-32 (default 4)\n"
+      "  --seed <n>           Random seed (default 1)\n"
+      "  --idle <n>           Idle keep-alive connections held during load (default 0)\n"
+      "  --idle-interval <s>  Ping period of idle connections (default 0 - only first ping)\n"
+      "  --max-p99 <ms>       Fail, if p99 latency of load exceeds it (default 0 - no check)\n"
+      "  --max-jitter <us>    Fail, if p99 HID tick jitter during load exceeds it\n"
+      "                       (read from /api/metrics, default 0 - no check)\n"
+      "  --json               Print machine-readable summary\n",
+      argv0);
+}
+
+bool parse_args(int argc, char** argv, Options& opt) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&]() -> const char* {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "Missed value for %s\n", arg.c_str());
+        exit(2);
+      }
+      return argv[++i];
+    };
+    if (arg == "--host") {
+      opt.host = value();
+    } else if (arg == "--port") {
+      opt.port = atoi(value());
+    } else if (arg == "--rate") {
+      opt.rate = atof(value());
+    } else if (arg == "--duration") {
+      opt.duration = atof(value());
+    } else if (arg == "--connections") {
+      opt.connections = atoi(value());
+    } else if (arg == "--timeout") {
+      opt.timeout_ms = atoi(value());
+    } else if (arg == "--mix") {
+      opt.mix = value();
+    } else if (arg == "--button") {
+      opt.button = value();
+    } else if (arg == "--click-delay") {
+      opt.click_delay = atoi(value());
+    } else if (arg == "--stream-frames") {
+      opt.stream_frames = atoi(value());
+    } else if (arg == "--seed") {
+      opt.seed = atoi(value());
+    } else if (arg == "--idle") {
+      opt.idle = atoi(value());
+    } else if (arg == "--idle-interval") {
+      opt.idle_interval = atof(value());
+    } else if (arg == "--max-p99") {
+      opt.max_p99 = atof(value());
+    } else if (arg == "--max-jitter") {
+      opt.max_jitter = atof(value());
+    } else if (arg == "--json") {
+      opt.json = true;
+    } else {
+      usage(argv[0]);
+      return false;
+    }
+  }
+  if (opt.rate <= 0 || opt.duration <= 0 || opt.connections <= 0) {
+    fprintf(stderr, "Rate, duration and connections must be positive\n");
+    return false;
+  }
+  if (opt.idle < 0 || opt.idle_interval < 0 || opt.max_p99 < 0 || opt.max_jitter < 0) {
+    fprintf(stderr, "Idle connections, interval, maximum p99 and jitter must not be negative\n");
+    return false;
+  }
+  if (opt.stream_frames < 1 || opt.stream_frames > kStreamMessageFrames) {
+    fprintf(stderr, "Stream frames must be 1-%d\n", kStreamMessageFrames);
+    return false;
+  }
+  return true;
+}
+
+std::string make_request(const Options& opt, const char* method, const char* path,
+                         const std::string& body) {
+  std::string req = std::string(method) + " " + path + " HTTP/1.1\r\n";
+  req += "Host: " + opt.host + "\r\n";
+  req += "Connection: keep-alive\r\n";
+  if (!body.empty()) {
+    req += "Content-Type: application/json\r\n";
+  }
+  req += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+  req += body;
+  return req;
+}
+
+bool build_routes(const Options& opt, std::vector<Route>& routes) {
+  std::string buttons = "{\"buttons\":[\"" + opt.button + "\"]}";
+  std::string click =
+      "{\"buttons\":[\"" + opt.button + "\"],\"delay\":" + std::to_string(opt.click_delay) + "}";
+
+  size_t pos = 0;
+  while (pos < opt.mix.size()) {
+    size_t end = opt.mix.find(',', pos);
+    if (end == std::string::npos) end = opt.mix.size();
+    std::string item = opt.mix.substr(pos, end - pos);
+    pos = end + 1;
+
+    size_t eq = item.find('=');
+    Route route;
+    route.name = item.substr(0, eq);
+    route.weight = eq == std::string::npos ? 1.0 : atof(item.c_str() + eq + 1);
+    if (route.name == "ping") {
+      route.request = make_request(opt, "GET", "/api/ping", "");
+    } else if (route.name == "press") {
+      route.request = make_request(opt, "POST", "/api/press", buttons);
+    } else if (route.name == "release") {
+      route.request = make_request(opt, "POST", "/api/release", buttons);
+    } else if (route.name == "click") {
+      route.request = make_request(opt, "POST", "/api/click", click);
+    } else if (route.name == "stream") {
+      route.stream = true;
+    } else {
+      fprintf(stderr, "Unknown route in mix: \"%s\"\n", route.name.c_str());
+      return false;
+    }
+    if (route.weight > 0) routes.push_back(route);
+  }
+  return !routes.empty();
+}
+
+bool resolve(const Options& opt, sockaddr_in& addr) {
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* res = nullptr;
+  if (getaddrinfo(opt.host.c_str(), nullptr, &hints, &res) != 0 || !res) {
+    fprintf(stderr, "Failed to resolve %s\n", opt.host.c_str());
+    return false;
+  }
+  addr = *(sockaddr_in*)res->ai_addr;
+  addr.sin_port = htons(opt.port);
+  freeaddrinfo(res);
+  return true;
+}
+
+void conn_close(Conn& c) {
+  if (c.fd >= 0) close(c.fd);
+  c.fd = -1;
+  c.state = Conn::Closed;
+  c.in.clear();
+  c.out.clear();
+  c.out_off = 0;
+}
+
+void conn_open(Conn& c, const sockaddr_in& addr, uint64_t& connects) {
+  c.fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (c.fd < 0) return;
+  fcntl(c.fd, F_SETFL, fcntl(c.fd, F_GETFL) | O_NONBLOCK);
+  int one = 1;
+  setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  connects++;
+  if (connect(c.fd, (const sockaddr*)&addr, sizeof(addr)) == 0) {
+    c.state = Conn::Idle;
+  } else if (errno == EINPROGRESS) {
+    c.state = Conn::Connecting;
+  } else {
+    conn_close(c);
+  }
+}
+
+// Try to parse complete HTTP response
+// Returns status code, 0 - response is not complete yet, -1 - malformed
+int parse_response(const std::string& in, bool& keep_alive) {
+  size_t hdr_end = in.find("\r\n\r\n");
+  if (hdr_end == std::string::npos) return 0;
+  if (in.compare(0, 5, "HTTP/") != 0) return -1;
+  int status = atoi(in.c_str() + in.find(' ') + 1);
+
+  std::string headers = in.substr(0, hdr_end);
+  std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+  keep_alive = headers.find("connection: close") == std::string::npos;
+
+  size_t body_start = hdr_end + 4;
+  size_t cl = headers.find("content-length:");
+  if (cl != std::string::npos) {
+    size_t len = strtoul(headers.c_str() + cl + 15, nullptr, 10);
+    return in.size() >= body_start + len ? status : 0;
+  }
+  if (headers.find("transfer-encoding: chunked") != std::string::npos) {
+    return in.find("\r\n0\r\n\r\n", body_start - 2) != std::string::npos ? status : 0;
+  }
+  // No body length, response ends with connection
+  keep_alive = false;
+  return status;
+}
+
+// Poll events of connection
+short conn_events(const Conn& c) {
+  short events = 0;
+  if (c.state == Conn::Connecting || (c.state == Conn::Busy && c.out_off < c.out.size())) {
+    events |= POLLOUT;
+  }
+  if (c.state == Conn::Busy || c.state == Conn::Idle) events |= POLLIN;
+  return events;
+}
+
+// Send pings of idle connections, when their time comes
+void idle_dispatch(const Options& opt, Idle& idle, int64_t now) {
+  for (Conn& c : idle.conns) {
+    if (c.state == Conn::Idle && c.next_us && now >= c.next_us) {
+      c.out = idle.request;
+      c.out_off = 0;
+      c.in.clear();
+      c.sent_us = now;
+      c.state = Conn::Busy;
+    }
+    if (c.state == Conn::Busy && now - c.sent_us > (int64_t)opt.timeout_ms * 1000) {
+      idle.failed++;
+      conn_close(c);
+    }
+  }
+}
+
+// Handle poll events of idle connection
+void idle_event(const Options& opt, Idle& idle, Conn& c, short rev, int64_t now) {
+  if (c.state == Conn::Connecting) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err != 0 || (rev & (POLLERR | POLLHUP))) {
+      idle.failed++;
+      conn_close(c);
+    } else {
+      c.state = Conn::Idle;
+      c.next_us = now;
+    }
+    return;
+  }
+
+  if ((rev & POLLOUT) && c.out_off < c.out.size()) {
+    ssize_t n = send(c.fd, c.out.data() + c.out_off, c.out.size() - c.out_off, MSG_NOSIGNAL);
+    if (n > 0) c.out_off += n;
+  }
+
+  if (rev & (POLLIN | POLLERR | POLLHUP)) {
+    char buf[1024];
+    ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+    if (n > 0) c.in.append(buf, n);
+    if (c.state != Conn::Busy) {
+      // Server closed idle connection (idle timeout or LRU purge)
+      idle.closed++;
+      conn_close(c);
+      return;
+    }
+
+    bool keep_alive = true;
+    int status = parse_response(c.in, keep_alive);
+    if (status == 0 && n <= 0) status = -1;
+    if (status == 0) return;
+
+    if (status == 200) {
+      c.ok++;
+      idle.latencies_us.push_back(now - c.sent_us);
+    } else {
+      idle.failed++;
+    }
+    if (keep_alive && status > 0) {
+      c.state = Conn::Idle;
+      c.in.clear();
+      c.next_us = opt.idle_interval > 0 ? now + (int64_t)(opt.idle_interval * 1e6) : 0;
+    } else {
+      idle.closed++;
+      conn_close(c);
+    }
+  }
+}
+
+// Open idle connections & wait for their first response
+void idle_open(const Options& opt, Idle& idle, const sockaddr_in& addr) {
+  uint64_t connects = 0;
+  for (Conn& c : idle.conns) conn_open(c, addr, connects);
+  const int64_t end = now_us() + (int64_t)opt.timeout_ms * 1000;
+  while (now_us() < end) {
+    int64_t now = now_us();
+    idle_dispatch(opt, idle, now);
+
+    std::vector<pollfd> pfds;
+    std::vector<Conn*> pconns;
+    for (Conn& c : idle.conns) {
+      if (c.fd < 0 || (c.state == Conn::Idle && !c.next_us)) continue;
+      pfds.push_back({c.fd, conn_events(c), 0});
+      pconns.push_back(&c);
+    }
+    if (pfds.empty()) break;
+    poll(pfds.data(), pfds.size(), 10);
+
+    now = now_us();
+    for (size_t i = 0; i < pfds.size(); i++) {
+      if (pfds[i].revents) idle_event(opt, idle, *pconns[i], pfds[i].revents, now);
+    }
+  }
+}
+
+// Upgrade separate connection to input stream WebSocket (blocking handshake)
+void stream_open(const Options& opt, const sockaddr_in& addr, Stream& s) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return;
+  timeval tv = {opt.timeout_ms / 1000, (opt.timeout_ms % 1000) * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+  std::string in;
+  if (connect(fd, (const sockaddr*)&addr, sizeof(addr)) == 0) {
+    // Key is the RFC 6455 sample nonce, server only echoes its hash
+    std::string req = "GET /api/stream HTTP/1.1\r\nHost: " + opt.host +
+                      "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                      "Sec-WebSocket-Version: 13\r\n"
+                      "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n";
+    if (send(fd, req.data(), req.size(), MSG_NOSIGNAL) == (ssize_t)req.size()) {
+      char buf[1024];
+      ssize_t n;
+      while (in.find("\r\n\r\n") == std::string::npos && (n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        in.append(buf, n);
+      }
+    }
+  }
+  s.status = in.compare(0, 5, "HTTP/") == 0 ? atoi(in.c_str() + in.find(' ') + 1) : -1;
+  if (s.status != 101) {
+    close(fd);
+    return;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  s.fd = fd;
+}
+
+// Queue binary message of stream frames (masked, as required for client)
+void stream_queue(const Options& opt, Stream& s, std::mt19937_64& rng, int64_t now) {
+  uint32_t ts = (uint32_t)now;
+  if (s.ts_valid && (int32_t)(s.next_ts - ts) > 0) ts = s.next_ts;
+
+  std::string payload;
+  for (int i = 0; i < opt.stream_frames; i++, ts += kStreamFramePeriodUs) {
+    // Left stick sweeps X axis, the rest is centered
+    uint8_t lx = (uint8_t)(ts / kStreamFramePeriodUs);
+    uint8_t frame[kStreamFrameSize] = {0, 0, 0, 0, 0, 0, 0xF, lx, 0x80, 0x80, 0x80, 0};
+    for (int b = 0; b < 4; b++) frame[b] = (ts >> (8 * b)) & 0xFF;
+    payload.append((const char*)frame, sizeof(frame));
+  }
+  s.next_ts = ts;
+  s.ts_valid = true;
+
+  uint8_t mask[4];
+  for (uint8_t& m : mask) m = rng() & 0xFF;
+  s.out += (char)0x82;  // FIN | binary
+  if (payload.size() < 126) {
+    s.out += (char)(0x80 | payload.size());
+  } else {
+    s.out += (char)(0x80 | 126);
+    s.out += (char)(payload.size() >> 8);
+    s.out += (char)(payload.size() & 0xFF);
+  }
+  s.out.append((const char*)mask, sizeof(mask));
+  for (size_t i = 0; i < payload.size(); i++) s.out += (char)(payload[i] ^ mask[i % 4]);
+  s.ends.push_back(s.out.size());
+}
+
+// Handle poll events of stream connection
+void stream_event(const Options& opt, Stream& s, Route& route, short rev) {
+  if ((rev & POLLOUT) && s.out_off < s.out.size()) {
+    ssize_t n = send(s.fd, s.out.data() + s.out_off, s.out.size() - s.out_off, MSG_NOSIGNAL);
+    if (n > 0) s.out_off += n;
+    while (!s.ends.empty() && s.ends.front() <= s.out_off) {
+      route.ok++;
+      s.frames += opt.stream_frames;
+      s.ends.pop_front();
+    }
+    if (s.ends.empty()) {
+      s.out.clear();
+      s.out_off = 0;
+    }
+  }
+
+  if (rev & (POLLIN | POLLERR | POLLHUP)) {
+    // Device sends nothing but close frame, unsent messages are lost with connection
+    char buf[256];
+    ssize_t n = recv(s.fd, buf, sizeof(buf), 0);
+    if (n > 0 || (n < 0 && errno == EAGAIN)) return;
+    route.errors += s.ends.size();
+    s.closed++;
+    close(s.fd);
+    s.fd = -1;
+    s.out.clear();
+    s.out_off = 0;
+    s.ends.clear();
+  }
+}
+
+// Blocking GET on a separate connection, returns response body (empty on failure)
+std::string http_get(const Options& opt, const sockaddr_in& addr, const char* path) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return "";
+  timeval tv = {opt.timeout_ms / 1000, (opt.timeout_ms % 1000) * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+  std::string in;
+  if (connect(fd, (const sockaddr*)&addr, sizeof(addr)) == 0) {
+    std::string req = make_request(opt, "GET", path, "");
+    bool keep_alive = true;
+    if (send(fd, req.data(), req.size(), MSG_NOSIGNAL) == (ssize_t)req.size()) {
+      char buf[4096];
+      ssize_t n;
+      while (parse_response(in, keep_alive) == 0 && (n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        in.append(buf, n);
+      }
+    }
+    if (parse_response(in, keep_alive) != 200) in.clear();
+  }
+  close(fd);
+  if (in.empty()) return "";
+
+  size_t body_start = in.find("\r\n\r\n") + 4;
+  std::string headers = in.substr(0, body_start);
+  std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+  if (headers.find("transfer-encoding: chunked") == std::string::npos) {
+    return in.substr(body_start);
+  }
+  // Join chunks
+  std::string body;
+  size_t pos = body_start;
+  while (pos < in.size()) {
+    size_t len = strtoul(in.c_str() + pos, nullptr, 16);
+    size_t data = in.find("\r\n", pos);
+    if (len == 0 || data == std::string::npos) break;
+    body.append(in, data + 2, len);
+    pos = data + 2 + len + 2;
+  }
+  return body;
+}
+
+// Read HID tick jitter histogram from /api/metrics
+Jitter jitter_read(const Options& opt, const sockaddr_in& addr) {
+  static const char bucket[] = "nsg_hid_tick_jitter_us_bucket{le=\"";
+  static const char sum[] = "nsg_hid_tick_jitter_us_sum ";
+  Jitter jitter;
+  std::string body = http_get(opt, addr, "/api/metrics");
+  size_t pos = 0;
+  while (pos < body.size()) {
+    size_t end = body.find('\n', pos);
+    if (end == std::string::npos) end = body.size();
+    std::string line = body.substr(pos, end - pos);
+    pos = end + 1;
+
+    if (line.compare(0, sizeof(bucket) - 1, bucket) == 0) {
+      const char* le = line.c_str() + sizeof(bucket) - 1;
+      jitter.le.push_back(strncmp(le, "+Inf", 4) == 0 ? INFINITY : atof(le));
+      jitter.count.push_back(strtoull(strchr(le, '}') + 1, nullptr, 10));
+    } else if (line.compare(0, sizeof(sum) - 1, sum) == 0) {
+      jitter.sum_us = strtoull(line.c_str() + sizeof(sum) - 1, nullptr, 10);
+    }
+  }
+  jitter.valid = !jitter.le.empty() && std::isinf(jitter.le.back());
+  return jitter;
+}
+
+// Jitter during load: ticks, mean & p99 (upper bound of the bucket reaching 99% of ticks)
+struct JitterWindow {
+  uint64_t ticks = 0;
+  double mean_us = 0;
+  double p99_us = 0;
+};
+
+JitterWindow jitter_window(const Jitter& before, const Jitter& after) {
+  JitterWindow w;
+  w.ticks = after.count.back() - before.count.back();
+  if (w.ticks == 0) return w;
+  w.mean_us = (double)(after.sum_us - before.sum_us) / w.ticks;
+  for (size_t b = 0; b < after.le.size(); b++) {
+    w.p99_us = after.le[b];
+    if ((after.count[b] - before.count[b]) * 100 >= w.ticks * 99) break;
+  }
+  return w;
+}
+
+double percentile(const std::vector<int64_t>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t idx = std::min(sorted.size() - 1, (size_t)std::ceil(p / 100.0 * sorted.size()) - 1);
+  return sorted[idx] / 1000.0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!parse_args(argc, argv, opt)) return 2;
+
+  std::vector<Route> routes;
+  if (!build_routes(opt, routes)) return 2;
+  sockaddr_in addr;
+  if (!resolve(opt, addr)) return 2;
+
+  std::mt19937_64 rng(opt.seed);
+  std::exponential_distribution<double> interarrival(opt.rate);
+  std::vector<double> weights;
+  for (const Route& r : routes) weights.push_back(r.weight);
+  std::discrete_distribution<size_t> route_pick(weights.begin(), weights.end());
+
+  std::vector<Conn> conns(opt.connections);
+  std::deque<Request> pending;
+  uint64_t connects = 0;
+  uint64_t timeouts = 0;
+  size_t max_pending = 0;
+
+  Idle idle;
+  idle.conns.resize(opt.idle);
+  idle.request = make_request(opt, "GET", "/api/ping", "");
+  if (opt.idle > 0) idle_open(opt, idle, addr);
+
+  // Input stream is opened once, messages after its failure are errors
+  Stream stream;
+  size_t stream_route = routes.size();
+  for (size_t r = 0; r < routes.size(); r++) {
+    if (routes[r].stream) stream_route = r;
+  }
+  if (stream_route < routes.size()) {
+    stream_open(opt, addr, stream);
+    if (stream.fd < 0) {
+      fprintf(stderr, "Failed to open input stream (status %d)\n", stream.status);
+      if (stream.status > 0) routes[stream_route].statuses[stream.status]++;
+    }
+  }
+
+  Jitter jitter_before;
+  if (opt.max_jitter > 0) {
+    jitter_before = jitter_read(opt, addr);
+    if (!jitter_before.valid) {
+      fprintf(stderr, "Failed to read HID tick jitter from /api/metrics\n");
+      return 2;
+    }
+  }
+
+  const int64_t start = now_us();
+  const int64_t end = start + (int64_t)(opt.duration * 1e6);
+  const int64_t drain_end = end + (int64_t)opt.timeout_ms * 1000;
+  int64_t next_arrival = start;
+
+  for (Conn& c : conns) conn_open(c, addr, connects);
+
+  while (true) {
+    int64_t now = now_us();
+
+    // Open-loop arrivals
+    while (next_arrival <= now && next_arrival < end) {
+      size_t route = route_pick(rng);
+      if (!routes[route].stream) {
+        pending.push_back({route, next_arrival});
+      } else if (stream.fd >= 0) {
+        stream_queue(opt, stream, rng, now);
+      } else {
+        routes[route].errors++;
+      }
+      next_arrival += (int64_t)(interarrival(rng) * 1e6);
+    }
+    max_pending = std::max(max_pending, pending.size());
+
+    bool busy = !pending.empty() || !stream.ends.empty();
+    for (Conn& c : conns) busy |= c.state == Conn::Busy;
+    if ((now >= end && !busy) || now >= drain_end) break;
+
+    // Dispatch pending requests to idle connections
+    for (Conn& c : conns) {
+      if (c.state == Conn::Closed && (!pending.empty() || now < end)) {
+        conn_open(c, addr, connects);
+      }
+      if (c.state == Conn::Idle && !pending.empty()) {
+        c.req = pending.front();
+        pending.pop_front();
+        c.out = routes[c.req.route].request;
+        c.out_off = 0;
+        c.in.clear();
+        c.sent_us = now;
+        c.state = Conn::Busy;
+      }
+      // Response timeout
+      if (c.state == Conn::Busy && now - c.sent_us > (int64_t)opt.timeout_ms * 1000) {
+        routes[c.req.route].errors++;
+        timeouts++;
+        conn_close(c);
+      }
+    }
+
+    // Wait for sockets or next arrival
+    std::vector<pollfd> pfds;
+    std::vector<Conn*> pconns;
+    for (Conn& c : conns) {
+      if (c.fd < 0) continue;
+      pfds.push_back({c.fd, conn_events(c), 0});
+      pconns.push_back(&c);
+    }
+    // Idle connections follow load connections
+    const size_t load_pfds = pfds.size();
+    idle_dispatch(opt, idle, now);
+    for (Conn& c : idle.conns) {
+      if (c.fd < 0) continue;
+      pfds.push_back({c.fd, conn_events(c), 0});
+      pconns.push_back(&c);
+    }
+    // Stream connection is the last one
+    if (stream.fd >= 0) {
+      pfds.push_back({stream.fd, (short)(POLLIN | (stream.ends.empty() ? 0 : POLLOUT)), 0});
+      pconns.push_back(nullptr);
+    }
+    int64_t wait_us = next_arrival < end ? std::max<int64_t>(next_arrival - now_us(), 0) : 10000;
+    poll(pfds.data(), pfds.size(), (int)std::min<int64_t>(wait_us / 1000, 10));
+
+    now = now_us();
+    for (size_t i = 0; i < pfds.size(); i++) {
+      short rev = pfds[i].revents;
+      if (!rev) continue;
+      if (!pconns[i]) {
+        stream_event(opt, stream, routes[stream_route], rev);
+        continue;
+      }
+      Conn& c = *pconns[i];
+      if (i >= load_pfds) {
+        idle_event(opt, idle, c, rev, now);
+        continue;
+      }
+
+      if (c.state == Conn::Connecting) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0 || (rev & (POLLERR | POLLHUP))) {
+          conn_close(c);
+        } else {
+          c.state = Conn::Idle;
+        }
+        continue;
+      }
+
+      if ((rev & POLLOUT) && c.out_off < c.out.size()) {
+        ssize_t n = send(c.fd, c.out.data() + c.out_off, c.out.size() - c.out_off, MSG_NOSIGNAL);
+        if (n > 0) c.out_off += n;
+      }
+
+      if (rev & (POLLIN | POLLERR | POLLHUP)) {
+        char buf[4096];
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n > 0) c.in.append(buf, n);
+        if (c.state != Conn::Busy) {
+          // Unexpected data or server closed idle connection
+          conn_close(c);
+          continue;
+        }
+
+        bool keep_alive = true;
+        int status = parse_response(c.in, keep_alive);
+        if (status == 0 && n <= 0) status = -1;
+        if (status == 0) continue;
+
+        Route& route = routes[c.req.route];
+        if (status == 200) {
+          route.ok++;
+          route.latencies_us.push_back(now - c.req.intended_us);
+        } else {
+          route.errors++;
+        }
+        if (status > 0) route.statuses[status]++;
+
+        if (keep_alive && status > 0) {
+          c.state = Conn::Idle;
+          c.in.clear();
+        } else {
+          conn_close(c);
+        }
+      }
+    }
+  }
+
+  const double elapsed = (now_us() - start) / 1e6;
+
+  // Jitter of load window
+  JitterWindow jitter;
+  bool jitter_failed = false;
+  if (opt.max_jitter > 0) {
+    Jitter jitter_after = jitter_read(opt, addr);
+    if (jitter_after.valid && jitter_after.le == jitter_before.le) {
+      jitter = jitter_window(jitter_before, jitter_after);
+    } else {
+      fprintf(stderr, "Failed to read HID tick jitter from /api/metrics after load\n");
+    }
+    jitter_failed = jitter.ticks == 0 || jitter.p99_us > opt.max_jitter;
+  }
+  uint64_t total_ok = 0;
+  uint64_t total_err = 0;
+  std::vector<int64_t> all;
+  for (Route& r : routes) {
+    std::sort(r.latencies_us.begin(), r.latencies_us.end());
+    all.insert(all.end(), r.latencies_us.begin(), r.latencies_us.end());
+    total_ok += r.ok;
+    total_err += r.errors;
+  }
+  std::sort(all.begin(), all.end());
+  const uint64_t unsent = pending.size() + stream.ends.size();
+
+  std::sort(idle.latencies_us.begin(), idle.latencies_us.end());
+  int idle_connected = 0;
+  int idle_open_end = 0;
+  for (const Conn& c : idle.conns) {
+    if (c.ok > 0) idle_connected++;
+    if (c.fd >= 0) idle_open_end++;
+  }
+  const bool p99_failed = opt.max_p99 > 0 && percentile(all, 99) > opt.max_p99;
+
+  if (opt.json) {
+    printf("{\"rate\":%.2f,\"duration\":%.2f,\"connections\":%d,\"throughput\":%.2f,", opt.rate,
+           elapsed, opt.connections, total_ok / elapsed);
+    printf("\"ok\":%llu,\"errors\":%llu,\"timeouts\":%llu,\"unsent\":%llu,\"connects\":%llu,",
+           (unsigned long long)total_ok, (unsigned long long)total_err,
+           (unsigned long long)timeouts, (unsigned long long)unsent,
+           (unsigned long long)connects);
+    printf("\"max_pending\":%zu,", max_pending);
+    printf("\"idle\":{\"requested\":%d,\"connected\":%d,\"open\":%d,\"closed\":%llu,"
+           "\"failed\":%llu,\"p99_ms\":%.3f},",
+           opt.idle, idle_connected, idle_open_end, (unsigned long long)idle.closed,
+           (unsigned long long)idle.failed, percentile(idle.latencies_us, 99));
+    if (stream_route < routes.size()) {
+      printf("\"stream\":{\"status\":%d,\"frames\":%llu,\"closed\":%llu},", stream.status,
+             (unsigned long long)stream.frames, (unsigned long long)stream.closed);
+    }
+    printf("\"p99_failed\":%s,", p99_failed ? "true" : "false");
+    if (opt.max_jitter > 0) {
+      // +Inf bucket is reported as -1 (JSON has no infinity)
+      printf("\"jitter\":{\"ticks\":%llu,\"mean_us\":%.1f,\"p99_us\":%.0f,\"failed\":%s},",
+             (unsigned long long)jitter.ticks, jitter.mean_us,
+             std::isinf(jitter.p99_us) ? -1.0 : jitter.p99_us, jitter_failed ? "true" : "false");
+    }
+    printf("\"routes\":{");
+    for (size_t i = 0; i < routes.size(); i++) {
+      const Route& r = routes[i];
+      printf("%s\"%s\":{\"ok\":%llu,\"errors\":%llu,\"p50_ms\":%.3f,\"p90_ms\":%.3f,"
+             "\"p99_ms\":%.3f,\"p999_ms\":%.3f,\"max_ms\":%.3f}",
+             i ? "," : "", r.name.c_str(), (unsigned long long)r.ok,
+             (unsigned long long)r.errors, percentile(r.latencies_us, 50),
+             percentile(r.latencies_us, 90), percentile(r.latencies_us, 99),
+             percentile(r.latencies_us, 99.9), percentile(r.latencies_us, 100));
+    }
+    printf("}}\n");
+  } else {
+    printf("Target: %s:%d, rate: %.1f req/s, connections: %d, duration: %.1f s\n",
+           opt.host.c_str(), opt.port, opt.rate, opt.connections, elapsed);
+    printf("Throughput: %.1f req/s, ok: %llu, errors: %llu (timeouts: %llu), unsent: %llu\n",
+           total_ok / elapsed, (unsigned long long)total_ok, (unsigned long long)total_err,
+           (unsigned long long)timeouts, (unsigned long long)unsent);
+    printf("Connects: %llu, max pending queue: %zu\n", (unsigned long long)connects, max_pending);
+    if (opt.idle > 0) {
+      printf("Idle connections: %d, connected: %d, open at end: %d, closed by server: %llu, "
+             "failed: %llu, ping p99: %.2f ms\n",
+             opt.idle, idle_connected, idle_open_end, (unsigned long long)idle.closed,
+             (unsigned long long)idle.failed, percentile(idle.latencies_us, 99));
+    }
+    if (stream_route < routes.size()) {
+      printf("Input stream: frames sent: %llu, closed by server: %llu (latency isn't measured)\n",
+             (unsigned long long)stream.frames, (unsigned long long)stream.closed);
+    }
+    if (opt.max_jitter > 0) {
+      printf("HID tick jitter: ticks: %llu, mean: %.1f us, p99: <= %.0f us\n",
+             (unsigned long long)jitter.ticks, jitter.mean_us, jitter.p99_us);
+      if (std::isinf(jitter.p99_us)) printf("p99 HID tick jitter is above the last bucket\n");
+    }
+    printf("\n%-10s %8s %7s %9s %9s %9s %9s %9s\n", "route", "ok", "errors", "p50 ms", "p90 ms",
+           "p99 ms", "p99.9 ms", "max ms");
+    auto row = [](const char* name, uint64_t ok, uint64_t err, const std::vector<int64_t>& l) {
+      printf("%-10s %8llu %7llu %9.2f %9.2f %9.2f %9.2f %9.2f\n", name, (unsigned long long)ok,
+             (unsigned long long)err, percentile(l, 50), percentile(l, 90), percentile(l, 99),
+             percentile(l, 99.9), percentile(l, 100));
+    };
+    for (const Route& r : routes) row(r.name.c_str(), r.ok, r.errors, r.latencies_us);
+    row("all", total_ok, total_err, all);
+    for (const Route& r : routes) {
+      for (const auto& [status, count] : r.statuses) {
+        if (status != 200) {
+          printf("%s: HTTP %d x%llu\n", r.name.c_str(), status, (unsigned long long)count);
+        }
+      }
+    }
+  }
+
+  if (p99_failed && !opt.json) {
+    printf("p99 latency %.2f ms exceeds %.2f ms\n", percentile(all, 99), opt.max_p99);
+  }
+  if (opt.max_jitter > 0 && !opt.json) {
+    printf("%s: p99 HID tick jitter <= %.0f us, bound %.0f us\n", jitter_failed ? "FAIL" : "PASS",
+           jitter.p99_us, opt.max_jitter);
+  }
+
+  return total_err > 0 || unsent > 0 || p99_failed || jitter_failed ? 1 : 0;
+}